@@ -1,16 +1,23 @@
 #include "av1_depacketizer.h"
+#include <algorithm>
 
 namespace rtp {
 
 bool AV1Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_payload, 
                                 std::vector<uint8_t>* out_frame) {
+    return Depacketize(rtp_payload.data(), rtp_payload.size(), out_frame);
+}
+
+bool AV1Depacketizer::Depacketize(const uint8_t* rtp_payload, 
+                                size_t size, 
+                                std::vector<uint8_t>* out_frame) {
     if (out_frame == nullptr) {
         return false;
     }
     
     out_frame->clear();
     
-    if (rtp_payload.size() <= 1) {
+    if (rtp_payload == nullptr || size <= 1) {
         return false;
     }
     
@@ -36,7 +43,7 @@ bool AV1Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_payload,
     }
 
     size_t obu_offset = 0;
-    for (size_t offset = 1; offset < rtp_payload.size(); obu_offset++) {
+    for (size_t offset = 1; offset < size; obu_offset++) {
         bool is_first = (obu_offset == 0);
         bool is_last = (obu_count != 0 && obu_offset == static_cast<size_t>(obu_count) - 1);
         
@@ -45,24 +52,26 @@ bool AV1Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_payload,
         size_t n = 0;
         
         if (obu_count == 0 || !is_last) {
-            if (!ReadLeb128(rtp_payload, offset, &length_field, &n)) {
+            if (!ReadLeb128(rtp_payload, size, offset, &length_field, &n)) {
                 return false;
             }
             
             offset += n;
-            if (obu_count == 0 && offset + length_field == rtp_payload.size()) {
+            if (obu_count == 0 && offset + length_field == size) {
                 is_last = true;
             }
         } else {
             // For last element when W is non-zero, length is implicit
-            length_field = rtp_payload.size() - offset;
+            length_field = size - offset;
         }
         
-        if (offset + length_field > rtp_payload.size()) {
+        if (offset + length_field > size) {
             return false;
         }
         
-        std::vector<uint8_t> obu_buffer;
+        const uint8_t* element = rtp_payload + offset;
+        size_t element_size = length_field;
+        bool combined = false;
         
         if (is_first && obu_z) {
             // We need to combine with the previous fragment
@@ -76,64 +85,31 @@ bool AV1Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_payload,
             }
             
             // Combine with buffered fragment
-            obu_buffer.reserve(buffer_.size() + length_field);
-            obu_buffer.insert(obu_buffer.end(), buffer_.begin(), buffer_.end());
-            obu_buffer.insert(obu_buffer.end(), 
-                            rtp_payload.begin() + offset,
-                            rtp_payload.begin() + offset + length_field);
-            buffer_.clear();
-        } else {
-            // Use this OBU element directly
-            obu_buffer.assign(rtp_payload.begin() + offset, 
-                            rtp_payload.begin() + offset + length_field);
+            buffer_.insert(buffer_.end(), element, element + element_size);
+            element = buffer_.data();
+            element_size = buffer_.size();
+            combined = true;
         }
         
         offset += length_field;
         
         // If this is the last fragment and Y is set, buffer it for next packet
         if (is_last && obu_y) {
-            buffer_ = obu_buffer;
+            if (!combined) {
+                buffer_.assign(element, element + element_size);
+            }
             break;
         }
         
-        if (obu_buffer.empty()) {
-            continue;
+        bool appended = element_size == 0 || AppendOBU(element, element_size, out_frame);
+        if (combined) {
+            buffer_.clear();
         }
         
-        // Parse OBU header to check OBU type
-        AV1OBUHeader obu_header;
-        size_t header_size = 0;
-        if (!AV1OBUHeader::Parse(obu_buffer, 0, &obu_header, &header_size)) {
+        if (!appended) {
             return false;
         }
         
-        // Skip temporal delimiter and tile list OBUs
-        if (obu_header.type == AV1OBUHeader::OBU_TEMPORAL_DELIMITER || 
-            obu_header.type == AV1OBUHeader::OBU_TILE_LIST) {
-            continue;
-        }
-        
-        // Add OBU with size field to the output
-        // OBUs in RTP should have has_size_field=0, but we add it for the output stream
-        std::vector<uint8_t> obu_with_size;
-        
-        // Set has_size_field=true for output
-        obu_header.has_size_field = true;
-        auto header_bytes = obu_header.Marshal();
-        
-        // Calculate size of payload (without header)
-        size_t payload_size = obu_buffer.size() - header_size;
-        
-        // Write header + size + payload
-        obu_with_size.insert(obu_with_size.end(), header_bytes.begin(), header_bytes.end());
-        auto size_bytes = WriteToLeb128(payload_size);
-        obu_with_size.insert(obu_with_size.end(), size_bytes.begin(), size_bytes.end());
-        obu_with_size.insert(obu_with_size.end(), 
-                           obu_buffer.begin() + header_size,
-                           obu_buffer.end());
-        
-        out_frame->insert(out_frame->end(), obu_with_size.begin(), obu_with_size.end());
-        
         if (is_last) {
             break;
         }
@@ -147,12 +123,57 @@ bool AV1Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_payload,
     return true;
 }
 
+bool AV1Depacketizer::AppendOBU(const uint8_t* obu, size_t size, std::vector<uint8_t>* out_frame) {
+    // Parse OBU header to check OBU type
+    AV1OBUHeader obu_header;
+    size_t header_size = 0;
+    if (!AV1OBUHeader::Parse(obu, size, 0, &obu_header, &header_size)) {
+        return false;
+    }
+    
+    // Skip temporal delimiter and tile list OBUs
+    if (obu_header.type == AV1OBUHeader::OBU_TEMPORAL_DELIMITER || 
+        obu_header.type == AV1OBUHeader::OBU_TILE_LIST) {
+        return true;
+    }
+    
+    // OBUs in RTP should have has_size_field=0, but we add it for the output stream
+    obu_header.has_size_field = true;
+    
+    // Calculate size of payload (without header)
+    size_t payload_size = size - header_size;
+    
+    // Write header + size + payload, leaving room for the longest leb128
+    size_t out_start = out_frame->size();
+    out_frame->resize(out_start + header_size + 5 + payload_size);
+    
+    uint8_t* out = out_frame->data() + out_start;
+    size_t written = obu_header.MarshalTo(out);
+    written += WriteToLeb128(static_cast<uint32_t>(payload_size), out + written);
+    std::copy(obu + header_size, obu + size, out + written);
+    written += payload_size;
+    
+    out_frame->resize(out_start + written);
+    return true;
+}
+
 bool AV1Depacketizer::IsPartitionHead(const std::vector<uint8_t>& rtp_payload) const {
-    if (rtp_payload.empty()) {
+    return IsPartitionHead(rtp_payload.data(), rtp_payload.size());
+}
+
+bool AV1Depacketizer::IsPartitionHead(const uint8_t* rtp_payload, size_t size) const {
+    if (size == 0) {
         return false;
     }
     
     return (rtp_payload[0] & kAV1ZMask) == 0;
 }
 
+void AV1Depacketizer::Reset() {
+    buffer_.clear();
+    z_ = false;
+    y_ = false;
+    n_ = false;
+}
+
 } // namespace rtp
\ No newline at end of file
@@ -18,11 +18,21 @@ public:
     // If the frame is incomplete, out_frame will be empty but the function still returns true
     bool Depacketize(const std::vector<uint8_t>& rtp_payload, 
                      std::vector<uint8_t>* out_frame);
+    bool Depacketize(const uint8_t* rtp_payload, 
+                     size_t size, 
+                     std::vector<uint8_t>* out_frame);
     
     // Returns true if the RTP packet is the start of a new frame
     bool IsPartitionHead(const std::vector<uint8_t>& rtp_payload) const;
+    bool IsPartitionHead(const uint8_t* rtp_payload, size_t size) const;
+    
+    // Drops a partially received OBU, e.g. after packet loss
+    void Reset();
 
 private:
+    // Appends one complete OBU element to out_frame with obu_has_size_field set
+    bool AppendOBU(const uint8_t* obu, size_t size, std::vector<uint8_t>* out_frame);
+
     // Buffer for fragmented OBU from previous packet
     std::vector<uint8_t> buffer_;
     
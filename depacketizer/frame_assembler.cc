@@ -0,0 +1,146 @@
+#include "frame_assembler.h"
+#include <cstring>
+
+namespace rtp {
+
+const char* GetFrameDropReasonMessage(FrameDropReason reason) {
+    switch (reason) {
+        case FrameDropReason::kSequenceGap:
+            return "Packet lost inside frame";
+        case FrameDropReason::kMissingStart:
+            return "First packet of frame lost";
+        case FrameDropReason::kMissingEnd:
+            return "Last packet of frame lost";
+        case FrameDropReason::kDepacketizeError:
+            return "Depacketization failed";
+        case FrameDropReason::kFrameTooLarge:
+            return "Frame too large";
+        default:
+            return "Unknown frame drop reason";
+    }
+}
+
+FrameAssembler::FrameAssembler(FrameDepacketizer* depacketizer, size_t max_frame_size)
+    : depacketizer_(depacketizer), max_frame_size_(max_frame_size) {
+}
+
+bool FrameAssembler::InsertPacket(const uint8_t* rtp_packet, size_t size, FrameSink* sink) {
+    PacketView packet;
+    if (!depacketizer_ || !packet.Parse(rtp_packet, size)) {
+        stats_.ignored++;
+        return false;
+    }
+    
+    // Only packets after the last one are accepted, anything else is a
+    // duplicate or arrived too late to be useful
+    uint16_t sequence_number = packet.sequence_number();
+    bool gap = false;
+    if (has_last_sequence_number_) {
+        int16_t delta = static_cast<int16_t>(sequence_number - last_sequence_number_);
+        if (delta <= 0) {
+            stats_.ignored++;
+            return false;
+        }
+        gap = delta != 1;
+    }
+    has_last_sequence_number_ = true;
+    last_sequence_number_ = sequence_number;
+    
+    bool same_frame = state_ != State::kIdle && packet.timestamp() == frame_timestamp_;
+    
+    switch (state_) {
+        case State::kAssembling:
+            if (same_frame) {
+                if (gap) {
+                    DropFrame(packet, FrameDropReason::kSequenceGap, sink);
+                } else {
+                    AppendPacket(packet, sink);
+                }
+                return true;
+            }
+            
+            // The next frame began before this one ended
+            DropFrame(packet, gap ? FrameDropReason::kSequenceGap : FrameDropReason::kMissingEnd, sink);
+            break;
+            
+        case State::kDiscarding:
+            if (same_frame) {
+                if (depacketizer_->IsFrameEnd(packet)) {
+                    state_ = State::kIdle;
+                }
+                return true;
+            }
+            break;
+            
+        case State::kIdle:
+            break;
+    }
+    
+    StartFrame(packet, gap, sink);
+    return true;
+}
+
+void FrameAssembler::Reset() {
+    if (depacketizer_) {
+        depacketizer_->Reset();
+    }
+    
+    frame_.clear();
+    state_ = State::kIdle;
+    has_last_sequence_number_ = false;
+}
+
+void FrameAssembler::StartFrame(const PacketView& packet, bool after_gap, FrameSink* sink) {
+    frame_.clear();
+    depacketizer_->Reset();
+    frame_timestamp_ = packet.timestamp();
+    
+    if (!depacketizer_->IsFrameStart(packet) || (after_gap && !depacketizer_->HasFrameStartFlag())) {
+        DropFrame(packet, FrameDropReason::kMissingStart, sink);
+        return;
+    }
+    
+    state_ = State::kAssembling;
+    AppendPacket(packet, sink);
+}
+
+void FrameAssembler::AppendPacket(const PacketView& packet, FrameSink* sink) {
+    if (!depacketizer_->AppendFrameData(packet, &frame_)) {
+        DropFrame(packet, FrameDropReason::kDepacketizeError, sink);
+        return;
+    }
+    
+    if (max_frame_size_ != 0 && frame_.size() > max_frame_size_) {
+        DropFrame(packet, FrameDropReason::kFrameTooLarge, sink);
+        return;
+    }
+    
+    if (depacketizer_->IsFrameEnd(packet)) {
+        state_ = State::kIdle;
+        stats_.frames++;
+        if (sink && pool_) {
+            PacketBuffer frame = pool_->Allocate(frame_.size());
+            std::memcpy(frame.data(), frame_.data(), frame_.size());
+            sink->OnFrameBuffer(std::move(frame), frame_timestamp_);
+        } else if (sink) {
+            sink->OnFrame(frame_.data(), frame_.size(), frame_timestamp_);
+        }
+    }
+}
+
+void FrameAssembler::DropFrame(const PacketView& packet, FrameDropReason reason, FrameSink* sink) {
+    stats_.dropped[static_cast<size_t>(reason)]++;
+    if (sink) {
+        sink->OnFrameDropped(frame_timestamp_, reason);
+    }
+    
+    frame_.clear();
+    depacketizer_->Reset();
+    
+    // Keep discarding until the dropped frame ends, unless this packet was
+    // already its last one
+    bool frame_ended = packet.timestamp() == frame_timestamp_ && depacketizer_->IsFrameEnd(packet);
+    state_ = frame_ended ? State::kIdle : State::kDiscarding;
+}
+
+} // namespace rtp
\ No newline at end of file
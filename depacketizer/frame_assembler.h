@@ -0,0 +1,131 @@
+#ifndef FRAME_ASSEMBLER_H_
+#define FRAME_ASSEMBLER_H_
+
+#include <cstdint>
+#include <vector>
+#include "rtp_packet.h"
+#include "buffer_pool.h"
+
+namespace rtp {
+
+// Why the frame assembler gave up on a frame
+enum class FrameDropReason {
+    kSequenceGap,         // A packet inside the frame was lost
+    kMissingStart,        // The first packet of the frame was lost
+    kMissingEnd,          // The next frame began before this one ended
+    kDepacketizeError,    // The codec depacketizer rejected a packet
+    kFrameTooLarge,       // The frame grew past the configured limit
+    kCount
+};
+
+const char* GetFrameDropReasonMessage(FrameDropReason reason);
+
+// FrameDepacketizer adapts a codec depacketizer to the frame assembler
+class FrameDepacketizer {
+public:
+    virtual ~FrameDepacketizer() = default;
+
+    // Whether the packet can begin a frame, e.g. not a continuation fragment
+    virtual bool IsFrameStart(const PacketView& packet) = 0;
+
+    // Whether IsFrameStart() identifies the first packet of a frame on its
+    // own. Without such a flag a frame right after a sequence gap may have
+    // lost its first packets and is dropped.
+    virtual bool HasFrameStartFlag() const { return false; }
+
+    // Whether the packet completes the frame it belongs to
+    virtual bool IsFrameEnd(const PacketView& packet) = 0;
+
+    // Appends the media carried by the packet to frame
+    virtual bool AppendFrameData(const PacketView& packet, std::vector<uint8_t>* frame) = 0;
+
+    // Discards any partially assembled codec state
+    virtual void Reset() = 0;
+};
+
+// FrameSink receives the outcome of every frame the assembler sees
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    // The frame buffer is only valid for the duration of the call
+    virtual void OnFrame(const uint8_t* frame, size_t size, uint32_t timestamp) = 0;
+
+    // Called instead of OnFrame() when the assembler draws frames from a
+    // buffer pool; the sink may keep the buffer past the call without
+    // copying it. Defaults to OnFrame().
+    virtual void OnFrameBuffer(PacketBuffer frame, uint32_t timestamp) {
+        OnFrame(frame.data(), frame.size(), timestamp);
+    }
+
+    // Called once for each frame that was given up on
+    virtual void OnFrameDropped(uint32_t /*timestamp*/, FrameDropReason /*reason*/) {}
+};
+
+// Counters of one frame assembler
+struct FrameAssemblerStats {
+    uint64_t frames = 0;
+    uint64_t dropped[static_cast<size_t>(FrameDropReason::kCount)] = {};
+    uint64_t ignored = 0;     // Malformed, duplicate or out of order packets
+};
+
+// FrameAssembler turns the in-order packets of one stream into complete
+// frames. A frame is delimited by the codec start and end checks and by RTP
+// timestamp changes; a sequence gap, a missing first or last packet or a
+// depacketization error drops the whole frame at once, and the rest of its
+// packets are discarded, so partial frames never reach the decoder. Packets
+// should come from a JitterBuffer or otherwise be in sequence order.
+class FrameAssembler {
+public:
+    // max_frame_size of 0 means unlimited
+    explicit FrameAssembler(FrameDepacketizer* depacketizer, size_t max_frame_size = 0);
+    ~FrameAssembler() = default;
+
+    // Feeds the next received packet; completed and dropped frames are
+    // reported to sink. Returns false if the packet was ignored.
+    bool InsertPacket(const uint8_t* rtp_packet, size_t size, FrameSink* sink);
+
+    // Forgets the current frame and the sequence history
+    void Reset();
+
+    // Hands completed frames to FrameSink::OnFrameBuffer() in buffers drawn
+    // from pool, null restores OnFrame(). The pool must outlive the assembler.
+    void SetBufferPool(BufferPool* pool) { pool_ = pool; }
+
+    const FrameAssemblerStats& Stats() const { return stats_; }
+
+private:
+    enum class State {
+        kIdle,          // Between frames
+        kAssembling,    // Collecting the packets of frame_timestamp_
+        kDiscarding     // Skipping the rest of a dropped frame
+    };
+
+    // Starts a frame with packet, or drops it if the packet cannot start one;
+    // after_gap tells whether packets right before it were lost
+    void StartFrame(const PacketView& packet, bool after_gap, FrameSink* sink);
+
+    // Adds packet to the current frame and completes it at its end
+    void AppendPacket(const PacketView& packet, FrameSink* sink);
+
+    // Gives up on the current frame; packet is the one being processed and
+    // decides whether the dropped frame has already ended
+    void DropFrame(const PacketView& packet, FrameDropReason reason, FrameSink* sink);
+
+    FrameDepacketizer* depacketizer_;
+    size_t max_frame_size_;
+    BufferPool* pool_ = nullptr;
+
+    State state_ = State::kIdle;
+    std::vector<uint8_t> frame_;
+    uint32_t frame_timestamp_ = 0;
+
+    bool has_last_sequence_number_ = false;
+    uint16_t last_sequence_number_ = 0;
+
+    FrameAssemblerStats stats_;
+};
+
+} // namespace rtp
+
+#endif // FRAME_ASSEMBLER_H_
\ No newline at end of file
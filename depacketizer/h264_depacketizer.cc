@@ -1,5 +1,4 @@
 #include "h264_depacketizer.h"
-#include <stdexcept>
 #include <arpa/inet.h>
 
 namespace rtp {
@@ -11,32 +10,37 @@ H264Depacketizer::H264Depacketizer(bool is_avc) : H264Packet() {
 }
 
 std::vector<uint8_t> H264Depacketizer::Process(const std::vector<uint8_t>& packet) {
-    Packet rtp_packet;
-    if (!rtp_packet.Depacketize(packet)) {
+    PacketView rtp_packet;
+    if (!rtp_packet.Parse(packet)) {
+        stats_.packets++;
+        Fail(kInvalidRtpPacket);
         return {};
     }
     
-    return ParseBody(rtp_packet.payload);
+    std::vector<uint8_t> result;
+    if (!ParseBody(rtp_packet.payload(), rtp_packet.payload_size(), rtp_packet.sequence_number(), &result)) {
+        return {};
+    }
+    return result;
 }
 
 bool H264Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* frame) {
+    return Depacketize(rtp_packet.data(), rtp_packet.size(), frame);
+}
+
+bool H264Depacketizer::Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* frame) {
     if (!frame) {
         return false;
     }
     
-    Packet packet;
-    if (!packet.Depacketize(rtp_packet)) {
-        return false;
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
+        stats_.packets++;
+        return Fail(kInvalidRtpPacket);
     }
     
-    std::vector<uint8_t> result = ParseBody(packet.payload);
-    if (result.empty() && !packet.payload.empty()) {
-        // Still in progress for fragmented packets
-        return true;
-    }
-    
-    frame->insert(frame->end(), result.begin(), result.end());
-    return true;
+    // Fragmented NALUs append nothing until their last fragment arrives
+    return ParseBody(packet.payload(), packet.payload_size(), packet.sequence_number(), frame);
 }
 
 bool H264Depacketizer::IsPartitionHead(const std::vector<uint8_t>& payload) {
@@ -47,9 +51,22 @@ bool H264Depacketizer::IsPartitionTail(bool marker, const std::vector<uint8_t>&
     return H264Packet::IsPartitionTail(marker, payload);
 }
 
-std::vector<uint8_t> H264Depacketizer::ParseBody(const std::vector<uint8_t>& payload) {
-    if (payload.empty()) {
-        throw std::runtime_error(GetH264ErrorMessage(kShortPacket));
+void H264Depacketizer::Reset() {
+    fua_buffer_.clear();
+}
+
+bool H264Depacketizer::Fail(H264ErrorCode code) {
+    last_error_ = code;
+    stats_.errors[code]++;
+    return false;
+}
+
+bool H264Depacketizer::ParseBody(const uint8_t* payload, size_t size, uint16_t sequence_number,
+                                 std::vector<uint8_t>* out) {
+    stats_.packets++;
+    
+    if (size == 0) {
+        return Fail(kShortPacket);
     }
 
     // Get NALU type
@@ -58,15 +75,16 @@ std::vector<uint8_t> H264Depacketizer::ParseBody(const std::vector<uint8_t>& pay
     // Handle different NALU types
     if (nalu_type > 0 && nalu_type < 24) {
         // Single NALU
-        return DoPackaging(payload);
+        DoPackaging(payload, size, out);
+        return true;
     } else if (nalu_type == kStapaNALUType) {
         // STAP-A (Single-time aggregation packet)
         size_t curr_offset = kStapaHeaderSize;
-        std::vector<uint8_t> result;
+        size_t out_start = out->size();
 
-        while (curr_offset < payload.size()) {
+        while (curr_offset < size) {
             // Check we have enough bytes for the NALU length
-            if (curr_offset + kStapaNALULengthSize > payload.size()) {
+            if (curr_offset + kStapaNALULengthSize > size) {
                 break;
             }
 
@@ -75,55 +93,59 @@ std::vector<uint8_t> H264Depacketizer::ParseBody(const std::vector<uint8_t>& pay
             curr_offset += kStapaNALULengthSize;
 
             // Check if we have enough bytes for the NALU
-            if (curr_offset + nalu_size > payload.size()) {
-                throw std::runtime_error(GetH264ErrorMessage(kShortPacket) + 
-                                       ": STAP-A declared size larger than buffer");
+            if (curr_offset + nalu_size > size) {
+                // Drop the NALUs already appended from this packet
+                out->resize(out_start);
+                return Fail(kStapATruncated);
             }
 
-            // Extract the NALU
-            std::vector<uint8_t> nalu(payload.begin() + curr_offset, 
-                                     payload.begin() + curr_offset + nalu_size);
-            
-            // Package the NALU
-            std::vector<uint8_t> packaged = DoPackaging(nalu);
-            result.insert(result.end(), packaged.begin(), packaged.end());
+            // Package the NALU straight from the packet
+            DoPackaging(payload + curr_offset, nalu_size, out);
             
             curr_offset += nalu_size;
         }
 
-        return result;
+        return true;
     } else if (nalu_type == kFuaNALUType) {
         // FU-A (Fragmentation unit)
-        if (payload.size() < kFuaHeaderSize) {
-            throw std::runtime_error(GetH264ErrorMessage(kShortPacket));
+        if (size < kFuaHeaderSize) {
+            return Fail(kShortPacket);
         }
 
-        // Extract the data part of the fragment
-        std::vector<uint8_t> fragment(payload.begin() + kFuaHeaderSize, payload.end());
-        fua_buffer_.insert(fua_buffer_.end(), fragment.begin(), fragment.end());
+        if (payload[1] & kFuStartBitmask) {
+            // A start fragment abandons any unfinished NALU and reserves the
+            // first byte for the reconstructed NALU header
+            fua_buffer_.assign(1, 0);
+        } else if (fua_buffer_.empty() ||
+                   sequence_number != static_cast<uint16_t>(fua_sequence_number_ + 1)) {
+            // The start or a middle fragment was lost, the NALU is corrupt
+            fua_buffer_.clear();
+            return Fail(kFuaFragmentLost);
+        }
+        fua_sequence_number_ = sequence_number;
+
+        // Append the data part of the fragment
+        fua_buffer_.insert(fua_buffer_.end(), payload + kFuaHeaderSize, payload + size);
 
         // Check if this is the end of a fragmentation unit
         if (payload[1] & kFuEndBitmask) {
-            // Reconstruct the original NALU
+            // Reconstruct the original NALU header
             uint8_t nalu_ref_idc = payload[0] & kNaluRefIdcBitmask;
             uint8_t fragment_type = payload[1] & kNaluTypeBitmask;
+            fua_buffer_[0] = nalu_ref_idc | fragment_type;
             
-            std::vector<uint8_t> nalu = {nalu_ref_idc | fragment_type};
-            nalu.insert(nalu.end(), fua_buffer_.begin(), fua_buffer_.end());
+            DoPackaging(fua_buffer_.data(), fua_buffer_.size(), out);
             
             // Clear the buffer for the next fragmented NALU
             fua_buffer_.clear();
-            
-            return DoPackaging(nalu);
         }
         
         // Still in progress for this fragmented NALU
-        return {};
+        return true;
     }
 
     // Unhandled NALU type
-    throw std::runtime_error(GetH264ErrorMessage(kUnhandledNALUType) + 
-                           ": " + std::to_string(nalu_type));
+    return Fail(kUnhandledNALUType);
 }
 
 } // namespace rtp
\ No newline at end of file
@@ -20,6 +20,7 @@ public:
 
     // Depacketize parses the passed RTP packet and stores the result
     bool Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* frame);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* frame);
 
     // IsPartitionHead checks if this is the head of an H264 partition
     bool IsPartitionHead(const std::vector<uint8_t>& payload) override;
@@ -27,12 +28,31 @@ public:
     // IsPartitionTail checks if this is the tail of an H264 partition
     bool IsPartitionTail(bool marker, const std::vector<uint8_t>& payload) override;
 
+    // Drops a partially received fragmented NALU, e.g. after packet loss
+    void Reset();
+
+    // Error of the last rejected packet; only meaningful after a failure
+    H264ErrorCode LastError() const { return last_error_; }
+    
+    // Packet and error counters of this stream
+    const H264DepacketizerStats& Stats() const { return stats_; }
+    void ResetStats() { stats_ = H264DepacketizerStats(); }
+
 private:
-    // Parse the H.264 payload
-    std::vector<uint8_t> ParseBody(const std::vector<uint8_t>& payload);
+    // Parse the H.264 payload and append the resulting NALUs to out
+    // Malformed payloads leave out unchanged and return false
+    bool ParseBody(const uint8_t* payload, size_t size, uint16_t sequence_number,
+                   std::vector<uint8_t>* out);
     
-    // Buffer for assembling fragmented NALUs
+    // Records a rejected packet, always returns false
+    bool Fail(H264ErrorCode code);
+    
+    // Buffer for assembling fragmented NALUs, starting with the NALU header
     std::vector<uint8_t> fua_buffer_;
+    uint16_t fua_sequence_number_ = 0;
+    
+    H264ErrorCode last_error_ = kShortPacket;
+    H264DepacketizerStats stats_;
 };
 
 } // namespace rtp
@@ -8,6 +8,11 @@ H265Depacketizer::H265Depacketizer() : h265_packet_(std::make_unique<H265Packet>
 
 H265Depacketizer::~H265Depacketizer() = default;
 
+void H265Depacketizer::Reset() {
+    fragment_buffer_.clear();
+    current_fragment_is_valid_ = false;
+}
+
 void H265Depacketizer::WithDONL(bool value) {
     h265_packet_->WithDONL(value);
 }
@@ -17,7 +22,15 @@ bool H265Depacketizer::IsPartitionHead(const std::vector<uint8_t>& payload) {
 }
 
 bool H265Depacketizer::IsPartitionTail(bool marker, const std::vector<uint8_t>& payload) {
-    if (payload.size() < 3) {
+    return IsPartitionTail(marker, payload.data(), payload.size());
+}
+
+bool H265Depacketizer::IsPartitionHead(const uint8_t* payload, size_t size) {
+    return h265_packet_->IsPartitionHead(payload, size);
+}
+
+bool H265Depacketizer::IsPartitionTail(bool marker, const uint8_t* payload, size_t size) {
+    if (size < 3) {
         return false;
     }
 
@@ -38,17 +51,22 @@ std::vector<uint8_t> H265Depacketizer::Process(const std::vector<uint8_t>& packe
 }
 
 bool H265Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* h265_frame) {
+    return Depacketize(rtp_packet.data(), rtp_packet.size(), h265_frame);
+}
+
+bool H265Depacketizer::Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* h265_frame) {
     if (!h265_frame) {
         return false;
     }
     
-    Packet packet;
-    if (!packet.Depacketize(rtp_packet)) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
         return false;
     }
 
-    const std::vector<uint8_t>& payload = packet.payload;
-    if (!h265_packet_->Unmarshal(payload)) {
+    // The H.265 payload parsers work on vectors, reuse one buffer across packets
+    payload_buffer_.assign(packet.payload(), packet.payload() + packet.payload_size());
+    if (!h265_packet_->Unmarshal(payload_buffer_)) {
         return false;
     }
 
@@ -62,22 +80,20 @@ bool H265Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet, std::
             H265FragmentationUnitHeader fu_header = fu_packet->FuHeader();
             
             if (fu_header.S()) {
-                // Start of fragmented NAL unit
-                if (!current_fragment_is_valid_) {
-                    fragment_buffer_.clear();
-                    current_fragment_is_valid_ = true;
-                    
-                    // Create NAL header for the first fragment
-                    uint8_t f_bit = fu_packet->PayloadHeader().F() ? 1 : 0;
-                    uint8_t type = fu_header.FuType();
-                    uint8_t layer_id = fu_packet->PayloadHeader().LayerID();
-                    uint8_t tid = fu_packet->PayloadHeader().TID();
-                    
-                    // Reconstruct the NAL header and add it to the buffer
-                    uint16_t reconstructed_header = (f_bit << 15) | (type << 9) | (layer_id << 3) | tid;
-                    fragment_buffer_.push_back(static_cast<uint8_t>(reconstructed_header >> 8));
-                    fragment_buffer_.push_back(static_cast<uint8_t>(reconstructed_header & 0xFF));
-                }
+                // Start of fragmented NAL unit, abandoning any unfinished one
+                fragment_buffer_.clear();
+                current_fragment_is_valid_ = true;
+                
+                // Create NAL header for the first fragment
+                uint8_t f_bit = fu_packet->PayloadHeader().F() ? 1 : 0;
+                uint8_t type = fu_header.FuType();
+                uint8_t layer_id = fu_packet->PayloadHeader().LayerID();
+                uint8_t tid = fu_packet->PayloadHeader().TID();
+                
+                // Reconstruct the NAL header and add it to the buffer
+                uint16_t reconstructed_header = (f_bit << 15) | (type << 9) | (layer_id << 3) | tid;
+                fragment_buffer_.push_back(static_cast<uint8_t>(reconstructed_header >> 8));
+                fragment_buffer_.push_back(static_cast<uint8_t>(reconstructed_header & 0xFF));
             } else if (!current_fragment_is_valid_) {
                 // Middle or end fragment without a valid start - discard
                 return false;
@@ -95,7 +111,8 @@ bool H265Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet, std::
             }
             
             // Middle fragment - don't output anything yet
-            return false;
+            h265_frame->clear();
+            return true;
         }
 
         case H265Packet::PacketType::SingleNALU: {
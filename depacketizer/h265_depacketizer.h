@@ -18,15 +18,22 @@ public:
     std::vector<uint8_t> Process(const std::vector<uint8_t>& packet) override;
     bool IsPartitionHead(const std::vector<uint8_t>& payload) override;
     bool IsPartitionTail(bool marker, const std::vector<uint8_t>& payload) override;
+    bool IsPartitionHead(const uint8_t* payload, size_t size);
+    bool IsPartitionTail(bool marker, const uint8_t* payload, size_t size);
     
     // Depacketize a single RTP packet
     bool Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* h265_frame);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* h265_frame);
     
     // Configure DONL settings
     void WithDONL(bool value);
     
+    // Drops a partially received fragmented NAL unit, e.g. after packet loss
+    void Reset();
+    
 private:
     std::unique_ptr<H265Packet> h265_packet_;
+    std::vector<uint8_t> payload_buffer_;
     std::vector<uint8_t> fragment_buffer_;
     bool current_fragment_is_valid_ = false;
 };
@@ -0,0 +1,180 @@
+#include "jitter_buffer.h"
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Consecutive packets far behind the release point that make it a
+    // restarted stream rather than a burst of very late packets
+    constexpr int kRestartPackets = 4;
+}
+
+JitterBuffer::JitterBuffer(size_t capacity, int64_t max_latency_ms, size_t max_packet_size)
+    : slots_(RoundUpToPowerOfTwo(capacity > 0 ? capacity : 1)),
+      mask_(slots_.size() - 1),
+      max_packet_size_(max_packet_size),
+      max_latency_ms_(max_latency_ms) {
+    storage_.resize(slots_.size() * max_packet_size_);
+}
+
+bool JitterBuffer::Insert(const uint8_t* rtp_packet, size_t size, int64_t now_ms) {
+    PacketView packet;
+    if (size > max_packet_size_ || !packet.Parse(rtp_packet, size)) {
+        stats_.invalid++;
+        return false;
+    }
+    
+    // A new SSRC is a new stream, whatever its sequence numbers
+    if (started_ && packet.ssrc() != ssrc_) {
+        Reset();
+    }
+    
+    int64_t sequence_number = unwrapper_.Unwrap(packet.sequence_number());
+    int64_t capacity = static_cast<int64_t>(slots_.size());
+    
+    if (started_ && sequence_number < next_ && next_ - sequence_number > capacity) {
+        // Far behind the release point: either a very late packet or a
+        // restarted stream, which only several consecutive packets agree on
+        if (restart_count_ > 0 && sequence_number > restart_last_ &&
+            sequence_number - restart_last_ <= capacity) {
+            restart_count_++;
+        } else {
+            restart_count_ = 1;
+        }
+        restart_last_ = sequence_number;
+        if (restart_count_ < kRestartPackets) {
+            stats_.late++;
+            return false;
+        }
+        Reset();
+        sequence_number = unwrapper_.Unwrap(packet.sequence_number());
+    }
+    restart_count_ = 0;
+    
+    if (!started_) {
+        started_ = true;
+        ssrc_ = packet.ssrc();
+        next_ = sequence_number;
+        newest_ = sequence_number;
+    } else if (sequence_number < next_) {
+        stats_.late++;
+        return false;
+    } else if (sequence_number - next_ >= capacity) {
+        // Make room by giving up on the oldest part of the window
+        AdvanceTo(sequence_number - capacity + 1);
+    }
+    
+    Slot& slot = SlotFor(sequence_number);
+    if (slot.used) {
+        stats_.duplicates++;
+        return false;
+    }
+    
+    std::memcpy(SlotData(sequence_number), rtp_packet, size);
+    slot.sequence_number = sequence_number;
+    slot.arrival_ms = now_ms;
+    slot.size = size;
+    slot.used = true;
+    count_++;
+    
+    if (count_ == 1 || (first_held_known_ && sequence_number < first_held_)) {
+        first_held_ = sequence_number;
+        first_held_known_ = true;
+    }
+    
+    if (sequence_number > newest_) {
+        newest_ = sequence_number;
+    }
+    
+    stats_.inserted++;
+    return true;
+}
+
+bool JitterBuffer::Pop(int64_t now_ms, JitterBufferPacket* packet) {
+    if (!packet || count_ == 0) {
+        return false;
+    }
+    
+    if (!Contains(next_)) {
+        // Find the first packet held back by the gap, once per gap
+        if (!first_held_known_) {
+            first_held_ = next_ + 1;
+            while (first_held_ <= newest_ && !Contains(first_held_)) {
+                first_held_++;
+            }
+            first_held_known_ = true;
+        }
+        
+        if (now_ms - SlotFor(first_held_).arrival_ms < max_latency_ms_) {
+            return false;
+        }
+        AdvanceTo(first_held_);
+    }
+    
+    Slot& slot = SlotFor(next_);
+    packet->data = SlotData(next_);
+    packet->size = slot.size;
+    packet->sequence_number = next_;
+    packet->arrival_ms = slot.arrival_ms;
+    packet->after_gap = gap_pending_;
+    
+    // The slot data stays intact until the slot is reused by Insert()
+    slot.used = false;
+    count_--;
+    next_++;
+    gap_pending_ = false;
+    first_held_known_ = false;
+    
+    stats_.released++;
+    return true;
+}
+
+void JitterBuffer::Reset() {
+    for (Slot& slot : slots_) {
+        slot.used = false;
+    }
+    
+    unwrapper_.Reset();
+    started_ = false;
+    restart_count_ = 0;
+    count_ = 0;
+    gap_pending_ = false;
+    first_held_known_ = false;
+}
+
+void JitterBuffer::AdvanceTo(int64_t sequence_number) {
+    // Only the slots of the window can hold packets, so a jump of more than
+    // the capacity visits each slot once
+    int64_t end = sequence_number;
+    if (end - next_ > static_cast<int64_t>(slots_.size())) {
+        end = next_ + static_cast<int64_t>(slots_.size());
+    }
+    
+    uint64_t dropped = 0;
+    for (int64_t seq = next_; seq < end && count_ > 0; seq++) {
+        if (Contains(seq)) {
+            SlotFor(seq).used = false;
+            count_--;
+            dropped++;
+        }
+    }
+    
+    stats_.overflow += dropped;
+    stats_.lost += static_cast<uint64_t>(sequence_number - next_) - dropped;
+    gap_pending_ = true;
+    next_ = sequence_number;
+    if (first_held_known_ && first_held_ < sequence_number) {
+        first_held_known_ = false;
+    }
+}
+
+} // namespace rtp
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef JITTER_BUFFER_H_
+#define JITTER_BUFFER_H_
+
+#include <cstdint>
+#include <vector>
+#include "rtp_packet.h"
+#include "sequence_unwrapper.h"
+
+namespace rtp {
+
+// A packet released by the jitter buffer. data points into the buffer's own
+// storage and stays valid until the next Insert() or Reset().
+struct JitterBufferPacket {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int64_t sequence_number = 0;   // Unwrapped sequence number
+    int64_t arrival_ms = 0;
+    bool after_gap = false;        // Packets before this one were given up on
+};
+
+// Counters of one jitter buffer
+struct JitterBufferStats {
+    uint64_t inserted = 0;
+    uint64_t released = 0;
+    uint64_t duplicates = 0;
+    uint64_t late = 0;         // Arrived after their slot was released or skipped
+    uint64_t invalid = 0;      // Unparseable or larger than the slot size
+    uint64_t lost = 0;         // Sequence numbers skipped without ever arriving
+    uint64_t overflow = 0;     // Buffered packets dropped to make room
+};
+
+// JitterBuffer reorders the RTP packets of one stream before they are handed
+// to a depacketizer. Packets live in a power-of-two ring of fixed-size slots
+// indexed by the unwrapped sequence number, so insert and lookup are O(1) and
+// nothing is allocated after construction. Pop() releases packets in sequence
+// order; a missing packet holds back the ones after it until the oldest of
+// them has waited max_latency_ms, after which the gap is skipped. Packets far
+// behind the release point are dropped as late; the buffer only starts over
+// when the SSRC changes or several consecutive packets land at a new position.
+class JitterBuffer {
+public:
+    // capacity is rounded up to a power of two; packets larger than
+    // max_packet_size are rejected
+    explicit JitterBuffer(size_t capacity = 512, int64_t max_latency_ms = 100,
+                          size_t max_packet_size = 1500);
+    ~JitterBuffer() = default;
+
+    // Stores a copy of a received RTP packet; now_ms is its arrival time on
+    // any monotonic clock. Returns false if the packet was dropped.
+    bool Insert(const uint8_t* rtp_packet, size_t size, int64_t now_ms);
+    bool Insert(const std::vector<uint8_t>& rtp_packet, int64_t now_ms) {
+        return Insert(rtp_packet.data(), rtp_packet.size(), now_ms);
+    }
+
+    // Releases the next packet in sequence order if it is ready at now_ms
+    bool Pop(int64_t now_ms, JitterBufferPacket* packet);
+
+    // Drops every buffered packet and starts over with the next insert
+    void Reset();
+
+    // Accessors
+    size_t Capacity() const { return slots_.size(); }
+    size_t Size() const { return count_; }
+    int64_t MaxLatencyMs() const { return max_latency_ms_; }
+    const JitterBufferStats& Stats() const { return stats_; }
+
+private:
+    struct Slot {
+        int64_t sequence_number = 0;
+        int64_t arrival_ms = 0;
+        size_t size = 0;
+        bool used = false;
+    };
+
+    Slot& SlotFor(int64_t sequence_number) {
+        return slots_[static_cast<uint64_t>(sequence_number) & mask_];
+    }
+    bool Contains(int64_t sequence_number) {
+        const Slot& slot = SlotFor(sequence_number);
+        return slot.used && slot.sequence_number == sequence_number;
+    }
+    uint8_t* SlotData(int64_t sequence_number) {
+        return storage_.data() + (static_cast<uint64_t>(sequence_number) & mask_) * max_packet_size_;
+    }
+
+    // Moves the release point forward to sequence_number, dropping whatever
+    // is buffered before it
+    void AdvanceTo(int64_t sequence_number);
+
+    std::vector<Slot> slots_;
+    std::vector<uint8_t> storage_;
+    uint64_t mask_;
+    size_t max_packet_size_;
+    int64_t max_latency_ms_;
+
+    SequenceNumberUnwrapper unwrapper_;
+    bool started_ = false;
+    uint32_t ssrc_ = 0;
+    int64_t next_ = 0;      // Next sequence number to release
+    int64_t newest_ = 0;    // Highest sequence number inserted
+    size_t count_ = 0;
+    bool gap_pending_ = false;
+
+    // Consecutive packets far behind the release point, and the last of them
+    int restart_count_ = 0;
+    int64_t restart_last_ = 0;
+
+    // Lowest buffered sequence number; only searched for again when a gap
+    // holds back the next release, so polling during a gap is O(1)
+    int64_t first_held_ = 0;
+    bool first_held_known_ = false;
+
+    JitterBufferStats stats_;
+};
+
+} // namespace rtp
+
+#endif // JITTER_BUFFER_H_
\ No newline at end of file
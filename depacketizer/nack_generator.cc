@@ -0,0 +1,259 @@
+#include "nack_generator.h"
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rtp {
+
+namespace {
+
+    constexpr size_t kMinWindow = 64;
+    constexpr size_t kMaxWindow = 1 << 15;
+
+    // RTCP common header plus packet sender and media source SSRCs
+    constexpr size_t kNackHeaderSize = kRtcpFeedbackHeaderSize;
+    constexpr size_t kNackItemSize = 4;
+
+    // Packets covered by one item: the PID and the 16 bits of the BLP
+    constexpr int64_t kNackItemSpan = 17;
+
+    inline unsigned CountTrailingZeros64(uint64_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+    }
+
+    size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void WriteUint16(uint8_t* buf, uint16_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 8);
+        buf[1] = static_cast<uint8_t>(value);
+    }
+
+    void WriteUint32(uint8_t* buf, uint32_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 24);
+        buf[1] = static_cast<uint8_t>(value >> 16);
+        buf[2] = static_cast<uint8_t>(value >> 8);
+        buf[3] = static_cast<uint8_t>(value);
+    }
+}
+
+NackGenerator::NackGenerator(size_t window, int max_retries)
+    : max_retries_(max_retries) {
+    window = RoundUpToPowerOfTwo(std::min(std::max(window, kMinWindow), kMaxWindow));
+    missing_.assign(window / 64, 0);
+    retries_.assign(window, 0);
+    last_sent_ms_.assign(window, 0);
+    mask_ = window - 1;
+}
+
+bool NackGenerator::OnPacket(const uint8_t* rtp_packet, size_t size) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
+        return false;
+    }
+    
+    media_ssrc_ = packet.ssrc();
+    OnPacket(packet.sequence_number());
+    return true;
+}
+
+void NackGenerator::OnPacket(uint16_t sequence_number) {
+    stats_.packets++;
+    
+    int64_t seq = unwrapper_.Unwrap(sequence_number);
+    if (!started_) {
+        started_ = true;
+        newest_ = seq;
+        return;
+    }
+    
+    int64_t window = static_cast<int64_t>(mask_ + 1);
+    int64_t delta = seq - newest_;
+    
+    if (delta > 0) {
+        if (delta >= window) {
+            // Too far ahead to request anything, treat it as a new start
+            stats_.given_up += missing_count_;
+            std::fill(missing_.begin(), missing_.end(), 0);
+            missing_count_ = 0;
+            newest_ = seq;
+            return;
+        }
+        
+        // Every sequence number skipped over is missing; their slots may
+        // still hold requests that just left the window
+        for (int64_t lost = newest_ + 1; lost < seq; lost++) {
+            size_t index = static_cast<size_t>(lost) & mask_;
+            if (IsMissing(index)) {
+                stats_.given_up++;
+            } else {
+                SetMissing(index);
+            }
+            retries_[index] = 0;
+        }
+        stats_.missing += static_cast<uint64_t>(delta - 1);
+        
+        size_t index = static_cast<size_t>(seq) & mask_;
+        if (IsMissing(index)) {
+            ClearMissing(index);
+            stats_.given_up++;
+        }
+        newest_ = seq;
+        return;
+    }
+    
+    // Reordered or retransmitted packet
+    if (-delta < window) {
+        size_t index = static_cast<size_t>(seq) & mask_;
+        if (IsMissing(index)) {
+            ClearMissing(index);
+            stats_.recovered++;
+        }
+    }
+}
+
+size_t NackGenerator::BuildNackItems(int64_t now_ms, NackItem* items, size_t max_items) {
+    if (!items || max_items == 0) {
+        return 0;
+    }
+    size_t offset = 0;
+    return FillNackItems(now_ms, items, 0, max_items, &offset);
+}
+
+size_t NackGenerator::FillNackItems(int64_t now_ms, NackItem* items, size_t count,
+                                    size_t max_items, size_t* offset) {
+    size_t window = static_cast<size_t>(mask_) + 1;
+    if (missing_count_ == 0) {
+        *offset = window;
+        return count;
+    }
+    
+    // Walk the bitmap in sequence order, from the oldest sequence number of
+    // the window, one word or the part of it in front of *offset at a time
+    int64_t first = newest_ - static_cast<int64_t>(mask_);
+    
+    while (*offset < window) {
+        size_t base = (static_cast<size_t>(first) + *offset) & mask_;
+        unsigned base_bit = base & 63;
+        size_t span = std::min<size_t>(64 - base_bit, window - *offset);
+        uint64_t bits = missing_[base >> 6] >> base_bit;
+        if (span < 64) {
+            bits &= (uint64_t(1) << span) - 1;
+        }
+        
+        while (bits) {
+            size_t step = CountTrailingZeros64(bits);
+            size_t index = base + step;
+            bits &= bits - 1;
+            
+            if (retries_[index] > 0 && now_ms - last_sent_ms_[index] < rtt_ms_) {
+                continue;
+            }
+            
+            if (retries_[index] >= max_retries_) {
+                ClearMissing(index);
+                stats_.given_up++;
+                continue;
+            }
+            
+            int64_t seq = first + static_cast<int64_t>(*offset + step);
+            
+            // Extend the current item's BLP or start a new item
+            if (count > 0 && seq - static_cast<int64_t>(items[count - 1].pid) > 0 &&
+                static_cast<uint16_t>(seq - items[count - 1].pid) < kNackItemSpan) {
+                uint16_t offset_in_item = static_cast<uint16_t>(seq - items[count - 1].pid);
+                items[count - 1].blp |= static_cast<uint16_t>(1 << (offset_in_item - 1));
+            } else if (count < max_items) {
+                items[count].pid = static_cast<uint16_t>(seq);
+                items[count].blp = 0;
+                count++;
+            } else {
+                // Full; the next call resumes at this sequence number
+                *offset += step;
+                return count;
+            }
+            
+            retries_[index]++;
+            last_sent_ms_[index] = now_ms;
+            stats_.requests++;
+        }
+        *offset += span;
+    }
+    
+    return count;
+}
+
+size_t NackGenerator::BuildNackPacket(int64_t now_ms, uint32_t sender_ssrc, uint8_t* buf, size_t buf_size) {
+    if (!buf || buf_size < kNackHeaderSize + kNackItemSize) {
+        return 0;
+    }
+    
+    // The FCI entries are built in batches behind the header, in one walk
+    // over the bitmap. The last item of a full batch is carried over to the
+    // next one, as later packets may still extend its BLP.
+    size_t max_items = (buf_size - kNackHeaderSize) / kNackItemSize;
+    NackItem items[64];
+    size_t count = 0;
+    size_t carried = 0;
+    size_t offset = 0;
+    size_t window = static_cast<size_t>(mask_) + 1;
+    for (;;) {
+        size_t batch = std::min(max_items - count, sizeof(items) / sizeof(items[0]));
+        size_t built = FillNackItems(now_ms, items, carried, batch, &offset);
+        bool last = offset >= window || built == max_items - count;
+        size_t written = last ? built : built - 1;
+        for (size_t i = 0; i < written; i++) {
+            uint8_t* fci = buf + kNackHeaderSize + (count + i) * kNackItemSize;
+            WriteUint16(fci, items[i].pid);
+            WriteUint16(fci + 2, items[i].blp);
+        }
+        count += written;
+        if (last) {
+            break;
+        }
+        items[0] = items[built - 1];
+        carried = 1;
+    }
+    
+    if (count == 0) {
+        return 0;
+    }
+    
+    size_t size = kNackHeaderSize + count * kNackItemSize;
+    WriteRtcpHeader(buf, kRtcpGenericNackFmt, kRtcpRtpfbPacketType, size);
+    WriteUint32(buf + 4, sender_ssrc);
+    WriteUint32(buf + 8, media_ssrc_);
+    return size;
+}
+
+void NackGenerator::Reset() {
+    std::fill(missing_.begin(), missing_.end(), 0);
+    unwrapper_.Reset();
+    started_ = false;
+    missing_count_ = 0;
+}
+
+void NackGenerator::SetMissing(size_t index) {
+    missing_[index >> 6] |= uint64_t(1) << (index & 63);
+    missing_count_++;
+}
+
+void NackGenerator::ClearMissing(size_t index) {
+    missing_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+    missing_count_--;
+}
+
+} // namespace rtp
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef NACK_GENERATOR_H_
+#define NACK_GENERATOR_H_
+
+#include <cstdint>
+#include <vector>
+#include "rtp_packet.h"
+#include "rtcp_packet.h"
+#include "sequence_unwrapper.h"
+
+namespace rtp {
+
+// Counters of one NACK generator
+struct NackGeneratorStats {
+    uint64_t packets = 0;
+    uint64_t missing = 0;        // Sequence numbers found missing
+    uint64_t recovered = 0;      // Missing packets that arrived later
+    uint64_t requests = 0;       // Sequence numbers put into NACK items
+    uint64_t given_up = 0;       // Dropped after max_retries or leaving the window
+};
+
+// NackGenerator watches the sequence numbers received on one SSRC, ahead of
+// the jitter buffer and depacketizer, and builds Generic NACK feedback for
+// the missing ones. Missing packets are tracked in a bitmap over a power-of-
+// two window of sequence numbers, so OnPacket() does constant work for
+// in-order packets and never allocates. Each missing packet is requested
+// again once per RTT until it arrives or max_retries requests were sent.
+class NackGenerator {
+public:
+    // window is rounded up to a power of two, at least 64 and at most 32768
+    explicit NackGenerator(size_t window = 1024, int max_retries = 10);
+    ~NackGenerator() = default;
+
+    // Records a received RTP packet; returns false if it cannot be parsed
+    bool OnPacket(const uint8_t* rtp_packet, size_t size);
+
+    // Records a received sequence number
+    void OnPacket(uint16_t sequence_number);
+
+    // Round trip time used as the interval between requests for a packet
+    void SetRtt(int64_t rtt_ms) { rtt_ms_ = rtt_ms; }
+
+    // Fills items with the packets due for a request at now_ms, in sequence
+    // order, and marks them requested. Returns the number of items written.
+    size_t BuildNackItems(int64_t now_ms, NackItem* items, size_t max_items);
+
+    // Writes one RTCP Generic NACK packet covering every packet due at now_ms
+    // that fits in buf. Returns the packet size, or 0 if nothing is due.
+    size_t BuildNackPacket(int64_t now_ms, uint32_t sender_ssrc, uint8_t* buf, size_t buf_size);
+
+    // Forgets every missing packet and the sequence history
+    void Reset();
+
+    // Accessors
+    uint32_t media_ssrc() const { return media_ssrc_; }
+    size_t MissingCount() const { return missing_count_; }
+    const NackGeneratorStats& Stats() const { return stats_; }
+
+private:
+    bool IsMissing(size_t index) const { return (missing_[index >> 6] >> (index & 63)) & 1; }
+    void SetMissing(size_t index);
+    void ClearMissing(size_t index);
+
+    // Continues the walk over the window at *offset sequence numbers past
+    // its oldest one, adding to the count items already in items, until
+    // max_items are filled or the window ends; *offset is left where the
+    // walk stopped. Returns the new number of items.
+    size_t FillNackItems(int64_t now_ms, NackItem* items, size_t count, size_t max_items,
+                         size_t* offset);
+
+    std::vector<uint64_t> missing_;      // One bit per sequence number in the window
+    std::vector<uint8_t> retries_;       // Requests sent per window slot
+    std::vector<int64_t> last_sent_ms_;  // Time of the last request per slot
+    uint64_t mask_;
+    int max_retries_;
+    int64_t rtt_ms_ = 100;
+
+    SequenceNumberUnwrapper unwrapper_;
+    bool started_ = false;
+    int64_t newest_ = 0;
+    size_t missing_count_ = 0;
+    uint32_t media_ssrc_ = 0;
+
+    NackGeneratorStats stats_;
+};
+
+} // namespace rtp
+
+#endif // NACK_GENERATOR_H_
\ No newline at end of file
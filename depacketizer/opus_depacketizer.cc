@@ -17,19 +17,27 @@ bool OPUSDepacketizer::IsPartitionTail(bool marker, const std::vector<uint8_t>&
 }
 
 bool OPUSDepacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* opus_frame) {
-    if (rtp_packet.empty() || !opus_frame) {
+    return Depacketize(rtp_packet.data(), rtp_packet.size(), opus_frame);
+}
+
+bool OPUSDepacketizer::Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* opus_frame) {
+    if (size == 0 || !opus_frame) {
         return false;
     }
 
     // Parse the RTP packet
-    Packet packet;
-    if (!packet.Depacketize(rtp_packet)) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
+        return false;
+    }
+
+    // Opus has no payload header, the RTP payload is the Opus frame
+    if (packet.payload_size() == 0) {
         return false;
     }
 
-    // Extract the Opus payload
-    OpusPacket opus_packet;
-    return opus_packet.Unmarshal(packet.payload, opus_frame);
+    opus_frame->assign(packet.payload(), packet.payload() + packet.payload_size());
+    return true;
 }
 
 } // namespace rtp
\ No newline at end of file
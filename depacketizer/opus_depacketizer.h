@@ -28,6 +28,7 @@ public:
 
     // Depacketizer extracts the Opus payload from an RTP packet.
     bool Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* opus_frame);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* opus_frame);
 };
 
 } // namespace rtp
@@ -14,29 +14,38 @@ bool VP8Depacketizer::IsPartitionHead(const std::vector<uint8_t>& payload) {
     return vp8_packet_.IsPartitionHead(payload);
 }
 
+bool VP8Depacketizer::IsPartitionHead(const uint8_t* payload, size_t size) const {
+    return vp8_packet_.IsPartitionHead(payload, size);
+}
+
 bool VP8Depacketizer::IsPartitionTail(bool marker, const std::vector<uint8_t>& /*payload*/) {
     // In VP8, a partition tail is indicated by the RTP marker bit being set
     return marker;
 }
 
 bool VP8Depacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* vp8_frame) {
+    return Depacketize(rtp_packet.data(), rtp_packet.size(), vp8_frame);
+}
+
+bool VP8Depacketizer::Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* vp8_frame) {
     if (vp8_frame == nullptr) {
         return false;
     }
     
     // Parse the RTP packet
-    Packet packet;
-    if (!packet.Depacketize(rtp_packet)) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
         return false;
     }
     
-    // Process the payload to extract VP8 frame data
-    std::vector<uint8_t> frame_data = Process(packet.payload);
-    if (frame_data.empty()) {
+    // Parse the VP8 payload descriptor in place
+    size_t offset = 0;
+    if (!vp8_packet_.Unmarshal(packet.payload(), packet.payload_size(), &offset) ||
+        offset >= packet.payload_size()) {
         return false;
     }
     
-    *vp8_frame = std::move(frame_data);
+    vp8_frame->assign(packet.payload() + offset, packet.payload() + packet.payload_size());
     return true;
 }
 
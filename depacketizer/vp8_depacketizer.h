@@ -19,12 +19,14 @@ public:
     
     // Checks if the packet is at the beginning of a VP8 partition
     bool IsPartitionHead(const std::vector<uint8_t>& payload) override;
+    bool IsPartitionHead(const uint8_t* payload, size_t size) const;
     
     // Checks if the packet is at the end of a VP8 partition
     bool IsPartitionTail(bool marker, const std::vector<uint8_t>& payload) override;
     
     // Main depacketization function that unpacks RTP packet to VP8 frame
     bool Depacketize(const std::vector<uint8_t>& rtp_packet, std::vector<uint8_t>* vp8_frame);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, std::vector<uint8_t>* vp8_frame);
 
 private:
     VP8Packet vp8_packet_;
@@ -3,30 +3,34 @@
 namespace rtp {
 
 VP9Depacketizer::VP9Depacketizer() 
-    : vp9Packet_(std::make_unique<VP9Packet>()),
-      rtpPacket_(std::make_unique<Packet>()) {
+    : vp9Packet_(std::make_unique<VP9Packet>()) {
 }
 
 VP9Depacketizer::~VP9Depacketizer() = default;
 
 bool VP9Depacketizer::Depacketize(const std::vector<uint8_t>& rtpPacket, std::vector<uint8_t>* vp9Frame) {
-    if (rtpPacket.empty() || !vp9Frame) {
+    return Depacketize(rtpPacket.data(), rtpPacket.size(), vp9Frame);
+}
+
+bool VP9Depacketizer::Depacketize(const uint8_t* rtpPacket, size_t size, std::vector<uint8_t>* vp9Frame) {
+    if (size == 0 || !vp9Frame) {
         return false;
     }
     
     // Depacketize RTP packet
-    if (!rtpPacket_->Depacketize(rtpPacket)) {
+    PacketView packet;
+    if (!packet.Parse(rtpPacket, size)) {
         return false;
     }
     
-    // Parse VP9 specific payload
-    std::vector<uint8_t> payload;
-    if (!vp9Packet_->Unmarshal(rtpPacket_->payload, &payload)) {
+    // Parse VP9 specific payload descriptor in place
+    size_t offset = 0;
+    if (!vp9Packet_->Unmarshal(packet.payload(), packet.payload_size(), &offset)) {
         return false;
     }
     
     // Append to the VP9 frame
-    vp9Frame->insert(vp9Frame->end(), payload.begin(), payload.end());
+    vp9Frame->insert(vp9Frame->end(), packet.payload() + offset, packet.payload() + packet.payload_size());
     
     return true;
 }
@@ -36,7 +40,11 @@ bool VP9Depacketizer::IsPartitionHead(const std::vector<uint8_t>& payload) {
 }
 
 bool VP9Depacketizer::IsPartitionTail(bool marker, const std::vector<uint8_t>& payload) {
-    if (payload.empty()) {
+    return IsPartitionTail(marker, payload.data(), payload.size());
+}
+
+bool VP9Depacketizer::IsPartitionTail(bool marker, const uint8_t* payload, size_t size) {
+    if (size == 0) {
         return false;
     }
     
@@ -17,16 +17,17 @@ public:
     
     // Process depacketizes the RTP payload and returns VP9 frame
     bool Depacketize(const std::vector<uint8_t>& rtpPacket, std::vector<uint8_t>* vp9Frame);
+    bool Depacketize(const uint8_t* rtpPacket, size_t size, std::vector<uint8_t>* vp9Frame);
     
     // Checks if the packet contains the beginning of a VP9 partition
     bool IsPartitionHead(const std::vector<uint8_t>& payload);
     
     // Checks if the packet contains the end of a VP9 partition
     bool IsPartitionTail(bool marker, const std::vector<uint8_t>& payload);
+    bool IsPartitionTail(bool marker, const uint8_t* payload, size_t size);
 
 private:
     std::unique_ptr<VP9Packet> vp9Packet_;
-    std::unique_ptr<Packet> rtpPacket_;
 };
 
 } // namespace rtp
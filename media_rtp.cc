@@ -13,6 +13,10 @@
 #include "vp8_depacketizer.h"
 #include "vp9_packetizer.h"
 #include "vp9_depacketizer.h"
+#include "jitter_buffer.h"
+#include "frame_assembler.h"
+#include "nack_generator.h"
+#include "buffer_pool.h"
 
 namespace media {
 
@@ -25,18 +29,96 @@ public:
     virtual ~PacketizerImpl() = default;
     virtual bool Packetize(const std::vector<uint8_t>& frame, 
                         std::vector<std::vector<uint8_t>>* rtp_packets) = 0;
-    virtual void SetSSRC(uint32_t ssrc) = 0;
-    virtual void SetPayloadType(uint8_t payload_type) = 0;
-    virtual void SetTimestamp(uint32_t timestamp) = 0;
+    virtual bool Packetize(const uint8_t* frame, size_t size, 
+                        rtp::PacketWriter* rtp_packets) = 0;
+    
+    // RTP header state of the codec packetizer, every codec writes its
+    // headers from it
+    virtual rtp::StreamState& Stream() = 0;
+    
+    // Packet buffer reused by the PacketSink mode
+    std::vector<uint8_t>& SinkBuffer() { return sink_buffer_; }
+
+    // Spare bytes around each packet in the arena and sink modes
+    size_t Headroom() const { return headroom_; }
+    size_t Tailroom() const { return tailroom_; }
+    void SetHeadroom(size_t bytes) { headroom_ = bytes; }
+    void SetTailroom(size_t bytes) { tailroom_ = bytes; }
+
+private:
+    std::vector<uint8_t> sink_buffer_;
+    size_t headroom_ = 0;
+    size_t tailroom_ = 0;
+};
+
+// Forwards packets from the codec packetizers to the caller's sink
+class SinkAdapter : public rtp::PacketSink {
+public:
+    explicit SinkAdapter(media::PacketSink& sink) : sink_(sink) {}
+
+    bool OnPacket(const uint8_t* packet, size_t size) override {
+        return sink_.OnPacket(packet, size);
+    }
+
+    bool OnWritablePacket(uint8_t* packet, size_t size,
+                          size_t headroom, size_t tailroom) override {
+        return sink_.OnWritablePacket(packet, size, headroom, tailroom);
+    }
+
+private:
+    media::PacketSink& sink_;
 };
 
-class DepacketizerImpl {
+// Every codec depacketizer doubles as the codec hooks of its frame assembler
+class DepacketizerImpl : public rtp::FrameDepacketizer {
 public:
+    DepacketizerImpl() : assembler_(this) {}
     virtual ~DepacketizerImpl() = default;
     virtual bool Depacketize(const std::vector<uint8_t>& rtp_packet, 
                            std::vector<uint8_t>* out_frame) = 0;
-    virtual bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) = 0;
-    virtual bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) = 0;
+    virtual bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                           std::vector<uint8_t>* out_frame) = 0;
+
+    // Most codecs replace the output of Depacketize() with the media of one
+    // packet, so it is collected in a scratch buffer and appended
+    bool AppendFrameData(const rtp::PacketView& packet, std::vector<uint8_t>* frame) override {
+        packet_media_.clear();
+        if (!Depacketize(packet.data(), packet.size(), &packet_media_)) {
+            return false;
+        }
+        frame->insert(frame->end(), packet_media_.begin(), packet_media_.end());
+        return true;
+    }
+
+    // Codecs without state across packets have nothing to reset
+    void Reset() override {}
+
+    rtp::FrameAssembler& Assembler() { return assembler_; }
+
+private:
+    std::vector<uint8_t> packet_media_;
+    rtp::FrameAssembler assembler_;
+};
+
+// Forwards assembled frames to the caller's sink
+class FrameSinkAdapter : public rtp::FrameSink {
+public:
+    explicit FrameSinkAdapter(media::FrameSink& sink) : sink_(sink) {}
+
+    void OnFrame(const uint8_t* frame, size_t size, uint32_t timestamp) override {
+        sink_.OnFrame(frame, size, timestamp);
+    }
+
+    void OnFrameBuffer(rtp::PacketBuffer frame, uint32_t timestamp) override {
+        sink_.OnFrameBuffer(std::move(frame), timestamp);
+    }
+
+    void OnFrameDropped(uint32_t timestamp, rtp::FrameDropReason reason) override {
+        sink_.OnFrameDropped(timestamp, static_cast<media::FrameDropReason>(reason));
+    }
+
+private:
+    media::FrameSink& sink_;
 };
 
 // Implementation for AV1
@@ -50,16 +132,13 @@ public:
         return packetizer_.Packetize(frame, rtp_packets);
     }
 
-    void SetSSRC(uint32_t ssrc) override {
-        // Not implemented in AV1Packetizer
-    }
-
-    void SetPayloadType(uint8_t payload_type) override {
-        // Not implemented in AV1Packetizer
+    bool Packetize(const uint8_t* frame, size_t size, 
+                rtp::PacketWriter* rtp_packets) override {
+        return packetizer_.Packetize(frame, size, rtp_packets);
     }
 
-    void SetTimestamp(uint32_t timestamp) override {
-        // Not implemented in AV1Packetizer
+    rtp::StreamState& Stream() override {
+        return packetizer_.Stream();
     }
 
 private:
@@ -73,16 +152,31 @@ public:
 
     bool Depacketize(const std::vector<uint8_t>& rtp_packet, 
                    std::vector<uint8_t>* out_frame) override {
-        return depacketizer_.Depacketize(rtp_packet, out_frame);
+        return Depacketize(rtp_packet.data(), rtp_packet.size(), out_frame);
+    }
+
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                   std::vector<uint8_t>* out_frame) override {
+        // AV1Depacketizer works on the RTP payload
+        rtp::PacketView packet;
+        if (!packet.Parse(rtp_packet, size)) {
+            return false;
+        }
+        return depacketizer_.Depacketize(packet.payload(), packet.payload_size(), out_frame);
     }
 
-    bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) override {
-        return depacketizer_.IsPartitionHead(rtp_packet);
+    bool IsFrameStart(const rtp::PacketView& packet) override {
+        return depacketizer_.IsPartitionHead(packet.payload(), packet.payload_size());
     }
 
-    bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) override {
-        // AV1 doesn't have a specific IsPartitionTail method
-        return false;
+    bool IsFrameEnd(const rtp::PacketView& packet) override {
+        // AV1 doesn't have a specific IsPartitionTail method, the marker bit
+        // ends the temporal unit
+        return packet.marker();
+    }
+
+    void Reset() override {
+        depacketizer_.Reset();
     }
 
 private:
@@ -100,16 +194,13 @@ public:
         return packetizer_.Packetize(frame, rtp_packets);
     }
 
-    void SetSSRC(uint32_t ssrc) override {
-        // Not directly exposed in H264Packetizer
+    bool Packetize(const uint8_t* frame, size_t size, 
+                rtp::PacketWriter* rtp_packets) override {
+        return packetizer_.Packetize(frame, size, rtp_packets);
     }
 
-    void SetPayloadType(uint8_t payload_type) override {
-        // Not directly exposed in H264Packetizer
-    }
-
-    void SetTimestamp(uint32_t timestamp) override {
-        // Not directly exposed in H264Packetizer
+    rtp::StreamState& Stream() override {
+        return packetizer_.Stream();
     }
 
     void EnableStapA(bool enable) {
@@ -120,6 +211,10 @@ public:
         }
     }
 
+    bool SetNaluLengthSize(uint8_t length_size) {
+        return packetizer_.SetNaluLengthSize(length_size);
+    }
+
 private:
     rtp::H264Packetizer packetizer_;
 };
@@ -134,14 +229,29 @@ public:
         return depacketizer_.Depacketize(rtp_packet, out_frame);
     }
 
-    bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) override {
-        return depacketizer_.IsPartitionHead(rtp_packet);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                   std::vector<uint8_t>* out_frame) override {
+        return depacketizer_.Depacketize(rtp_packet, size, out_frame);
     }
 
-    bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) override {
-        // Use the marker bit to determine if it's the end
-        bool marker = true; // Extract marker bit from RTP packet
-        return depacketizer_.IsPartitionTail(marker, rtp_packet);
+    bool IsFrameStart(const rtp::PacketView& packet) override {
+        return rtp::H264Packet::IsPartitionHead(packet.payload(), packet.payload_size());
+    }
+
+    bool IsFrameEnd(const rtp::PacketView& packet) override {
+        // The marker bit ends the access unit, a fragmented NALU also needs
+        // its end fragment
+        return packet.marker() &&
+               rtp::H264Packet::IsPartitionTail(packet.marker(), packet.payload(), packet.payload_size());
+    }
+
+    // H.264 output is appended, so no scratch copy is needed
+    bool AppendFrameData(const rtp::PacketView& packet, std::vector<uint8_t>* frame) override {
+        return depacketizer_.Depacketize(packet.data(), packet.size(), frame);
+    }
+
+    void Reset() override {
+        depacketizer_.Reset();
     }
 
 private:
@@ -159,16 +269,13 @@ public:
         return packetizer_.Packetize(frame, rtp_packets);
     }
 
-    void SetSSRC(uint32_t ssrc) override {
-        packetizer_.WithSSRC(ssrc);
+    bool Packetize(const uint8_t* frame, size_t size, 
+                rtp::PacketWriter* rtp_packets) override {
+        return packetizer_.Packetize(frame, size, rtp_packets);
     }
 
-    void SetPayloadType(uint8_t payload_type) override {
-        packetizer_.WithPayloadType(payload_type);
-    }
-
-    void SetTimestamp(uint32_t timestamp) override {
-        packetizer_.WithTimestamp(timestamp);
+    rtp::StreamState& Stream() override {
+        return packetizer_.Stream();
     }
 
     void SetDONL(bool enable) {
@@ -179,6 +286,10 @@ public:
         packetizer_.WithSkipAggregation(value);
     }
 
+    bool SetNaluLengthSize(uint8_t length_size) {
+        return packetizer_.WithNaluLengthSize(length_size);
+    }
+
 private:
     rtp::H265Packetizer packetizer_;
 };
@@ -193,13 +304,37 @@ public:
         return depacketizer_.Depacketize(rtp_packet, out_frame);
     }
 
-    bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) override {
-        return depacketizer_.IsPartitionHead(rtp_packet);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                   std::vector<uint8_t>* out_frame) override {
+        return depacketizer_.Depacketize(rtp_packet, size, out_frame);
+    }
+
+    bool IsFrameStart(const rtp::PacketView& packet) override {
+        return depacketizer_.IsPartitionHead(packet.payload(), packet.payload_size());
+    }
+
+    bool IsFrameEnd(const rtp::PacketView& packet) override {
+        return packet.marker() &&
+               depacketizer_.IsPartitionTail(packet.marker(), packet.payload(), packet.payload_size());
     }
 
-    bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) override {
-        bool marker = true; // Extract marker bit from RTP packet
-        return depacketizer_.IsPartitionTail(marker, rtp_packet);
+    // H.265 depacketization yields bare NAL units, frames get Annex B start
+    // codes between them
+    bool AppendFrameData(const rtp::PacketView& packet, std::vector<uint8_t>* frame) override {
+        nalu_.clear();
+        if (!depacketizer_.Depacketize(packet.data(), packet.size(), &nalu_)) {
+            return false;
+        }
+        if (!nalu_.empty()) {
+            static const uint8_t kStartCode[] = {0x00, 0x00, 0x00, 0x01};
+            frame->insert(frame->end(), kStartCode, kStartCode + sizeof(kStartCode));
+            frame->insert(frame->end(), nalu_.begin(), nalu_.end());
+        }
+        return true;
+    }
+
+    void Reset() override {
+        depacketizer_.Reset();
     }
 
     void SetDONL(bool enable) {
@@ -208,6 +343,7 @@ public:
 
 private:
     rtp::H265Depacketizer depacketizer_;
+    std::vector<uint8_t> nalu_;
 };
 
 // Implementation for OPUS
@@ -221,22 +357,13 @@ public:
         return packetizer_.Packetize(frame, rtp_packets);
     }
 
-    void SetSSRC(uint32_t ssrc) override {
-        rtp::Header header = packetizer_.GetRTPHeader();
-        header.ssrc = ssrc;
-        packetizer_.SetRTPHeader(header);
+    bool Packetize(const uint8_t* frame, size_t size, 
+                rtp::PacketWriter* rtp_packets) override {
+        return packetizer_.Packetize(frame, size, rtp_packets);
     }
 
-    void SetPayloadType(uint8_t payload_type) override {
-        rtp::Header header = packetizer_.GetRTPHeader();
-        header.payload_type = payload_type;
-        packetizer_.SetRTPHeader(header);
-    }
-
-    void SetTimestamp(uint32_t timestamp) override {
-        rtp::Header header = packetizer_.GetRTPHeader();
-        header.timestamp = timestamp;
-        packetizer_.SetRTPHeader(header);
+    rtp::StreamState& Stream() override {
+        return packetizer_.Stream();
     }
 
 private:
@@ -253,13 +380,22 @@ public:
         return depacketizer_.Depacketize(rtp_packet, out_frame);
     }
 
-    bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) override {
-        return depacketizer_.IsPartitionHead(rtp_packet);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                   std::vector<uint8_t>* out_frame) override {
+        return depacketizer_.Depacketize(rtp_packet, size, out_frame);
+    }
+
+    // Every Opus packet carries one whole frame
+    bool IsFrameStart(const rtp::PacketView& /*packet*/) override {
+        return true;
+    }
+
+    bool HasFrameStartFlag() const override {
+        return true;
     }
 
-    bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) override {
-        bool marker = true; // Extract marker bit from RTP packet
-        return depacketizer_.IsPartitionTail(marker, rtp_packet);
+    bool IsFrameEnd(const rtp::PacketView& /*packet*/) override {
+        return true;
     }
 
 private:
@@ -277,16 +413,13 @@ public:
         return packetizer_.Packetize(frame, rtp_packets);
     }
 
-    void SetSSRC(uint32_t ssrc) override {
-        packetizer_.SetSSRC(ssrc);
-    }
-
-    void SetPayloadType(uint8_t payload_type) override {
-        packetizer_.SetPayloadType(payload_type);
+    bool Packetize(const uint8_t* frame, size_t size, 
+                rtp::PacketWriter* rtp_packets) override {
+        return packetizer_.Packetize(frame, size, rtp_packets);
     }
 
-    void SetTimestamp(uint32_t timestamp) override {
-        packetizer_.SetTimestamp(timestamp);
+    rtp::StreamState& Stream() override {
+        return packetizer_.Stream();
     }
 
     void EnablePictureID(bool enable) {
@@ -307,16 +440,28 @@ public:
         return depacketizer_.Depacketize(rtp_packet, out_frame);
     }
 
-    bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) override {
-        return depacketizer_.IsPartitionHead(rtp_packet);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                   std::vector<uint8_t>* out_frame) override {
+        return depacketizer_.Depacketize(rtp_packet, size, out_frame);
+    }
+
+    bool IsFrameStart(const rtp::PacketView& packet) override {
+        // A frame starts with the first packet of partition 0
+        return depacketizer_.IsPartitionHead(packet.payload(), packet.payload_size()) &&
+               (packet.payload()[0] & kVP8PartitionIDMask) == 0;
+    }
+
+    bool HasFrameStartFlag() const override {
+        return true;
     }
 
-    bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) override {
-        bool marker = true; // Extract marker bit from RTP packet
-        return depacketizer_.IsPartitionTail(marker, rtp_packet);
+    bool IsFrameEnd(const rtp::PacketView& packet) override {
+        return packet.marker();
     }
 
 private:
+    static constexpr uint8_t kVP8PartitionIDMask = 0x07;
+
     rtp::VP8Depacketizer depacketizer_;
 };
 
@@ -331,16 +476,13 @@ public:
         return packetizer_.Packetize(frame, rtp_packets);
     }
 
-    void SetSSRC(uint32_t ssrc) override {
-        // Not directly exposed in VP9Packetizer
-    }
-
-    void SetPayloadType(uint8_t payload_type) override {
-        // Not directly exposed in VP9Packetizer
+    bool Packetize(const uint8_t* frame, size_t size, 
+                rtp::PacketWriter* rtp_packets) override {
+        return packetizer_.Packetize(frame, size, rtp_packets);
     }
 
-    void SetTimestamp(uint32_t timestamp) override {
-        // Not directly exposed in VP9Packetizer
+    rtp::StreamState& Stream() override {
+        return packetizer_.Stream();
     }
 
     void SetInitialPictureID(uint16_t id) {
@@ -365,21 +507,50 @@ public:
         return depacketizer_.Depacketize(rtp_packet, out_frame);
     }
 
-    bool IsFrameStart(const std::vector<uint8_t>& rtp_packet) override {
-        return depacketizer_.IsPartitionHead(rtp_packet);
+    bool Depacketize(const uint8_t* rtp_packet, size_t size, 
+                   std::vector<uint8_t>* out_frame) override {
+        return depacketizer_.Depacketize(rtp_packet, size, out_frame);
+    }
+
+    bool IsFrameStart(const rtp::PacketView& packet) override {
+        return rtp::VP9Packet::IsPartitionHead(packet.payload(), packet.payload_size());
     }
 
-    bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet) override {
-        bool marker = true; // Extract marker bit from RTP packet
-        return depacketizer_.IsPartitionTail(marker, rtp_packet);
+    bool HasFrameStartFlag() const override {
+        return true;
+    }
+
+    bool IsFrameEnd(const rtp::PacketView& packet) override {
+        // The marker bit ends the superframe, the E bit only a layer frame
+        return packet.marker() &&
+               depacketizer_.IsPartitionTail(packet.marker(), packet.payload(), packet.payload_size());
+    }
+
+    // VP9 output is appended, so no scratch copy is needed
+    bool AppendFrameData(const rtp::PacketView& packet, std::vector<uint8_t>* frame) override {
+        return depacketizer_.Depacketize(packet.data(), packet.size(), frame);
     }
 
 private:
     rtp::VP9Depacketizer depacketizer_;
 };
 
+class JitterBufferImpl : public rtp::JitterBuffer {
+public:
+    using rtp::JitterBuffer::JitterBuffer;
+};
+
+class NackGeneratorImpl : public rtp::NackGenerator {
+public:
+    using rtp::NackGenerator::NackGenerator;
+};
+
 } // namespace internal
 
+void FrameSink::OnFrameBuffer(rtp::PacketBuffer frame, uint32_t timestamp) {
+    OnFrame(frame.data(), frame.size(), timestamp);
+}
+
 //----------------------------------------
 // RTPPacketizer Implementation
 //----------------------------------------
@@ -414,16 +585,92 @@ bool RTPPacketizer::Packetize(const std::vector<uint8_t>& frame,
     return impl_->Packetize(frame, rtp_packets);
 }
 
+bool RTPPacketizer::Packetize(const uint8_t* frame, size_t frame_size, 
+                             std::vector<uint8_t>* packet_data, 
+                             std::vector<size_t>* packet_offsets) {
+    if (packet_data == nullptr || packet_offsets == nullptr) {
+        return false;
+    }
+    
+    rtp::PacketArena arena(packet_data, packet_offsets, impl_->Headroom(), impl_->Tailroom());
+    if (!impl_->Packetize(frame, frame_size, &arena)) {
+        arena.Clear();
+        return false;
+    }
+    
+    return true;
+}
+
+bool RTPPacketizer::Packetize(const uint8_t* frame, size_t frame_size, PacketSink& sink) {
+    internal::SinkAdapter adapter(sink);
+    rtp::SinkWriter writer(&adapter, &impl_->SinkBuffer(), impl_->Headroom(), impl_->Tailroom());
+    return impl_->Packetize(frame, frame_size, &writer);
+}
+
+bool RTPPacketizer::Packetize(const std::vector<uint8_t>& frame, PacketSink& sink) {
+    return Packetize(frame.data(), frame.size(), sink);
+}
+
+bool RTPPacketizer::Packetize(const uint8_t* frame, size_t frame_size, rtp::BufferPool& pool,
+                             std::vector<rtp::PacketBuffer>* rtp_packets) {
+    if (rtp_packets == nullptr) {
+        return false;
+    }
+    
+    size_t count = rtp_packets->size();
+    rtp::PoolWriter writer(&pool, rtp_packets, impl_->Headroom(), impl_->Tailroom());
+    if (!impl_->Packetize(frame, frame_size, &writer)) {
+        rtp_packets->resize(count);
+        return false;
+    }
+    
+    return true;
+}
+
 void RTPPacketizer::SetSSRC(uint32_t ssrc) {
-    impl_->SetSSRC(ssrc);
+    impl_->Stream().SetSSRC(ssrc);
 }
 
 void RTPPacketizer::SetPayloadType(uint8_t payload_type) {
-    impl_->SetPayloadType(payload_type);
+    impl_->Stream().SetPayloadType(payload_type);
 }
 
 void RTPPacketizer::SetTimestamp(uint32_t timestamp) {
-    impl_->SetTimestamp(timestamp);
+    impl_->Stream().SetTimestamp(timestamp);
+}
+
+void RTPPacketizer::SetCSRCs(const std::vector<uint32_t>& csrcs) {
+    impl_->Stream().SetCSRCs(csrcs);
+}
+
+bool RTPPacketizer::AddHeaderExtension(uint8_t id, const std::vector<uint8_t>& value,
+                                       ExtensionPlacement placement) {
+    return impl_->Stream().AddExtension(id, value.data(), value.size(),
+                                        static_cast<rtp::ExtensionPlacement>(placement));
+}
+
+bool RTPPacketizer::SetHeaderExtensionValue(uint8_t id, const std::vector<uint8_t>& value) {
+    return impl_->Stream().SetExtensionValue(id, value.data(), value.size());
+}
+
+bool RTPPacketizer::SetTransportSequenceNumber(uint8_t id, std::shared_ptr<rtp::Sequencer> sequencer) {
+    return impl_->Stream().SetTransportSequenceNumber(id, std::move(sequencer));
+}
+
+bool RTPPacketizer::GetHeaderExtensionOffset(uint8_t id, size_t* offset, size_t* size) const {
+    return impl_->Stream().GetExtensionOffset(id, offset, size);
+}
+
+void RTPPacketizer::SetSrtpOverhead(size_t bytes) {
+    impl_->Stream().SetSrtpOverhead(bytes);
+}
+
+void RTPPacketizer::SetHeadroom(size_t bytes) {
+    impl_->SetHeadroom(bytes);
+}
+
+void RTPPacketizer::SetTailroom(size_t bytes) {
+    impl_->SetTailroom(bytes);
 }
 
 void RTPPacketizer::EnableStapA(bool enable) {
@@ -440,6 +687,16 @@ void RTPPacketizer::SetDONL(bool enable) {
     }
 }
 
+bool RTPPacketizer::SetNaluLengthSize(uint8_t length_size) {
+    if (auto* h264_impl = dynamic_cast<internal::H264PacketizerImpl*>(impl_.get())) {
+        return h264_impl->SetNaluLengthSize(length_size);
+    }
+    if (auto* h265_impl = dynamic_cast<internal::H265PacketizerImpl*>(impl_.get())) {
+        return h265_impl->SetNaluLengthSize(length_size);
+    }
+    return false;
+}
+
 void RTPPacketizer::EnablePictureID(bool enable) {
     auto* vp8_impl = dynamic_cast<internal::VP8PacketizerImpl*>(impl_.get());
     if (vp8_impl) {
@@ -495,12 +752,32 @@ bool RTPDepacketizer::Depacketize(const std::vector<uint8_t>& rtp_packet,
     return impl_->Depacketize(rtp_packet, out_frame);
 }
 
+bool RTPDepacketizer::Depacketize(const uint8_t* rtp_packet, size_t size, 
+                                 std::vector<uint8_t>* out_frame) {
+    return impl_->Depacketize(rtp_packet, size, out_frame);
+}
+
 bool RTPDepacketizer::IsFrameStart(const std::vector<uint8_t>& rtp_packet) {
-    return impl_->IsFrameStart(rtp_packet);
+    rtp::PacketView packet;
+    return packet.Parse(rtp_packet) && impl_->IsFrameStart(packet);
 }
 
 bool RTPDepacketizer::IsFrameEnd(const std::vector<uint8_t>& rtp_packet) {
-    return impl_->IsFrameEnd(rtp_packet);
+    rtp::PacketView packet;
+    return packet.Parse(rtp_packet) && impl_->IsFrameEnd(packet);
+}
+
+bool RTPDepacketizer::InsertPacket(const uint8_t* rtp_packet, size_t size, FrameSink& sink) {
+    internal::FrameSinkAdapter adapter(sink);
+    return impl_->Assembler().InsertPacket(rtp_packet, size, &adapter);
+}
+
+bool RTPDepacketizer::InsertPacket(const std::vector<uint8_t>& rtp_packet, FrameSink& sink) {
+    return InsertPacket(rtp_packet.data(), rtp_packet.size(), sink);
+}
+
+void RTPDepacketizer::SetBufferPool(rtp::BufferPool* pool) {
+    impl_->Assembler().SetBufferPool(pool);
 }
 
 void RTPDepacketizer::SetDONL(bool enable) {
@@ -510,6 +787,83 @@ void RTPDepacketizer::SetDONL(bool enable) {
     }
 }
 
+//----------------------------------------
+// JitterBuffer Implementation
+//----------------------------------------
+
+JitterBuffer::JitterBuffer(size_t capacity, int64_t max_latency_ms, size_t max_packet_size)
+    : impl_(std::make_unique<internal::JitterBufferImpl>(capacity, max_latency_ms, max_packet_size)) {
+}
+
+JitterBuffer::~JitterBuffer() = default;
+
+bool JitterBuffer::Insert(const uint8_t* rtp_packet, size_t size, int64_t now_ms) {
+    return impl_->Insert(rtp_packet, size, now_ms);
+}
+
+bool JitterBuffer::Insert(const std::vector<uint8_t>& rtp_packet, int64_t now_ms) {
+    return impl_->Insert(rtp_packet.data(), rtp_packet.size(), now_ms);
+}
+
+bool JitterBuffer::Pop(int64_t now_ms, const uint8_t** rtp_packet, size_t* size) {
+    if (!rtp_packet || !size) {
+        return false;
+    }
+    
+    rtp::JitterBufferPacket packet;
+    if (!impl_->Pop(now_ms, &packet)) {
+        return false;
+    }
+    
+    *rtp_packet = packet.data;
+    *size = packet.size;
+    return true;
+}
+
+size_t JitterBuffer::DrainTo(int64_t now_ms, RTPDepacketizer& depacketizer, FrameSink& sink) {
+    size_t count = 0;
+    rtp::JitterBufferPacket packet;
+    while (impl_->Pop(now_ms, &packet)) {
+        depacketizer.InsertPacket(packet.data, packet.size, sink);
+        count++;
+    }
+    return count;
+}
+
+size_t JitterBuffer::Size() const {
+    return impl_->Size();
+}
+
+//----------------------------------------
+// NackGenerator Implementation
+//----------------------------------------
+
+NackGenerator::NackGenerator(size_t window, int max_retries)
+    : impl_(std::make_unique<internal::NackGeneratorImpl>(window, max_retries)) {
+}
+
+NackGenerator::~NackGenerator() = default;
+
+bool NackGenerator::OnPacket(const uint8_t* rtp_packet, size_t size) {
+    return impl_->OnPacket(rtp_packet, size);
+}
+
+bool NackGenerator::OnPacket(const std::vector<uint8_t>& rtp_packet) {
+    return impl_->OnPacket(rtp_packet.data(), rtp_packet.size());
+}
+
+void NackGenerator::SetRtt(int64_t rtt_ms) {
+    impl_->SetRtt(rtt_ms);
+}
+
+size_t NackGenerator::BuildNackPacket(int64_t now_ms, uint32_t sender_ssrc, uint8_t* buf, size_t buf_size) {
+    return impl_->BuildNackPacket(now_ms, sender_ssrc, buf, buf_size);
+}
+
+size_t NackGenerator::MissingCount() const {
+    return impl_->MissingCount();
+}
+
 //----------------------------------------
 // Version Information
 //----------------------------------------
@@ -5,12 +5,20 @@
 #include <vector>
 #include <memory>
 
+namespace rtp {
+    class BufferPool;
+    class PacketBuffer;
+    class Sequencer;
+}
+
 namespace media {
 
 // Forward declarations for internal implementation classes
 namespace internal {
     class PacketizerImpl;
     class DepacketizerImpl;
+    class JitterBufferImpl;
+    class NackGeneratorImpl;
 }
 
 // Supported codecs
@@ -23,6 +31,67 @@ enum class Codec {
     VP9
 };
 
+/**
+ * PacketSink - Receives RTP packets one at a time as a frame is packetized
+ */
+class PacketSink {
+public:
+    virtual ~PacketSink() = default;
+
+    // Called for each packet as soon as it is built, in sending order
+    // The packet buffer is only valid for the duration of the call
+    // Return false to stop packetizing the rest of the frame
+    virtual bool OnPacket(const uint8_t* packet, size_t size) = 0;
+
+    // Called instead of OnPacket when the packetizer reserves headroom or
+    // tailroom: headroom bytes before packet and tailroom bytes after it
+    // belong to the same buffer and may be written, e.g. to add a length
+    // prefix or an SRTP tag in place. Defaults to OnPacket().
+    virtual bool OnWritablePacket(uint8_t* packet, size_t size,
+                                  size_t /*headroom*/, size_t /*tailroom*/) {
+        return OnPacket(packet, size);
+    }
+};
+
+/**
+ * FrameDropReason - Why an incomplete frame was dropped
+ */
+enum class FrameDropReason {
+    kSequenceGap,       // A packet inside the frame was lost
+    kMissingStart,      // The first packet of the frame was lost
+    kMissingEnd,        // The next frame began before this one ended
+    kDepacketizeError,  // A packet of the frame was malformed
+    kFrameTooLarge      // The frame exceeded the size limit
+};
+
+/**
+ * FrameSink - Receives frames assembled by an RTPDepacketizer
+ */
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    // Called with each complete frame; the buffer is only valid for the
+    // duration of the call
+    virtual void OnFrame(const uint8_t* frame, size_t size, uint32_t timestamp) = 0;
+
+    // Called instead of OnFrame when the depacketizer has a buffer pool; the
+    // refcounted buffer may be kept past the call. Defaults to OnFrame().
+    virtual void OnFrameBuffer(rtp::PacketBuffer frame, uint32_t timestamp);
+
+    // Called once for each incomplete frame that was dropped
+    virtual void OnFrameDropped(uint32_t /*timestamp*/, FrameDropReason /*reason*/) {}
+};
+
+/**
+ * ExtensionPlacement - Packets of a frame a header extension is written on
+ */
+enum class ExtensionPlacement {
+    kEveryPacket,
+    kFirstPacket,
+    kLastPacket
+};
+
 /**
  * RTPPacketizer - Packetizes codec frames into RTP packets
  */
@@ -37,16 +106,72 @@ public:
     bool Packetize(const std::vector<uint8_t>& frame, 
                    std::vector<std::vector<uint8_t>>* rtp_packets);
 
+    // Packetize a frame into caller-owned storage without per-packet allocation
+    // Packets are written back to back into packet_data; packet_offsets receives
+    // one entry per packet plus the end offset, so packet i spans
+    // [packet_offsets[i] + headroom, packet_offsets[i + 1] - tailroom), with
+    // the headroom and tailroom bytes around it free for the caller. Both
+    // containers keep their capacity across calls.
+    bool Packetize(const uint8_t* frame, size_t frame_size,
+                   std::vector<uint8_t>* packet_data,
+                   std::vector<size_t>* packet_offsets);
+
+    // Packetize a frame, handing each packet to the sink as soon as it is built
+    // Only one packet is held in memory at a time, so the first fragment of a
+    // large frame can be sent before the last one is produced
+    // Returns false on error or if the sink stopped packetization
+    bool Packetize(const uint8_t* frame, size_t frame_size, PacketSink& sink);
+    bool Packetize(const std::vector<uint8_t>& frame, PacketSink& sink);
+
+    // Packetize a frame into refcounted buffers drawn from pool (see
+    // buffer_pool.h), appended to rtp_packets with the configured headroom
+    // and tailroom around each packet. Clearing rtp_packets returns the
+    // buffers, so a steady stream of frames costs no heap allocation.
+    // On failure rtp_packets is left as it was.
+    bool Packetize(const uint8_t* frame, size_t frame_size, rtp::BufferPool& pool,
+                   std::vector<rtp::PacketBuffer>* rtp_packets);
+
     // Configuration methods
     void SetSSRC(uint32_t ssrc);
     void SetPayloadType(uint8_t payload_type);
     void SetTimestamp(uint32_t timestamp);
+    void SetCSRCs(const std::vector<uint32_t>& csrcs);
     
     // Codec-specific configuration
     
     // H264/H265 options
     void EnableStapA(bool enable); // H264-specific: combine SPS and PPS in STAP-A packets
     void SetDONL(bool enable);     // H265-specific: enable Decoding Order Number
+    
+    // H264/H265: frames hold length-prefixed NALUs (AVCC/HVCC) with 1, 2 or 4
+    // byte lengths instead of Annex B start codes; 0 restores Annex B
+    bool SetNaluLengthSize(uint8_t length_size);
+
+    // Header extensions written on every packet, or only on the first or
+    // last packet of each frame. Their size is taken off the payload budget
+    // up front; the value keeps its size once added.
+    bool AddHeaderExtension(uint8_t id, const std::vector<uint8_t>& value,
+                            ExtensionPlacement placement = ExtensionPlacement::kEveryPacket);
+    bool SetHeaderExtensionValue(uint8_t id, const std::vector<uint8_t>& value);
+
+    // Stamps a transport-wide sequence number (transport-cc) extension with
+    // the given id on every packet, numbered by a sequencer shared by every
+    // stream of the transport. A null sequencer removes it again.
+    bool SetTransportSequenceNumber(uint8_t id, std::shared_ptr<rtp::Sequencer> sequencer);
+
+    // Location of an extension value within every packet header, for
+    // patching send-time values or restamping retransmissions
+    bool GetHeaderExtensionOffset(uint8_t id, size_t* offset, size_t* size) const;
+
+    // Bytes SRTP appends to every packet (authentication tag and MKI),
+    // reserved in the payload budget
+    void SetSrtpOverhead(size_t bytes);
+
+    // Spare bytes kept in front of and behind every packet in the arena,
+    // sink and pool output buffers, so framing headers and SRTP tags can be
+    // added without copying the packet. Does not change the payload budget.
+    void SetHeadroom(size_t bytes);
+    void SetTailroom(size_t bytes);
 
     // VP8/VP9 options
     void EnablePictureID(bool enable);     // VP8-specific
@@ -71,12 +196,29 @@ public:
     bool Depacketize(const std::vector<uint8_t>& rtp_packet, 
                      std::vector<uint8_t>* out_frame);
 
+    // Depacketize an RTP packet held in any contiguous buffer
+    // out_frame is caller-owned and keeps its capacity across calls
+    bool Depacketize(const uint8_t* rtp_packet, size_t size,
+                     std::vector<uint8_t>* out_frame);
+
     // Returns true if this packet is the start of a new frame
     bool IsFrameStart(const std::vector<uint8_t>& rtp_packet);
 
     // Returns true if this packet is the end of a frame
     bool IsFrameEnd(const std::vector<uint8_t>& rtp_packet);
 
+    // Assemble frames from packets given in sequence order (for example from
+    // a JitterBuffer). Only complete frames reach the sink; a frame with a
+    // lost or malformed packet is dropped as a whole and reported with its
+    // reason. Returns false if the packet was ignored as malformed or stale.
+    bool InsertPacket(const uint8_t* rtp_packet, size_t size, FrameSink& sink);
+    bool InsertPacket(const std::vector<uint8_t>& rtp_packet, FrameSink& sink);
+
+    // Assembled frames are copied into buffers drawn from pool and handed to
+    // FrameSink::OnFrameBuffer(); null restores OnFrame(). The pool must
+    // outlive the depacketizer.
+    void SetBufferPool(rtp::BufferPool* pool);
+
     // Codec-specific configuration
     void SetDONL(bool enable); // H265-specific: Decoding Order Number present
 
@@ -84,6 +226,70 @@ private:
     std::unique_ptr<internal::DepacketizerImpl> impl_;
 };
 
+/**
+ * JitterBuffer - Reorders received RTP packets of one stream before they are
+ * passed to an RTPDepacketizer
+ */
+class JitterBuffer {
+public:
+    // capacity is rounded up to a power of two; a missing packet holds back
+    // later ones for at most max_latency_ms before it is given up on
+    explicit JitterBuffer(size_t capacity = 512, int64_t max_latency_ms = 100,
+                          size_t max_packet_size = 1500);
+    ~JitterBuffer();
+
+    // Store a received RTP packet; now_ms is its arrival time on any
+    // monotonic clock. Returns false if the packet was dropped as late,
+    // duplicate or malformed.
+    bool Insert(const uint8_t* rtp_packet, size_t size, int64_t now_ms);
+    bool Insert(const std::vector<uint8_t>& rtp_packet, int64_t now_ms);
+
+    // Get the next packet in sequence order if it is ready at now_ms
+    // The packet stays valid until the next Insert()
+    bool Pop(int64_t now_ms, const uint8_t** rtp_packet, size_t* size);
+
+    // Hand every packet that is ready at now_ms to the depacketizer's frame
+    // assembler in order, which delivers each completed frame to sink
+    // Returns the number of packets passed on
+    size_t DrainTo(int64_t now_ms, RTPDepacketizer& depacketizer, FrameSink& sink);
+
+    // Number of packets currently buffered
+    size_t Size() const;
+
+private:
+    std::unique_ptr<internal::JitterBufferImpl> impl_;
+};
+
+/**
+ * NackGenerator - Tracks the packets lost on one received stream and builds
+ * RTCP Generic NACK feedback (RFC 4585) asking for their retransmission
+ */
+class NackGenerator {
+public:
+    // Sequence numbers up to window (a power of two) behind the newest one
+    // are tracked; each is requested at most max_retries times
+    explicit NackGenerator(size_t window = 1024, int max_retries = 10);
+    ~NackGenerator();
+
+    // Record a received RTP packet before it goes to the JitterBuffer or
+    // RTPDepacketizer. Returns false if the packet is malformed.
+    bool OnPacket(const uint8_t* rtp_packet, size_t size);
+    bool OnPacket(const std::vector<uint8_t>& rtp_packet);
+
+    // Round trip time to wait before requesting a packet again
+    void SetRtt(int64_t rtt_ms);
+
+    // Write one RTCP NACK packet for every loss due at now_ms into buf
+    // Returns the packet size, or 0 if there is nothing to request
+    size_t BuildNackPacket(int64_t now_ms, uint32_t sender_ssrc, uint8_t* buf, size_t buf_size);
+
+    // Number of packets currently considered lost
+    size_t MissingCount() const;
+
+private:
+    std::unique_ptr<internal::NackGeneratorImpl> impl_;
+};
+
 // Library version information
 struct Version {
     int major;
@@ -0,0 +1,247 @@
+#include "annexb_scanner.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RTP_ANNEXB_SSE2 1
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RTP_ANNEXB_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define RTP_ANNEXB_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rtp {
+
+namespace {
+
+    inline unsigned CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    // Every start code ends in 0x01, so jump between 0x01 bytes with memchr
+    // and check the two bytes in front of each one
+    size_t FindStartCodeScalar(const uint8_t* data, size_t size, size_t from) {
+        size_t i = from + 2;
+        while (i < size) {
+            const void* hit = std::memchr(data + i, 1, size - i);
+            if (!hit) {
+                break;
+            }
+            
+            i = static_cast<const uint8_t*>(hit) - data;
+            if (data[i - 1] == 0 && data[i - 2] == 0) {
+                return i - 2;
+            }
+            i++;
+        }
+        return size;
+    }
+
+#if RTP_ANNEXB_SSE2
+    // Tests 16 candidate positions per step; each one needs 2 bytes of lookahead
+    size_t FindStartCodeSSE2(const uint8_t* data, size_t size, size_t from) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi8(1);
+        
+        size_t i = from;
+        while (i + 16 + 2 <= size) {
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+            __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+            
+            __m128i match = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+                _mm_cmpeq_epi8(b2, one));
+            
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+            if (mask != 0) {
+                return i + CountTrailingZeros(mask);
+            }
+            i += 16;
+        }
+        return FindStartCodeScalar(data, size, i);
+    }
+#endif
+
+#if RTP_ANNEXB_AVX2
+    __attribute__((target("avx2")))
+    size_t FindStartCodeAVX2(const uint8_t* data, size_t size, size_t from) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi8(1);
+        
+        size_t i = from;
+        while (i + 32 + 2 <= size) {
+            __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+            __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2));
+            
+            __m256i match = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)),
+                _mm256_cmpeq_epi8(b2, one));
+            
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+            if (mask != 0) {
+                return i + CountTrailingZeros(mask);
+            }
+            i += 32;
+        }
+        return FindStartCodeSSE2(data, size, i);
+    }
+#endif
+
+#if RTP_ANNEXB_NEON
+    size_t FindStartCodeNEON(const uint8_t* data, size_t size, size_t from) {
+        const uint8x16_t one = vdupq_n_u8(1);
+        
+        size_t i = from;
+        while (i + 16 + 2 <= size) {
+            uint8x16_t b0 = vld1q_u8(data + i);
+            uint8x16_t b1 = vld1q_u8(data + i + 1);
+            uint8x16_t b2 = vld1q_u8(data + i + 2);
+            
+            uint8x16_t match = vandq_u8(vandq_u8(vceqzq_u8(b0), vceqzq_u8(b1)), vceqq_u8(b2, one));
+            if (vmaxvq_u8(match) != 0) {
+                // NEON has no movemask, locate the hit within the block
+                for (size_t k = i; k < i + 16; k++) {
+                    if (data[k] == 0 && data[k + 1] == 0 && data[k + 2] == 1) {
+                        return k;
+                    }
+                }
+            }
+            i += 16;
+        }
+        return FindStartCodeScalar(data, size, i);
+    }
+#endif
+
+    using FindStartCodeFunc = size_t (*)(const uint8_t*, size_t, size_t);
+
+    // Picks the widest implementation the running CPU supports
+    FindStartCodeFunc SelectFindStartCode() {
+#if RTP_ANNEXB_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return FindStartCodeAVX2;
+        }
+#endif
+#if RTP_ANNEXB_SSE2
+        return FindStartCodeSSE2;
+#elif RTP_ANNEXB_NEON
+        return FindStartCodeNEON;
+#else
+        return FindStartCodeScalar;
+#endif
+    }
+}
+
+size_t FindStartCode(const uint8_t* data, size_t size, size_t from) {
+    static const FindStartCodeFunc find_start_code = SelectFindStartCode();
+    
+    if (!data || from >= size) {
+        return size;
+    }
+    return find_start_code(data, size, from);
+}
+
+bool NextNalu(const uint8_t* data, size_t size, size_t* pos, NaluRange* nalu) {
+    if (!data || !pos || !nalu || *pos >= size) {
+        return false;
+    }
+    
+    size_t start = *pos;
+    if (start == 0) {
+        start = FindStartCode(data, size, 0);
+        if (start == size) {
+            // No start code, the whole buffer is one NALU
+            nalu->offset = 0;
+            nalu->size = size;
+            *pos = size;
+            return true;
+        }
+    }
+    
+    // Skip the 3-byte start code
+    size_t begin = start + 3;
+    if (begin >= size) {
+        *pos = size;
+        return false;
+    }
+    
+    // The next NALU starts where this one ends
+    size_t next = FindStartCode(data, size, begin);
+    size_t end = next;
+    
+    // Check if the next NALU is actually a 4-byte start code
+    if (next < size && next > begin && data[next - 1] == 0) {
+        end--;
+    }
+    
+    nalu->offset = begin;
+    nalu->size = end - begin;
+    *pos = next;
+    return true;
+}
+
+void SplitNalus(const uint8_t* data, size_t size, std::vector<NaluRange>* nalus) {
+    if (!nalus) {
+        return;
+    }
+    
+    nalus->clear();
+    
+    size_t pos = 0;
+    NaluRange nalu;
+    while (NextNalu(data, size, &pos, &nalu)) {
+        nalus->push_back(nalu);
+    }
+}
+
+bool NextLengthPrefixedNalu(const uint8_t* data, size_t size, uint8_t length_size,
+                            size_t* pos, NaluRange* nalu) {
+    if (!data || !pos || !nalu || !IsValidNaluLengthSize(length_size)) {
+        return false;
+    }
+    
+    size_t start = *pos;
+    if (start >= size || size - start < length_size) {
+        return false;
+    }
+    
+    size_t nalu_size = 0;
+    for (uint8_t i = 0; i < length_size; i++) {
+        nalu_size = (nalu_size << 8) | data[start + i];
+    }
+    
+    size_t begin = start + length_size;
+    if (nalu_size > size - begin) {
+        return false;
+    }
+    
+    nalu->offset = begin;
+    nalu->size = nalu_size;
+    *pos = begin + nalu_size;
+    return true;
+}
+
+bool IsWellFormedLengthPrefixed(const uint8_t* data, size_t size, uint8_t length_size) {
+    size_t pos = 0;
+    NaluRange nalu;
+    while (NextLengthPrefixedNalu(data, size, length_size, &pos, &nalu)) {
+    }
+    return pos == size;
+}
+
+} // namespace rtp
\ No newline at end of file
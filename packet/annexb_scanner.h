@@ -0,0 +1,54 @@
+#ifndef ANNEXB_SCANNER_H_
+#define ANNEXB_SCANNER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace rtp {
+
+// NaluRange locates one NAL unit inside a frame buffer, start code or length
+// field excluded
+struct NaluRange {
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+// FindStartCode returns the offset of the first 00 00 01 start code at or
+// after from, or size if there is none. The scan uses AVX2, SSE2 or NEON when
+// the CPU has them and a memchr based scalar loop otherwise.
+size_t FindStartCode(const uint8_t* data, size_t size, size_t from);
+
+// NextNalu steps through the NAL units of an H.264/H.265 Annex B buffer in
+// place. *pos must be 0 for the first call and is advanced past the returned
+// NALU; returns false once the buffer is exhausted. Bytes before the first
+// start code are skipped, and a buffer without any start code is returned as
+// a single NALU. The leading zero of a 4-byte start code is not part of the
+// preceding NALU.
+bool NextNalu(const uint8_t* data, size_t size, size_t* pos, NaluRange* nalu);
+
+// SplitNalus replaces the contents of nalus with every NALU of the buffer
+void SplitNalus(const uint8_t* data, size_t size, std::vector<NaluRange>* nalus);
+
+// IsValidNaluLengthSize reports whether length_size is a supported AVCC/HVCC
+// length field size (1, 2 or 4 bytes)
+inline bool IsValidNaluLengthSize(uint8_t length_size) {
+    return length_size == 1 || length_size == 2 || length_size == 4;
+}
+
+// NextLengthPrefixedNalu steps through a buffer of NAL units each preceded by
+// a big-endian length field of length_size bytes (AVCC/HVCC). *pos must be 0
+// for the first call; returns false once the buffer is exhausted. A truncated
+// length field or NALU also returns false but leaves *pos before it, so the
+// buffer was well formed only if *pos == size afterwards.
+bool NextLengthPrefixedNalu(const uint8_t* data, size_t size, uint8_t length_size,
+                            size_t* pos, NaluRange* nalu);
+
+// IsWellFormedLengthPrefixed walks the length fields of an AVCC/HVCC buffer
+// once and reports whether they end exactly at size, so packetizers can reject
+// a truncated frame before writing any packet
+bool IsWellFormedLengthPrefixed(const uint8_t* data, size_t size, uint8_t length_size);
+
+} // namespace rtp
+
+#endif // ANNEXB_SCANNER_H_
\ No newline at end of file
@@ -7,7 +7,15 @@ bool ReadLeb128(const std::vector<uint8_t>& input,
                 size_t offset, 
                 uint32_t* value, 
                 size_t* bytes_read) {
-    if (offset >= input.size()) {
+    return ReadLeb128(input.data(), input.size(), offset, value, bytes_read);
+}
+
+bool ReadLeb128(const uint8_t* input, 
+                size_t size, 
+                size_t offset, 
+                uint32_t* value, 
+                size_t* bytes_read) {
+    if (offset >= size) {
         return false;
     }
     
@@ -15,7 +23,7 @@ bool ReadLeb128(const std::vector<uint8_t>& input,
     *bytes_read = 0;
     uint32_t shift = 0;
     
-    for (size_t i = offset; i < input.size(); i++) {
+    for (size_t i = offset; i < size; i++) {
         (*bytes_read)++;
         *value |= (input[i] & 0x7f) << shift;
         
@@ -53,6 +61,23 @@ std::vector<uint8_t> WriteToLeb128(uint32_t value) {
     return result;
 }
 
+size_t WriteToLeb128(uint32_t value, uint8_t* out) {
+    size_t n = 0;
+    
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        
+        if (value != 0) {
+            byte |= 0x80;  // Set the MSB if we have more bytes
+        }
+        
+        out[n++] = byte;
+    } while (value != 0);
+    
+    return n;
+}
+
 uint8_t AV1OBUHeader::ExtensionHeader::Marshal() const {
     return (temporal_id << 5) | ((spatial_id & 0x3) << 3) | (reserved_3bits & 0x07);
 }
@@ -61,7 +86,15 @@ bool AV1OBUHeader::Parse(const std::vector<uint8_t>& data,
                          size_t offset, 
                          AV1OBUHeader* header,
                          size_t* bytes_read) {
-    if (offset >= data.size()) {
+    return Parse(data.data(), data.size(), offset, header, bytes_read);
+}
+
+bool AV1OBUHeader::Parse(const uint8_t* data, 
+                         size_t size, 
+                         size_t offset, 
+                         AV1OBUHeader* header,
+                         size_t* bytes_read) {
+    if (offset >= size) {
         return false;
     }
     
@@ -80,7 +113,7 @@ bool AV1OBUHeader::Parse(const std::vector<uint8_t>& data,
     header->reserved_1bit = (header_byte & 0x01) != 0;
     
     if (extension_flag) {
-        if (offset + 1 >= data.size()) {
+        if (offset + 1 >= size) {
             return false;
         }
         
@@ -124,6 +157,30 @@ std::vector<uint8_t> AV1OBUHeader::Marshal() const {
     return result;
 }
 
+size_t AV1OBUHeader::MarshalTo(uint8_t* out) const {
+    uint8_t header_byte = static_cast<uint8_t>(type << 3);
+    
+    if (extension_header) {
+        header_byte |= 0x04;
+    }
+    
+    if (has_size_field) {
+        header_byte |= 0x02;
+    }
+    
+    if (reserved_1bit) {
+        header_byte |= 0x01;
+    }
+    
+    out[0] = header_byte;
+    
+    if (extension_header) {
+        out[1] = extension_header->Marshal();
+    }
+    
+    return Size();
+}
+
 size_t AV1OBUHeader::Size() const {
     return 1 + (extension_header ? 1 : 0);
 }
@@ -28,10 +28,18 @@ bool ReadLeb128(const std::vector<uint8_t>& input,
                 size_t offset, 
                 uint32_t* value, 
                 size_t* bytes_read);
+bool ReadLeb128(const uint8_t* input, 
+                size_t size, 
+                size_t offset, 
+                uint32_t* value, 
+                size_t* bytes_read);
 
 // Write a value as LEB128 encoding
 std::vector<uint8_t> WriteToLeb128(uint32_t value);
 
+// Write a value as LEB128 encoding into out, returns the number of bytes written (at most 5)
+size_t WriteToLeb128(uint32_t value, uint8_t* out);
+
 class AV1OBUHeader {
 public:
     // OBU types
@@ -62,9 +70,17 @@ public:
                       size_t offset, 
                       AV1OBUHeader* header, 
                       size_t* bytes_read);
+    static bool Parse(const uint8_t* data, 
+                      size_t size, 
+                      size_t offset, 
+                      AV1OBUHeader* header, 
+                      size_t* bytes_read);
                       
     // Serialize the OBU header
     std::vector<uint8_t> Marshal() const;
+
+    // Serialize the OBU header into out, returns Size()
+    size_t MarshalTo(uint8_t* out) const;
     
     // Get header size in bytes
     size_t Size() const;
@@ -0,0 +1,358 @@
+#include "buffer_pool.h"
+#include <algorithm>
+#include <mutex>
+#include <new>
+
+namespace rtp {
+
+namespace {
+
+// Size class index of blocks allocated straight from the heap
+constexpr uint32_t kHeapSizeClass = kBufferSizeClassCount;
+
+// Bytes carved from the heap at once when a size class runs dry
+constexpr size_t kSlabSize = 512 * 1024;
+
+// Slab blocks are padded to whole cache lines so neighbouring buffers
+// written by different threads do not share one
+constexpr size_t kBlockAlignment = 64;
+
+constexpr size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+uint32_t SizeClassFor(size_t size) {
+    for (uint32_t i = 0; i < kBufferSizeClassCount; i++) {
+        if (size <= kBufferSizeClasses[i]) {
+            return i;
+        }
+    }
+    return kHeapSizeClass;
+}
+
+} // namespace
+
+// Block header in front of the buffer bytes
+struct BufferPool::Block {
+    State* state;
+    std::atomic<uint32_t> references;
+    uint32_t size_class;
+    size_t capacity;
+    Block* next;
+
+    uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+};
+
+// Shared pool state; thread caches only hold weak references, so the state
+// goes away with the pool and caches of exited pools are simply dropped
+struct BufferPool::State : public std::enable_shared_from_this<BufferPool::State> {
+    explicit State(size_t cache_size) : thread_cache_size(std::max<size_t>(cache_size, 2)) {}
+
+    ~State() {
+        for (uint8_t* slab : slabs) {
+            ::operator delete(slab);
+        }
+    }
+
+    size_t thread_cache_size;
+
+    std::mutex mutex;
+    Block* free_lists[kBufferSizeClassCount] = {};
+    std::vector<uint8_t*> slabs;
+
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> heap_allocations{0};
+    uint64_t slab_count = 0;
+    uint64_t slab_bytes = 0;
+
+    // Carves a new slab of size_class onto its free list, called locked
+    void Grow(uint32_t size_class) {
+        size_t stride = AlignUp(sizeof(Block) + kBufferSizeClasses[size_class], kBlockAlignment);
+        size_t count = std::max<size_t>(kSlabSize / stride, 1);
+        uint8_t* slab = static_cast<uint8_t*>(::operator new(stride * count));
+        slabs.push_back(slab);
+        slab_count++;
+        slab_bytes += stride * count;
+
+        for (size_t i = 0; i < count; i++) {
+            Block* block = new (slab + i * stride) Block();
+            block->state = this;
+            block->size_class = size_class;
+            block->capacity = kBufferSizeClasses[size_class];
+            block->next = free_lists[size_class];
+            free_lists[size_class] = block;
+        }
+    }
+};
+
+// Free lists of one thread for one pool
+struct BufferPool::ThreadCache {
+    State* state = nullptr;
+    std::weak_ptr<State> owner;
+    std::vector<Block*> blocks[kBufferSizeClassCount];
+
+    ~ThreadCache() {
+        // Hand the cached blocks back if the pool still exists
+        std::shared_ptr<State> alive = owner.lock();
+        if (!alive) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(alive->mutex);
+        for (uint32_t i = 0; i < kBufferSizeClassCount; i++) {
+            for (Block* block : blocks[i]) {
+                block->next = alive->free_lists[i];
+                alive->free_lists[i] = block;
+            }
+        }
+    }
+
+    // Moves blocks between the thread and the pool so the cache ends up half
+    // full, which keeps a thread alternating around the limit off the lock.
+    // The pool grows by at most one slab per refill, so large size classes
+    // do not carve more buffers than are in use.
+    void Refill(uint32_t size_class) {
+        std::vector<Block*>& cache = blocks[size_class];
+        std::lock_guard<std::mutex> lock(state->mutex);
+        size_t wanted = state->thread_cache_size / 2;
+        while (cache.size() < wanted) {
+            if (!state->free_lists[size_class]) {
+                if (!cache.empty()) {
+                    break;
+                }
+                state->Grow(size_class);
+            }
+            Block* block = state->free_lists[size_class];
+            state->free_lists[size_class] = block->next;
+            cache.push_back(block);
+        }
+    }
+
+    void Drain(uint32_t size_class) {
+        std::vector<Block*>& cache = blocks[size_class];
+        std::lock_guard<std::mutex> lock(state->mutex);
+        size_t keep = state->thread_cache_size / 2;
+        while (cache.size() > keep) {
+            Block* block = cache.back();
+            cache.pop_back();
+            block->next = state->free_lists[size_class];
+            state->free_lists[size_class] = block;
+        }
+    }
+};
+
+BufferPool::BufferPool(size_t thread_cache_size)
+    : state_(std::make_shared<State>(thread_cache_size)) {
+}
+
+BufferPool::~BufferPool() = default;
+
+BufferPool::ThreadCache* BufferPool::LocalCache(State* state) {
+    thread_local std::vector<std::unique_ptr<ThreadCache>> caches;
+
+    for (size_t i = 0; i < caches.size(); i++) {
+        ThreadCache* cache = caches[i].get();
+        if (cache->state != state) {
+            continue;
+        }
+        if (!cache->owner.expired()) {
+            return cache;
+        }
+        // A destroyed pool left its cache behind at the same address
+        caches.erase(caches.begin() + i);
+        break;
+    }
+
+    // Drop the caches of any other destroyed pools while at it
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [](const std::unique_ptr<ThreadCache>& cache) {
+                                    return cache->owner.expired();
+                                }),
+                 caches.end());
+
+    std::unique_ptr<ThreadCache> cache(new ThreadCache());
+    cache->state = state;
+    cache->owner = state->shared_from_this();
+    for (auto& blocks : cache->blocks) {
+        blocks.reserve(state->thread_cache_size);
+    }
+    caches.push_back(std::move(cache));
+    return caches.back().get();
+}
+
+BufferPool::Block* BufferPool::Pop(State* state, size_t size_class) {
+    ThreadCache* cache = LocalCache(state);
+    std::vector<Block*>& blocks = cache->blocks[size_class];
+    if (blocks.empty()) {
+        cache->Refill(static_cast<uint32_t>(size_class));
+    }
+    Block* block = blocks.back();
+    blocks.pop_back();
+    return block;
+}
+
+void BufferPool::Release(Block* block) {
+    if (block->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if (block->size_class == kHeapSizeClass) {
+        block->~Block();
+        ::operator delete(block);
+        return;
+    }
+
+    ThreadCache* cache = LocalCache(block->state);
+    std::vector<Block*>& blocks = cache->blocks[block->size_class];
+    blocks.push_back(block);
+    if (blocks.size() >= block->state->thread_cache_size) {
+        cache->Drain(block->size_class);
+    }
+}
+
+PacketBuffer BufferPool::Allocate(size_t size, size_t headroom, size_t tailroom) {
+    size_t capacity = headroom + size + tailroom;
+    uint32_t size_class = SizeClassFor(capacity);
+    state_->allocations.fetch_add(1, std::memory_order_relaxed);
+
+    Block* block;
+    if (size_class == kHeapSizeClass) {
+        state_->heap_allocations.fetch_add(1, std::memory_order_relaxed);
+        block = new (::operator new(sizeof(Block) + capacity)) Block();
+        block->state = state_.get();
+        block->size_class = kHeapSizeClass;
+        block->capacity = capacity;
+        block->next = nullptr;
+    } else {
+        block = Pop(state_.get(), size_class);
+    }
+
+    block->references.store(1, std::memory_order_relaxed);
+    return PacketBuffer(block, headroom, size);
+}
+
+BufferPoolStats BufferPool::Stats() const {
+    BufferPoolStats stats;
+    stats.allocations = state_->allocations.load(std::memory_order_relaxed);
+    stats.heap_allocations = state_->heap_allocations.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    stats.slabs = state_->slab_count;
+    stats.slab_bytes = state_->slab_bytes;
+    return stats;
+}
+
+// PacketBuffer implementation
+PacketBuffer::PacketBuffer(const PacketBuffer& other)
+    : block_(other.block_), offset_(other.offset_), size_(other.size_) {
+    if (block_) {
+        block_->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept
+    : block_(other.block_), offset_(other.offset_), size_(other.size_) {
+    other.block_ = nullptr;
+    other.offset_ = 0;
+    other.size_ = 0;
+}
+
+PacketBuffer& PacketBuffer::operator=(const PacketBuffer& other) {
+    if (this != &other) {
+        if (other.block_) {
+            other.block_->references.fetch_add(1, std::memory_order_relaxed);
+        }
+        Reset();
+        block_ = other.block_;
+        offset_ = other.offset_;
+        size_ = other.size_;
+    }
+    return *this;
+}
+
+PacketBuffer& PacketBuffer::operator=(PacketBuffer&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        block_ = other.block_;
+        offset_ = other.offset_;
+        size_ = other.size_;
+        other.block_ = nullptr;
+        other.offset_ = 0;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+PacketBuffer::~PacketBuffer() {
+    Reset();
+}
+
+uint8_t* PacketBuffer::data() {
+    return block_ ? block_->data() + offset_ : nullptr;
+}
+
+const uint8_t* PacketBuffer::data() const {
+    return block_ ? block_->data() + offset_ : nullptr;
+}
+
+size_t PacketBuffer::capacity() const {
+    return block_ ? block_->capacity : 0;
+}
+
+bool PacketBuffer::Prepend(size_t bytes) {
+    if (bytes > headroom()) {
+        return false;
+    }
+    offset_ -= bytes;
+    size_ += bytes;
+    return true;
+}
+
+bool PacketBuffer::Append(size_t bytes) {
+    if (bytes > tailroom()) {
+        return false;
+    }
+    size_ += bytes;
+    return true;
+}
+
+bool PacketBuffer::SetRange(size_t offset, size_t size) {
+    if (offset > capacity() || size > capacity() - offset) {
+        return false;
+    }
+    offset_ = offset;
+    size_ = size;
+    return true;
+}
+
+bool PacketBuffer::unique() const {
+    return block_ && block_->references.load(std::memory_order_acquire) == 1;
+}
+
+void PacketBuffer::Reset() {
+    if (block_) {
+        BufferPool::Release(block_);
+    }
+    block_ = nullptr;
+    offset_ = 0;
+    size_ = 0;
+}
+
+// PoolWriter implementation
+PoolWriter::PoolWriter(BufferPool* pool, std::vector<PacketBuffer>* packets,
+                       size_t headroom, size_t tailroom)
+    : pool_(pool), packets_(packets), headroom_(headroom), tailroom_(tailroom) {}
+
+uint8_t* PoolWriter::Begin(size_t max_size) {
+    current_ = pool_->Allocate(max_size, headroom_, tailroom_);
+    return current_.data();
+}
+
+bool PoolWriter::Commit(size_t size) {
+    if (!current_.SetRange(headroom_, size)) {
+        return false;
+    }
+    packets_->push_back(std::move(current_));
+    return true;
+}
+
+} // namespace rtp
@@ -0,0 +1,142 @@
+#ifndef BUFFER_POOL_H_
+#define BUFFER_POOL_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "rtp_packet.h"
+
+namespace rtp {
+
+class PacketBuffer;
+
+// Buffer capacities the pool hands out; larger requests fall back to a plain
+// heap allocation per buffer
+constexpr size_t kBufferSizeClasses[] = {256, 2048, 16384, 131072};
+constexpr size_t kBufferSizeClassCount = sizeof(kBufferSizeClasses) / sizeof(kBufferSizeClasses[0]);
+
+// Counters of one buffer pool
+struct BufferPoolStats {
+    uint64_t allocations = 0;       // Buffers handed out
+    uint64_t heap_allocations = 0;  // Buffers too large for any size class
+    uint64_t slabs = 0;             // Slabs carved into pooled buffers
+    uint64_t slab_bytes = 0;
+};
+
+// BufferPool hands out refcounted packet buffers carved from large slabs,
+// one free list per size class. Every thread keeps a small free list of its
+// own per pool, so allocating and releasing buffers only takes the pool lock
+// to move a batch between the thread and the pool. Slabs are never returned
+// to the heap, so once the pool has grown to its working set, allocating
+// costs no heap allocation. The pool must outlive every buffer drawn from it.
+class BufferPool {
+public:
+    // thread_cache_size is the most buffers of one size class a thread keeps
+    // before handing half of them back to the pool
+    explicit BufferPool(size_t thread_cache_size = 64);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Returns a buffer of size bytes with at least headroom bytes in front
+    // and tailroom bytes behind it; the contents are uninitialized
+    PacketBuffer Allocate(size_t size, size_t headroom = 0, size_t tailroom = 0);
+
+    BufferPoolStats Stats() const;
+
+private:
+    friend class PacketBuffer;
+
+    struct Block;
+    struct State;
+    struct ThreadCache;
+
+    // The calling thread's free lists for state, created on first use
+    static ThreadCache* LocalCache(State* state);
+
+    // Pops a block of the size class, refilling the thread from the pool
+    static Block* Pop(State* state, size_t size_class);
+
+    // Drops one reference and recycles the block with the last one
+    static void Release(Block* block);
+
+    std::shared_ptr<State> state_;
+};
+
+// PacketBuffer is a refcounted handle to a pooled buffer. Copies share the
+// bytes, while each handle keeps its own data range, so the spare bytes
+// around the range can be claimed with Prepend() and Append() to add
+// framing headers or SRTP tags without moving the packet.
+class PacketBuffer {
+public:
+    PacketBuffer() = default;
+    PacketBuffer(const PacketBuffer& other);
+    PacketBuffer(PacketBuffer&& other) noexcept;
+    PacketBuffer& operator=(const PacketBuffer& other);
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept;
+    ~PacketBuffer();
+
+    bool empty() const { return block_ == nullptr; }
+
+    // Data range
+    uint8_t* data();
+    const uint8_t* data() const;
+    size_t size() const { return size_; }
+
+    // Whole buffer and the spare bytes on either side of the data range
+    size_t capacity() const;
+    size_t headroom() const { return offset_; }
+    size_t tailroom() const { return capacity() - offset_ - size_; }
+
+    // Grows the data range into the headroom or tailroom
+    // Returns false if there is not enough room
+    bool Prepend(size_t bytes);
+    bool Append(size_t bytes);
+
+    // Moves the data range within the buffer
+    bool SetRange(size_t offset, size_t size);
+
+    // Whether this is the only handle to the buffer, so it may be modified
+    // without affecting other holders
+    bool unique() const;
+
+    // Releases the buffer
+    void Reset();
+
+private:
+    friend class BufferPool;
+
+    PacketBuffer(BufferPool::Block* block, size_t offset, size_t size)
+        : block_(block), offset_(offset), size_(size) {}
+
+    BufferPool::Block* block_ = nullptr;
+    size_t offset_ = 0;
+    size_t size_ = 0;
+};
+
+// PoolWriter serializes every packet into its own pooled buffer and appends
+// the handles to packets, keeping headroom and tailroom spare bytes around
+// each packet. Clearing packets returns the buffers to the pool.
+class PoolWriter : public PacketWriter {
+public:
+    PoolWriter(BufferPool* pool, std::vector<PacketBuffer>* packets,
+               size_t headroom = 0, size_t tailroom = 0);
+
+    // PacketWriter
+    uint8_t* Begin(size_t max_size) override;
+    bool Commit(size_t size) override;
+
+private:
+    BufferPool* pool_;
+    std::vector<PacketBuffer>* packets_;
+    size_t headroom_;
+    size_t tailroom_;
+    PacketBuffer current_;
+};
+
+} // namespace rtp
+
+#endif // BUFFER_POOL_H_
\ No newline at end of file
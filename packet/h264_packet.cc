@@ -7,7 +7,11 @@ namespace rtp {
 H264Packet::H264Packet() = default;
 
 bool H264Packet::IsPartitionHead(const std::vector<uint8_t>& payload) {
-    if (payload.size() < 2) {
+    return IsPartitionHead(payload.data(), payload.size());
+}
+
+bool H264Packet::IsPartitionHead(const uint8_t* payload, size_t size) {
+    if (size < 2) {
         return false;
     }
 
@@ -20,7 +24,11 @@ bool H264Packet::IsPartitionHead(const std::vector<uint8_t>& payload) {
 }
 
 bool H264Packet::IsPartitionTail(bool marker, const std::vector<uint8_t>& payload) {
-    if (payload.size() < 2) {
+    return IsPartitionTail(marker, payload.data(), payload.size());
+}
+
+bool H264Packet::IsPartitionTail(bool marker, const uint8_t* payload, size_t size) {
+    if (size < 2) {
         return false;
     }
 
@@ -32,96 +40,51 @@ bool H264Packet::IsPartitionTail(bool marker, const std::vector<uint8_t>& payloa
     return marker;
 }
 
-void H264Packet::EmitNalus(const std::vector<uint8_t>& data, 
-                         std::function<void(const std::vector<uint8_t>&)> emit_func) {
-    // Look for 3-byte NALU start code
-    size_t start = 0;
-    size_t offset = kNaluStartCode.size();
-    size_t length = data.size();
-
-    auto find_subsequence = [](auto begin, auto end, auto s_begin, auto s_end) {
-        auto it = std::search(begin, end, s_begin, s_end);
-        if (it != end) {
-            return std::distance(begin, it);
-        }
-        return std::distance(begin, end); // Changed -1 to return consistent type
-    };
-
-    auto start_pos = find_subsequence(data.begin(), data.end(), 
-                                    kNaluStartCode.begin(), kNaluStartCode.end());
-    
-    if (start_pos == std::distance(data.begin(), data.end())) { // Changed comparison
-        // No start code, emit the whole buffer
-        emit_func(data);
-        return;
-    }
-
-    start = start_pos;
-
-    while (start < length) {
-        // Look for the next NALU start (end of this NALU)
-        auto end_pos = std::distance(data.begin(), data.end()); // Changed initialization
-        if (start + offset < length) {
-            end_pos = find_subsequence(data.begin() + start + offset, data.end(),
-                                      kNaluStartCode.begin(), kNaluStartCode.end());
-        }
-
-        if (end_pos == std::distance(data.begin() + start + offset, data.end())) { // Changed comparison
-            // No more NALUs, emit the rest of the buffer
-            std::vector<uint8_t> nalu(data.begin() + start + offset, data.end());
-            emit_func(nalu);
-            break;
-        }
-
-        // Next NALU start
-        size_t next_start = start + offset + end_pos;
-
-        // Check if the next NALU is actually a 4-byte start code
-        bool end_is_4_byte = (next_start > 0 && data[next_start - 1] == 0);
-        if (end_is_4_byte) {
-            next_start--;
-        }
-
-        std::vector<uint8_t> nalu(data.begin() + start + offset, data.begin() + next_start);
-        emit_func(nalu);
-
-        start = next_start;
-
-        if (end_is_4_byte) {
-            offset = 4;
-        } else {
-            offset = 3;
-        }
+void H264Packet::EmitNalus(const uint8_t* data, size_t size,
+                         const std::function<void(const uint8_t*, size_t)>& emit_func) {
+    size_t pos = 0;
+    NaluRange nalu;
+    while (NextNalu(data, size, &pos, &nalu)) {
+        emit_func(data + nalu.offset, nalu.size);
     }
 }
 
-std::vector<uint8_t> H264Packet::DoPackaging(const std::vector<uint8_t>& nalu) const {
-    std::vector<uint8_t> result;
-    
+void H264Packet::DoPackaging(const uint8_t* nalu, size_t size, std::vector<uint8_t>* out) const {
     if (is_avc_) {
         // Add AVC length prefix (4 bytes)
-        uint32_t nalu_size = htonl(static_cast<uint32_t>(nalu.size()));
+        uint32_t nalu_size = htonl(static_cast<uint32_t>(size));
         const uint8_t* size_bytes = reinterpret_cast<const uint8_t*>(&nalu_size);
-        result.insert(result.end(), size_bytes, size_bytes + 4);
-        result.insert(result.end(), nalu.begin(), nalu.end());
+        out->insert(out->end(), size_bytes, size_bytes + 4);
     } else {
         // Add Annex B start code
-        result.insert(result.end(), kAnnexbNALUStartCode.begin(), kAnnexbNALUStartCode.end());
-        result.insert(result.end(), nalu.begin(), nalu.end());
+        out->insert(out->end(), kAnnexbNALUStartCode.begin(), kAnnexbNALUStartCode.end());
     }
-    
-    return result;
+    out->insert(out->end(), nalu, nalu + size);
 }
 
-std::string GetH264ErrorMessage(H264ErrorCode code) {
+const char* GetH264ErrorMessage(H264ErrorCode code) {
     switch (code) {
         case kShortPacket:
             return "H264 packet too short";
         case kUnhandledNALUType:
             return "Unhandled NALU type";
+        case kStapATruncated:
+            return "STAP-A declared size larger than buffer";
+        case kFuaFragmentLost:
+            return "FU-A fragment lost";
+        case kInvalidRtpPacket:
+            return "Invalid RTP packet";
         default:
             return "Unknown H264 error";
     }
 }
 
+uint64_t H264DepacketizerStats::TotalErrors() const {
+    uint64_t total = 0;
+    for (uint64_t count : errors) {
+        total += count;
+    }
+    return total;
+}
+
 } // namespace rtp
\ No newline at end of file
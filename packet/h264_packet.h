@@ -8,6 +8,7 @@
 #include <functional>  // Added this include for std::function
 
 #include "rtp_packet.h"
+#include "annexb_scanner.h"
 
 namespace rtp {
 
@@ -45,14 +46,16 @@ public:
     // Utility functions
     static bool IsPartitionHead(const std::vector<uint8_t>& payload);
     static bool IsPartitionTail(bool marker, const std::vector<uint8_t>& payload);
+    static bool IsPartitionHead(const uint8_t* payload, size_t size);
+    static bool IsPartitionTail(bool marker, const uint8_t* payload, size_t size);
 
 protected:
     // Helper function to find NAL units in a buffer
-    static void EmitNalus(const std::vector<uint8_t>& data, 
-                         std::function<void(const std::vector<uint8_t>&)> emit_func);
+    static void EmitNalus(const uint8_t* data, size_t size,
+                         const std::function<void(const uint8_t*, size_t)>& emit_func);
     
-    // Helper to package NALU with/without AVC format
-    std::vector<uint8_t> DoPackaging(const std::vector<uint8_t>& nalu) const;
+    // Helper to append a NALU with/without AVC format to the output
+    void DoPackaging(const uint8_t* nalu, size_t size, std::vector<uint8_t>* out) const;
 
     bool is_avc_ = false;
 };
@@ -60,10 +63,24 @@ protected:
 // Error codes and messages
 enum H264ErrorCode {
     kShortPacket,
-    kUnhandledNALUType
+    kUnhandledNALUType,
+    kStapATruncated,      // STAP-A unit length runs past the end of the payload
+    kFuaFragmentLost,     // FU-A fragment without its start or predecessor
+    kInvalidRtpPacket,    // RTP header or padding does not parse
+    kH264ErrorCodeCount
 };
 
-std::string GetH264ErrorMessage(H264ErrorCode code);
+// Returns a static description of code, never allocates
+const char* GetH264ErrorMessage(H264ErrorCode code);
+
+// H264DepacketizerStats counts the packets one depacketizer has seen and the
+// ones it rejected, per error code
+struct H264DepacketizerStats {
+    uint64_t packets = 0;
+    uint64_t errors[kH264ErrorCodeCount] = {};
+    
+    uint64_t TotalErrors() const;
+};
 
 } // namespace rtp
 
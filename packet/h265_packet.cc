@@ -560,7 +560,11 @@ void H265Packet::WithDONL(bool value) {
 }
 
 bool H265Packet::IsPartitionHead(const std::vector<uint8_t>& payload) const {
-    if (payload.size() < 3) {
+    return IsPartitionHead(payload.data(), payload.size());
+}
+
+bool H265Packet::IsPartitionHead(const uint8_t* payload, size_t size) const {
+    if (size < 3) {
         return false;
     }
 
@@ -201,6 +201,7 @@ public:
     void WithDONL(bool value);
     
     bool IsPartitionHead(const std::vector<uint8_t>& payload) const;
+    bool IsPartitionHead(const uint8_t* payload, size_t size) const;
     
     enum class PacketType {
         SingleNALU,
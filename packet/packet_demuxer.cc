@@ -0,0 +1,349 @@
+#include "packet_demuxer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RTP_DEMUX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <xmmintrin.h>
+#endif
+
+namespace rtp {
+
+namespace {
+
+    constexpr size_t kClassCount = static_cast<size_t>(PacketClass::kRtcp) + 1;
+
+    // Shortest valid datagram of each class: STUN and RTP fixed headers, a
+    // DTLS record header, the ChannelData header and an RTCP header with
+    // its SSRC
+    constexpr size_t kMinimumSize[kClassCount] = {
+        ~size_t(0),     // kGarbage
+        20,             // kStun
+        13,             // kDtls
+        4,              // kTurnChannel
+        12,             // kRtp
+        8               // kRtcp
+    };
+
+    // RFC 5761 RTCP packet types that share the second byte with RTP
+    constexpr uint8_t kFirstRtcpType = 200;
+    constexpr uint8_t kRtcpTypeCount = 12;
+
+    // RFC 7983 ranges of the first byte; RTP stands for RTP and RTCP
+    struct FirstByteTable {
+        PacketClass classes[256];
+
+        FirstByteTable() {
+            for (int b = 0; b < 256; b++) {
+                PacketClass type = PacketClass::kGarbage;
+                if (b <= 3) {
+                    type = PacketClass::kStun;
+                } else if (b >= 20 && b <= 63) {
+                    type = PacketClass::kDtls;
+                } else if (b >= 64 && b <= 79) {
+                    type = PacketClass::kTurnChannel;
+                } else if (b >= 128 && b <= 191) {
+                    type = PacketClass::kRtp;
+                }
+                classes[b] = type;
+            }
+        }
+    };
+
+    const FirstByteTable kFirstByte;
+
+    inline PacketClass Classify(const uint8_t* data, size_t size) {
+        if (size < 2) {
+            return PacketClass::kGarbage;
+        }
+        uint8_t type = static_cast<uint8_t>(kFirstByte.classes[data[0]]);
+
+        // RTCP follows RTP in the enum
+        bool rtcp = static_cast<uint8_t>(data[1] - kFirstRtcpType) < kRtcpTypeCount;
+        type = static_cast<uint8_t>(type + (type == static_cast<uint8_t>(PacketClass::kRtp) && rtcp));
+
+        return size >= kMinimumSize[type] ? static_cast<PacketClass>(type) : PacketClass::kGarbage;
+    }
+
+    // SSRC of an RTP or RTCP packet classified as such
+    inline uint32_t ReadSsrc(const uint8_t* data, PacketClass type) {
+        const uint8_t* ssrc = data + (type == PacketClass::kRtp ? 8 : 4);
+        return (uint32_t(ssrc[0]) << 24) | (uint32_t(ssrc[1]) << 16) |
+               (uint32_t(ssrc[2]) << 8) | uint32_t(ssrc[3]);
+    }
+
+    inline bool HasSsrc(PacketClass type) {
+        return type == PacketClass::kRtp || type == PacketClass::kRtcp;
+    }
+
+    // Murmur3 finalizer; SSRCs are random but need not be
+    inline uint32_t HashSsrc(uint32_t ssrc) {
+        ssrc ^= ssrc >> 16;
+        ssrc *= 0x85ebca6b;
+        ssrc ^= ssrc >> 13;
+        ssrc *= 0xc2b2ae35;
+        ssrc ^= ssrc >> 16;
+        return ssrc;
+    }
+
+    inline unsigned CountTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    inline void PrefetchLine(const void* address) {
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // Batch slice whose buckets are prefetched together
+    constexpr size_t kPrefetchBatch = 32;
+}
+
+PacketClass ClassifyPacket(const uint8_t* data, size_t size) {
+    return Classify(data, size);
+}
+
+// SsrcMap
+
+SsrcMap::SsrcMap(size_t expected_streams) {
+    Rehash(1);
+    Reserve(expected_streams);
+}
+
+size_t SsrcMap::HomeBucket(uint32_t ssrc) const {
+    return HashSsrc(ssrc) & bucket_mask_;
+}
+
+void SsrcMap::Reserve(size_t count) {
+    size_t bucket_count = buckets_.size();
+    while (count * 8 > bucket_count * kBucketSlots * 7) {
+        bucket_count *= 2;
+    }
+    if (bucket_count != buckets_.size()) {
+        Rehash(bucket_count);
+    }
+}
+
+void SsrcMap::Rehash(size_t bucket_count) {
+    std::vector<Bucket> old;
+    old.swap(buckets_);
+
+    Bucket empty;
+    for (size_t slot = 0; slot < kBucketSlots; slot++) {
+        empty.ssrcs[slot] = 0;
+        empty.streams[slot] = kNoStream;
+    }
+    buckets_.assign(bucket_count, empty);
+    bucket_mask_ = bucket_count - 1;
+    size_ = 0;
+
+    for (const Bucket& bucket : old) {
+        for (size_t slot = 0; slot < kBucketSlots; slot++) {
+            if (bucket.streams[slot] != kNoStream) {
+                Insert(bucket.ssrcs[slot], bucket.streams[slot]);
+            }
+        }
+    }
+}
+
+void SsrcMap::Clear() {
+    for (Bucket& bucket : buckets_) {
+        for (size_t slot = 0; slot < kBucketSlots; slot++) {
+            bucket.streams[slot] = kNoStream;
+        }
+    }
+    size_ = 0;
+}
+
+uint32_t SsrcMap::Find(uint32_t ssrc) const {
+    size_t index = HomeBucket(ssrc);
+#if RTP_DEMUX_SSE2
+    const __m128i key = _mm_set1_epi32(static_cast<int>(ssrc));
+    const __m128i none = _mm_set1_epi32(-1);
+#endif
+    for (;;) {
+        // Compare the whole bucket at once: slots holding ssrc, and free slots
+        const Bucket& bucket = buckets_[index];
+        unsigned match = 0;
+        unsigned empty = 0;
+#if RTP_DEMUX_SSE2
+        for (size_t half = 0; half < kBucketSlots; half += 4) {
+            __m128i ssrcs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bucket.ssrcs + half));
+            __m128i streams = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bucket.streams + half));
+            match |= unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(ssrcs, key)))) << half;
+            empty |= unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(streams, none)))) << half;
+        }
+#else
+        for (size_t slot = 0; slot < kBucketSlots; slot++) {
+            match |= unsigned(bucket.ssrcs[slot] == ssrc) << slot;
+            empty |= unsigned(bucket.streams[slot] == kNoStream) << slot;
+        }
+#endif
+        match &= ~empty;
+        if (match) {
+            return bucket.streams[CountTrailingZeros(match)];
+        }
+        // An SSRC only spills past full buckets
+        if (empty) {
+            return kNoStream;
+        }
+        index = (index + 1) & bucket_mask_;
+    }
+}
+
+void SsrcMap::Prefetch(uint32_t ssrc) const {
+    PrefetchLine(&buckets_[HomeBucket(ssrc)]);
+}
+
+bool SsrcMap::Insert(uint32_t ssrc, uint32_t stream) {
+    if (stream == kNoStream) {
+        return false;
+    }
+
+    // Replace an existing mapping, else take the first free slot on the path
+    size_t index = HomeBucket(ssrc);
+    Bucket* free_bucket = nullptr;
+    size_t free_slot = 0;
+    for (;;) {
+        Bucket& bucket = buckets_[index];
+        bool full = true;
+        for (size_t slot = 0; slot < kBucketSlots; slot++) {
+            if (bucket.streams[slot] == kNoStream) {
+                if (full) {
+                    free_bucket = &bucket;
+                    free_slot = slot;
+                }
+                full = false;
+            } else if (bucket.ssrcs[slot] == ssrc) {
+                bucket.streams[slot] = stream;
+                return true;
+            }
+        }
+        if (!full) {
+            break;
+        }
+        index = (index + 1) & bucket_mask_;
+    }
+
+    free_bucket->ssrcs[free_slot] = ssrc;
+    free_bucket->streams[free_slot] = stream;
+    size_++;
+    if (size_ * 8 > buckets_.size() * kBucketSlots * 7) {
+        Rehash(buckets_.size() * 2);
+    }
+    return true;
+}
+
+bool SsrcMap::Erase(uint32_t ssrc) {
+    size_t index = HomeBucket(ssrc);
+    size_t slot = kBucketSlots;
+    for (;;) {
+        Bucket& bucket = buckets_[index];
+        bool full = true;
+        for (size_t i = 0; i < kBucketSlots; i++) {
+            if (bucket.streams[i] == kNoStream) {
+                full = false;
+            } else if (bucket.ssrcs[i] == ssrc) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < kBucketSlots) {
+            break;
+        }
+        if (!full) {
+            return false;
+        }
+        index = (index + 1) & bucket_mask_;
+    }
+
+    buckets_[index].streams[slot] = kNoStream;
+    size_--;
+
+    // Lookups stop at the first bucket with a free slot, so move back every
+    // SSRC further along whose probe path now ends at the hole
+    size_t hole = index;
+    size_t hole_slot = slot;
+    size_t next = (hole + 1) & bucket_mask_;
+    for (;;) {
+        Bucket& bucket = buckets_[next];
+        bool full = true;
+        bool moved = false;
+        for (size_t i = 0; i < kBucketSlots; i++) {
+            if (bucket.streams[i] == kNoStream) {
+                full = false;
+                continue;
+            }
+            size_t distance = (next - HomeBucket(bucket.ssrcs[i])) & bucket_mask_;
+            if (distance >= ((next - hole) & bucket_mask_)) {
+                buckets_[hole].ssrcs[hole_slot] = bucket.ssrcs[i];
+                buckets_[hole].streams[hole_slot] = bucket.streams[i];
+                bucket.streams[i] = kNoStream;
+                hole = next;
+                hole_slot = i;
+                moved = true;
+                break;
+            }
+        }
+        if (!moved && !full) {
+            break;
+        }
+        next = (next + 1) & bucket_mask_;
+    }
+    return true;
+}
+
+// PacketDemuxer
+
+PacketDemuxer::PacketDemuxer(size_t expected_streams) : streams_(expected_streams) {}
+
+DemuxedPacket PacketDemuxer::Demux(const uint8_t* data, size_t size) const {
+    DemuxedPacket packet;
+    packet.data = data;
+    packet.size = size;
+    packet.type = Classify(data, size);
+    if (HasSsrc(packet.type)) {
+        packet.stream = streams_.Find(ReadSsrc(data, packet.type));
+    }
+    return packet;
+}
+
+size_t PacketDemuxer::Demux(DemuxedPacket* packets, size_t count) const {
+    size_t routed = 0;
+    for (size_t begin = 0; begin < count; begin += kPrefetchBatch) {
+        size_t end = count - begin < kPrefetchBatch ? count : begin + kPrefetchBatch;
+
+        // Classify the slice and start loading its buckets
+        for (size_t i = begin; i < end; i++) {
+            DemuxedPacket& packet = packets[i];
+            packet.type = Classify(packet.data, packet.size);
+            packet.stream = SsrcMap::kNoStream;
+            if (HasSsrc(packet.type)) {
+                streams_.Prefetch(ReadSsrc(packet.data, packet.type));
+            }
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            DemuxedPacket& packet = packets[i];
+            if (HasSsrc(packet.type)) {
+                packet.stream = streams_.Find(ReadSsrc(packet.data, packet.type));
+                routed += packet.stream != SsrcMap::kNoStream;
+            }
+        }
+    }
+    return routed;
+}
+
+} // namespace rtp
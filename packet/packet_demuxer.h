@@ -0,0 +1,110 @@
+#ifndef PACKET_DEMUXER_H_
+#define PACKET_DEMUXER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace rtp {
+
+// Protocol of a datagram received on a socket shared by RTP, RTCP, STUN,
+// DTLS and TURN (RFC 7983 and RFC 5761)
+enum class PacketClass : uint8_t {
+    kGarbage = 0,       // Unknown first byte or too short for its protocol
+    kStun,              // First byte 0-3
+    kDtls,              // First byte 20-63
+    kTurnChannel,       // TURN ChannelData, first byte 64-79
+    kRtp,               // Version 2, payload type not in the RTCP range
+    kRtcp               // Version 2, packet type 200-211
+};
+
+// Classifies a datagram from its first two bytes with two table lookups
+// and a length check
+PacketClass ClassifyPacket(const uint8_t* data, size_t size);
+
+// SsrcMap maps SSRCs to stream indices. It is an open-addressing table of
+// 64-byte buckets holding eight SSRCs and their streams each, so a lookup
+// usually touches a single cache line; a full bucket spills into the next
+// one. Buckets are kept at most 7/8 full, which is 512 KiB for 50k SSRCs.
+class SsrcMap {
+public:
+    static constexpr uint32_t kNoStream = 0xFFFFFFFF;
+
+    explicit SsrcMap(size_t expected_streams = 64);
+    ~SsrcMap() = default;
+
+    // Maps ssrc to stream, replacing an existing mapping
+    // Returns false if stream is kNoStream
+    bool Insert(uint32_t ssrc, uint32_t stream);
+    bool Erase(uint32_t ssrc);
+    void Clear();
+
+    // Grows the table to hold count SSRCs without rehashing
+    void Reserve(size_t count);
+
+    // Stream of ssrc, or kNoStream
+    uint32_t Find(uint32_t ssrc) const;
+
+    // Hints the bucket of ssrc into the cache ahead of Find()
+    void Prefetch(uint32_t ssrc) const;
+
+    size_t Size() const { return size_; }
+
+private:
+    static constexpr size_t kBucketSlots = 8;
+
+    // One cache line; an empty slot has stream kNoStream
+    struct alignas(64) Bucket {
+        uint32_t ssrcs[kBucketSlots];
+        uint32_t streams[kBucketSlots];
+    };
+    static_assert(sizeof(Bucket) == 64, "a bucket must fill one cache line");
+
+    size_t HomeBucket(uint32_t ssrc) const;
+    void Rehash(size_t bucket_count);
+
+    std::vector<Bucket> buckets_;
+    size_t bucket_mask_ = 0;
+    size_t size_ = 0;
+};
+
+// A datagram for PacketDemuxer::Demux(); the caller sets data and size,
+// the demuxer fills in type and stream
+struct DemuxedPacket {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    PacketClass type = PacketClass::kGarbage;
+    uint32_t stream = SsrcMap::kNoStream;
+};
+
+// PacketDemuxer sorts datagrams from a shared socket by protocol and routes
+// RTP and RTCP to the stream registered for their SSRC, e.g. as an index
+// into the RTPDepacketizer of each received stream. RTCP is routed by the
+// SSRC of its first packet's sender.
+class PacketDemuxer {
+public:
+    explicit PacketDemuxer(size_t expected_streams = 64);
+    ~PacketDemuxer() = default;
+
+    // Streams by SSRC
+    bool AddStream(uint32_t ssrc, uint32_t stream) { return streams_.Insert(ssrc, stream); }
+    bool RemoveStream(uint32_t ssrc) { return streams_.Erase(ssrc); }
+    uint32_t FindStream(uint32_t ssrc) const { return streams_.Find(ssrc); }
+    size_t StreamCount() const { return streams_.Size(); }
+
+    // Classifies one datagram and finds its stream
+    DemuxedPacket Demux(const uint8_t* data, size_t size) const;
+
+    // Classifies count datagrams in place. The stream buckets of the whole
+    // batch are prefetched before the first lookup, so large tables cost
+    // about one memory latency per batch. Returns the number of RTP and
+    // RTCP packets that have a stream.
+    size_t Demux(DemuxedPacket* packets, size_t count) const;
+
+private:
+    SsrcMap streams_;
+};
+
+} // namespace rtp
+
+#endif // PACKET_DEMUXER_H_
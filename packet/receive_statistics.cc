@@ -0,0 +1,128 @@
+#include "receive_statistics.h"
+#include "rtp_packet.h"
+
+namespace rtp {
+
+ReceiveStatistics::ReceiveStatistics(uint32_t ssrc, uint32_t clock_rate)
+    : ssrc_(ssrc), clock_rate_(clock_rate) {
+}
+
+bool ReceiveStatistics::OnPacket(const uint8_t* rtp_packet, size_t size, int64_t now_ms) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
+        return false;
+    }
+    
+    if (!started_) {
+        ssrc_ = packet.ssrc();
+    }
+    OnPacket(packet.sequence_number(), packet.timestamp(), now_ms);
+    return true;
+}
+
+void ReceiveStatistics::OnPacket(uint16_t sequence_number, uint32_t rtp_timestamp, int64_t now_ms) {
+    int64_t seq = unwrapper_.Unwrap(sequence_number);
+    received_++;
+    
+    bool in_order = !started_ || seq > max_seq_;
+    if (!started_) {
+        started_ = true;
+        base_seq_ = seq;
+        expected_prior_ = 0;
+        received_prior_ = 0;
+    }
+    if (!in_order) {
+        // Reordered and retransmitted packets count as received but would
+        // distort the jitter estimate
+        return;
+    }
+    max_seq_ = seq;
+    
+    // Interarrival jitter (RFC 3550 section 6.4.1), in timestamp units
+    uint32_t arrival = static_cast<uint32_t>(now_ms * clock_rate_ / 1000);
+    uint32_t transit = arrival - rtp_timestamp;
+    if (has_transit_) {
+        int32_t d = static_cast<int32_t>(transit - last_transit_);
+        if (d < 0) {
+            d = -d;
+        }
+        jitter_q4_ += d - ((jitter_q4_ + 8) >> 4);
+    }
+    last_transit_ = transit;
+    has_transit_ = true;
+}
+
+void ReceiveStatistics::OnSenderReport(uint32_t ntp_seconds, uint32_t ntp_fraction, int64_t now_ms) {
+    last_sr_ = (ntp_seconds << 16) | (ntp_fraction >> 16);
+    last_sr_time_ms_ = now_ms;
+}
+
+bool ReceiveStatistics::BuildReportBlock(int64_t now_ms, ReportBlock* block) {
+    if (!block || !started_) {
+        return false;
+    }
+    
+    // Loss over the interval since the previous report (RFC 3550 A.3)
+    int64_t expected = max_seq_ - base_seq_ + 1;
+    int64_t expected_interval = expected - expected_prior_;
+    int64_t received_interval = static_cast<int64_t>(received_ - received_prior_);
+    int64_t lost_interval = expected_interval - received_interval;
+    expected_prior_ = expected;
+    received_prior_ = received_;
+    
+    uint8_t fraction_lost = 0;
+    if (expected_interval > 0 && lost_interval > 0) {
+        int64_t fraction = (lost_interval << 8) / expected_interval;
+        fraction_lost = static_cast<uint8_t>(fraction > 255 ? 255 : fraction);
+    }
+    
+    int64_t lost = cumulative_lost();
+    if (lost > 0x7FFFFF) {
+        lost = 0x7FFFFF;
+    } else if (lost < -0x800000) {
+        lost = -0x800000;
+    }
+    
+    block->ssrc = ssrc_;
+    block->fraction_lost = fraction_lost;
+    block->cumulative_lost = static_cast<int32_t>(lost);
+    block->extended_highest_sequence_number = extended_highest_sequence_number();
+    block->jitter = jitter();
+    block->last_sr = 0;
+    block->delay_since_last_sr = 0;
+    if (last_sr_time_ms_ >= 0) {
+        block->last_sr = last_sr_;
+        // DLSR is expressed in units of 1/65536 seconds
+        block->delay_since_last_sr = static_cast<uint32_t>((now_ms - last_sr_time_ms_) * 65536 / 1000);
+    }
+    return true;
+}
+
+void ReceiveStatistics::Reset() {
+    unwrapper_.Reset();
+    started_ = false;
+    base_seq_ = 0;
+    max_seq_ = 0;
+    received_ = 0;
+    expected_prior_ = 0;
+    received_prior_ = 0;
+    has_transit_ = false;
+    last_transit_ = 0;
+    jitter_q4_ = 0;
+    last_sr_ = 0;
+    last_sr_time_ms_ = -1;
+}
+
+int64_t ReceiveStatistics::cumulative_lost() const {
+    if (!started_) {
+        return 0;
+    }
+    
+    return (max_seq_ - base_seq_ + 1) - static_cast<int64_t>(received_);
+}
+
+uint32_t ReceiveStatistics::extended_highest_sequence_number() const {
+    return static_cast<uint32_t>(max_seq_);
+}
+
+} // namespace rtp
\ No newline at end of file
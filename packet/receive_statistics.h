@@ -0,0 +1,70 @@
+#ifndef RECEIVE_STATISTICS_H_
+#define RECEIVE_STATISTICS_H_
+
+#include <cstdint>
+#include "rtcp_packet.h"
+#include "sequence_unwrapper.h"
+
+namespace rtp {
+
+// ReceiveStatistics keeps the RFC 3550 reception statistics of one source:
+// extended highest sequence number, cumulative and interval loss, and the
+// interarrival jitter. OnPacket() does a constant amount of integer work;
+// jitter is kept in 1/16 timestamp units as in RFC 3550 appendix A.8.
+class ReceiveStatistics {
+public:
+    // clock_rate is the RTP timestamp rate of the source in Hz
+    explicit ReceiveStatistics(uint32_t ssrc = 0, uint32_t clock_rate = 90000);
+    ~ReceiveStatistics() = default;
+
+    // Records a received RTP packet; now_ms is its arrival time on any
+    // monotonic clock. Returns false if the packet cannot be parsed.
+    bool OnPacket(const uint8_t* rtp_packet, size_t size, int64_t now_ms);
+
+    // Records a received packet from its header fields
+    void OnPacket(uint16_t sequence_number, uint32_t rtp_timestamp, int64_t now_ms);
+
+    // Records the NTP time of a sender report of this source, for the LSR
+    // and DLSR fields of the next report block
+    void OnSenderReport(uint32_t ntp_seconds, uint32_t ntp_fraction, int64_t now_ms);
+
+    // Fills a report block and starts a new loss interval
+    // Returns false if no packet has been received yet
+    bool BuildReportBlock(int64_t now_ms, ReportBlock* block);
+
+    // Forgets all statistics
+    void Reset();
+
+    // Accessors
+    uint32_t ssrc() const { return ssrc_; }
+    uint64_t packets_received() const { return received_; }
+    int64_t cumulative_lost() const;
+    uint32_t extended_highest_sequence_number() const;
+    uint32_t jitter() const { return jitter_q4_ >> 4; }
+
+private:
+    uint32_t ssrc_;
+    uint32_t clock_rate_;
+    SequenceNumberUnwrapper unwrapper_;
+    bool started_ = false;
+
+    // Loss
+    int64_t base_seq_ = 0;
+    int64_t max_seq_ = 0;
+    uint64_t received_ = 0;
+    int64_t expected_prior_ = 0;
+    uint64_t received_prior_ = 0;
+
+    // Jitter
+    bool has_transit_ = false;
+    uint32_t last_transit_ = 0;
+    uint32_t jitter_q4_ = 0;
+
+    // Last sender report
+    uint32_t last_sr_ = 0;
+    int64_t last_sr_time_ms_ = -1;
+};
+
+} // namespace rtp
+
+#endif // RECEIVE_STATISTICS_H_
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "roq_framing.h"
+#include <utility>
+
+namespace rtp {
+
+// RoqSender
+
+RoqSender::RoqSender(QuicSink* sink, uint64_t flow_id)
+    : sink_(sink), flow_id_(flow_id > kMaxQuicVarint ? kMaxQuicVarint : flow_id) {
+}
+
+bool RoqSender::SetFlowId(uint64_t flow_id) {
+    if (flow_id > kMaxQuicVarint) {
+        return false;
+    }
+    flow_id_ = flow_id;
+    return true;
+}
+
+size_t RoqSender::PrefixSize(size_t size) const {
+    return QuicVarintSize(in_stream() ? size : flow_id_);
+}
+
+uint8_t* RoqSender::Begin(size_t max_size) {
+    if (buffer_.size() < kMaxQuicVarintSize + max_size) {
+        buffer_.resize(kMaxQuicVarintSize + max_size);
+    }
+    return buffer_.data() + kMaxQuicVarintSize;
+}
+
+bool RoqSender::Commit(size_t size) {
+    if (kMaxQuicVarintSize + size > buffer_.size()) {
+        return false;
+    }
+    return Send(buffer_.data() + kMaxQuicVarintSize, size);
+}
+
+bool RoqSender::SendPacket(const uint8_t* packet, size_t size) {
+    uint8_t* buffer = Begin(size);
+    std::memcpy(buffer, packet, size);
+    return Commit(size);
+}
+
+bool RoqSender::SendPacketInPlace(uint8_t* packet, size_t size, size_t headroom) {
+    if (headroom < PrefixSize(size)) {
+        return false;
+    }
+    return Send(packet, size);
+}
+
+bool RoqSender::Send(uint8_t* packet, size_t size) {
+    if (!sink_) {
+        return false;
+    }
+
+    // Flow identifier in front of a datagram, length in front of a stream
+    // packet
+    uint64_t prefix = in_stream() ? size : flow_id_;
+    size_t prefix_size = QuicVarintSize(prefix);
+    uint8_t* start = packet - prefix_size;
+    WriteQuicVarint(prefix, start);
+
+    if (in_stream()) {
+        if (!sink_->WriteStream(stream_, start, prefix_size + size, false)) {
+            stats_.send_failures++;
+            return false;
+        }
+        stats_.stream_packets++;
+        return true;
+    }
+
+    if (prefix_size + size > sink_->MaxDatagramSize()) {
+        stats_.oversized++;
+        return false;
+    }
+    if (!sink_->SendDatagram(start, prefix_size + size)) {
+        stats_.send_failures++;
+        return false;
+    }
+    stats_.datagrams++;
+    return true;
+}
+
+bool RoqSender::BeginStream() {
+    if (!sink_ || in_stream()) {
+        return false;
+    }
+    int64_t stream = sink_->OpenStream();
+    if (stream < 0) {
+        return false;
+    }
+
+    uint8_t flow_id[kMaxQuicVarintSize];
+    size_t size = WriteQuicVarint(flow_id_, flow_id);
+    if (!sink_->WriteStream(stream, flow_id, size, false)) {
+        sink_->WriteStream(stream, nullptr, 0, true);
+        return false;
+    }
+    stream_ = stream;
+    stats_.streams++;
+    return true;
+}
+
+bool RoqSender::EndStream() {
+    if (!in_stream()) {
+        return false;
+    }
+    bool result = sink_->WriteStream(stream_, nullptr, 0, true);
+    stream_ = -1;
+    return result;
+}
+
+// RoqReceiver
+
+RoqReceiver::RoqReceiver(RoqPacketHandler* handler, size_t max_packet_size)
+    : handler_(handler), max_packet_size_(max_packet_size) {
+}
+
+bool RoqReceiver::OnDatagram(const uint8_t* data, size_t size) {
+    uint64_t flow_id = 0;
+    size_t prefix_size = ReadQuicVarint(data, size, &flow_id);
+    if (prefix_size == 0 || prefix_size == size) {
+        stats_.malformed++;
+        return false;
+    }
+    stats_.datagrams++;
+    if (handler_) {
+        handler_->OnRoqPacket(flow_id, data + prefix_size, size - prefix_size);
+    }
+    return true;
+}
+
+RoqReceiver::StreamState* RoqReceiver::FindStream(int64_t stream) {
+    for (StreamState& state : streams_) {
+        if (state.id == stream) {
+            return &state;
+        }
+    }
+    streams_.emplace_back();
+    streams_.back().id = stream;
+    return &streams_.back();
+}
+
+void RoqReceiver::CloseStream(StreamState* state) {
+    size_t index = state - streams_.data();
+    if (index + 1 != streams_.size()) {
+        std::swap(streams_[index], streams_.back());
+    }
+    streams_.pop_back();
+}
+
+bool RoqReceiver::OnStreamData(int64_t stream, const uint8_t* data, size_t size, bool fin) {
+    StreamState* state = FindStream(stream);
+
+    bool result = !state->failed;
+    if (result && !ParseStream(state, data, size)) {
+        state->failed = true;
+        state->pending.clear();
+        stats_.malformed++;
+        result = false;
+    }
+
+    if (fin) {
+        // A stream may only end between packets
+        if (result && !state->pending.empty()) {
+            stats_.malformed++;
+            result = false;
+        }
+        CloseStream(state);
+    }
+    return result;
+}
+
+bool RoqReceiver::ItemSize(const StreamState& state, const uint8_t* data, size_t size,
+                           size_t* item) const {
+    *item = 0;
+    if (size == 0) {
+        return true;
+    }
+    if (!state.has_flow_id) {
+        size_t length = size_t(1) << (data[0] >> 6);
+        *item = length <= size ? length : 0;
+        return true;
+    }
+
+    uint64_t packet_size = 0;
+    size_t prefix_size = ReadQuicVarint(data, size, &packet_size);
+    if (prefix_size == 0) {
+        return true;
+    }
+    if (packet_size > max_packet_size_) {
+        return false;
+    }
+    *item = prefix_size + static_cast<size_t>(packet_size);
+    return true;
+}
+
+void RoqReceiver::ParseItem(StreamState* state, const uint8_t* data, size_t size) {
+    if (!state->has_flow_id) {
+        ReadQuicVarint(data, size, &state->flow_id);
+        state->has_flow_id = true;
+        return;
+    }
+
+    uint64_t packet_size = 0;
+    size_t prefix_size = ReadQuicVarint(data, size, &packet_size);
+    if (packet_size == 0) {
+        return;
+    }
+    stats_.stream_packets++;
+    if (handler_) {
+        handler_->OnRoqPacket(state->flow_id, data + prefix_size, static_cast<size_t>(packet_size));
+    }
+}
+
+bool RoqReceiver::ParseStream(StreamState* state, const uint8_t* data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        const uint8_t* next = data + offset;
+        size_t remaining = size - offset;
+        size_t item = 0;
+
+        if (state->pending.empty()) {
+            // Whole items are parsed where they are
+            if (!ItemSize(*state, next, remaining, &item)) {
+                return false;
+            }
+            if (item != 0 && item <= remaining) {
+                ParseItem(state, next, item);
+                offset += item;
+                continue;
+            }
+            state->pending.assign(next, next + remaining);
+            return true;
+        }
+
+        // Complete the item started by an earlier chunk, or at least its
+        // varint so its size is known
+        std::vector<uint8_t>& pending = state->pending;
+        if (!ItemSize(*state, pending.data(), pending.size(), &item)) {
+            return false;
+        }
+        size_t target = item != 0 ? item : size_t(1) << (pending[0] >> 6);
+        size_t take = target - pending.size() < remaining ? target - pending.size() : remaining;
+        pending.insert(pending.end(), next, next + take);
+        offset += take;
+
+        // A completed varint may complete the item too
+        if (item == 0 && !ItemSize(*state, pending.data(), pending.size(), &item)) {
+            return false;
+        }
+        if (item != 0 && pending.size() == item) {
+            ParseItem(state, pending.data(), item);
+            pending.clear();
+        }
+    }
+    return true;
+}
+
+} // namespace rtp
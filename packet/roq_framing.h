@@ -0,0 +1,206 @@
+#ifndef ROQ_FRAMING_H_
+#define ROQ_FRAMING_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "rtp_packet.h"
+
+namespace rtp {
+
+// QUIC variable-length integers (RFC 9000 16): the two top bits of the
+// first byte give the encoded size of 1, 2, 4 or 8 bytes
+constexpr uint64_t kMaxQuicVarint = (uint64_t(1) << 62) - 1;
+constexpr size_t kMaxQuicVarintSize = 8;
+
+// Encoded size of value, which must not exceed kMaxQuicVarint
+inline size_t QuicVarintSize(uint64_t value) {
+    return size_t(1) << ((value > 63) + (value > 16383) + (value > 1073741823));
+}
+
+// Writes value in QuicVarintSize(value) bytes; returns the size
+inline size_t WriteQuicVarint(uint64_t value, uint8_t* out) {
+    unsigned size_log = (value > 63) + (value > 16383) + (value > 1073741823);
+    size_t size = size_t(1) << size_log;
+    uint64_t encoded = value | (uint64_t(size_log) << (size * 8 - 2));
+
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = static_cast<uint8_t>(encoded >> (56 - 8 * i));
+    }
+    std::memcpy(out, bytes + 8 - size, size);
+    return size;
+}
+
+// Reads a varint from data; returns its size, or 0 if size is too short
+inline size_t ReadQuicVarint(const uint8_t* data, size_t size, uint64_t* value) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t length = size_t(1) << (data[0] >> 6);
+    if (length > size) {
+        return 0;
+    }
+
+    // Load up to eight bytes big-endian and drop what is not part of the
+    // varint, then the two size bits
+    uint8_t bytes[8] = {};
+    std::memcpy(bytes, data, length);
+    uint64_t raw = 0;
+    for (int i = 0; i < 8; i++) {
+        raw = (raw << 8) | bytes[i];
+    }
+    raw >>= 64 - 8 * length;
+    *value = raw & ((uint64_t(1) << (8 * length - 2)) - 1);
+    return length;
+}
+
+// QuicSink is the QUIC connection an RoQ sender writes to (RFC 9605), so
+// any QUIC or WebTransport stack, or an in-memory stand-in, can carry it
+class QuicSink {
+public:
+    virtual ~QuicSink() = default;
+
+    // Sends one QUIC DATAGRAM frame payload; false if it was not accepted
+    virtual bool SendDatagram(const uint8_t* data, size_t size) = 0;
+
+    // Largest datagram payload the connection takes right now
+    virtual size_t MaxDatagramSize() const = 0;
+
+    // Opens a unidirectional stream; returns its id, or -1
+    virtual int64_t OpenStream() = 0;
+
+    // Appends data to a stream, finishing it with fin
+    virtual bool WriteStream(int64_t stream, const uint8_t* data, size_t size, bool fin) = 0;
+};
+
+// Counters of one RoQ sender
+struct RoqSenderStats {
+    uint64_t datagrams = 0;
+    uint64_t stream_packets = 0;
+    uint64_t streams = 0;
+    uint64_t oversized = 0;         // Packets larger than MaxDatagramSize()
+    uint64_t send_failures = 0;     // Packets the sink refused
+};
+
+// RoqSender sends the RTP/RTCP packets of one RoQ flow. By default every
+// packet is a QUIC datagram carrying the flow identifier varint and the
+// packet. Between BeginStream() and EndStream() packets go on one new
+// QUIC stream instead, which starts with the flow identifier and frames
+// every packet with its length varint; this carries a large keyframe
+// reliably and without the datagram size limit.
+//
+// As a PacketWriter, packetizers build packets directly behind room for the
+// varint prefix, so nothing is copied. Packets packetized with headroom can
+// be sent in place with SendPacketInPlace().
+class RoqSender : public PacketWriter {
+public:
+    RoqSender(QuicSink* sink, uint64_t flow_id);
+    ~RoqSender() override = default;
+
+    RoqSender(const RoqSender&) = delete;
+    RoqSender& operator=(const RoqSender&) = delete;
+
+    // Flow identifier, at most kMaxQuicVarint; takes effect on the next
+    // datagram or stream
+    bool SetFlowId(uint64_t flow_id);
+    uint64_t flow_id() const { return flow_id_; }
+
+    // PacketWriter: Commit() sends the packet
+    uint8_t* Begin(size_t max_size) override;
+    bool Commit(size_t size) override;
+
+    // Sends a packet, copying it behind the prefix
+    bool SendPacket(const uint8_t* packet, size_t size);
+
+    // Sends a packet after writing the prefix into the headroom bytes in
+    // front of it; PrefixSize(size) of headroom is enough
+    bool SendPacketInPlace(uint8_t* packet, size_t size, size_t headroom);
+
+    // Prefix written in front of a packet of size bytes in the current mode
+    size_t PrefixSize(size_t size) const;
+
+    // Stream mode; EndStream() must be called before the sink goes away
+    bool BeginStream();
+    bool EndStream();
+    bool in_stream() const { return stream_ >= 0; }
+
+    const RoqSenderStats& Stats() const { return stats_; }
+
+private:
+    // Sends the prefix and packet that end at packet + size
+    bool Send(uint8_t* packet, size_t size);
+
+    QuicSink* sink_;
+    uint64_t flow_id_;
+    int64_t stream_ = -1;
+    std::vector<uint8_t> buffer_;   // Begin() target behind kMaxQuicVarintSize bytes
+    RoqSenderStats stats_;
+};
+
+// RoqPacketHandler receives the packets an RoqReceiver parses; the packet
+// is only valid for the duration of the call
+class RoqPacketHandler {
+public:
+    virtual ~RoqPacketHandler() = default;
+    virtual void OnRoqPacket(uint64_t flow_id, const uint8_t* packet, size_t size) = 0;
+};
+
+// Counters of one RoQ receiver
+struct RoqReceiverStats {
+    uint64_t datagrams = 0;
+    uint64_t stream_packets = 0;
+    uint64_t malformed = 0;         // Bad datagrams and broken streams
+};
+
+// RoqReceiver parses RoQ datagrams and streams back into packets with their
+// flow identifier. Packets are handed over in place; only a packet split
+// across stream data chunks is collected in a buffer first.
+class RoqReceiver {
+public:
+    explicit RoqReceiver(RoqPacketHandler* handler, size_t max_packet_size = 65535);
+    ~RoqReceiver() = default;
+
+    // A received QUIC DATAGRAM frame payload
+    // Returns false if it is malformed
+    bool OnDatagram(const uint8_t* data, size_t size);
+
+    // Data received on a stream, in order; fin marks its end
+    // Returns false if the stream is malformed; its further data is ignored
+    bool OnStreamData(int64_t stream, const uint8_t* data, size_t size, bool fin);
+
+    const RoqReceiverStats& Stats() const { return stats_; }
+
+private:
+    struct StreamState {
+        int64_t id = -1;
+        bool has_flow_id = false;
+        bool failed = false;
+        uint64_t flow_id = 0;
+        std::vector<uint8_t> pending;   // Incomplete varint or packet
+    };
+
+    StreamState* FindStream(int64_t stream);
+    void CloseStream(StreamState* state);
+
+    // Parses data of a stream; returns false when it breaks the framing
+    bool ParseStream(StreamState* state, const uint8_t* data, size_t size);
+
+    // Size of the flow identifier or length-prefixed packet that data
+    // starts with, 0 while its varint is incomplete; false if the packet
+    // is too large
+    bool ItemSize(const StreamState& state, const uint8_t* data, size_t size, size_t* item) const;
+
+    // Consumes one whole flow identifier or length-prefixed packet
+    void ParseItem(StreamState* state, const uint8_t* data, size_t size);
+
+    RoqPacketHandler* handler_;
+    size_t max_packet_size_;
+    std::vector<StreamState> streams_;
+    RoqReceiverStats stats_;
+};
+
+} // namespace rtp
+
+#endif // ROQ_FRAMING_H_
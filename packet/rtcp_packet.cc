@@ -0,0 +1,493 @@
+#include "rtcp_packet.h"
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    constexpr uint8_t kRtcpVersion = 2;
+
+    uint16_t ReadUint16(const uint8_t* buf) {
+        return static_cast<uint16_t>((buf[0] << 8) | buf[1]);
+    }
+
+    uint32_t ReadUint24(const uint8_t* buf) {
+        return (uint32_t(buf[0]) << 16) | (uint32_t(buf[1]) << 8) | buf[2];
+    }
+
+    uint32_t ReadUint32(const uint8_t* buf) {
+        return (uint32_t(buf[0]) << 24) | (uint32_t(buf[1]) << 16) |
+               (uint32_t(buf[2]) << 8) | buf[3];
+    }
+
+    void WriteUint16(uint8_t* buf, uint16_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 8);
+        buf[1] = static_cast<uint8_t>(value);
+    }
+
+    void WriteUint24(uint8_t* buf, uint32_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 16);
+        buf[1] = static_cast<uint8_t>(value >> 8);
+        buf[2] = static_cast<uint8_t>(value);
+    }
+
+    void WriteUint32(uint8_t* buf, uint32_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 24);
+        buf[1] = static_cast<uint8_t>(value >> 16);
+        buf[2] = static_cast<uint8_t>(value >> 8);
+        buf[3] = static_cast<uint8_t>(value);
+    }
+
+    size_t PadTo4(size_t size) {
+        return (size + 3) & ~size_t(3);
+    }
+
+    void ReadReportBlock(const uint8_t* buf, ReportBlock* block) {
+        block->ssrc = ReadUint32(buf);
+        block->fraction_lost = buf[4];
+        // Sign-extend the 24-bit cumulative loss
+        uint32_t lost = ReadUint24(buf + 5);
+        block->cumulative_lost = (lost & 0x800000) ? static_cast<int32_t>(lost | 0xFF000000) : static_cast<int32_t>(lost);
+        block->extended_highest_sequence_number = ReadUint32(buf + 8);
+        block->jitter = ReadUint32(buf + 12);
+        block->last_sr = ReadUint32(buf + 16);
+        block->delay_since_last_sr = ReadUint32(buf + 20);
+    }
+
+    void WriteReportBlock(uint8_t* buf, const ReportBlock& block) {
+        // Clamp the cumulative loss to the 24-bit signed range
+        int32_t lost = block.cumulative_lost;
+        if (lost > 0x7FFFFF) {
+            lost = 0x7FFFFF;
+        } else if (lost < -0x800000) {
+            lost = -0x800000;
+        }
+        
+        WriteUint32(buf, block.ssrc);
+        buf[4] = block.fraction_lost;
+        WriteUint24(buf + 5, static_cast<uint32_t>(lost) & 0xFFFFFF);
+        WriteUint32(buf + 8, block.extended_highest_sequence_number);
+        WriteUint32(buf + 12, block.jitter);
+        WriteUint32(buf + 16, block.last_sr);
+        WriteUint32(buf + 20, block.delay_since_last_sr);
+    }
+}
+
+bool IsRtcpPacket(const uint8_t* data, size_t size) {
+    if (!data || size < kRtcpHeaderSize) {
+        return false;
+    }
+    
+    return (data[0] >> 6) == kRtcpVersion && data[1] >= 192 && data[1] <= 223;
+}
+
+bool ParseRtcpHeader(const uint8_t* data, size_t size, RtcpHeader* header) {
+    if (!data || !header || size < kRtcpHeaderSize) {
+        return false;
+    }
+    
+    if ((data[0] >> 6) != kRtcpVersion) {
+        return false;
+    }
+    
+    size_t packet_size = (size_t(ReadUint16(data + 2)) + 1) * 4;
+    if (packet_size > size) {
+        return false;
+    }
+    
+    size_t body_size = packet_size - kRtcpHeaderSize;
+    if (data[0] & 0x20) {
+        // The last octet holds the padding count, itself included
+        uint8_t padding = data[packet_size - 1];
+        if (padding == 0 || padding > body_size) {
+            return false;
+        }
+        body_size -= padding;
+    }
+    
+    header->count = data[0] & 0x1F;
+    header->packet_type = data[1];
+    header->body = data + kRtcpHeaderSize;
+    header->body_size = body_size;
+    header->packet_size = packet_size;
+    return true;
+}
+
+bool RtcpReader::Next(RtcpHeader* header) {
+    if (error_ || offset_ >= size_) {
+        return false;
+    }
+    
+    if (!ParseRtcpHeader(data_ + offset_, size_ - offset_, header)) {
+        error_ = true;
+        return false;
+    }
+    
+    offset_ += header->packet_size;
+    return true;
+}
+
+bool ParseSenderReport(const RtcpHeader& header, SenderReport* report) {
+    if (!report || header.packet_type != kRtcpSenderReportType) {
+        return false;
+    }
+    
+    if (header.body_size < 4 + kRtcpSenderInfoSize + header.count * kRtcpReportBlockSize) {
+        return false;
+    }
+    
+    const uint8_t* body = header.body;
+    report->sender_ssrc = ReadUint32(body);
+    report->sender_info.ntp_seconds = ReadUint32(body + 4);
+    report->sender_info.ntp_fraction = ReadUint32(body + 8);
+    report->sender_info.rtp_timestamp = ReadUint32(body + 12);
+    report->sender_info.packet_count = ReadUint32(body + 16);
+    report->sender_info.octet_count = ReadUint32(body + 20);
+    
+    report->report_count = header.count;
+    for (size_t i = 0; i < header.count; i++) {
+        ReadReportBlock(body + 4 + kRtcpSenderInfoSize + i * kRtcpReportBlockSize, &report->report_blocks[i]);
+    }
+    return true;
+}
+
+bool ParseReceiverReport(const RtcpHeader& header, ReceiverReport* report) {
+    if (!report || header.packet_type != kRtcpReceiverReportType) {
+        return false;
+    }
+    
+    if (header.body_size < 4 + header.count * kRtcpReportBlockSize) {
+        return false;
+    }
+    
+    report->sender_ssrc = ReadUint32(header.body);
+    report->report_count = header.count;
+    for (size_t i = 0; i < header.count; i++) {
+        ReadReportBlock(header.body + 4 + i * kRtcpReportBlockSize, &report->report_blocks[i]);
+    }
+    return true;
+}
+
+bool ParseBye(const RtcpHeader& header, Bye* bye) {
+    if (!bye || header.packet_type != kRtcpByeType) {
+        return false;
+    }
+    
+    size_t ssrc_size = header.count * 4;
+    if (header.body_size < ssrc_size) {
+        return false;
+    }
+    
+    bye->ssrc_count = header.count;
+    for (size_t i = 0; i < header.count; i++) {
+        bye->ssrcs[i] = ReadUint32(header.body + i * 4);
+    }
+    
+    bye->reason = nullptr;
+    bye->reason_size = 0;
+    if (header.body_size > ssrc_size) {
+        size_t length = header.body[ssrc_size];
+        if (ssrc_size + 1 + length > header.body_size) {
+            return false;
+        }
+        bye->reason = header.body + ssrc_size + 1;
+        bye->reason_size = length;
+    }
+    return true;
+}
+
+bool ParseFeedback(const RtcpHeader& header, FeedbackMessage* feedback) {
+    if (!feedback) {
+        return false;
+    }
+    
+    if (header.packet_type != kRtcpRtpfbPacketType && header.packet_type != kRtcpPsfbPacketType) {
+        return false;
+    }
+    
+    if (header.body_size < kRtcpFeedbackHeaderSize - kRtcpHeaderSize) {
+        return false;
+    }
+    
+    feedback->packet_type = header.packet_type;
+    feedback->fmt = header.count;
+    feedback->sender_ssrc = ReadUint32(header.body);
+    feedback->media_ssrc = ReadUint32(header.body + 4);
+    feedback->fci = header.body + 8;
+    feedback->fci_size = header.body_size - 8;
+    return true;
+}
+
+bool ParseSdes(const RtcpHeader& header, SdesItem* items, size_t max_items, size_t* count) {
+    if (header.packet_type != kRtcpSdesType) {
+        return false;
+    }
+    
+    const uint8_t* body = header.body;
+    size_t size = header.body_size;
+    size_t offset = 0;
+    size_t found = 0;
+    
+    for (size_t chunk = 0; chunk < header.count; chunk++) {
+        if (offset + 4 > size) {
+            return false;
+        }
+        uint32_t ssrc = ReadUint32(body + offset);
+        offset += 4;
+        
+        // Items until the null item, then padding to the next 32-bit boundary
+        while (true) {
+            if (offset >= size) {
+                return false;
+            }
+            uint8_t type = body[offset];
+            if (type == kSdesEnd) {
+                offset = PadTo4(offset + 1);
+                break;
+            }
+            if (offset + 2 > size || offset + 2 + body[offset + 1] > size) {
+                return false;
+            }
+            
+            uint8_t length = body[offset + 1];
+            if (items && found < max_items) {
+                items[found].ssrc = ssrc;
+                items[found].type = type;
+                items[found].text = body + offset + 2;
+                items[found].size = length;
+            }
+            found++;
+            offset += 2 + length;
+        }
+    }
+    
+    if (count) {
+        *count = found;
+    }
+    return true;
+}
+
+size_t ParseNackItems(const FeedbackMessage& feedback, NackItem* items, size_t max_items) {
+    if (!items || feedback.packet_type != kRtcpRtpfbPacketType || feedback.fmt != kRtcpGenericNackFmt) {
+        return 0;
+    }
+    
+    size_t count = feedback.fci_size / 4;
+    if (count > max_items) {
+        count = max_items;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        items[i].pid = ReadUint16(feedback.fci + i * 4);
+        items[i].blp = ReadUint16(feedback.fci + i * 4 + 2);
+    }
+    return count;
+}
+
+void WriteRtcpHeader(uint8_t* buf, uint8_t count, uint8_t packet_type, size_t packet_size) {
+    buf[0] = static_cast<uint8_t>((kRtcpVersion << 6) | (count & 0x1F));
+    buf[1] = packet_type;
+    WriteUint16(buf + 2, static_cast<uint16_t>(packet_size / 4 - 1));
+}
+
+uint8_t* RtcpWriter::Reserve(size_t size) {
+    if (!buf_ || size > capacity_ - size_) {
+        return nullptr;
+    }
+    
+    uint8_t* packet = buf_ + size_;
+    size_ += size;
+    return packet;
+}
+
+bool RtcpWriter::AddSenderReport(uint32_t sender_ssrc, const SenderInfo& info,
+                                 const ReportBlock* blocks, size_t block_count) {
+    if (block_count > kRtcpMaxCount || (block_count > 0 && !blocks)) {
+        return false;
+    }
+    
+    size_t packet_size = kRtcpHeaderSize + 4 + kRtcpSenderInfoSize + block_count * kRtcpReportBlockSize;
+    uint8_t* packet = Reserve(packet_size);
+    if (!packet) {
+        return false;
+    }
+    
+    WriteRtcpHeader(packet, static_cast<uint8_t>(block_count), kRtcpSenderReportType, packet_size);
+    WriteUint32(packet + 4, sender_ssrc);
+    WriteUint32(packet + 8, info.ntp_seconds);
+    WriteUint32(packet + 12, info.ntp_fraction);
+    WriteUint32(packet + 16, info.rtp_timestamp);
+    WriteUint32(packet + 20, info.packet_count);
+    WriteUint32(packet + 24, info.octet_count);
+    for (size_t i = 0; i < block_count; i++) {
+        WriteReportBlock(packet + 28 + i * kRtcpReportBlockSize, blocks[i]);
+    }
+    return true;
+}
+
+bool RtcpWriter::AddReceiverReport(uint32_t sender_ssrc, const ReportBlock* blocks, size_t block_count) {
+    if (block_count > kRtcpMaxCount || (block_count > 0 && !blocks)) {
+        return false;
+    }
+    
+    size_t packet_size = kRtcpHeaderSize + 4 + block_count * kRtcpReportBlockSize;
+    uint8_t* packet = Reserve(packet_size);
+    if (!packet) {
+        return false;
+    }
+    
+    WriteRtcpHeader(packet, static_cast<uint8_t>(block_count), kRtcpReceiverReportType, packet_size);
+    WriteUint32(packet + 4, sender_ssrc);
+    for (size_t i = 0; i < block_count; i++) {
+        WriteReportBlock(packet + 8 + i * kRtcpReportBlockSize, blocks[i]);
+    }
+    return true;
+}
+
+bool RtcpWriter::AddSdes(const SdesItem* items, size_t item_count) {
+    if (!items || item_count == 0) {
+        return false;
+    }
+    
+    // Size every chunk first: SSRC, items, the null item and padding
+    size_t packet_size = kRtcpHeaderSize;
+    size_t chunks = 0;
+    size_t chunk_size = 0;
+    for (size_t i = 0; i < item_count; i++) {
+        if (items[i].type == kSdesEnd || (items[i].size > 0 && !items[i].text)) {
+            return false;
+        }
+        if (i == 0 || items[i].ssrc != items[i - 1].ssrc) {
+            if (i > 0) {
+                packet_size += PadTo4(chunk_size + 1);
+            }
+            chunk_size = 4;
+            chunks++;
+        }
+        chunk_size += 2 + items[i].size;
+    }
+    packet_size += PadTo4(chunk_size + 1);
+    
+    if (chunks > kRtcpMaxCount || packet_size > kRtcpMaxPacketSize) {
+        return false;
+    }
+    
+    uint8_t* packet = Reserve(packet_size);
+    if (!packet) {
+        return false;
+    }
+    
+    WriteRtcpHeader(packet, static_cast<uint8_t>(chunks), kRtcpSdesType, packet_size);
+    size_t offset = kRtcpHeaderSize;
+    for (size_t i = 0; i < item_count; i++) {
+        if (i == 0 || items[i].ssrc != items[i - 1].ssrc) {
+            if (i > 0) {
+                size_t end = PadTo4(offset + 1);
+                std::memset(packet + offset, 0, end - offset);
+                offset = end;
+            }
+            WriteUint32(packet + offset, items[i].ssrc);
+            offset += 4;
+        }
+        packet[offset] = items[i].type;
+        packet[offset + 1] = items[i].size;
+        if (items[i].size > 0) {
+            std::memcpy(packet + offset + 2, items[i].text, items[i].size);
+        }
+        offset += 2 + items[i].size;
+    }
+    std::memset(packet + offset, 0, packet_size - offset);
+    return true;
+}
+
+bool RtcpWriter::AddCname(uint32_t ssrc, const char* cname, size_t size) {
+    if (size > 255) {
+        return false;
+    }
+    
+    SdesItem item;
+    item.ssrc = ssrc;
+    item.type = kSdesCname;
+    item.text = reinterpret_cast<const uint8_t*>(cname);
+    item.size = static_cast<uint8_t>(size);
+    return AddSdes(&item, 1);
+}
+
+bool RtcpWriter::AddBye(const uint32_t* ssrcs, size_t ssrc_count, const char* reason, size_t reason_size) {
+    if (ssrc_count > kRtcpMaxCount || (ssrc_count > 0 && !ssrcs) || reason_size > 255 ||
+        (reason_size > 0 && !reason)) {
+        return false;
+    }
+    
+    size_t packet_size = kRtcpHeaderSize + ssrc_count * 4;
+    if (reason_size > 0) {
+        packet_size += PadTo4(1 + reason_size);
+    }
+    
+    uint8_t* packet = Reserve(packet_size);
+    if (!packet) {
+        return false;
+    }
+    
+    WriteRtcpHeader(packet, static_cast<uint8_t>(ssrc_count), kRtcpByeType, packet_size);
+    for (size_t i = 0; i < ssrc_count; i++) {
+        WriteUint32(packet + 4 + i * 4, ssrcs[i]);
+    }
+    
+    if (reason_size > 0) {
+        size_t offset = kRtcpHeaderSize + ssrc_count * 4;
+        packet[offset] = static_cast<uint8_t>(reason_size);
+        std::memcpy(packet + offset + 1, reason, reason_size);
+        std::memset(packet + offset + 1 + reason_size, 0, packet_size - offset - 1 - reason_size);
+    }
+    return true;
+}
+
+bool RtcpWriter::AddFeedback(uint8_t packet_type, uint8_t fmt, uint32_t sender_ssrc, uint32_t media_ssrc,
+                             const uint8_t* fci, size_t fci_size) {
+    if (fmt > kRtcpMaxCount || fci_size % 4 != 0 || (fci_size > 0 && !fci) ||
+        fci_size > kRtcpMaxPacketSize - kRtcpFeedbackHeaderSize) {
+        return false;
+    }
+    
+    size_t packet_size = kRtcpFeedbackHeaderSize + fci_size;
+    uint8_t* packet = Reserve(packet_size);
+    if (!packet) {
+        return false;
+    }
+    
+    WriteRtcpHeader(packet, fmt, packet_type, packet_size);
+    WriteUint32(packet + 4, sender_ssrc);
+    WriteUint32(packet + 8, media_ssrc);
+    if (fci_size > 0) {
+        std::memcpy(packet + kRtcpFeedbackHeaderSize, fci, fci_size);
+    }
+    return true;
+}
+
+bool RtcpWriter::AddNack(uint32_t sender_ssrc, uint32_t media_ssrc, const NackItem* items, size_t item_count) {
+    if (!items || item_count == 0 || item_count > (kRtcpMaxPacketSize - kRtcpFeedbackHeaderSize) / 4) {
+        return false;
+    }
+    
+    size_t packet_size = kRtcpFeedbackHeaderSize + item_count * 4;
+    uint8_t* packet = Reserve(packet_size);
+    if (!packet) {
+        return false;
+    }
+    
+    WriteRtcpHeader(packet, kRtcpGenericNackFmt, kRtcpRtpfbPacketType, packet_size);
+    WriteUint32(packet + 4, sender_ssrc);
+    WriteUint32(packet + 8, media_ssrc);
+    for (size_t i = 0; i < item_count; i++) {
+        WriteUint16(packet + kRtcpFeedbackHeaderSize + i * 4, items[i].pid);
+        WriteUint16(packet + kRtcpFeedbackHeaderSize + i * 4 + 2, items[i].blp);
+    }
+    return true;
+}
+
+bool RtcpWriter::AddPli(uint32_t sender_ssrc, uint32_t media_ssrc) {
+    return AddFeedback(kRtcpPsfbPacketType, kRtcpPliFmt, sender_ssrc, media_ssrc, nullptr, 0);
+}
+
+} // namespace rtp
\ No newline at end of file
@@ -0,0 +1,198 @@
+#ifndef RTCP_PACKET_H_
+#define RTCP_PACKET_H_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace rtp {
+
+// RTCP packet types (RFC 3550, RFC 4585)
+constexpr uint8_t kRtcpSenderReportType = 200;
+constexpr uint8_t kRtcpReceiverReportType = 201;
+constexpr uint8_t kRtcpSdesType = 202;
+constexpr uint8_t kRtcpByeType = 203;
+constexpr uint8_t kRtcpAppType = 204;
+constexpr uint8_t kRtcpRtpfbPacketType = 205;
+constexpr uint8_t kRtcpPsfbPacketType = 206;
+
+// Feedback message types carried in the count field
+constexpr uint8_t kRtcpGenericNackFmt = 1;
+constexpr uint8_t kRtcpTransportFeedbackFmt = 15;
+constexpr uint8_t kRtcpPliFmt = 1;
+constexpr uint8_t kRtcpFirFmt = 4;
+constexpr uint8_t kRtcpAfbFmt = 15;
+
+// SDES item types
+constexpr uint8_t kSdesEnd = 0;
+constexpr uint8_t kSdesCname = 1;
+
+// Sizes on the wire
+constexpr size_t kRtcpHeaderSize = 4;
+constexpr size_t kRtcpSenderInfoSize = 20;
+constexpr size_t kRtcpReportBlockSize = 24;
+constexpr size_t kRtcpFeedbackHeaderSize = 12;
+constexpr size_t kRtcpMaxCount = 31;
+
+// Largest packet the 16-bit length field (size in words minus one) describes
+constexpr size_t kRtcpMaxPacketSize = (size_t(0xFFFF) + 1) * 4;
+
+// Sender information of an SR, with the NTP timestamp split into its halves
+struct SenderInfo {
+    uint32_t ntp_seconds = 0;
+    uint32_t ntp_fraction = 0;
+    uint32_t rtp_timestamp = 0;
+    uint32_t packet_count = 0;
+    uint32_t octet_count = 0;
+};
+
+// Reception report block of an SR or RR
+struct ReportBlock {
+    uint32_t ssrc = 0;
+    uint8_t fraction_lost = 0;
+    int32_t cumulative_lost = 0;     // 24-bit signed on the wire
+    uint32_t extended_highest_sequence_number = 0;
+    uint32_t jitter = 0;
+    uint32_t last_sr = 0;            // Middle 32 bits of the last SR NTP time
+    uint32_t delay_since_last_sr = 0; // In units of 1/65536 seconds
+};
+
+// One Generic NACK FCI entry: packet PID is lost, and so is PID + i + 1 for
+// every bit i set in the bitmask of following lost packets (BLP)
+struct NackItem {
+    uint16_t pid = 0;
+    uint16_t blp = 0;
+};
+
+// One SDES item; text points into the parsed buffer or the caller's string
+struct SdesItem {
+    uint32_t ssrc = 0;
+    uint8_t type = kSdesCname;
+    const uint8_t* text = nullptr;
+    uint8_t size = 0;
+};
+
+// Parsed packets. Report and SSRC lists are fixed arrays sized for the 5-bit
+// count field, so parsing never allocates; pointers refer into the buffer
+// that was parsed.
+struct SenderReport {
+    uint32_t sender_ssrc = 0;
+    SenderInfo sender_info;
+    size_t report_count = 0;
+    ReportBlock report_blocks[kRtcpMaxCount];
+};
+
+struct ReceiverReport {
+    uint32_t sender_ssrc = 0;
+    size_t report_count = 0;
+    ReportBlock report_blocks[kRtcpMaxCount];
+};
+
+struct Bye {
+    size_t ssrc_count = 0;
+    uint32_t ssrcs[kRtcpMaxCount];
+    const uint8_t* reason = nullptr;
+    size_t reason_size = 0;
+};
+
+// Common part of RTPFB and PSFB messages (RFC 4585 section 6.1)
+struct FeedbackMessage {
+    uint8_t packet_type = 0;
+    uint8_t fmt = 0;
+    uint32_t sender_ssrc = 0;
+    uint32_t media_ssrc = 0;
+    const uint8_t* fci = nullptr;
+    size_t fci_size = 0;
+};
+
+// RtcpHeader is one packet of a compound RTCP packet
+struct RtcpHeader {
+    uint8_t count = 0;               // RC, SC or FMT depending on the type
+    uint8_t packet_type = 0;
+    const uint8_t* body = nullptr;   // After the 4 byte header, without padding
+    size_t body_size = 0;
+    size_t packet_size = 0;          // Including header and padding
+};
+
+// Returns true if the first two bytes look like an RTCP header (version 2 and
+// a packet type in 192..223, RFC 5761 section 4)
+bool IsRtcpPacket(const uint8_t* data, size_t size);
+
+// Parses the header of the first packet in data
+bool ParseRtcpHeader(const uint8_t* data, size_t size, RtcpHeader* header);
+
+// RtcpReader walks the packets of a compound RTCP packet in place
+class RtcpReader {
+public:
+    RtcpReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    // Returns the next packet; false at the end or on a malformed packet
+    bool Next(RtcpHeader* header);
+
+    // True if iteration stopped because of a malformed packet
+    bool error() const { return error_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool error_ = false;
+};
+
+// Typed parsers for a packet returned by RtcpReader
+bool ParseSenderReport(const RtcpHeader& header, SenderReport* report);
+bool ParseReceiverReport(const RtcpHeader& header, ReceiverReport* report);
+bool ParseBye(const RtcpHeader& header, Bye* bye);
+bool ParseFeedback(const RtcpHeader& header, FeedbackMessage* feedback);
+
+// Visits the SDES items of every chunk; returns false if the packet is
+// malformed. items receives up to max_items entries, count the total seen.
+bool ParseSdes(const RtcpHeader& header, SdesItem* items, size_t max_items, size_t* count);
+
+// Decodes the Generic NACK entries of an RTPFB FMT=1 message
+size_t ParseNackItems(const FeedbackMessage& feedback, NackItem* items, size_t max_items);
+
+// Writes the 4 byte common header; packet_size includes the header and must
+// be a multiple of 4
+void WriteRtcpHeader(uint8_t* buf, uint8_t count, uint8_t packet_type, size_t packet_size);
+
+// RtcpWriter appends packets to a compound RTCP packet in a caller buffer.
+// Every Add method writes nothing and returns false if the packet does not
+// fit, so a full buffer leaves a valid compound packet behind.
+class RtcpWriter {
+public:
+    RtcpWriter(uint8_t* buf, size_t buf_size) : buf_(buf), capacity_(buf_size) {}
+
+    bool AddSenderReport(uint32_t sender_ssrc, const SenderInfo& info,
+                         const ReportBlock* blocks, size_t block_count);
+    bool AddReceiverReport(uint32_t sender_ssrc, const ReportBlock* blocks, size_t block_count);
+
+    // Items of the same SSRC must be adjacent; each run becomes one chunk
+    bool AddSdes(const SdesItem* items, size_t item_count);
+    bool AddCname(uint32_t ssrc, const char* cname, size_t size);
+
+    bool AddBye(const uint32_t* ssrcs, size_t ssrc_count, const char* reason = nullptr, size_t reason_size = 0);
+
+    // Generic RTPFB/PSFB message; fci_size must be a multiple of 4
+    bool AddFeedback(uint8_t packet_type, uint8_t fmt, uint32_t sender_ssrc, uint32_t media_ssrc,
+                     const uint8_t* fci, size_t fci_size);
+    bool AddNack(uint32_t sender_ssrc, uint32_t media_ssrc, const NackItem* items, size_t item_count);
+    bool AddPli(uint32_t sender_ssrc, uint32_t media_ssrc);
+
+    // Compound packet written so far
+    const uint8_t* data() const { return buf_; }
+    size_t size() const { return size_; }
+
+    // Starts a new compound packet in the same buffer
+    void Reset() { size_ = 0; }
+
+private:
+    uint8_t* Reserve(size_t size);
+
+    uint8_t* buf_;
+    size_t capacity_;
+    size_t size_ = 0;
+};
+
+} // namespace rtp
+
+#endif // RTCP_PACKET_H_
\ No newline at end of file
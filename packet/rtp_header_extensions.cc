@@ -0,0 +1,328 @@
+#include "rtp_header_extensions.h"
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    constexpr size_t kExtensionTypeCount = static_cast<size_t>(ExtensionType::kCount);
+
+    // Indexed by ExtensionType
+    const char* const kExtensionUris[kExtensionTypeCount] = {
+        "",
+        "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time",
+        "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01",
+        "urn:ietf:params:rtp-hdrext:ssrc-audio-level",
+        "urn:ietf:params:rtp-hdrext:sdes:mid",
+        "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id",
+        "urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id",
+        "http://www.webrtc.org/experiments/rtp-hdrext/playout-delay",
+        "urn:3gpp:video-orientation",
+        "http://www.webrtc.org/experiments/rtp-hdrext/abs-capture-time",
+    };
+
+    // Largest string the one-byte profile can carry
+    constexpr size_t kMaxStringSize = 16;
+
+    // playout-delay fields are 12 bits in units of 10ms
+    constexpr int kPlayoutDelayGranularityMs = 10;
+    constexpr int kPlayoutDelayMaxValue = 0xFFF;
+
+    uint64_t ReadUint64(const uint8_t* buf) {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) {
+            value = (value << 8) | buf[i];
+        }
+        return value;
+    }
+
+    void WriteUint64(uint8_t* buf, uint64_t value) {
+        for (int i = 7; i >= 0; i--) {
+            buf[i] = static_cast<uint8_t>(value);
+            value >>= 8;
+        }
+    }
+}
+
+const char* GetExtensionUri(ExtensionType type) {
+    size_t index = static_cast<size_t>(type);
+    return index < kExtensionTypeCount ? kExtensionUris[index] : "";
+}
+
+//----------------------------------------
+// ExtensionMap
+//----------------------------------------
+
+ExtensionMap::ExtensionMap() {
+    std::memset(ids_, 0, sizeof(ids_));
+    for (auto& type : types_) {
+        type = ExtensionType::kNone;
+    }
+}
+
+bool ExtensionMap::Register(ExtensionType type, uint8_t id) {
+    if (type == ExtensionType::kNone || type >= ExtensionType::kCount || id == 0) {
+        return false;
+    }
+    
+    if (types_[id] != ExtensionType::kNone && types_[id] != type) {
+        return false;
+    }
+    
+    Deregister(type);
+    ids_[static_cast<size_t>(type)] = id;
+    types_[id] = type;
+    return true;
+}
+
+bool ExtensionMap::Register(const std::string& uri, uint8_t id) {
+    for (size_t i = 1; i < kExtensionTypeCount; i++) {
+        if (uri == kExtensionUris[i]) {
+            return Register(static_cast<ExtensionType>(i), id);
+        }
+    }
+    return false;
+}
+
+void ExtensionMap::Deregister(ExtensionType type) {
+    if (type >= ExtensionType::kCount) {
+        return;
+    }
+    
+    uint8_t id = ids_[static_cast<size_t>(type)];
+    if (id != 0) {
+        types_[id] = ExtensionType::kNone;
+        ids_[static_cast<size_t>(type)] = 0;
+    }
+}
+
+//----------------------------------------
+// Extension encodings
+//----------------------------------------
+
+bool AbsSendTimeExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    if (size != 3) {
+        return false;
+    }
+    *value = (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8) | data[2];
+    return true;
+}
+
+size_t AbsSendTimeExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    if (size < 3) {
+        return 0;
+    }
+    buf[0] = static_cast<uint8_t>(value >> 16);
+    buf[1] = static_cast<uint8_t>(value >> 8);
+    buf[2] = static_cast<uint8_t>(value);
+    return 3;
+}
+
+bool TransportSequenceNumberExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    if (size != 2) {
+        return false;
+    }
+    *value = static_cast<uint16_t>((data[0] << 8) | data[1]);
+    return true;
+}
+
+size_t TransportSequenceNumberExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    if (size < 2) {
+        return 0;
+    }
+    buf[0] = static_cast<uint8_t>(value >> 8);
+    buf[1] = static_cast<uint8_t>(value);
+    return 2;
+}
+
+bool AudioLevelExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    if (size != 1) {
+        return false;
+    }
+    value->voice_activity = (data[0] & 0x80) != 0;
+    value->level = data[0] & 0x7F;
+    return true;
+}
+
+size_t AudioLevelExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    if (size < 1 || value.level > 0x7F) {
+        return 0;
+    }
+    buf[0] = static_cast<uint8_t>((value.voice_activity ? 0x80 : 0) | value.level);
+    return 1;
+}
+
+bool StringExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    // Trailing null bytes are padding, not part of the value
+    while (size > 0 && data[size - 1] == 0) {
+        size--;
+    }
+    if (size == 0) {
+        return false;
+    }
+    value->data = reinterpret_cast<const char*>(data);
+    value->size = size;
+    return true;
+}
+
+size_t StringExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    if (!value.data || value.size == 0 || value.size > kMaxStringSize || size < value.size) {
+        return 0;
+    }
+    std::memcpy(buf, value.data, value.size);
+    return value.size;
+}
+
+bool PlayoutDelayExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    if (size != 3) {
+        return false;
+    }
+    uint32_t raw = (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8) | data[2];
+    value->min_ms = static_cast<int>(raw >> 12) * kPlayoutDelayGranularityMs;
+    value->max_ms = static_cast<int>(raw & 0xFFF) * kPlayoutDelayGranularityMs;
+    return true;
+}
+
+size_t PlayoutDelayExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    int min_value = value.min_ms / kPlayoutDelayGranularityMs;
+    int max_value = value.max_ms / kPlayoutDelayGranularityMs;
+    if (size < 3 || min_value < 0 || max_value < min_value || max_value > kPlayoutDelayMaxValue) {
+        return 0;
+    }
+    uint32_t raw = (static_cast<uint32_t>(min_value) << 12) | static_cast<uint32_t>(max_value);
+    buf[0] = static_cast<uint8_t>(raw >> 16);
+    buf[1] = static_cast<uint8_t>(raw >> 8);
+    buf[2] = static_cast<uint8_t>(raw);
+    return 3;
+}
+
+bool VideoOrientationExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    if (size != 1) {
+        return false;
+    }
+    value->camera_back = (data[0] & 0x08) != 0;
+    value->flip = (data[0] & 0x04) != 0;
+    value->rotation = static_cast<uint16_t>((data[0] & 0x03) * 90);
+    return true;
+}
+
+size_t VideoOrientationExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    if (size < 1 || value.rotation % 90 != 0 || value.rotation >= 360) {
+        return 0;
+    }
+    buf[0] = static_cast<uint8_t>((value.camera_back ? 0x08 : 0) | (value.flip ? 0x04 : 0) |
+                                  (value.rotation / 90));
+    return 1;
+}
+
+bool AbsoluteCaptureTimeExtension::Parse(const uint8_t* data, size_t size, value_type* value) {
+    if (size != 8 && size != 16) {
+        return false;
+    }
+    value->absolute_capture_timestamp = ReadUint64(data);
+    value->has_estimated_capture_clock_offset = size == 16;
+    value->estimated_capture_clock_offset = size == 16 ? static_cast<int64_t>(ReadUint64(data + 8)) : 0;
+    return true;
+}
+
+size_t AbsoluteCaptureTimeExtension::Write(uint8_t* buf, size_t size, const value_type& value) {
+    size_t value_size = ValueSize(value);
+    if (size < value_size) {
+        return 0;
+    }
+    WriteUint64(buf, value.absolute_capture_timestamp);
+    if (value.has_estimated_capture_clock_offset) {
+        WriteUint64(buf + 8, static_cast<uint64_t>(value.estimated_capture_clock_offset));
+    }
+    return value_size;
+}
+
+//----------------------------------------
+// ExtensionReader
+//----------------------------------------
+
+ExtensionReader::ExtensionReader(const PacketView& packet, const ExtensionMap* map)
+    : data_(packet.extension_data()),
+      size_(packet.extension_size()),
+      profile_(packet.extension_profile()),
+      map_(map) {
+}
+
+void ExtensionReader::Index() const {
+    indexed_ = true;
+    
+    bool one_byte = profile_ == kExtensionProfileOneByte;
+    bool two_byte = (profile_ & 0xFFF0) == kExtensionProfileTwoByte;
+    
+    // Only the IDs the profile can carry need clearing
+    std::memset(offsets_, 0, (one_byte ? 16 : 256) * sizeof(offsets_[0]));
+    if (!one_byte && !two_byte) {
+        return;
+    }
+    
+    size_t n = 0;
+    while (n < size_) {
+        if (data_[n] == 0x00) { // padding
+            n++;
+            continue;
+        }
+        
+        uint8_t id;
+        size_t length;
+        if (one_byte) {
+            id = data_[n] >> 4;
+            length = static_cast<size_t>((data_[n] & 0x0F) + 1);
+            n++;
+            if (id == kExtensionIDReserved) {
+                break;
+            }
+        } else {
+            if (n + 1 >= size_) {
+                break;
+            }
+            id = data_[n];
+            length = data_[n + 1];
+            n += 2;
+        }
+        
+        if (n + length > size_) {
+            break;
+        }
+        
+        // The first element of an ID wins
+        if (offsets_[id] == 0) {
+            offsets_[id] = static_cast<uint16_t>(n + 1);
+            sizes_[id] = static_cast<uint8_t>(length);
+        }
+        n += length;
+    }
+}
+
+bool ExtensionReader::Find(uint8_t id, const uint8_t** data, size_t* size) const {
+    if (id == 0 || !data || !size || size_ == 0) {
+        return false;
+    }
+    
+    if (!indexed_) {
+        Index();
+    }
+    
+    if (profile_ == kExtensionProfileOneByte && id > 15) {
+        return false;
+    }
+    
+    if (offsets_[id] == 0) {
+        return false;
+    }
+    *data = data_ + offsets_[id] - 1;
+    *size = sizes_[id];
+    return true;
+}
+
+bool ExtensionReader::Has(ExtensionType type) const {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    return map_ && Find(map_->GetId(type), &data, &size);
+}
+
+} // namespace rtp
\ No newline at end of file
@@ -0,0 +1,217 @@
+#ifndef RTP_HEADER_EXTENSIONS_H_
+#define RTP_HEADER_EXTENSIONS_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "rtp_packet.h"
+
+namespace rtp {
+
+// Header extensions known to the registry
+enum class ExtensionType : uint8_t {
+    kNone = 0,
+    kAbsSendTime,
+    kTransportSequenceNumber,
+    kAudioLevel,
+    kMid,
+    kRtpStreamId,
+    kRepairedRtpStreamId,
+    kPlayoutDelay,
+    kVideoOrientation,
+    kAbsoluteCaptureTime,
+    kCount
+};
+
+// Returns the extmap URI of an extension type, or an empty string for kNone
+const char* GetExtensionUri(ExtensionType type);
+
+// ExtensionMap holds the extmap IDs negotiated for a session, in both
+// directions: type to ID and ID to type are plain array lookups
+class ExtensionMap {
+public:
+    ExtensionMap();
+
+    // IDs 1-14 fit the one-byte profile, 1-255 the two-byte profile
+    // Returns false if the ID is invalid or already taken by another type
+    bool Register(ExtensionType type, uint8_t id);
+    bool Register(const std::string& uri, uint8_t id);
+    void Deregister(ExtensionType type);
+
+    // 0 if the type is not registered
+    uint8_t GetId(ExtensionType type) const { return ids_[static_cast<size_t>(type)]; }
+
+    // kNone if the ID is not registered
+    ExtensionType GetType(uint8_t id) const { return types_[id]; }
+
+    bool IsRegistered(ExtensionType type) const { return GetId(type) != 0; }
+
+private:
+    uint8_t ids_[static_cast<size_t>(ExtensionType::kCount)];
+    ExtensionType types_[256];
+};
+
+// Non-owning string value of the MID, RID and RRID extensions
+struct StringExtensionValue {
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+// audio-level (RFC 6464): level in -dBov, 0 to 127
+struct AudioLevel {
+    bool voice_activity = false;
+    uint8_t level = 127;
+};
+
+// playout-delay: bounds in milliseconds, 10ms granularity on the wire
+struct PlayoutDelay {
+    int min_ms = 0;
+    int max_ms = 0;
+};
+
+// Coordination of video orientation (3GPP TS 26.114)
+struct VideoOrientation {
+    bool camera_back = false;
+    bool flip = false;
+    uint16_t rotation = 0;           // 0, 90, 180 or 270 degrees
+};
+
+// abs-capture-time: Q32.32 NTP capture timestamp and optional Q32.32 clock
+// offset estimate
+struct AbsoluteCaptureTime {
+    uint64_t absolute_capture_timestamp = 0;
+    bool has_estimated_capture_clock_offset = false;
+    int64_t estimated_capture_clock_offset = 0;
+};
+
+// Each extension is a traits struct: Parse() decodes straight from the wire
+// bytes, ValueSize() and Write() encode a value for a caller buffer
+struct AbsSendTimeExtension {
+    static constexpr ExtensionType kType = ExtensionType::kAbsSendTime;
+    using value_type = uint32_t;     // 6.18 fixed point seconds, 24 bits
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type&) { return 3; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+struct TransportSequenceNumberExtension {
+    static constexpr ExtensionType kType = ExtensionType::kTransportSequenceNumber;
+    using value_type = uint16_t;
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type&) { return 2; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+struct AudioLevelExtension {
+    static constexpr ExtensionType kType = ExtensionType::kAudioLevel;
+    using value_type = AudioLevel;
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type&) { return 1; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+// MID, RID and RRID share the 1 to 16 character string encoding
+struct StringExtension {
+    using value_type = StringExtensionValue;
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type& value) { return value.size; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+struct MidExtension : StringExtension {
+    static constexpr ExtensionType kType = ExtensionType::kMid;
+};
+
+struct RtpStreamIdExtension : StringExtension {
+    static constexpr ExtensionType kType = ExtensionType::kRtpStreamId;
+};
+
+struct RepairedRtpStreamIdExtension : StringExtension {
+    static constexpr ExtensionType kType = ExtensionType::kRepairedRtpStreamId;
+};
+
+struct PlayoutDelayExtension {
+    static constexpr ExtensionType kType = ExtensionType::kPlayoutDelay;
+    using value_type = PlayoutDelay;
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type&) { return 3; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+struct VideoOrientationExtension {
+    static constexpr ExtensionType kType = ExtensionType::kVideoOrientation;
+    using value_type = VideoOrientation;
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type&) { return 1; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+struct AbsoluteCaptureTimeExtension {
+    static constexpr ExtensionType kType = ExtensionType::kAbsoluteCaptureTime;
+    using value_type = AbsoluteCaptureTime;
+    static bool Parse(const uint8_t* data, size_t size, value_type* value);
+    static size_t ValueSize(const value_type& value) { return value.has_estimated_capture_clock_offset ? 16 : 8; }
+    static size_t Write(uint8_t* buf, size_t size, const value_type& value);
+};
+
+// ExtensionReader looks up the header extensions of a parsed packet by ID.
+// The first lookup walks the extension block once and fills an offset table
+// (15 entries for the one-byte profile, 255 for the two-byte profile); every
+// later lookup is an array access. The packet buffer must outlive the
+// reader.
+class ExtensionReader {
+public:
+    explicit ExtensionReader(const PacketView& packet, const ExtensionMap* map = nullptr);
+
+    // Raw element payload by ID
+    bool Find(uint8_t id, const uint8_t** data, size_t* size) const;
+
+    // Typed access through the extension map
+    bool Has(ExtensionType type) const;
+
+    template <typename Extension>
+    bool Get(typename Extension::value_type* value) const {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        if (!map_ || !value || !Find(map_->GetId(Extension::kType), &data, &size)) {
+            return false;
+        }
+        return Extension::Parse(data, size, value);
+    }
+
+private:
+    void Index() const;
+
+    const uint8_t* data_;
+    size_t size_;
+    uint16_t profile_;
+    const ExtensionMap* map_;
+
+    // Element offset + 1 within the block, 0 if absent
+    mutable bool indexed_ = false;
+    mutable uint16_t offsets_[256];
+    mutable uint8_t sizes_[256];
+};
+
+// Overwrites the value of an extension already present in a serialized
+// packet, e.g. abs-send-time right before sending. The encoded value must
+// have the size of the element in the packet.
+template <typename Extension>
+bool UpdateExtension(uint8_t* packet, size_t size, uint8_t id, const typename Extension::value_type& value) {
+    PacketView view;
+    if (!view.Parse(packet, size)) {
+        return false;
+    }
+    
+    ExtensionReader reader(view);
+    const uint8_t* data = nullptr;
+    size_t data_size = 0;
+    if (!reader.Find(id, &data, &data_size) || Extension::ValueSize(value) != data_size) {
+        return false;
+    }
+    return Extension::Write(packet + (data - packet), data_size, value) == data_size;
+}
+
+} // namespace rtp
+
+#endif // RTP_HEADER_EXTENSIONS_H_
\ No newline at end of file
@@ -4,8 +4,7 @@
 #include <random>
 #include <chrono>
 #include <algorithm>
-#include <mutex>
-#include <mutex>
+#include <thread>
 
 namespace rtp {
 
@@ -34,14 +33,27 @@ namespace {
         data[3] = static_cast<uint8_t>(value & 0xFF);
     }
 
-    // Global random generator with seed
-    std::mt19937 CreateRandomGenerator() {
-        auto seed = std::chrono::system_clock::now().time_since_epoch().count();
-        return std::mt19937(static_cast<unsigned int>(seed));
+    // Per-thread random generator, so creating streams on many threads at once
+    // does not contend on a shared generator
+    std::mt19937& ThreadRandomGenerator() {
+        thread_local std::mt19937 generator([] {
+            std::random_device device;
+            auto time_seed = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto thread_seed = std::hash<std::thread::id>()(std::this_thread::get_id());
+            std::seed_seq seed{device(), 
+                               static_cast<uint32_t>(time_seed), 
+                               static_cast<uint32_t>(thread_seed)};
+            return std::mt19937(seed);
+        }());
+        return generator;
+    }
+
+    uint16_t RandomInitialSequenceNumber() {
+        // Use only half the potential sequence number space to avoid issues with SRTP
+        constexpr uint16_t max_initial_random_seq = (1 << 15) - 1;
+        std::uniform_int_distribution<uint16_t> dist(0, max_initial_random_seq);
+        return dist(ThreadRandomGenerator());
     }
-    
-    std::mt19937 global_random_generator = CreateRandomGenerator();
-    std::mutex random_mutex;
 }
 
 // Header implementation
@@ -163,7 +175,15 @@ bool Header::PacketizeTo(std::vector<uint8_t>* buf) const {
         buf->resize(size);
     }
     
-    uint8_t& first_byte = (*buf)[0];
+    return PacketizeTo(buf->data(), buf->size());
+}
+
+bool Header::PacketizeTo(uint8_t* buf, size_t buf_size) const {
+    if (!buf || buf_size < PacketSize()) {
+        return false;
+    }
+    
+    uint8_t& first_byte = buf[0];
     first_byte = (version << kVersionShift) | (csrc.size() & kCCMask);
     if (padding) {
         first_byte |= (1 << kPaddingShift);
@@ -172,24 +192,24 @@ bool Header::PacketizeTo(std::vector<uint8_t>* buf) const {
         first_byte |= (1 << kExtensionShift);
     }
     
-    (*buf)[1] = payload_type;
+    buf[1] = payload_type;
     if (marker) {
-        (*buf)[1] |= (1 << kMarkerShift);
+        buf[1] |= (1 << kMarkerShift);
     }
     
-    HostToNetwork16(sequence_number, &(*buf)[kSeqNumOffset]);
-    HostToNetwork32(timestamp, &(*buf)[kTimestampOffset]);
-    HostToNetwork32(ssrc, &(*buf)[kSsrcOffset]);
+    HostToNetwork16(sequence_number, &buf[kSeqNumOffset]);
+    HostToNetwork32(timestamp, &buf[kTimestampOffset]);
+    HostToNetwork32(ssrc, &buf[kSsrcOffset]);
     
     size_t n = kCsrcOffset;
     for (uint32_t csrc_val : csrc) {
-        HostToNetwork32(csrc_val, &(*buf)[n]);
+        HostToNetwork32(csrc_val, &buf[n]);
         n += kCsrcLength;
     }
     
     if (extension) {
         size_t ext_header_pos = n;
-        HostToNetwork16(extension_profile, &(*buf)[n]);
+        HostToNetwork16(extension_profile, &buf[n]);
         n += 2;
         size_t ext_length_pos = n;
         n += 2; // Skip length for now
@@ -205,8 +225,8 @@ bool Header::PacketizeTo(std::vector<uint8_t>* buf) const {
                         return false;
                     }
                     
-                    (*buf)[n++] = (ext.id() << 4) | ((ext.payload().size() - 1) & 0x0F);
-                    std::copy(ext.payload().begin(), ext.payload().end(), buf->begin() + n);
+                    buf[n++] = (ext.id() << 4) | ((ext.payload().size() - 1) & 0x0F);
+                    std::copy(ext.payload().begin(), ext.payload().end(), buf + n);
                     n += ext.payload().size();
                 }
                 break;
@@ -220,9 +240,9 @@ bool Header::PacketizeTo(std::vector<uint8_t>* buf) const {
                         return false;
                     }
                     
-                    (*buf)[n++] = ext.id();
-                    (*buf)[n++] = static_cast<uint8_t>(ext.payload().size());
-                    std::copy(ext.payload().begin(), ext.payload().end(), buf->begin() + n);
+                    buf[n++] = ext.id();
+                    buf[n++] = static_cast<uint8_t>(ext.payload().size());
+                    std::copy(ext.payload().begin(), ext.payload().end(), buf + n);
                     n += ext.payload().size();
                 }
                 break;
@@ -233,7 +253,7 @@ bool Header::PacketizeTo(std::vector<uint8_t>* buf) const {
                     if (payload.size() % 4 != 0) {
                         return false;
                     }
-                    std::copy(payload.begin(), payload.end(), buf->begin() + n);
+                    std::copy(payload.begin(), payload.end(), buf + n);
                     n += payload.size();
                 }
                 break;
@@ -244,11 +264,11 @@ bool Header::PacketizeTo(std::vector<uint8_t>* buf) const {
         size_t rounded_ext_size = ((ext_size + 3) / 4) * 4;
         
         // Set the extension length (in 32-bit words)
-        HostToNetwork16(static_cast<uint16_t>(rounded_ext_size / 4), &(*buf)[ext_length_pos]);
+        HostToNetwork16(static_cast<uint16_t>(rounded_ext_size / 4), &buf[ext_length_pos]);
         
         // Add padding to reach 4 byte boundary
         for (size_t i = 0; i < rounded_ext_size - ext_size; i++) {
-            (*buf)[n++] = 0;
+            buf[n++] = 0;
         }
     }
     
@@ -295,7 +315,7 @@ bool Header::SetExtension(uint8_t id, const std::vector<uint8_t>& payload) {
                 if (id < 1 || id > 14) {
                     return false;
                 }
-                if (payload.size() > 16) {
+                if (payload.empty() || payload.size() > 16) {
                     return false;
                 }
                 break;
@@ -329,13 +349,17 @@ bool Header::SetExtension(uint8_t id, const std::vector<uint8_t>& payload) {
         return true;
     }
     
-    // No existing extensions, create first one
-    extension = true;
-    
+    // No existing extensions, create first one in the smallest profile that
+    // fits both the id and the payload
     size_t payload_len = payload.size();
-    if (payload_len <= 16) {
+    if (id < 1 || payload_len < 1 || payload_len > 255) {
+        return false;
+    }
+    
+    extension = true;
+    if (id <= 14 && payload_len <= 16) {
         extension_profile = kExtensionProfileOneByte;
-    } else if (payload_len < 256) {
+    } else {
         extension_profile = kExtensionProfileTwoByte;
     }
     
@@ -415,6 +439,9 @@ bool Packet::Depacketize(const std::vector<uint8_t>& buf) {
             return false;
         }
         padding_size = buf[end - 1];
+        if (padding_size == 0 || padding_size > end - header_size) {
+            return false;
+        }
         end -= padding_size;
     } else {
         padding_size = 0;
@@ -439,24 +466,55 @@ bool Packet::PacketizeTo(std::vector<uint8_t>* buf) const {
         return false;
     }
     
-    if (header.padding && padding_size == 0) {
+    size_t size = PacketSize();
+    if (buf->size() < size) {
+        buf->resize(size);
+    }
+    
+    return PacketizeTo(buf->data(), buf->size());
+}
+
+std::vector<uint8_t> Packet::Packetize(size_t headroom, size_t tailroom) const {
+    std::vector<uint8_t> buf(headroom + PacketSize() + tailroom);
+    PacketizeTo(&buf, headroom, tailroom);
+    return buf;
+}
+
+bool Packet::PacketizeTo(std::vector<uint8_t>* buf, size_t headroom, size_t tailroom) const {
+    if (!buf) {
         return false;
     }
     
     size_t size = PacketSize();
-    if (buf->size() < size) {
-        buf->resize(size);
+    if (buf->size() < headroom + size + tailroom) {
+        buf->resize(headroom + size + tailroom);
+    }
+    
+    return PacketizeTo(buf->data() + headroom, size);
+}
+
+bool Packet::PacketizeTo(uint8_t* buf, size_t buf_size) const {
+    if (!buf) {
+        return false;
+    }
+    
+    if (header.padding && padding_size == 0) {
+        return false;
     }
     
-    if (!header.PacketizeTo(buf)) {
+    if (buf_size < PacketSize()) {
+        return false;
+    }
+    
+    if (!header.PacketizeTo(buf, buf_size)) {
         return false;
     }
     
     size_t header_size = header.PacketSize();
-    std::copy(payload.begin(), payload.end(), buf->begin() + header_size);
+    std::copy(payload.begin(), payload.end(), buf + header_size);
     
     if (header.padding) {
-        (*buf)[header_size + payload.size() + padding_size - 1] = padding_size;
+        buf[header_size + payload.size() + padding_size - 1] = padding_size;
     }
     
     return true;
@@ -487,45 +545,281 @@ std::string Packet::ToString() const {
     return ss.str();
 }
 
-// RandomSequencer implementation
-RandomSequencer::RandomSequencer() {
-    std::lock_guard<std::mutex> lock(random_mutex);
-    // Use only half the potential sequence number space to avoid issues with SRTP
-    constexpr uint16_t max_initial_random_seq = (1 << 15) - 1;
-    std::uniform_int_distribution<uint16_t> dist(0, max_initial_random_seq);
-    sequence_number_ = dist(global_random_generator);
+// PacketView implementation
+bool PacketView::Parse(const uint8_t* data, size_t size) {
+    data_ = data;
+    size_ = size;
+    extension_profile_ = 0;
+    extension_offset_ = 0;
+    extension_size_ = 0;
+
+    if (!data || size < kCsrcOffset) {
+        return false;
+    }
+
+    size_t n = kCsrcOffset + (csrc_count() * kCsrcLength);
+    if (size < n) {
+        return false;
+    }
+
+    if (extension()) {
+        if (size < n + 4) {
+            return false;
+        }
+
+        extension_profile_ = NetworkToHost16(&data[n]);
+        size_t extension_length = NetworkToHost16(&data[n + 2]) * 4;
+        n += 4;
+
+        if (size < n + extension_length) {
+            return false;
+        }
+
+        extension_offset_ = n;
+        extension_size_ = extension_length;
+        n += extension_length;
+    }
+
+    header_size_ = n;
+
+    size_t end = size;
+    if (padding()) {
+        if (end <= header_size_) {
+            return false;
+        }
+        padding_size_ = data[end - 1];
+        if (padding_size_ == 0 || padding_size_ > end - header_size_) {
+            return false;
+        }
+        end -= padding_size_;
+    } else {
+        padding_size_ = 0;
+    }
+
+    if (end < header_size_) {
+        return false;
+    }
+
+    payload_size_ = end - header_size_;
+    return true;
+}
+
+uint16_t PacketView::sequence_number() const {
+    return NetworkToHost16(&data_[kSeqNumOffset]);
+}
+
+uint32_t PacketView::timestamp() const {
+    return NetworkToHost32(&data_[kTimestampOffset]);
+}
+
+uint32_t PacketView::ssrc() const {
+    return NetworkToHost32(&data_[kSsrcOffset]);
+}
+
+uint32_t PacketView::csrc(size_t index) const {
+    return NetworkToHost32(&data_[kCsrcOffset + (index * kCsrcLength)]);
 }
 
-uint16_t RandomSequencer::NextSequenceNumber() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sequence_number_++;
-    if (sequence_number_ == 0) {
-        roll_over_count_++;
+bool PacketView::GetExtension(uint8_t id, const uint8_t** payload, size_t* size) const {
+    if (!payload || !size || extension_size_ == 0) {
+        return false;
     }
-    return sequence_number_;
+
+    const uint8_t* ext = data_ + extension_offset_;
+    size_t n = 0;
+
+    if (extension_profile_ != kExtensionProfileOneByte &&
+        extension_profile_ != kExtensionProfileTwoByte) {
+        // RFC3550 Extension, exposed as id 0
+        if (id != 0) {
+            return false;
+        }
+        *payload = ext;
+        *size = extension_size_;
+        return true;
+    }
+
+    while (n < extension_size_) {
+        if (ext[n] == 0x00) { // padding
+            n++;
+            continue;
+        }
+
+        uint8_t ext_id;
+        size_t payload_len;
+
+        if (extension_profile_ == kExtensionProfileOneByte) {
+            ext_id = ext[n] >> 4;
+            payload_len = static_cast<size_t>((ext[n] & 0x0F) + 1);
+            n++;
+
+            if (ext_id == kExtensionIDReserved) {
+                return false;
+            }
+        } else { // Two-byte profile
+            ext_id = ext[n];
+            n++;
+
+            if (n >= extension_size_) {
+                return false;
+            }
+
+            payload_len = ext[n];
+            n++;
+        }
+
+        if (n + payload_len > extension_size_) {
+            return false;
+        }
+
+        if (ext_id == id) {
+            *payload = ext + n;
+            *size = payload_len;
+            return true;
+        }
+
+        n += payload_len;
+    }
+
+    return false;
 }
 
-uint64_t RandomSequencer::RollOverCount() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return roll_over_count_;
+// PacketArena implementation
+HeaderTemplate::HeaderTemplate() {
+    Update(Header());
 }
 
-// FixedSequencer implementation
-FixedSequencer::FixedSequencer(uint16_t starting_seq) 
-    : sequence_number_(starting_seq - 1) {} // -1 because first call increments
+HeaderTemplate::HeaderTemplate(const Header& header) {
+    Update(header);
+}
+
+bool HeaderTemplate::Update(const Header& header) {
+    std::vector<uint8_t> bytes(header.PacketSize());
+    if (!header.PacketizeTo(bytes.data(), bytes.size())) {
+        return false;
+    }
+    bytes_ = std::move(bytes);
+    return true;
+}
 
-uint16_t FixedSequencer::NextSequenceNumber() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sequence_number_++;
-    if (sequence_number_ == 0) {
-        roll_over_count_++;
+void HeaderTemplate::WriteTo(uint8_t* buf, uint16_t sequence_number, uint32_t timestamp, bool marker) const {
+    std::memcpy(buf, bytes_.data(), bytes_.size());
+    
+    if (marker) {
+        buf[1] |= kMarkerMask << kMarkerShift;
+    } else {
+        buf[1] &= ~(kMarkerMask << kMarkerShift);
     }
-    return sequence_number_;
+    
+    buf[kSeqNumOffset] = static_cast<uint8_t>(sequence_number >> 8);
+    buf[kSeqNumOffset + 1] = static_cast<uint8_t>(sequence_number);
+    
+    buf[kTimestampOffset] = static_cast<uint8_t>(timestamp >> 24);
+    buf[kTimestampOffset + 1] = static_cast<uint8_t>(timestamp >> 16);
+    buf[kTimestampOffset + 2] = static_cast<uint8_t>(timestamp >> 8);
+    buf[kTimestampOffset + 3] = static_cast<uint8_t>(timestamp);
 }
 
-uint64_t FixedSequencer::RollOverCount() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return roll_over_count_;
+void HeaderTemplate::Patch(size_t offset, const uint8_t* data, size_t size) {
+    if (offset + size <= bytes_.size()) {
+        std::memcpy(bytes_.data() + offset, data, size);
+    }
 }
 
+PacketArena::PacketArena(std::vector<uint8_t>* data, std::vector<size_t>* offsets,
+                         size_t headroom, size_t tailroom)
+    : data_(data), offsets_(offsets), headroom_(headroom), tailroom_(tailroom) {
+    Clear();
+}
+
+void PacketArena::Clear() {
+    data_->clear();
+    offsets_->assign(1, 0);
+}
+
+uint8_t* PacketArena::Begin(size_t max_size) {
+    size_t start = offsets_->back();
+    data_->resize(start + headroom_ + max_size + tailroom_);
+    return data_->data() + start + headroom_;
+}
+
+bool PacketArena::Commit(size_t size) {
+    size_t end = offsets_->back() + headroom_ + size + tailroom_;
+    data_->resize(end);
+    offsets_->push_back(end);
+    return true;
+}
+
+size_t PacketArena::Count() const {
+    return offsets_->size() - 1;
+}
+
+uint8_t* PacketArena::PacketData(size_t index) {
+    return data_->data() + (*offsets_)[index] + headroom_;
+}
+
+const uint8_t* PacketArena::PacketData(size_t index) const {
+    return data_->data() + (*offsets_)[index] + headroom_;
+}
+
+size_t PacketArena::PacketSize(size_t index) const {
+    return (*offsets_)[index + 1] - (*offsets_)[index] - headroom_ - tailroom_;
+}
+
+void PacketArena::CopyTo(std::vector<std::vector<uint8_t>>* packets) const {
+    packets->clear();
+    packets->reserve(Count());
+    for (size_t i = 0; i < Count(); i++) {
+        packets->emplace_back(PacketData(i), PacketData(i) + PacketSize(i));
+    }
+}
+
+// SinkWriter implementation
+SinkWriter::SinkWriter(PacketSink* sink, std::vector<uint8_t>* buffer,
+                       size_t headroom, size_t tailroom)
+    : sink_(sink), buffer_(buffer), headroom_(headroom), tailroom_(tailroom) {}
+
+uint8_t* SinkWriter::Begin(size_t max_size) {
+    size_t needed = headroom_ + max_size + tailroom_;
+    if (buffer_->size() < needed) {
+        buffer_->resize(needed);
+    }
+    return buffer_->data() + headroom_;
+}
+
+bool SinkWriter::Commit(size_t size) {
+    return sink_->OnWritablePacket(buffer_->data() + headroom_, size, headroom_, tailroom_);
+}
+
+// AtomicSequencer implementation
+AtomicSequencer::AtomicSequencer(uint16_t first_sequence_number)
+    : next_extended_sequence_number_(first_sequence_number) {}
+
+uint16_t AtomicSequencer::NextSequenceNumber() {
+    return static_cast<uint16_t>(Reserve(1));
+}
+
+uint64_t AtomicSequencer::RollOverCount() {
+    return ExtendedSequenceNumber() >> 16;
+}
+
+uint64_t AtomicSequencer::Reserve(size_t count) {
+    return next_extended_sequence_number_.fetch_add(count, std::memory_order_relaxed) &
+           kExtendedSequenceNumberMask;
+}
+
+uint64_t AtomicSequencer::ExtendedSequenceNumber() {
+    // Before the first number the count stays at ROC 0 rather than wrapping
+    uint64_t next = next_extended_sequence_number_.load(std::memory_order_relaxed);
+    return (next == 0 ? 0 : next - 1) & kExtendedSequenceNumberMask;
+}
+
+// RandomSequencer implementation
+RandomSequencer::RandomSequencer() 
+    : AtomicSequencer(RandomInitialSequenceNumber()) {}
+
+// FixedSequencer implementation
+FixedSequencer::FixedSequencer(uint16_t starting_seq) 
+    : AtomicSequencer(starting_seq) {}
+
 } // namespace rtp
\ No newline at end of file
@@ -6,7 +6,7 @@
 #include <vector>
 #include <memory>
 #include <sstream>
-#include <mutex>
+#include <atomic>
 
 namespace rtp {
 
@@ -60,6 +60,7 @@ public:
     // Parsing and serialization
     bool Depacketize(const std::vector<uint8_t>& buf, size_t* bytes_read);
     bool PacketizeTo(std::vector<uint8_t>* buf) const;
+    bool PacketizeTo(uint8_t* buf, size_t buf_size) const;
     std::vector<uint8_t> Packetize() const;
     size_t PacketSize() const;
 
@@ -86,6 +87,33 @@ public:
     std::vector<Extension> extensions;
 };
 
+// HeaderTemplate caches a Header in serialized form so the per-packet header
+// write is a fixed-size copy plus the sequence number, timestamp and marker
+// stores. Update() must be called again whenever SSRC, payload type, CSRCs or
+// extensions change.
+class HeaderTemplate {
+public:
+    HeaderTemplate();
+    explicit HeaderTemplate(const Header& header);
+
+    // Re-serializes the cached header bytes. Returns false, keeping the
+    // previous bytes, if the header cannot be serialized.
+    bool Update(const Header& header);
+
+    // Serialized header, including CSRCs and extensions
+    const uint8_t* data() const { return bytes_.data(); }
+    size_t size() const { return bytes_.size(); }
+
+    // Writes the header to buf, which must hold at least size() bytes
+    void WriteTo(uint8_t* buf, uint16_t sequence_number, uint32_t timestamp, bool marker) const;
+
+    // Overwrites cached bytes in place, e.g. an extension value of the same size
+    void Patch(size_t offset, const uint8_t* data, size_t size);
+
+private:
+    std::vector<uint8_t> bytes_;
+};
+
 // Packet represents a complete RTP packet
 class Packet {
 public:
@@ -96,8 +124,15 @@ public:
     bool Depacketize(const std::vector<uint8_t>& buf);
     std::vector<uint8_t> Packetize() const;
     bool PacketizeTo(std::vector<uint8_t>* buf) const;
+    bool PacketizeTo(uint8_t* buf, size_t buf_size) const;
     size_t PacketSize() const;
 
+    // Serializes the packet at offset headroom of buf, leaving at least
+    // tailroom bytes after it, so length prefixes or tunnel headers can be
+    // written in front and SRTP tags appended without moving the packet
+    std::vector<uint8_t> Packetize(size_t headroom, size_t tailroom) const;
+    bool PacketizeTo(std::vector<uint8_t>* buf, size_t headroom, size_t tailroom) const;
+
     // Clone
     std::shared_ptr<Packet> Clone() const;
     
@@ -110,6 +145,151 @@ public:
     uint8_t padding_size = 0;
 };
 
+// PacketView is a non-owning view of a serialized RTP packet. Parse() only
+// records offsets into the borrowed buffer and never allocates, so the buffer
+// must outlive the view.
+class PacketView {
+public:
+    PacketView() = default;
+
+    // Parsing
+    bool Parse(const uint8_t* data, size_t size);
+    bool Parse(const std::vector<uint8_t>& buf) { return Parse(buf.data(), buf.size()); }
+
+    // RTP header fields, decoded straight from the wire bytes
+    uint8_t version() const { return (data_[0] >> kVersionShift) & kVersionMask; }
+    bool padding() const { return ((data_[0] >> kPaddingShift) & kPaddingMask) > 0; }
+    bool extension() const { return ((data_[0] >> kExtensionShift) & kExtensionMask) > 0; }
+    bool marker() const { return ((data_[1] >> kMarkerShift) & kMarkerMask) > 0; }
+    uint8_t payload_type() const { return data_[1] & kPayloadTypeMask; }
+    uint16_t sequence_number() const;
+    uint32_t timestamp() const;
+    uint32_t ssrc() const;
+
+    // CSRC range
+    size_t csrc_count() const { return data_[0] & kCCMask; }
+    uint32_t csrc(size_t index) const;
+
+    // Extension block range (excluding the 4 byte profile/length word)
+    uint16_t extension_profile() const { return extension_profile_; }
+    const uint8_t* extension_data() const { return data_ + extension_offset_; }
+    size_t extension_size() const { return extension_size_; }
+
+    // Looks up an extension element in place, without copying its payload
+    bool GetExtension(uint8_t id, const uint8_t** payload, size_t* size) const;
+
+    // Payload range
+    const uint8_t* payload() const { return data_ + header_size_; }
+    size_t payload_size() const { return payload_size_; }
+    uint8_t padding_size() const { return padding_size_; }
+
+    // Whole packet
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t header_size() const { return header_size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t header_size_ = 0;
+    uint16_t extension_profile_ = 0;
+    size_t extension_offset_ = 0;
+    size_t extension_size_ = 0;
+    size_t payload_size_ = 0;
+    uint8_t padding_size_ = 0;
+};
+
+// PacketWriter is the destination packetizers serialize RTP packets into,
+// one packet at a time
+class PacketWriter {
+public:
+    virtual ~PacketWriter() = default;
+
+    // Starts the next packet; at most max_size bytes may be written to the
+    // returned buffer, which stays valid until Commit()
+    virtual uint8_t* Begin(size_t max_size) = 0;
+
+    // Finalizes the packet started by Begin() with its actual size
+    // Returns false if the writer wants packetization to stop
+    virtual bool Commit(size_t size) = 0;
+};
+
+// PacketArena writes serialized RTP packets back to back into caller-owned
+// storage, so packetizing a frame costs no per-packet allocation once the
+// storage has grown. offsets receives one entry per packet plus the end
+// offset: slot i spans [offsets[i], offsets[i + 1]) of data and holds
+// headroom bytes, the packet, then tailroom bytes. With no headroom or
+// tailroom the slot is exactly the packet.
+class PacketArena : public PacketWriter {
+public:
+    PacketArena(std::vector<uint8_t>* data, std::vector<size_t>* offsets,
+                size_t headroom = 0, size_t tailroom = 0);
+
+    // Drops all packets while keeping the storage capacity
+    void Clear();
+
+    // PacketWriter
+    uint8_t* Begin(size_t max_size) override;
+    bool Commit(size_t size) override;
+
+    // Packet access
+    size_t Count() const;
+    uint8_t* PacketData(size_t index);
+    const uint8_t* PacketData(size_t index) const;
+    size_t PacketSize(size_t index) const;
+
+    // Spare bytes reserved in front of and behind every packet
+    size_t headroom() const { return headroom_; }
+    size_t tailroom() const { return tailroom_; }
+
+    // Copies every packet out into its own vector, without the spare bytes
+    void CopyTo(std::vector<std::vector<uint8_t>>* packets) const;
+
+private:
+    std::vector<uint8_t>* data_;
+    std::vector<size_t>* offsets_;
+    size_t headroom_;
+    size_t tailroom_;
+};
+
+// PacketSink receives each serialized RTP packet as soon as it is finished
+class PacketSink {
+public:
+    virtual ~PacketSink() = default;
+
+    // The packet buffer is only valid for the duration of the call
+    // Returning false stops packetization of the current frame
+    virtual bool OnPacket(const uint8_t* packet, size_t size) = 0;
+
+    // Called by writers that reserve spare bytes around the packet: headroom
+    // bytes before packet and tailroom bytes after it may be written, so the
+    // packet can be framed or protected in place. Defaults to OnPacket().
+    virtual bool OnWritablePacket(uint8_t* packet, size_t size,
+                                  size_t /*headroom*/, size_t /*tailroom*/) {
+        return OnPacket(packet, size);
+    }
+};
+
+// SinkWriter builds one packet at a time in a reusable buffer and hands it to
+// a PacketSink on Commit(), so no more than one packet is held in memory.
+// The buffer keeps headroom bytes in front of and tailroom bytes behind the
+// packet for the sink to grow it in place.
+class SinkWriter : public PacketWriter {
+public:
+    SinkWriter(PacketSink* sink, std::vector<uint8_t>* buffer,
+               size_t headroom = 0, size_t tailroom = 0);
+
+    // PacketWriter
+    uint8_t* Begin(size_t max_size) override;
+    bool Commit(size_t size) override;
+
+private:
+    PacketSink* sink_;
+    std::vector<uint8_t>* buffer_;
+    size_t headroom_;
+    size_t tailroom_;
+};
+
 // Interface for payload processing
 class PayloadProcessor {
 public:
@@ -131,32 +311,48 @@ public:
     virtual ~Sequencer() = default;
     virtual uint16_t NextSequenceNumber() = 0;
     virtual uint64_t RollOverCount() = 0;
+
+    // Reserves count consecutive sequence numbers in one step and returns the
+    // extended number of the first; the 16-bit sequence number of the i-th
+    // packet is static_cast<uint16_t>(first + i)
+    virtual uint64_t Reserve(size_t count) = 0;
+
+    // Extended sequence number (ROC << 16 | seq) of the last number handed
+    // out. The first number always has ROC 0.
+    virtual uint64_t ExtendedSequenceNumber() = 0;
 };
 
-// Random sequencer implementation
-class RandomSequencer : public Sequencer {
+// Extended sequence numbers carry a 32-bit roll-over count above the 16-bit
+// sequence number
+constexpr uint64_t kExtendedSequenceNumberMask = (uint64_t(1) << 48) - 1;
+
+// AtomicSequencer hands out sequence numbers from a single atomic extended
+// counter, so concurrent callers never take a lock
+class AtomicSequencer : public Sequencer {
 public:
-    RandomSequencer();
     uint16_t NextSequenceNumber() override;
     uint64_t RollOverCount() override;
+    uint64_t Reserve(size_t count) override;
+    uint64_t ExtendedSequenceNumber() override;
+
+protected:
+    explicit AtomicSequencer(uint16_t first_sequence_number);
 
 private:
-    uint16_t sequence_number_;
-    uint64_t roll_over_count_ = 0;
-    mutable std::mutex mutex_;
+    // Extended number handed out next
+    std::atomic<uint64_t> next_extended_sequence_number_;
+};
+
+// Random sequencer implementation
+class RandomSequencer : public AtomicSequencer {
+public:
+    RandomSequencer();
 };
 
 // Fixed sequencer implementation
-class FixedSequencer : public Sequencer {
+class FixedSequencer : public AtomicSequencer {
 public:
     explicit FixedSequencer(uint16_t starting_seq);
-    uint16_t NextSequenceNumber() override;
-    uint64_t RollOverCount() override;
-
-private:
-    uint16_t sequence_number_;
-    uint64_t roll_over_count_ = 0;
-    mutable std::mutex mutex_;
 };
 
 } // namespace rtp
@@ -0,0 +1,258 @@
+#include "rtp_stream.h"
+#include "rtp_header_extensions.h"
+#include <cstring>
+#include <utility>
+
+namespace rtp {
+
+namespace {
+    // Two-byte transport-wide sequence number (transport-cc)
+    constexpr size_t kTransportSequenceNumberSize = 2;
+
+    // Version, flags, sequence number, timestamp and SSRC
+    constexpr size_t kFixedHeaderSize = kCsrcOffset;
+}
+
+StreamState::StreamState() 
+    : sequencer_(std::make_shared<RandomSequencer>()) {
+    UpdateTemplate();
+}
+
+void StreamState::SetSSRC(uint32_t ssrc) {
+    header_.ssrc = ssrc;
+    UpdateTemplate();
+}
+
+void StreamState::SetPayloadType(uint8_t payload_type) {
+    header_.payload_type = payload_type;
+    UpdateTemplate();
+}
+
+void StreamState::SetCSRCs(const std::vector<uint32_t>& csrcs) {
+    header_.csrc = csrcs;
+    UpdateTemplate();
+}
+
+void StreamState::SetHeader(const Header& header) {
+    header_ = header;
+    if (transport_sequencer_) {
+        header_.SetExtension(transport_extension_id_, std::vector<uint8_t>(kTransportSequenceNumberSize, 0));
+    }
+    for (const auto& slot : extensions_) {
+        header_.SetExtension(slot.id, slot.value);
+    }
+    UpdateTemplate();
+}
+
+void StreamState::SetSequencer(std::shared_ptr<Sequencer> sequencer) {
+    if (sequencer) {
+        sequencer_ = sequencer;
+    }
+}
+
+bool StreamState::SetTransportSequenceNumber(uint8_t extension_id, std::shared_ptr<Sequencer> sequencer) {
+    if (sequencer && !ExtensionIdFits(extension_id)) {
+        return false;
+    }
+    for (const auto& slot : extensions_) {
+        if (sequencer && slot.id == extension_id) {
+            return false;
+        }
+    }
+    
+    Header previous_header = header_;
+    std::shared_ptr<Sequencer> previous_sequencer = transport_sequencer_;
+    uint8_t previous_extension_id = transport_extension_id_;
+    
+    if (transport_sequencer_) {
+        RemoveHeaderExtension(transport_extension_id_);
+    }
+    transport_sequencer_ = nullptr;
+    
+    if (sequencer && header_.SetExtension(extension_id, std::vector<uint8_t>(kTransportSequenceNumberSize, 0))) {
+        transport_sequencer_ = sequencer;
+        transport_extension_id_ = extension_id;
+    }
+    
+    if (UpdateTemplate() && (!sequencer || transport_sequencer_)) {
+        return true;
+    }
+    
+    // Leave the stream exactly as it was before the call
+    header_ = std::move(previous_header);
+    transport_sequencer_ = std::move(previous_sequencer);
+    transport_extension_id_ = previous_extension_id;
+    UpdateTemplate();
+    return false;
+}
+
+bool StreamState::AddExtension(uint8_t id, const uint8_t* value, size_t size, ExtensionPlacement placement) {
+    if (!value || size == 0 || !ExtensionIdFits(id) || (transport_sequencer_ && id == transport_extension_id_)) {
+        return false;
+    }
+    for (const auto& slot : extensions_) {
+        if (slot.id == id) {
+            return false;
+        }
+    }
+    
+    Header previous_header = header_;
+    std::vector<uint8_t> bytes(value, value + size);
+    if (!header_.SetExtension(id, bytes)) {
+        header_ = std::move(previous_header);
+        return false;
+    }
+    
+    ExtensionSlot slot;
+    slot.id = id;
+    slot.placement = placement;
+    slot.value = std::move(bytes);
+    extensions_.push_back(std::move(slot));
+    if (!UpdateTemplate()) {
+        extensions_.pop_back();
+        header_ = std::move(previous_header);
+        UpdateTemplate();
+        return false;
+    }
+    return true;
+}
+
+bool StreamState::RemoveExtension(uint8_t id) {
+    for (auto it = extensions_.begin(); it != extensions_.end(); ++it) {
+        if (it->id == id) {
+            extensions_.erase(it);
+            RemoveHeaderExtension(id);
+            UpdateTemplate();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StreamState::SetExtensionValue(uint8_t id, const uint8_t* value, size_t size) {
+    for (auto& slot : extensions_) {
+        if (slot.id != id) {
+            continue;
+        }
+        // A different size would move every later header byte
+        if (!value || size != slot.value.size()) {
+            return false;
+        }
+        
+        std::memcpy(slot.value.data(), value, size);
+        header_template_.Patch(slot.value_offset, value, size);
+        header_.SetExtension(id, slot.value);
+        return true;
+    }
+    return false;
+}
+
+bool StreamState::GetExtensionOffset(uint8_t id, size_t* offset, size_t* size) const {
+    if (!offset || !size) {
+        return false;
+    }
+    
+    if (transport_sequencer_ && id == transport_extension_id_) {
+        *offset = transport_sequence_number_offset_;
+        *size = kTransportSequenceNumberSize;
+        return true;
+    }
+    
+    for (const auto& slot : extensions_) {
+        if (slot.id == id) {
+            *offset = slot.value_offset;
+            *size = slot.value.size();
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t StreamState::PayloadOverhead() const {
+    return header_template_.size() - kFixedHeaderSize + srtp_overhead_;
+}
+
+void StreamState::SetMarker(uint8_t* buf) {
+    buf[1] |= kMarkerMask << kMarkerShift;
+    
+    // Extensions of the last packet were left out when the header was written
+    for (const auto& slot : extensions_) {
+        if (slot.placement == ExtensionPlacement::kLastPacket) {
+            std::memcpy(buf + slot.element_offset, header_template_.data() + slot.element_offset, slot.element_size);
+        }
+    }
+    first_packet_ = true;
+}
+
+bool StreamState::ExtensionIdFits(uint8_t id) const {
+    // IDs 1-14 fit either profile, IDs above 14 only the two-byte profile
+    return id >= 1 && (id <= 14 || header_.extension_profile == kExtensionProfileTwoByte);
+}
+
+bool StreamState::UpdateTemplate() {
+    // Offsets below stay valid for the previous template if this fails
+    if (!header_template_.Update(header_)) {
+        return false;
+    }
+    has_placed_extensions_ = false;
+    
+    if (!transport_sequencer_ && extensions_.empty()) {
+        return true;
+    }
+    
+    // Locate every extension once, so writing a header only patches or
+    // blanks bytes at fixed offsets
+    PacketView view;
+    view.Parse(header_template_.data(), header_template_.size());
+    ExtensionReader reader(view);
+    size_t element_header_size = view.extension_profile() == kExtensionProfileOneByte ? 1 : 2;
+    const uint8_t* payload = nullptr;
+    size_t size = 0;
+    
+    if (transport_sequencer_) {
+        if (!reader.Find(transport_extension_id_, &payload, &size) || size != kTransportSequenceNumberSize) {
+            transport_sequencer_ = nullptr;
+        } else {
+            transport_sequence_number_offset_ = static_cast<size_t>(payload - header_template_.data());
+        }
+    }
+    
+    for (auto& slot : extensions_) {
+        if (!reader.Find(slot.id, &payload, &size)) {
+            continue;
+        }
+        slot.value_offset = static_cast<size_t>(payload - header_template_.data());
+        slot.element_offset = slot.value_offset - element_header_size;
+        slot.element_size = element_header_size + size;
+        has_placed_extensions_ = has_placed_extensions_ || slot.placement != ExtensionPlacement::kEveryPacket;
+    }
+    return true;
+}
+
+void StreamState::PlaceExtensions(uint8_t* buf, bool first, bool last) const {
+    for (const auto& slot : extensions_) {
+        bool placed = slot.placement == ExtensionPlacement::kEveryPacket ||
+                      (first && slot.placement == ExtensionPlacement::kFirstPacket) ||
+                      (last && slot.placement == ExtensionPlacement::kLastPacket);
+        if (!placed) {
+            // Zero bytes are padding between extension elements
+            std::memset(buf + slot.element_offset, 0, slot.element_size);
+        }
+    }
+}
+
+void StreamState::RemoveHeaderExtension(uint8_t id) {
+    header_.DeleteExtension(id);
+    if (header_.extensions.empty()) {
+        header_.extension = false;
+        header_.extension_profile = 0;
+    }
+}
+
+void StreamState::WriteTransportSequenceNumber(uint8_t* buf) const {
+    uint16_t sequence_number = transport_sequencer_->NextSequenceNumber();
+    buf[transport_sequence_number_offset_] = static_cast<uint8_t>(sequence_number >> 8);
+    buf[transport_sequence_number_offset_ + 1] = static_cast<uint8_t>(sequence_number);
+}
+
+} // namespace rtp
\ No newline at end of file
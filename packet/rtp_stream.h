@@ -0,0 +1,144 @@
+#ifndef RTP_STREAM_H_
+#define RTP_STREAM_H_
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "rtp_packet.h"
+
+namespace rtp {
+
+// Packets of a frame a per-packet header extension is written on
+enum class ExtensionPlacement {
+    kEveryPacket,
+    kFirstPacket,
+    kLastPacket
+};
+
+// StreamState is the per-stream RTP header state shared by every packetizer:
+// SSRC, payload type, timestamp, CSRCs and the sequencer. Packetizers write
+// each packet header from it in the same pass that fills the payload.
+class StreamState {
+public:
+    StreamState();
+    ~StreamState() = default;
+
+    // Fields that are part of the serialized header template
+    void SetSSRC(uint32_t ssrc);
+    void SetPayloadType(uint8_t payload_type);
+    void SetCSRCs(const std::vector<uint32_t>& csrcs);
+    void SetHeader(const Header& header);
+
+    // Timestamp of the frame being packetized, patched into every header
+    void SetTimestamp(uint32_t timestamp) { header_.timestamp = timestamp; }
+
+    // Replaces the sequence number generator, null is ignored
+    void SetSequencer(std::shared_ptr<Sequencer> sequencer);
+
+    // Stamps a transport-wide sequence number (transport-cc) header extension
+    // with the given one-byte extension id on every packet. The sequencer is
+    // normally shared by every stream of a transport. A null sequencer
+    // removes the extension again.
+    bool SetTransportSequenceNumber(uint8_t extension_id, std::shared_ptr<Sequencer> sequencer);
+
+    // Adds a header extension written on the packets given by placement.
+    // Its bytes are reserved in every header, so HeaderSize() is the same
+    // for all packets of a frame; packets it is not placed on carry RFC 8285
+    // padding bytes instead. The value size is fixed from here on.
+    bool AddExtension(uint8_t id, const uint8_t* value, size_t size,
+                      ExtensionPlacement placement = ExtensionPlacement::kEveryPacket);
+    bool RemoveExtension(uint8_t id);
+
+    // Replaces the value of an added extension for the following packets
+    bool SetExtensionValue(uint8_t id, const uint8_t* value, size_t size);
+
+    // Location of an extension value within every header this stream writes,
+    // so send-time values such as abs-send-time can be patched in place
+    bool GetExtensionOffset(uint8_t id, size_t* offset, size_t* size) const;
+
+    // Bytes appended to every packet after packetization, such as the SRTP
+    // authentication tag and MKI
+    void SetSrtpOverhead(size_t bytes) { srtp_overhead_ = bytes; }
+    size_t SrtpOverhead() const { return srtp_overhead_; }
+
+    // Bytes every packet spends beyond a plain 12 byte RTP header: CSRCs,
+    // header extensions and the SRTP overhead. Packetizers take it off their
+    // payload budget before fragmenting.
+    size_t PayloadOverhead() const;
+
+    // Payload bytes left of mtu once PayloadOverhead() is taken off
+    size_t PayloadBudget(size_t mtu) const {
+        size_t overhead = PayloadOverhead();
+        return mtu > overhead ? mtu - overhead : 0;
+    }
+
+    // Marks the start of a frame; the next header written is its first packet
+    void BeginFrame() { first_packet_ = true; }
+
+    // Accessors
+    uint32_t ssrc() const { return header_.ssrc; }
+    uint8_t payload_type() const { return header_.payload_type; }
+    uint32_t timestamp() const { return header_.timestamp; }
+    const std::vector<uint32_t>& csrcs() const { return header_.csrc; }
+    const Header& header() const { return header_; }
+    const std::shared_ptr<Sequencer>& sequencer() const { return sequencer_; }
+
+    // Size of every RTP header written for this stream
+    size_t HeaderSize() const { return header_template_.size(); }
+
+    // Claims count consecutive sequence numbers, see Sequencer::Reserve
+    uint64_t ReserveSequenceNumbers(size_t count) { return sequencer_->Reserve(count); }
+
+    // Writes the RTP header of a packet of the current frame to buf, which must
+    // hold at least HeaderSize() bytes. The marker bit also marks the last
+    // packet of the frame for extension placement.
+    void WriteHeader(uint8_t* buf, uint16_t sequence_number, bool marker) {
+        header_template_.WriteTo(buf, sequence_number, header_.timestamp, marker);
+        if (transport_sequencer_) {
+            WriteTransportSequenceNumber(buf);
+        }
+        if (has_placed_extensions_) {
+            PlaceExtensions(buf, first_packet_, marker);
+        }
+        first_packet_ = marker;
+    }
+
+    // Sets the marker bit of a header written earlier with marker false, for
+    // packetizers that only learn later that a packet ends the frame
+    void SetMarker(uint8_t* buf);
+
+private:
+    // Per-packet extension and the element bytes it spans in the template
+    struct ExtensionSlot {
+        uint8_t id = 0;
+        ExtensionPlacement placement = ExtensionPlacement::kEveryPacket;
+        std::vector<uint8_t> value;
+        size_t element_offset = 0;
+        size_t element_size = 0;
+        size_t value_offset = 0;
+    };
+
+    bool ExtensionIdFits(uint8_t id) const;
+    bool UpdateTemplate();
+    void WriteTransportSequenceNumber(uint8_t* buf) const;
+    void PlaceExtensions(uint8_t* buf, bool first, bool last) const;
+    void RemoveHeaderExtension(uint8_t id);
+
+    Header header_;
+    HeaderTemplate header_template_;
+    std::shared_ptr<Sequencer> sequencer_;
+
+    // Transport-wide sequence number, patched into the template copy
+    std::shared_ptr<Sequencer> transport_sequencer_;
+    uint8_t transport_extension_id_ = 0;
+    size_t transport_sequence_number_offset_ = 0;
+
+    std::vector<ExtensionSlot> extensions_;
+    bool has_placed_extensions_ = false;
+    bool first_packet_ = true;
+    size_t srtp_overhead_ = 0;
+};
+
+} // namespace rtp
+
+#endif // RTP_STREAM_H_
\ No newline at end of file
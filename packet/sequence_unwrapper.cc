@@ -0,0 +1,18 @@
+#include "sequence_unwrapper.h"
+
+namespace rtp {
+
+int64_t SequenceNumberUnwrapper::Unwrap(uint16_t sequence_number) {
+    if (!has_last_) {
+        last_ = sequence_number;
+        has_last_ = true;
+        return last_;
+    }
+    
+    // Signed distance from the previous number, in [-32768, 32767]
+    int16_t delta = static_cast<int16_t>(sequence_number - static_cast<uint16_t>(last_));
+    last_ += delta;
+    return last_;
+}
+
+} // namespace rtp
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef SEQUENCE_UNWRAPPER_H_
+#define SEQUENCE_UNWRAPPER_H_
+
+#include <cstdint>
+
+namespace rtp {
+
+// SequenceNumberUnwrapper extends received 16-bit RTP sequence numbers to 64
+// bits. Each number is placed within half the sequence space of the previous
+// one, so reordering across a wrap still yields monotonic values.
+class SequenceNumberUnwrapper {
+public:
+    SequenceNumberUnwrapper() = default;
+
+    // Returns the unwrapped value of sequence_number; the first number
+    // unwraps to itself
+    int64_t Unwrap(uint16_t sequence_number);
+
+    // Forgets the previous number so the next one starts a new stream
+    void Reset() { has_last_ = false; }
+
+    // Last unwrapped value, only valid after the first Unwrap()
+    int64_t last() const { return last_; }
+
+private:
+    int64_t last_ = 0;
+    bool has_last_ = false;
+};
+
+} // namespace rtp
+
+#endif // SEQUENCE_UNWRAPPER_H_
\ No newline at end of file
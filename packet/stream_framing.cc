@@ -0,0 +1,280 @@
+#include "stream_framing.h"
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    // Largest RTSP message header searched for its end
+    constexpr size_t kMaxRtspHeaderSize = 8192;
+
+    constexpr uint8_t kInterleavedMagic = '$';
+
+    size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    inline char ToLower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+    }
+
+    // Value of the Content-Length header in an RTSP message header, 0 when
+    // there is none; false if the value is malformed
+    bool ParseContentLength(const uint8_t* header, size_t size, size_t* length) {
+        static const char kName[] = "content-length:";
+        const size_t name_size = sizeof(kName) - 1;
+
+        *length = 0;
+        size_t line = 0;
+        while (line < size) {
+            size_t end = line;
+            while (end < size && header[end] != '\n') {
+                end++;
+            }
+
+            bool match = end - line > name_size;
+            for (size_t i = 0; match && i < name_size; i++) {
+                match = ToLower(static_cast<char>(header[line + i])) == kName[i];
+            }
+            if (match) {
+                size_t i = line + name_size;
+                while (i < end && (header[i] == ' ' || header[i] == '\t')) {
+                    i++;
+                }
+                size_t value = 0;
+                size_t digits = 0;
+                while (i < end && header[i] >= '0' && header[i] <= '9' && digits < 9) {
+                    value = value * 10 + (header[i] - '0');
+                    digits++;
+                    i++;
+                }
+                if (digits == 0) {
+                    return false;
+                }
+                *length = value;
+                return true;
+            }
+            line = end + 1;
+        }
+        return true;
+    }
+}
+
+size_t FrameHeaderSize(StreamFraming framing) {
+    return framing == StreamFraming::kRfc4571 ? kRfc4571HeaderSize : kInterleavedHeaderSize;
+}
+
+bool WriteFrameHeader(StreamFraming framing, uint8_t channel, uint8_t* packet, size_t size) {
+    if (size > kMaxFramedPacketSize) {
+        return false;
+    }
+    uint8_t* length = packet - kRfc4571HeaderSize;
+    length[0] = static_cast<uint8_t>(size >> 8);
+    length[1] = static_cast<uint8_t>(size);
+    if (framing == StreamFraming::kRtspInterleaved) {
+        packet[-4] = kInterleavedMagic;
+        packet[-3] = channel;
+    }
+    return true;
+}
+
+bool FramePacket(StreamFraming framing, uint8_t channel, PacketBuffer* packet) {
+    size_t header_size = FrameHeaderSize(framing);
+    size_t size = packet->size();
+    if (size > kMaxFramedPacketSize || !packet->Prepend(header_size)) {
+        return false;
+    }
+    return WriteFrameHeader(framing, channel, packet->data() + header_size, size);
+}
+
+bool FrameArena(StreamFraming framing, uint8_t channel, std::vector<uint8_t>* packet_data,
+                const std::vector<size_t>& packet_offsets, size_t headroom, size_t tailroom,
+                std::vector<StreamSpan>* spans) {
+    size_t header_size = FrameHeaderSize(framing);
+    if (headroom < header_size) {
+        return false;
+    }
+    size_t count = packet_offsets.size() < 2 ? 0 : packet_offsets.size() - 1;
+    for (size_t i = 0; i < count; i++) {
+        size_t span = packet_offsets[i + 1] - packet_offsets[i];
+        if (span < headroom + tailroom || span - headroom - tailroom > kMaxFramedPacketSize) {
+            return false;
+        }
+    }
+
+    size_t first_span = spans->size();
+    uint8_t* data = packet_data->data();
+    for (size_t i = 0; i < count; i++) {
+        size_t begin = packet_offsets[i] + headroom;
+        size_t size = packet_offsets[i + 1] - tailroom - begin;
+        WriteFrameHeader(framing, channel, data + begin, size);
+
+        const uint8_t* start = data + begin - header_size;
+        if (spans->size() > first_span && spans->back().data + spans->back().size == start) {
+            spans->back().size += header_size + size;
+        } else {
+            StreamSpan framed;
+            framed.data = start;
+            framed.size = header_size + size;
+            spans->push_back(framed);
+        }
+    }
+    return true;
+}
+
+// StreamDeframer
+
+StreamDeframer::StreamDeframer(StreamFraming framing, size_t capacity) : framing_(framing) {
+    size_t minimum = 2 * (kMaxFramedPacketSize + kInterleavedHeaderSize);
+    ring_.assign(RoundUpToPowerOfTwo(capacity < minimum ? minimum : capacity), 0);
+    mask_ = ring_.size() - 1;
+    scratch_.reserve(kMaxFramedPacketSize);
+}
+
+void StreamDeframer::Reset() {
+    read_ = 0;
+    write_ = 0;
+    release_ = 0;
+    header_scan_ = 0;
+    failed_ = false;
+}
+
+uint8_t* StreamDeframer::WriteBuffer(size_t* size) {
+    size_t offset = static_cast<size_t>(write_) & mask_;
+    size_t free = ring_.size() - Buffered();
+    size_t to_end = ring_.size() - offset;
+    *size = free < to_end ? free : to_end;
+    return ring_.data() + offset;
+}
+
+void StreamDeframer::CommitWrite(size_t size) {
+    size_t free = ring_.size() - Buffered();
+    write_ += size < free ? size : free;
+}
+
+size_t StreamDeframer::Write(const uint8_t* data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        size_t room = 0;
+        uint8_t* buffer = WriteBuffer(&room);
+        if (room == 0) {
+            break;
+        }
+        size_t chunk = size - written < room ? size - written : room;
+        std::memcpy(buffer, data + written, chunk);
+        CommitWrite(chunk);
+        written += chunk;
+    }
+    return written;
+}
+
+const uint8_t* StreamDeframer::Contiguous(uint64_t position, size_t size) {
+    size_t offset = static_cast<size_t>(position) & mask_;
+    if (offset + size <= ring_.size()) {
+        return ring_.data() + offset;
+    }
+    size_t first = ring_.size() - offset;
+    scratch_.resize(size);
+    std::memcpy(scratch_.data(), ring_.data() + offset, first);
+    std::memcpy(scratch_.data() + first, ring_.data(), size - first);
+    return scratch_.data();
+}
+
+size_t StreamDeframer::RtspMessageSize() {
+    size_t available = Buffered();
+    size_t limit = available < kMaxRtspHeaderSize ? available : kMaxRtspHeaderSize;
+
+    // Resume the search for the empty line where the last call stopped
+    size_t i = header_scan_ > 3 ? header_scan_ - 3 : 0;
+    size_t header_size = 0;
+    for (; i + 4 <= limit; i++) {
+        if (At(read_ + i) == '\r' && At(read_ + i + 1) == '\n' &&
+            At(read_ + i + 2) == '\r' && At(read_ + i + 3) == '\n') {
+            header_size = i + 4;
+            break;
+        }
+    }
+    if (header_size == 0) {
+        header_scan_ = limit;
+        if (limit == kMaxRtspHeaderSize) {
+            failed_ = true;
+        }
+        return 0;
+    }
+    header_scan_ = i;
+
+    size_t body_size = 0;
+    if (!ParseContentLength(Contiguous(read_, header_size), header_size, &body_size) ||
+        body_size > ring_.size() / 2) {
+        failed_ = true;
+        return 0;
+    }
+    size_t message_size = header_size + body_size;
+    return message_size <= available ? message_size : 0;
+}
+
+bool StreamDeframer::Next(FramedPacket* packet) {
+    // The previous packet is no longer referenced
+    read_ += release_;
+    release_ = 0;
+
+    while (!failed_) {
+        size_t available = Buffered();
+        size_t header_size = kRfc4571HeaderSize;
+        int channel = 0;
+
+        if (framing_ == StreamFraming::kRtspInterleaved) {
+            if (available < 1) {
+                return false;
+            }
+            if (At(read_) != kInterleavedMagic) {
+                size_t message_size = RtspMessageSize();
+                if (message_size == 0) {
+                    return false;
+                }
+                header_scan_ = 0;
+                packet->data = Contiguous(read_, message_size);
+                packet->size = message_size;
+                packet->channel = kRtspMessageChannel;
+                release_ = message_size;
+                stats_.rtsp_messages++;
+                return true;
+            }
+            header_size = kInterleavedHeaderSize;
+            if (available < header_size) {
+                return false;
+            }
+            channel = At(read_ + 1);
+        } else if (available < header_size) {
+            return false;
+        }
+
+        size_t size = (size_t(At(read_ + header_size - 2)) << 8) | At(read_ + header_size - 1);
+        if (available < header_size + size) {
+            return false;
+        }
+        if (size == 0) {
+            // Nothing to deliver
+            read_ += header_size;
+            continue;
+        }
+
+        uint64_t start = read_ + header_size;
+        if ((static_cast<size_t>(start) & mask_) + size > ring_.size()) {
+            stats_.wrapped_packets++;
+        }
+        packet->data = Contiguous(start, size);
+        packet->size = size;
+        packet->channel = channel;
+        release_ = header_size + size;
+        stats_.packets++;
+        return true;
+    }
+    return false;
+}
+
+} // namespace rtp
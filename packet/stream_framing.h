@@ -0,0 +1,135 @@
+#ifndef STREAM_FRAMING_H_
+#define STREAM_FRAMING_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "buffer_pool.h"
+
+namespace rtp {
+
+// Framing of RTP and RTCP packets on a TCP byte stream
+enum class StreamFraming {
+    kRfc4571,           // 16-bit big-endian length in front of each packet
+    kRtspInterleaved    // '$', channel and 16-bit length (RFC 2326 10.12)
+};
+
+constexpr size_t kRfc4571HeaderSize = 2;
+constexpr size_t kInterleavedHeaderSize = 4;
+constexpr size_t kMaxFramedPacketSize = 65535;
+
+// Channel of RTSP messages found between interleaved packets
+constexpr int kRtspMessageChannel = -1;
+
+// Bytes the framing puts in front of every packet; reserve at least this
+// much packetizer headroom to frame packets in place
+size_t FrameHeaderSize(StreamFraming framing);
+
+// Writes the framing header into the FrameHeaderSize() bytes in front of
+// packet. channel is ignored for RFC 4571.
+// Returns false if size is larger than kMaxFramedPacketSize
+bool WriteFrameHeader(StreamFraming framing, uint8_t channel, uint8_t* packet, size_t size);
+
+// Frames a pooled packet in place by growing it into its headroom
+bool FramePacket(StreamFraming framing, uint8_t channel, PacketBuffer* packet);
+
+// A byte range to send; converts one-to-one into an iovec
+struct StreamSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Frames every packet of an RTPPacketizer arena (packet_data and
+// packet_offsets, packetized with at least FrameHeaderSize() of headroom)
+// in place and appends the bytes to send to spans. Adjacent ranges are
+// merged, so with headroom equal to the header size and no tailroom the
+// whole frame is a single span for one writev.
+// Returns false, leaving spans as it was, if a packet cannot be framed
+bool FrameArena(StreamFraming framing, uint8_t channel, std::vector<uint8_t>* packet_data,
+                const std::vector<size_t>& packet_offsets, size_t headroom, size_t tailroom,
+                std::vector<StreamSpan>* spans);
+
+// One packet found by StreamDeframer; data stays valid until the next call
+// to Next() or Reset()
+struct FramedPacket {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int channel = 0;    // Interleaved channel, 0 for RFC 4571
+};
+
+// Counters of one deframer
+struct StreamDeframerStats {
+    uint64_t packets = 0;
+    uint64_t rtsp_messages = 0;
+    uint64_t wrapped_packets = 0;   // Packets copied because they wrapped
+};
+
+// StreamDeframer splits a TCP byte stream back into packets. Bytes are
+// received straight into a ring buffer, via WriteBuffer() and CommitWrite()
+// around a recv() call or by copying with Write(), and Next() returns each
+// complete packet as a view into the ring. Only a packet that wraps around
+// the end of the ring is copied, into a scratch buffer. The views can be
+// handed directly to RTPDepacketizer::InsertPacket() or a JitterBuffer.
+//
+// With RTSP interleaving the stream can also carry RTSP responses and
+// requests between packets; Next() returns each whole message, including
+// its body, on kRtspMessageChannel.
+//
+// A stream that breaks the framing cannot be resynchronized; Failed() then
+// stays true until Reset().
+class StreamDeframer {
+public:
+    // capacity is rounded up to a power of two that holds at least two
+    // packets of the largest size
+    explicit StreamDeframer(StreamFraming framing, size_t capacity = 256 * 1024);
+    ~StreamDeframer() = default;
+
+    // Contiguous free space of the ring to receive into, and the number of
+    // bytes written there. The packet returned by the last Next() is only
+    // released on the next call to Next().
+    uint8_t* WriteBuffer(size_t* size);
+    void CommitWrite(size_t size);
+
+    // Copies as much of data into the ring as fits; returns the bytes taken
+    size_t Write(const uint8_t* data, size_t size);
+
+    // Next complete packet or RTSP message
+    // Returns false if more bytes are needed or the framing failed
+    bool Next(FramedPacket* packet);
+
+    // Drops all buffered bytes and the error state
+    void Reset();
+
+    // Accessors
+    bool Failed() const { return failed_; }
+    size_t Buffered() const { return static_cast<size_t>(write_ - read_); }
+    size_t Capacity() const { return ring_.size(); }
+    const StreamDeframerStats& Stats() const { return stats_; }
+
+private:
+    uint8_t At(uint64_t position) const { return ring_[position & mask_]; }
+
+    // size bytes from position in one piece, copied out if they wrap
+    const uint8_t* Contiguous(uint64_t position, size_t size);
+
+    // Length of the RTSP message at read_, 0 while it is incomplete
+    size_t RtspMessageSize();
+
+    StreamFraming framing_;
+    std::vector<uint8_t> ring_;
+    size_t mask_ = 0;
+    std::vector<uint8_t> scratch_;
+
+    // Absolute stream positions; read_ is the start of the unreleased data
+    uint64_t read_ = 0;
+    uint64_t write_ = 0;
+    size_t release_ = 0;        // Size of the packet returned last
+    size_t header_scan_ = 0;    // RTSP header bytes already searched
+    bool failed_ = false;
+
+    StreamDeframerStats stats_;
+};
+
+} // namespace rtp
+
+#endif // STREAM_FRAMING_H_
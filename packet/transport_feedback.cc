@@ -0,0 +1,446 @@
+#include "transport_feedback.h"
+#include "rtp_packet.h"
+#include <algorithm>
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    // Packet status symbols
+    constexpr uint8_t kNotReceived = 0;
+    constexpr uint8_t kSmallDelta = 1;
+    constexpr uint8_t kLargeDelta = 2;
+
+    // Status chunk capacities
+    constexpr size_t kTwoBitVectorCapacity = 7;
+    constexpr size_t kOneBitVectorCapacity = 14;
+    constexpr size_t kMaxRunLength = 0x1FFF;
+
+    // Base sequence number, status count, reference time and feedback count
+    constexpr size_t kFciHeaderSize = 8;
+    constexpr size_t kMaxWindow = 1 << 15;
+
+    // Arrival time of a slot without a received packet
+    constexpr int64_t kNotReceivedTime = INT64_MIN;
+
+    uint16_t ReadUint16(const uint8_t* buf) {
+        return static_cast<uint16_t>((buf[0] << 8) | buf[1]);
+    }
+
+    void WriteUint16(uint8_t* buf, uint16_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 8);
+        buf[1] = static_cast<uint8_t>(value);
+    }
+
+    void WriteUint32(uint8_t* buf, uint32_t value) {
+        buf[0] = static_cast<uint8_t>(value >> 24);
+        buf[1] = static_cast<uint8_t>(value >> 16);
+        buf[2] = static_cast<uint8_t>(value >> 8);
+        buf[3] = static_cast<uint8_t>(value);
+    }
+
+    size_t ChunkSymbolCount(uint16_t chunk) {
+        if (!(chunk & 0x8000)) {
+            return chunk & kMaxRunLength;
+        }
+        return (chunk & 0x4000) ? kTwoBitVectorCapacity : kOneBitVectorCapacity;
+    }
+
+    // Rounds towards negative infinity, arrival times may precede the epoch
+    int64_t FloorDiv(int64_t value, int64_t divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    // StatusChunkEncoder buffers packet status symbols and writes them out as
+    // the densest chunk that can hold them: a run-length chunk while all
+    // symbols are equal, otherwise a 1-bit vector of 14 symbols or a 2-bit
+    // vector of 7 once a large delta is involved
+    class StatusChunkEncoder {
+    public:
+        explicit StatusChunkEncoder(uint8_t* out) : out_(out) {}
+
+        void Add(uint8_t symbol) {
+            if (!CanAdd(symbol)) {
+                Emit();
+            }
+            if (size_ < kOneBitVectorCapacity) {
+                symbols_[size_] = symbol;
+            }
+            all_same_ = size_ == 0 || (all_same_ && symbol == symbols_[0]);
+            has_large_ = has_large_ || symbol == kLargeDelta;
+            size_++;
+        }
+
+        // Writes the buffered symbols; at most two more chunks
+        void Finish() {
+            while (size_ > 0) {
+                if (all_same_ || size_ <= kTwoBitVectorCapacity || !has_large_) {
+                    EmitPartial();
+                } else {
+                    Emit();
+                }
+            }
+        }
+
+        size_t chunk_count() const { return chunks_; }
+
+    private:
+        bool CanAdd(uint8_t symbol) const {
+            if (size_ < kTwoBitVectorCapacity) {
+                return true;
+            }
+            if (size_ < kOneBitVectorCapacity && !has_large_ && symbol != kLargeDelta) {
+                return true;
+            }
+            return size_ < kMaxRunLength && all_same_ && symbol == symbols_[0];
+        }
+
+        void Emit() {
+            if (all_same_) {
+                WriteRunLength();
+                return;
+            }
+            
+            if (size_ == kOneBitVectorCapacity && !has_large_) {
+                WriteVector(kOneBitVectorCapacity, false);
+                Clear();
+                return;
+            }
+            
+            // Emit the first 7 symbols and keep the rest buffered
+            WriteVector(kTwoBitVectorCapacity, true);
+            size_t remaining = size_ - kTwoBitVectorCapacity;
+            std::memmove(symbols_, symbols_ + kTwoBitVectorCapacity, remaining);
+            size_ = remaining;
+            all_same_ = true;
+            has_large_ = false;
+            for (size_t i = 0; i < size_; i++) {
+                all_same_ = all_same_ && symbols_[i] == symbols_[0];
+                has_large_ = has_large_ || symbols_[i] == kLargeDelta;
+            }
+        }
+
+        // Final chunk, which may be a vector that is not full
+        void EmitPartial() {
+            if (all_same_) {
+                WriteRunLength();
+            } else if (has_large_) {
+                WriteVector(size_, true);
+                Clear();
+            } else {
+                WriteVector(size_, false);
+                Clear();
+            }
+        }
+
+        void WriteRunLength() {
+            WriteUint16(out_ + chunks_ * 2, static_cast<uint16_t>((symbols_[0] << 13) | size_));
+            chunks_++;
+            Clear();
+        }
+
+        void WriteVector(size_t count, bool two_bit) {
+            uint16_t chunk = two_bit ? 0xC000 : 0x8000;
+            for (size_t i = 0; i < count; i++) {
+                if (two_bit) {
+                    chunk |= symbols_[i] << (12 - 2 * i);
+                } else {
+                    chunk |= symbols_[i] << (13 - i);
+                }
+            }
+            WriteUint16(out_ + chunks_ * 2, chunk);
+            chunks_++;
+        }
+
+        void Clear() {
+            size_ = 0;
+            all_same_ = true;
+            has_large_ = false;
+        }
+
+        uint8_t* out_;
+        size_t chunks_ = 0;
+        uint8_t symbols_[kOneBitVectorCapacity] = {};
+        size_t size_ = 0;
+        bool all_same_ = true;
+        bool has_large_ = false;
+    };
+}
+
+//----------------------------------------
+// TransportFeedbackReader
+//----------------------------------------
+
+bool TransportFeedbackReader::Parse(const FeedbackMessage& feedback) {
+    error_ = true;
+    if (feedback.packet_type != kRtcpRtpfbPacketType || feedback.fmt != kRtcpTransportFeedbackFmt) {
+        return false;
+    }
+    
+    if (!feedback.fci || feedback.fci_size < kFciHeaderSize) {
+        return false;
+    }
+    
+    fci_ = feedback.fci;
+    fci_size_ = feedback.fci_size;
+    base_sequence_number_ = ReadUint16(fci_);
+    packet_status_count_ = ReadUint16(fci_ + 2);
+    
+    // 24-bit signed reference time in multiples of 64ms
+    uint32_t reference = (uint32_t(fci_[4]) << 16) | (uint32_t(fci_[5]) << 8) | fci_[6];
+    int32_t reference_time = (reference & 0x800000) ? static_cast<int32_t>(reference | 0xFF000000)
+                                                     : static_cast<int32_t>(reference);
+    reference_time_us_ = reference_time * kTransportFeedbackReferenceTimeUs;
+    feedback_count_ = fci_[7];
+    
+    // The receive deltas follow the last chunk needed for the status count
+    size_t offset = kFciHeaderSize;
+    size_t statuses = 0;
+    while (statuses < packet_status_count_) {
+        if (offset + 2 > fci_size_) {
+            return false;
+        }
+        statuses += ChunkSymbolCount(ReadUint16(fci_ + offset));
+        offset += 2;
+    }
+    
+    index_ = 0;
+    chunk_offset_ = kFciHeaderSize;
+    chunk_ = 0;
+    chunk_size_ = 0;
+    chunk_index_ = 0;
+    delta_offset_ = offset;
+    time_us_ = reference_time_us_;
+    error_ = false;
+    return true;
+}
+
+bool TransportFeedbackReader::NextSymbol(uint8_t* symbol) {
+    while (chunk_index_ >= chunk_size_) {
+        if (chunk_offset_ + 2 > fci_size_) {
+            return false;
+        }
+        chunk_ = ReadUint16(fci_ + chunk_offset_);
+        chunk_offset_ += 2;
+        chunk_size_ = ChunkSymbolCount(chunk_);
+        chunk_index_ = 0;
+    }
+    
+    if (!(chunk_ & 0x8000)) {
+        *symbol = (chunk_ >> 13) & 0x3;
+    } else if (chunk_ & 0x4000) {
+        *symbol = (chunk_ >> (12 - 2 * chunk_index_)) & 0x3;
+    } else {
+        *symbol = (chunk_ >> (13 - chunk_index_)) & 0x1;
+    }
+    chunk_index_++;
+    return true;
+}
+
+bool TransportFeedbackReader::Next(PacketArrival* arrival) {
+    if (error_ || !arrival || index_ >= packet_status_count_) {
+        return false;
+    }
+    
+    uint8_t symbol;
+    if (!NextSymbol(&symbol)) {
+        error_ = true;
+        return false;
+    }
+    
+    arrival->sequence_number = static_cast<uint16_t>(base_sequence_number_ + index_);
+    arrival->received = symbol != kNotReceived;
+    index_++;
+    
+    if (symbol == kSmallDelta) {
+        if (delta_offset_ + 1 > fci_size_) {
+            error_ = true;
+            return false;
+        }
+        time_us_ += fci_[delta_offset_] * kTransportFeedbackDeltaUs;
+        delta_offset_ += 1;
+    } else if (symbol == kLargeDelta) {
+        if (delta_offset_ + 2 > fci_size_) {
+            error_ = true;
+            return false;
+        }
+        time_us_ += static_cast<int16_t>(ReadUint16(fci_ + delta_offset_)) * kTransportFeedbackDeltaUs;
+        delta_offset_ += 2;
+    } else if (symbol != kNotReceived) {
+        // Reserved symbol
+        error_ = true;
+        return false;
+    }
+    
+    arrival->arrival_time_us = arrival->received ? time_us_ : 0;
+    return true;
+}
+
+//----------------------------------------
+// TransportFeedbackRecorder
+//----------------------------------------
+
+TransportFeedbackRecorder::TransportFeedbackRecorder(uint8_t extension_id, size_t window)
+    : extension_id_(extension_id) {
+    size_t capacity = 1;
+    while (capacity < std::min(std::max(window, size_t(1)), kMaxWindow)) {
+        capacity <<= 1;
+    }
+    arrival_time_us_.assign(capacity, kNotReceivedTime);
+    // A large delta for every packet is the worst case
+    deltas_.resize(capacity * 2);
+    mask_ = capacity - 1;
+}
+
+bool TransportFeedbackRecorder::OnPacket(const uint8_t* rtp_packet, size_t size, int64_t arrival_time_us) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
+        return false;
+    }
+    
+    const uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+    if (!packet.GetExtension(extension_id_, &payload, &payload_size) || payload_size != 2) {
+        return false;
+    }
+    
+    media_ssrc_ = packet.ssrc();
+    OnPacket(ReadUint16(payload), arrival_time_us);
+    return true;
+}
+
+void TransportFeedbackRecorder::OnPacket(uint16_t transport_sequence_number, int64_t arrival_time_us) {
+    int64_t seq = unwrapper_.Unwrap(transport_sequence_number);
+    int64_t window = static_cast<int64_t>(mask_ + 1);
+    
+    if (!started_) {
+        started_ = true;
+        begin_ = seq;
+        end_ = seq;
+    }
+    
+    // Already reported
+    if (seq < begin_) {
+        return;
+    }
+    
+    if (seq >= end_) {
+        // Slots skipped over hold stale arrivals from a window ago
+        for (int64_t s = std::max(end_, seq - window + 1); s < seq; s++) {
+            arrival_time_us_[static_cast<size_t>(s) & mask_] = kNotReceivedTime;
+        }
+        end_ = seq + 1;
+        if (end_ - begin_ > window) {
+            begin_ = end_ - window;
+        }
+    }
+    
+    arrival_time_us_[static_cast<size_t>(seq) & mask_] = arrival_time_us;
+}
+
+size_t TransportFeedbackRecorder::BuildFeedbackPacket(uint32_t sender_ssrc, uint8_t* buf, size_t buf_size) {
+    // Header, FCI header, and one chunk and delta padded to 32 bits
+    if (!buf || buf_size < kRtcpFeedbackHeaderSize + kFciHeaderSize + 4 || !HasPendingFeedback()) {
+        return 0;
+    }
+    
+    // The reference time is taken from the first received packet
+    int64_t first_arrival = kNotReceivedTime;
+    for (int64_t seq = begin_; seq < end_ && first_arrival == kNotReceivedTime; seq++) {
+        first_arrival = arrival_time_us_[static_cast<size_t>(seq) & mask_];
+    }
+    int64_t reference_time = FloorDiv(first_arrival, kTransportFeedbackReferenceTimeUs);
+    int64_t last_time_us = reference_time * kTransportFeedbackReferenceTimeUs;
+    
+    uint8_t* chunks = buf + kRtcpFeedbackHeaderSize + kFciHeaderSize;
+    StatusChunkEncoder encoder(chunks);
+    size_t delta_size = 0;
+    size_t count = 0;
+    
+    for (int64_t seq = begin_; seq < end_ && count < 0xFFFF; seq++) {
+        int64_t arrival = arrival_time_us_[static_cast<size_t>(seq) & mask_];
+        uint8_t symbol = kNotReceived;
+        int64_t delta = 0;
+        if (arrival != kNotReceivedTime) {
+            // Round to the nearest tick; the running time follows the
+            // rounded deltas so errors do not accumulate
+            int64_t diff = arrival - last_time_us;
+            delta = FloorDiv(diff + kTransportFeedbackDeltaUs / 2, kTransportFeedbackDeltaUs);
+            if (delta >= 0 && delta <= 0xFF) {
+                symbol = kSmallDelta;
+            } else if (delta >= INT16_MIN && delta <= INT16_MAX) {
+                symbol = kLargeDelta;
+            } else {
+                // Left for the next message, with its own reference time
+                break;
+            }
+        }
+        
+        // Room for the chunks still to be written (one when this symbol does
+        // not fit the buffered ones, two when finishing), this delta and
+        // padding
+        size_t delta_bytes = symbol == kSmallDelta ? 1 : (symbol == kLargeDelta ? 2 : 0);
+        size_t needed = kRtcpFeedbackHeaderSize + kFciHeaderSize + (encoder.chunk_count() + 3) * 2 +
+                        delta_size + delta_bytes + 3;
+        if (needed > buf_size) {
+            break;
+        }
+        
+        encoder.Add(symbol);
+        if (symbol == kSmallDelta) {
+            deltas_[delta_size++] = static_cast<uint8_t>(delta);
+        } else if (symbol == kLargeDelta) {
+            WriteUint16(&deltas_[delta_size], static_cast<uint16_t>(delta));
+            delta_size += 2;
+        }
+        if (symbol != kNotReceived) {
+            last_time_us += delta * kTransportFeedbackDeltaUs;
+        }
+        count++;
+    }
+    
+    if (count == 0) {
+        return 0;
+    }
+    encoder.Finish();
+    
+    size_t size = kRtcpFeedbackHeaderSize + kFciHeaderSize + encoder.chunk_count() * 2 + delta_size;
+    std::memcpy(buf + size - delta_size, deltas_.data(), delta_size);
+    
+    size_t padding = (4 - size % 4) % 4;
+    if (padding > 0) {
+        std::memset(buf + size, 0, padding);
+        size += padding;
+        buf[size - 1] = static_cast<uint8_t>(padding);
+    }
+    
+    WriteRtcpHeader(buf, kRtcpTransportFeedbackFmt, kRtcpRtpfbPacketType, size);
+    if (padding > 0) {
+        buf[0] |= 0x20;
+    }
+    WriteUint32(buf + 4, sender_ssrc);
+    WriteUint32(buf + 8, media_ssrc_);
+    
+    uint8_t* fci = buf + kRtcpFeedbackHeaderSize;
+    WriteUint16(fci, static_cast<uint16_t>(begin_));
+    WriteUint16(fci + 2, static_cast<uint16_t>(count));
+    uint32_t reference = static_cast<uint32_t>(reference_time) & 0xFFFFFF;
+    fci[4] = static_cast<uint8_t>(reference >> 16);
+    fci[5] = static_cast<uint8_t>(reference >> 8);
+    fci[6] = static_cast<uint8_t>(reference);
+    fci[7] = feedback_count_++;
+    
+    begin_ += static_cast<int64_t>(count);
+    return size;
+}
+
+void TransportFeedbackRecorder::Reset() {
+    std::fill(arrival_time_us_.begin(), arrival_time_us_.end(), kNotReceivedTime);
+    unwrapper_.Reset();
+    started_ = false;
+    begin_ = 0;
+    end_ = 0;
+}
+
+} // namespace rtp
\ No newline at end of file
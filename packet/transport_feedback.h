@@ -0,0 +1,117 @@
+#ifndef TRANSPORT_FEEDBACK_H_
+#define TRANSPORT_FEEDBACK_H_
+
+#include <cstdint>
+#include <vector>
+#include "rtcp_packet.h"
+#include "sequence_unwrapper.h"
+
+namespace rtp {
+
+// Time resolution of transport-wide congestion control feedback
+// (draft-holmer-rmcat-transport-wide-cc-extensions-01)
+constexpr int64_t kTransportFeedbackDeltaUs = 250;
+constexpr int64_t kTransportFeedbackReferenceTimeUs = 64000;
+
+// Arrival of one packet as reported by transport-wide feedback
+struct PacketArrival {
+    uint16_t sequence_number = 0;
+    bool received = false;
+    int64_t arrival_time_us = 0;     // Receiver clock, only set if received
+};
+
+// TransportFeedbackReader decodes an RTPFB FMT=15 message in place, one
+// packet status at a time, without allocating
+class TransportFeedbackReader {
+public:
+    TransportFeedbackReader() = default;
+
+    // Validates the FCI header and the packet status chunks
+    bool Parse(const FeedbackMessage& feedback);
+
+    // Returns the next packet in sequence order; false once every status has
+    // been read or if the receive deltas are truncated
+    bool Next(PacketArrival* arrival);
+
+    // Feedback header fields
+    uint16_t base_sequence_number() const { return base_sequence_number_; }
+    size_t packet_status_count() const { return packet_status_count_; }
+    int64_t reference_time_us() const { return reference_time_us_; }
+    uint8_t feedback_count() const { return feedback_count_; }
+
+    // True if decoding stopped on a malformed message
+    bool error() const { return error_; }
+
+private:
+    bool NextSymbol(uint8_t* symbol);
+
+    const uint8_t* fci_ = nullptr;
+    size_t fci_size_ = 0;
+    uint16_t base_sequence_number_ = 0;
+    size_t packet_status_count_ = 0;
+    int64_t reference_time_us_ = 0;
+    uint8_t feedback_count_ = 0;
+
+    // Decoding position
+    size_t index_ = 0;
+    size_t chunk_offset_ = 0;
+    uint16_t chunk_ = 0;
+    size_t chunk_size_ = 0;          // Symbols in the current chunk
+    size_t chunk_index_ = 0;         // Next symbol within the current chunk
+    size_t delta_offset_ = 0;
+    int64_t time_us_ = 0;
+    bool error_ = false;
+};
+
+// TransportFeedbackRecorder records the transport-wide sequence number and
+// arrival time of every received packet and encodes them into RTPFB FMT=15
+// feedback messages with run-length and status vector chunks. Arrival times
+// are kept in a ring indexed by sequence number, so recording a packet never
+// allocates.
+class TransportFeedbackRecorder {
+public:
+    // extension_id is the one-byte header extension id of transport-cc;
+    // window is rounded up to a power of two, at most 32768
+    explicit TransportFeedbackRecorder(uint8_t extension_id = 0, size_t window = 8192);
+    ~TransportFeedbackRecorder() = default;
+
+    void SetExtensionId(uint8_t extension_id) { extension_id_ = extension_id; }
+
+    // Records a received RTP packet; returns false if it cannot be parsed or
+    // carries no transport-wide sequence number
+    bool OnPacket(const uint8_t* rtp_packet, size_t size, int64_t arrival_time_us);
+
+    // Records a received transport-wide sequence number
+    void OnPacket(uint16_t transport_sequence_number, int64_t arrival_time_us);
+
+    // Writes one feedback message for the packets recorded since the last
+    // one, as many as fit in buf. Returns the packet size, or 0 if there is
+    // nothing to report.
+    size_t BuildFeedbackPacket(uint32_t sender_ssrc, uint8_t* buf, size_t buf_size);
+
+    // True if packets were recorded since the last feedback message
+    bool HasPendingFeedback() const { return started_ && begin_ < end_; }
+
+    // Forgets all recorded packets
+    void Reset();
+
+    // SSRC of the last recorded RTP packet
+    uint32_t media_ssrc() const { return media_ssrc_; }
+
+private:
+    std::vector<int64_t> arrival_time_us_;   // INT64_MIN if not received
+    std::vector<uint8_t> deltas_;            // Receive delta scratch
+    size_t mask_;
+    uint8_t extension_id_;
+
+    SequenceNumberUnwrapper unwrapper_;
+    bool started_ = false;
+    int64_t begin_ = 0;      // First sequence number not yet reported
+    int64_t end_ = 0;        // One past the newest sequence number
+    uint8_t feedback_count_ = 0;
+    uint32_t media_ssrc_ = 0;
+};
+
+} // namespace rtp
+
+#endif // TRANSPORT_FEEDBACK_H_
\ No newline at end of file
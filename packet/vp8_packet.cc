@@ -5,11 +5,33 @@
 namespace rtp {
 
 bool VP8Packet::Unmarshal(const std::vector<uint8_t>& payload, std::vector<uint8_t>* output) {
-    if (payload.empty()) {
+    size_t payload_index = 0;
+    if (!Unmarshal(payload.data(), payload.size(), &payload_index)) {
         return false;
     }
 
-    size_t payload_len = payload.size();
+    // Extract payload
+    if (payload_index < payload.size()) {
+        Payload.assign(payload.begin() + payload_index, payload.end());
+        if (output) {
+            *output = Payload;
+        }
+    } else {
+        Payload.clear();
+        if (output) {
+            output->clear();
+        }
+    }
+
+    return true;
+}
+
+bool VP8Packet::Unmarshal(const uint8_t* payload, size_t size, size_t* payload_offset) {
+    if (!payload || size == 0 || !payload_offset) {
+        return false;
+    }
+
+    size_t payload_len = size;
     size_t payload_index = 0;
 
     if (payload_index >= payload_len) {
@@ -97,24 +119,16 @@ bool VP8Packet::Unmarshal(const std::vector<uint8_t>& payload, std::vector<uint8
         KEYIDX = 0;
     }
 
-    // Extract payload
-    if (payload_index < payload_len) {
-        Payload.assign(payload.begin() + payload_index, payload.end());
-        if (output) {
-            *output = Payload;
-        }
-    } else {
-        Payload.clear();
-        if (output) {
-            output->clear();
-        }
-    }
-
+    *payload_offset = payload_index;
     return true;
 }
 
 bool VP8Packet::IsPartitionHead(const std::vector<uint8_t>& payload) const {
-    if (payload.size() < 1) {
+    return IsPartitionHead(payload.data(), payload.size());
+}
+
+bool VP8Packet::IsPartitionHead(const uint8_t* payload, size_t size) const {
+    if (size < 1) {
         return false;
     }
     
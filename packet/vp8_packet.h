@@ -30,9 +30,14 @@ public:
 
     // Parse VP8 packet from RTP payload
     bool Unmarshal(const std::vector<uint8_t>& payload, std::vector<uint8_t>* output);
+
+    // Parse only the VP8 payload descriptor; the VP8 data starts at
+    // payload + *payload_offset and is neither copied nor stored in Payload
+    bool Unmarshal(const uint8_t* payload, size_t size, size_t* payload_offset);
     
     // Check if this is a head of the VP8 partition
     bool IsPartitionHead(const std::vector<uint8_t>& payload) const;
+    bool IsPartitionHead(const uint8_t* payload, size_t size) const;
 
     // Required Header
     uint8_t X = 0;        // Extended control bits present
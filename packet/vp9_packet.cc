@@ -1,4 +1,5 @@
 #include "vp9_packet.h"
+#include <algorithm>
 #include <stdexcept>
 
 namespace rtp {
@@ -11,30 +12,50 @@ const char* kErrTooManyPDiff = "too many PDiff elements";
 
 // Bit reading utilities implementation
 bool hasSpace(const std::vector<uint8_t>& buf, int pos, int n) {
-    return n <= ((buf.size() * 8) - pos);
+    return hasSpace(buf.size(), pos, n);
 }
 
 bool readFlag(const std::vector<uint8_t>& buf, int* pos) {
-    if (!hasSpace(buf, *pos, 1)) {
+    return readFlag(buf.data(), buf.size(), pos);
+}
+
+bool readFlagUnsafe(const std::vector<uint8_t>& buf, int* pos) {
+    return readFlagUnsafe(buf.data(), pos);
+}
+
+uint64_t readBits(const std::vector<uint8_t>& buf, int* pos, int n) {
+    return readBits(buf.data(), buf.size(), pos, n);
+}
+
+uint64_t readBitsUnsafe(const std::vector<uint8_t>& buf, int* pos, int n) {
+    return readBitsUnsafe(buf.data(), pos, n);
+}
+
+bool hasSpace(size_t size, int pos, int n) {
+    return n <= static_cast<int64_t>(size * 8) - pos;
+}
+
+bool readFlag(const uint8_t* buf, size_t size, int* pos) {
+    if (!hasSpace(size, *pos, 1)) {
         throw std::runtime_error("not enough bits");
     }
     return readFlagUnsafe(buf, pos);
 }
 
-bool readFlagUnsafe(const std::vector<uint8_t>& buf, int* pos) {
+bool readFlagUnsafe(const uint8_t* buf, int* pos) {
     bool b = (buf[*pos >> 0x03] >> (7 - (*pos & 0x07))) & 0x01;
     (*pos)++;
     return b == 1;
 }
 
-uint64_t readBits(const std::vector<uint8_t>& buf, int* pos, int n) {
-    if (!hasSpace(buf, *pos, n)) {
+uint64_t readBits(const uint8_t* buf, size_t size, int* pos, int n) {
+    if (!hasSpace(size, *pos, n)) {
         throw std::runtime_error("not enough bits");
     }
     return readBitsUnsafe(buf, pos, n);
 }
 
-uint64_t readBitsUnsafe(const std::vector<uint8_t>& buf, int* pos, int n) {
+uint64_t readBitsUnsafe(const uint8_t* buf, int* pos, int n) {
     int res = 8 - (*pos & 0x07);
     if (n < res) {
         uint64_t bits = (buf[*pos >> 0x03] >> (res - n)) & ((1 << n) - 1);
@@ -62,17 +83,33 @@ uint64_t readBitsUnsafe(const std::vector<uint8_t>& buf, int* pos, int n) {
 
 // VP9Packet implementation
 bool VP9Packet::IsPartitionHead(const std::vector<uint8_t>& payload) {
-    if (payload.empty()) {
+    return IsPartitionHead(payload.data(), payload.size());
+}
+
+bool VP9Packet::IsPartitionHead(const uint8_t* payload, size_t size) {
+    if (size == 0) {
         return false;
     }
     return (payload[0] & 0x08) != 0; // B flag
 }
 
 bool VP9Packet::Unmarshal(const std::vector<uint8_t>& packet, std::vector<uint8_t>* payload) {
-    if (packet.empty()) {
+    size_t pos = 0;
+    if (!Unmarshal(packet.data(), packet.size(), &pos)) {
         return false;
     }
-    if (packet.size() < 1) {
+
+    // Copy payload
+    if (pos < packet.size()) {
+        payload->assign(packet.begin() + pos, packet.end());
+    } else {
+        payload->clear();
+    }
+    return true;
+}
+
+bool VP9Packet::Unmarshal(const uint8_t* packet, size_t size, size_t* payload_offset) {
+    if (!packet || size == 0 || !payload_offset) {
         return false;
     }
 
@@ -88,42 +125,37 @@ bool VP9Packet::Unmarshal(const std::vector<uint8_t>& packet, std::vector<uint8_
     int pos = 1;
     try {
         if (I) {
-            pos = parsePictureID(packet, pos);
+            pos = parsePictureID(packet, size, pos);
         }
 
         if (L) {
-            pos = parseLayerInfo(packet, pos);
+            pos = parseLayerInfo(packet, size, pos);
         }
 
         if (F && P) {
-            pos = parseRefIndices(packet, pos);
+            pos = parseRefIndices(packet, size, pos);
         }
 
         if (V) {
-            pos = parseSSData(packet, pos);
+            pos = parseSSData(packet, size, pos);
         }
 
-        // Copy payload
-        if (pos < static_cast<int>(packet.size())) {
-            payload->assign(packet.begin() + pos, packet.end());
-        } else {
-            payload->clear();
-        }
+        *payload_offset = std::min(static_cast<size_t>(pos), size);
         return true;
     } catch (const std::exception& e) {
         return false;
     }
 }
 
-int VP9Packet::parsePictureID(const std::vector<uint8_t>& packet, int pos) {
-    if (packet.size() <= static_cast<size_t>(pos)) {
+int VP9Packet::parsePictureID(const uint8_t* packet, size_t size, int pos) {
+    if (size <= static_cast<size_t>(pos)) {
         throw std::runtime_error(kErrShortPacketVP9);
     }
 
     PictureID = packet[pos] & 0x7F;
     if ((packet[pos] & 0x80) != 0) {
         pos++;
-        if (packet.size() <= static_cast<size_t>(pos)) {
+        if (size <= static_cast<size_t>(pos)) {
             throw std::runtime_error(kErrShortPacketVP9);
         }
         PictureID = (PictureID << 8) | packet[pos];
@@ -133,18 +165,18 @@ int VP9Packet::parsePictureID(const std::vector<uint8_t>& packet, int pos) {
     return pos;
 }
 
-int VP9Packet::parseLayerInfo(const std::vector<uint8_t>& packet, int pos) {
-    pos = parseLayerInfoCommon(packet, pos);
+int VP9Packet::parseLayerInfo(const uint8_t* packet, size_t size, int pos) {
+    pos = parseLayerInfoCommon(packet, size, pos);
 
     if (F) {
         return pos;
     }
 
-    return parseLayerInfoNonFlexibleMode(packet, pos);
+    return parseLayerInfoNonFlexibleMode(packet, size, pos);
 }
 
-int VP9Packet::parseLayerInfoCommon(const std::vector<uint8_t>& packet, int pos) {
-    if (packet.size() <= static_cast<size_t>(pos)) {
+int VP9Packet::parseLayerInfoCommon(const uint8_t* packet, size_t size, int pos) {
+    if (size <= static_cast<size_t>(pos)) {
         throw std::runtime_error(kErrShortPacketVP9);
     }
 
@@ -161,8 +193,8 @@ int VP9Packet::parseLayerInfoCommon(const std::vector<uint8_t>& packet, int pos)
     return pos;
 }
 
-int VP9Packet::parseLayerInfoNonFlexibleMode(const std::vector<uint8_t>& packet, int pos) {
-    if (packet.size() <= static_cast<size_t>(pos)) {
+int VP9Packet::parseLayerInfoNonFlexibleMode(const uint8_t* packet, size_t size, int pos) {
+    if (size <= static_cast<size_t>(pos)) {
         throw std::runtime_error(kErrShortPacketVP9);
     }
 
@@ -172,11 +204,11 @@ int VP9Packet::parseLayerInfoNonFlexibleMode(const std::vector<uint8_t>& packet,
     return pos;
 }
 
-int VP9Packet::parseRefIndices(const std::vector<uint8_t>& packet, int pos) {
+int VP9Packet::parseRefIndices(const uint8_t* packet, size_t size, int pos) {
     PDiff.clear();
     
     while (true) {
-        if (packet.size() <= static_cast<size_t>(pos)) {
+        if (size <= static_cast<size_t>(pos)) {
             throw std::runtime_error(kErrShortPacketVP9);
         }
         PDiff.push_back(packet[pos] >> 1);
@@ -193,8 +225,8 @@ int VP9Packet::parseRefIndices(const std::vector<uint8_t>& packet, int pos) {
     return pos;
 }
 
-int VP9Packet::parseSSData(const std::vector<uint8_t>& packet, int pos) {
-    if (packet.size() <= static_cast<size_t>(pos)) {
+int VP9Packet::parseSSData(const uint8_t* packet, size_t size, int pos) {
+    if (size <= static_cast<size_t>(pos)) {
         throw std::runtime_error(kErrShortPacketVP9);
     }
 
@@ -211,7 +243,7 @@ int VP9Packet::parseSSData(const std::vector<uint8_t>& packet, int pos) {
         Height.resize(ns);
         
         for (int i = 0; i < ns; i++) {
-            if (packet.size() <= static_cast<size_t>(pos + 3)) {
+            if (size <= static_cast<size_t>(pos + 3)) {
                 throw std::runtime_error(kErrShortPacketVP9);
             }
 
@@ -223,7 +255,7 @@ int VP9Packet::parseSSData(const std::vector<uint8_t>& packet, int pos) {
     }
 
     if (G) {
-        if (packet.size() <= static_cast<size_t>(pos)) {
+        if (size <= static_cast<size_t>(pos)) {
             throw std::runtime_error(kErrShortPacketVP9);
         }
 
@@ -236,7 +268,7 @@ int VP9Packet::parseSSData(const std::vector<uint8_t>& packet, int pos) {
     PGPDiff.clear();
 
     for (int i = 0; i < NG; i++) {
-        if (packet.size() <= static_cast<size_t>(pos)) {
+        if (size <= static_cast<size_t>(pos)) {
             throw std::runtime_error(kErrShortPacketVP9);
         }
 
@@ -247,7 +279,7 @@ int VP9Packet::parseSSData(const std::vector<uint8_t>& packet, int pos) {
 
         PGPDiff.push_back({});
 
-        if (packet.size() <= static_cast<size_t>(pos + R - 1)) {
+        if (size <= static_cast<size_t>(pos + R - 1)) {
             throw std::runtime_error(kErrShortPacketVP9);
         }
 
@@ -262,10 +294,14 @@ int VP9Packet::parseSSData(const std::vector<uint8_t>& packet, int pos) {
 
 // VP9Header implementation
 bool VP9Header::Unmarshal(const std::vector<uint8_t>& buf) {
+    return Unmarshal(buf.data(), buf.size());
+}
+
+bool VP9Header::Unmarshal(const uint8_t* buf, size_t size) {
     int pos = 0;
     
     try {
-        if (!hasSpace(buf, pos, 4)) {
+        if (!hasSpace(size, pos, 4)) {
             return false;
         }
 
@@ -279,20 +315,20 @@ bool VP9Header::Unmarshal(const std::vector<uint8_t>& buf) {
         Profile = (profileHighBit << 1) + profileLowBit;
 
         if (Profile == 3) {
-            if (!hasSpace(buf, pos, 1)) {
+            if (!hasSpace(size, pos, 1)) {
                 return false;
             }
             pos++;
         }
 
-        ShowExistingFrame = readFlag(buf, &pos);
+        ShowExistingFrame = readFlag(buf, size, &pos);
 
         if (ShowExistingFrame) {
-            FrameToShowMapIdx = static_cast<uint8_t>(readBits(buf, &pos, 3));
+            FrameToShowMapIdx = static_cast<uint8_t>(readBits(buf, size, &pos, 3));
             return true;
         }
 
-        if (!hasSpace(buf, pos, 3)) {
+        if (!hasSpace(size, pos, 3)) {
             return false;
         }
 
@@ -301,7 +337,7 @@ bool VP9Header::Unmarshal(const std::vector<uint8_t>& buf) {
         ErrorResilientMode = readFlagUnsafe(buf, &pos);
 
         if (!NonKeyFrame) {
-            if (!hasSpace(buf, pos, 24)) {
+            if (!hasSpace(size, pos, 24)) {
                 return false;
             }
 
@@ -321,12 +357,12 @@ bool VP9Header::Unmarshal(const std::vector<uint8_t>& buf) {
             }
 
             ColorConfigData = std::make_unique<ColorConfig>();
-            if (!ColorConfigData->Unmarshal(Profile, buf, &pos)) {
+            if (!ColorConfigData->Unmarshal(Profile, buf, size, &pos)) {
                 return false;
             }
 
             FrameSizeData = std::make_unique<FrameSize>();
-            if (!FrameSizeData->Unmarshal(buf, &pos)) {
+            if (!FrameSizeData->Unmarshal(buf, size, &pos)) {
                 return false;
             }
         }
@@ -352,22 +388,22 @@ uint16_t VP9Header::Height() const {
 }
 
 // ColorConfig implementation
-bool VP9Header::ColorConfig::Unmarshal(uint8_t profile, const std::vector<uint8_t>& buf, int* pos) {
+bool VP9Header::ColorConfig::Unmarshal(uint8_t profile, const uint8_t* buf, size_t size, int* pos) {
     try {
         if (profile >= 2) {
-            TenOrTwelveBit = readFlag(buf, pos);
+            TenOrTwelveBit = readFlag(buf, size, pos);
             BitDepth = TenOrTwelveBit ? 12 : 10;
         } else {
             BitDepth = 8;
         }
 
-        ColorSpace = static_cast<uint8_t>(readBits(buf, pos, 3));
+        ColorSpace = static_cast<uint8_t>(readBits(buf, size, pos, 3));
 
         if (ColorSpace != 7) {
-            ColorRange = readFlag(buf, pos);
+            ColorRange = readFlag(buf, size, pos);
 
             if (profile == 1 || profile == 3) {
-                if (!hasSpace(buf, *pos, 3)) {
+                if (!hasSpace(size, *pos, 3)) {
                     return false;
                 }
                 SubsamplingX = readFlagUnsafe(buf, pos);
@@ -384,7 +420,7 @@ bool VP9Header::ColorConfig::Unmarshal(uint8_t profile, const std::vector<uint8_
                 SubsamplingX = false;
                 SubsamplingY = false;
 
-                if (!hasSpace(buf, *pos, 1)) {
+                if (!hasSpace(size, *pos, 1)) {
                     return false;
                 }
                 (*pos)++;
@@ -398,9 +434,9 @@ bool VP9Header::ColorConfig::Unmarshal(uint8_t profile, const std::vector<uint8_
 }
 
 // FrameSize implementation
-bool VP9Header::FrameSize::Unmarshal(const std::vector<uint8_t>& buf, int* pos) {
+bool VP9Header::FrameSize::Unmarshal(const uint8_t* buf, size_t size, int* pos) {
     try {
-        if (!hasSpace(buf, *pos, 32)) {
+        if (!hasSpace(size, *pos, 32)) {
             return false;
         }
 
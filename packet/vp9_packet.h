@@ -28,9 +28,14 @@ public:
 
     // Parse the VP9 packet from RTP payload
     bool Unmarshal(const std::vector<uint8_t>& packet, std::vector<uint8_t>* payload);
+
+    // Parse only the VP9 payload descriptor; the VP9 data starts at
+    // packet + *payload_offset and is not copied
+    bool Unmarshal(const uint8_t* packet, size_t size, size_t* payload_offset);
     
     // Check if this is a head of the VP9 partition
     static bool IsPartitionHead(const std::vector<uint8_t>& payload);
+    static bool IsPartitionHead(const uint8_t* payload, size_t size);
 
     // Required header fields
     bool I = false;  // PictureID is present
@@ -67,12 +72,12 @@ public:
     std::vector<std::vector<uint8_t>> PGPDiff; // Reference indices of pictures in a Picture Group
 
 private:
-    int parsePictureID(const std::vector<uint8_t>& packet, int pos);
-    int parseLayerInfo(const std::vector<uint8_t>& packet, int pos);
-    int parseLayerInfoCommon(const std::vector<uint8_t>& packet, int pos);
-    int parseLayerInfoNonFlexibleMode(const std::vector<uint8_t>& packet, int pos);
-    int parseRefIndices(const std::vector<uint8_t>& packet, int pos);
-    int parseSSData(const std::vector<uint8_t>& packet, int pos);
+    int parsePictureID(const uint8_t* packet, size_t size, int pos);
+    int parseLayerInfo(const uint8_t* packet, size_t size, int pos);
+    int parseLayerInfoCommon(const uint8_t* packet, size_t size, int pos);
+    int parseLayerInfoNonFlexibleMode(const uint8_t* packet, size_t size, int pos);
+    int parseRefIndices(const uint8_t* packet, size_t size, int pos);
+    int parseSSData(const uint8_t* packet, size_t size, int pos);
 };
 
 // VP9Header is a VP9 Frame header
@@ -83,6 +88,7 @@ public:
 
     // Parse the VP9 header from the payload
     bool Unmarshal(const std::vector<uint8_t>& buf);
+    bool Unmarshal(const uint8_t* buf, size_t size);
 
     // Get frame dimensions
     uint16_t Width() const;
@@ -105,7 +111,7 @@ public:
         bool SubsamplingX = true;
         bool SubsamplingY = true;
         
-        bool Unmarshal(uint8_t profile, const std::vector<uint8_t>& buf, int* pos);
+        bool Unmarshal(uint8_t profile, const uint8_t* buf, size_t size, int* pos);
     };
     std::unique_ptr<ColorConfig> ColorConfigData;
 
@@ -114,7 +120,7 @@ public:
         uint16_t FrameWidthMinus1 = 0;
         uint16_t FrameHeightMinus1 = 0;
         
-        bool Unmarshal(const std::vector<uint8_t>& buf, int* pos);
+        bool Unmarshal(const uint8_t* buf, size_t size, int* pos);
     };
     std::unique_ptr<FrameSize> FrameSizeData;
 
@@ -132,6 +138,11 @@ bool readFlag(const std::vector<uint8_t>& buf, int* pos);
 bool readFlagUnsafe(const std::vector<uint8_t>& buf, int* pos);
 uint64_t readBits(const std::vector<uint8_t>& buf, int* pos, int n);
 uint64_t readBitsUnsafe(const std::vector<uint8_t>& buf, int* pos, int n);
+bool hasSpace(size_t size, int pos, int n);
+bool readFlag(const uint8_t* buf, size_t size, int* pos);
+bool readFlagUnsafe(const uint8_t* buf, int* pos);
+uint64_t readBits(const uint8_t* buf, size_t size, int* pos, int n);
+uint64_t readBitsUnsafe(const uint8_t* buf, int* pos, int n);
 
 } // namespace rtp
 
@@ -1,5 +1,6 @@
 #include "av1_packetizer.h"
 #include <algorithm>
+#include <cstring>
 
 namespace rtp {
 
@@ -14,24 +15,51 @@ bool AV1Packetizer::Packetize(const std::vector<uint8_t>& frame,
         return false;
     }
     
-    out_packets->clear();
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    
+    if (!Packetize(frame.data(), frame.size(), &arena)) {
+        out_packets->clear();
+        return false;
+    }
+    
+    arena.CopyTo(out_packets);
+    return true;
+}
+
+bool AV1Packetizer::Packetize(const uint8_t* frame, 
+                            size_t size, 
+                            PacketWriter* out_packets) {
+    if (out_packets == nullptr || frame == nullptr || size == 0) {
+        return false;
+    }
+    
+    // The aggregation header needs at least one byte of payload budget
+    if (stream_.PayloadBudget(mtu_) < 2) {
+        return false;
+    }
+    
+    open_payload_ = nullptr;
+    open_size_ = 0;
+    stream_.BeginFrame();
     
     // Parse the OBUs from the input frame
-    std::vector<std::vector<uint8_t>> obu_payloads;
     size_t offset = 0;
     
-    std::vector<uint8_t> current_obu_payload;
+    std::vector<uint8_t>& current_obu_payload = obu_payload_;
+    current_obu_payload.clear();
     std::unique_ptr<AV1OBUHeader::ExtensionHeader> current_packet_obu_header;
     int obus_in_packet = 0;
     bool new_sequence = false;
     bool start_with_new_packet = false;
     
-    while (offset < frame.size()) {
+    while (offset < size) {
         // Parse the OBU header
         AV1OBUHeader obu_header;
         size_t header_size;
         
-        if (!AV1OBUHeader::Parse(frame, offset, &obu_header, &header_size)) {
+        if (!AV1OBUHeader::Parse(frame, size, offset, &obu_header, &header_size)) {
             return false;
         }
         
@@ -42,14 +70,14 @@ bool AV1Packetizer::Packetize(const std::vector<uint8_t>& frame,
         if (obu_header.has_size_field) {
             uint32_t size_value;
             size_t n;
-            if (!ReadLeb128(frame, offset, &size_value, &n)) {
+            if (!ReadLeb128(frame, size, offset, &size_value, &n)) {
                 return false;
             }
             
             offset += n;
             obu_size = size_value;
         } else {
-            obu_size = frame.size() - offset;
+            obu_size = size - offset;
         }
         
         // Check if we need to start a new packet
@@ -69,24 +97,22 @@ bool AV1Packetizer::Packetize(const std::vector<uint8_t>& frame,
                 *obu_header.extension_header);
         }
         
-        if (offset + obu_size > frame.size()) {
+        if (offset + obu_size > size) {
             return false;
         }
         
         // Process the current OBU payload if we have one
         if (!current_obu_payload.empty()) {
-            auto [new_payloads, new_obus_in_packet] = AppendOBUPayload(
-                *out_packets,
-                current_obu_payload,
-                new_sequence,
-                need_new_packet,
-                start_with_new_packet,
-                mtu_,
-                obus_in_packet
-            );
+            if (!AppendOBUPayload(
+                    out_packets,
+                    current_obu_payload,
+                    new_sequence,
+                    need_new_packet,
+                    start_with_new_packet,
+                    &obus_in_packet)) {
+                return false;
+            }
             
-            *out_packets = std::move(new_payloads);
-            obus_in_packet = new_obus_in_packet;
             current_obu_payload.clear();
             start_with_new_packet = need_new_packet;
             
@@ -108,10 +134,9 @@ bool AV1Packetizer::Packetize(const std::vector<uint8_t>& frame,
         
         // Ensure obu_has_size_field is false for RTP transport
         obu_header.has_size_field = false;
-        std::vector<uint8_t> header_bytes = obu_header.Marshal();
-        std::copy(header_bytes.begin(), header_bytes.end(), current_obu_payload.begin());
-        std::copy(frame.begin() + offset, 
-                 frame.begin() + offset + obu_size, 
+        obu_header.MarshalTo(current_obu_payload.data());
+        std::copy(frame + offset, 
+                 frame + offset + obu_size, 
                  current_obu_payload.begin() + header_size);
         
         offset += obu_size;
@@ -119,52 +144,42 @@ bool AV1Packetizer::Packetize(const std::vector<uint8_t>& frame,
     }
     
     // Process the last OBU payload
-    if (!current_obu_payload.empty()) {
-        auto [new_payloads, _] = AppendOBUPayload(
-            *out_packets,
+    if (!current_obu_payload.empty() &&
+        !AppendOBUPayload(
+            out_packets,
             current_obu_payload,
             new_sequence,
             true,
             start_with_new_packet,
-            mtu_,
-            obus_in_packet
-        );
-        
-        *out_packets = std::move(new_payloads);
+            &obus_in_packet)) {
+        return false;
     }
     
-    return true;
+    // The packet still open is the last one of the frame
+    return FinishPayload(out_packets, true);
 }
 
-std::tuple<std::vector<std::vector<uint8_t>>, int> AV1Packetizer::AppendOBUPayload(
-    std::vector<std::vector<uint8_t>> payloads,
-    const std::vector<uint8_t>& obu_payload,
-    bool is_new_video_sequence,
-    bool is_last,
-    bool start_with_new_packet,
-    int mtu,
-    int current_obu_count) {
-    
-    int current_payload = static_cast<int>(payloads.size()) - 1;
+bool AV1Packetizer::AppendOBUPayload(PacketWriter* payloads,
+                                     const std::vector<uint8_t>& obu_payload,
+                                     bool is_new_video_sequence,
+                                     bool is_last,
+                                     bool start_with_new_packet,
+                                     int* current_obu_count) {
+    int mtu = static_cast<int>(stream_.PayloadBudget(mtu_));
     int free_space = 0;
     
-    if (current_payload >= 0) {
-        free_space = mtu - static_cast<int>(payloads[current_payload].size());
+    if (open_payload_ != nullptr) {
+        free_space = mtu - static_cast<int>(open_size_);
     }
     
     // Create a new packet if needed
-    if (current_payload < 0 || free_space <= 0 || start_with_new_packet) {
-        std::vector<uint8_t> payload(1, 0);  // Start with aggregation header
-        
+    if (open_payload_ == nullptr || free_space <= 0 || start_with_new_packet) {
         // Set N bit if this is a new video sequence
-        if (is_new_video_sequence) {
-            payload[0] |= kAV1NMask;
+        if (!StartPayload(payloads, is_new_video_sequence ? kAV1NMask : 0)) {
+            return false;
         }
-        
-        payloads.push_back(payload);
-        current_payload = static_cast<int>(payloads.size() - 1);
         free_space = mtu - 1;  // Account for aggregation header
-        current_obu_count = 0;
+        *current_obu_count = 0;
     }
     
     size_t remaining = obu_payload.size();
@@ -176,87 +191,100 @@ std::tuple<std::vector<std::vector<uint8_t>>, int> AV1Packetizer::AppendOBUPaylo
     
     // Decide if we should use the W field
     bool should_use_w_field = (is_last || to_write >= static_cast<size_t>(free_space)) && 
-                              current_obu_count < 3;
+                              *current_obu_count < 3;
     
     if (should_use_w_field) {
         // Set W field to number of OBUs in packet
-        payloads[current_payload][0] |= static_cast<uint8_t>((current_obu_count + 1) << kAV1WBitshift) & kAV1WMask;
+        open_payload_[0] |= static_cast<uint8_t>((*current_obu_count + 1) << kAV1WBitshift) & kAV1WMask;
         
         // Append the OBU directly
-        payloads[current_payload].insert(
-            payloads[current_payload].end(),
-            obu_payload.begin(),
-            obu_payload.begin() + to_write);
+        std::memcpy(open_payload_ + open_size_, obu_payload.data(), to_write);
+        open_size_ += to_write;
         
-        current_obu_count = 0;
+        *current_obu_count = 0;
     } else if (free_space >= 2) {
         // Need at least 2 bytes for length field + min OBU
         to_write = ComputeWriteSize(to_write, free_space);
         
         // Add length field
-        auto length_field = WriteToLeb128(to_write);
-        payloads[current_payload].insert(
-            payloads[current_payload].end(),
-            length_field.begin(), 
-            length_field.end());
+        open_size_ += WriteToLeb128(static_cast<uint32_t>(to_write), open_payload_ + open_size_);
         
         // Add OBU data
-        payloads[current_payload].insert(
-            payloads[current_payload].end(),
-            obu_payload.begin(),
-            obu_payload.begin() + to_write);
+        std::memcpy(open_payload_ + open_size_, obu_payload.data(), to_write);
+        open_size_ += to_write;
         
-        current_obu_count++;
+        (*current_obu_count)++;
     } else {
         // Not enough space for even 1 byte, skip this one
         to_write = 0;
     }
     
     // Handle fragmentation
-    std::vector<uint8_t> remaining_obu(obu_payload.begin() + to_write, obu_payload.end());
-    remaining = remaining_obu.size();
+    size_t written = to_write;
+    remaining = obu_payload.size() - written;
     
     while (remaining > 0) {
-        // New packet with empty aggregation header
-        std::vector<uint8_t> payload(1, 0);
-        payloads.push_back(payload);
-        current_payload++;
-        
         // If we wrote something to the previous packet, set Y bit on previous and Z bit on current
         if (to_write != 0) {
-            payloads[current_payload - 1][0] |= kAV1YMask;
-            payloads[current_payload][0] |= kAV1ZMask;
+            open_payload_[0] |= kAV1YMask;
+        }
+        
+        if (!StartPayload(payloads, to_write != 0 ? kAV1ZMask : 0)) {
+            return false;
         }
         
         to_write = remaining;
-        if (to_write > mtu - 1) {  // MTU - aggregation header
+        if (to_write > static_cast<size_t>(mtu - 1)) {  // MTU - aggregation header
             to_write = mtu - 1;
         }
         
         // For the last fragment (or full fragment), use W=1
         if (is_last || remaining <= static_cast<size_t>(mtu - 1)) {
-            payloads[current_payload][0] |= 1 << kAV1WBitshift;
+            open_payload_[0] |= 1 << kAV1WBitshift;
         } else {
             to_write = ComputeWriteSize(to_write, mtu - 1);
-            auto length_field = WriteToLeb128(to_write);
-            payloads[current_payload].insert(
-                payloads[current_payload].end(),
-                length_field.begin(), 
-                length_field.end());
+            open_size_ += WriteToLeb128(static_cast<uint32_t>(to_write), open_payload_ + open_size_);
         }
         
         // Add fragment data
-        payloads[current_payload].insert(
-            payloads[current_payload].end(),
-            remaining_obu.begin(),
-            remaining_obu.begin() + to_write);
+        std::memcpy(open_payload_ + open_size_, obu_payload.data() + written, to_write);
+        open_size_ += to_write;
         
-        remaining_obu.erase(remaining_obu.begin(), remaining_obu.begin() + to_write);
-        remaining = remaining_obu.size();
-        current_obu_count = 1;
+        written += to_write;
+        remaining = obu_payload.size() - written;
+        *current_obu_count = 1;
+    }
+    
+    return true;
+}
+
+bool AV1Packetizer::StartPayload(PacketWriter* payloads, uint8_t aggregation_header) {
+    if (!FinishPayload(payloads, false)) {
+        return false;
+    }
+    
+    size_t header_size = stream_.HeaderSize();
+    uint8_t* packet = payloads->Begin(header_size + stream_.PayloadBudget(mtu_));
+    stream_.WriteHeader(packet, static_cast<uint16_t>(stream_.ReserveSequenceNumbers(1)), false);
+    
+    open_payload_ = packet + header_size;
+    open_payload_[0] = aggregation_header;
+    open_size_ = 1;
+    return true;
+}
+
+bool AV1Packetizer::FinishPayload(PacketWriter* payloads, bool marker) {
+    if (open_payload_ == nullptr) {
+        return true;
+    }
+    
+    size_t header_size = stream_.HeaderSize();
+    if (marker) {
+        stream_.SetMarker(open_payload_ - header_size);
     }
     
-    return {payloads, current_obu_count};
+    open_payload_ = nullptr;
+    return payloads->Commit(header_size + open_size_);
 }
 
 size_t AV1Packetizer::ComputeWriteSize(size_t want_to_write, size_t can_write) const {
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <vector>
 #include "av1_packet.h"
+#include "rtp_packet.h"
+#include "rtp_stream.h"
 
 namespace rtp {
 
@@ -16,6 +18,13 @@ public:
     // Packetize converts an AV1 OBU stream into RTP packets
     bool Packetize(const std::vector<uint8_t>& frame, 
                   std::vector<std::vector<uint8_t>>* out_packets);
+    bool Packetize(const uint8_t* frame, 
+                  size_t size, 
+                  PacketWriter* out_packets);
+    
+    // RTP header state (SSRC, payload type, timestamp, CSRCs, sequencer)
+    StreamState& Stream() { return stream_; }
+    const StreamState& Stream() const { return stream_; }
                   
 private:
     // Measure the maximum write size for a payload with leb128 encoding added
@@ -24,17 +33,31 @@ private:
     // Calculate the size of a leb128 encoded value and whether it's at edge of size change
     void Leb128Size(size_t value, size_t* size, bool* is_at_edge) const;
     
-    // Append an OBU to the current set of payloads
-    std::tuple<std::vector<std::vector<uint8_t>>, int> AppendOBUPayload(
-        std::vector<std::vector<uint8_t>> payloads,
-        const std::vector<uint8_t>& obu_payload,
-        bool is_new_video_sequence,
-        bool is_last,
-        bool start_with_new_packet,
-        int mtu,
-        int current_obu_count);
+    // Append an OBU to the open payload, opening new payloads as needed
+    bool AppendOBUPayload(PacketWriter* payloads,
+                          const std::vector<uint8_t>& obu_payload,
+                          bool is_new_video_sequence,
+                          bool is_last,
+                          bool start_with_new_packet,
+                          int* current_obu_count);
+
+    // Commits the open payload (if any) and opens a new packet whose payload
+    // starts with the given aggregation header
+    bool StartPayload(PacketWriter* payloads, uint8_t aggregation_header);
+
+    // Commits the open payload, if any, optionally as the frame's last packet
+    bool FinishPayload(PacketWriter* payloads, bool marker);
         
     size_t mtu_;
+    StreamState stream_;
+
+    // The payload currently being filled lives in the arena, right after its
+    // RTP header, until committed
+    uint8_t* open_payload_ = nullptr;
+    size_t open_size_ = 0;
+
+    // Reused between frames so steady-state packetization does not allocate
+    std::vector<uint8_t> obu_payload_;
 };
 
 } // namespace rtp
@@ -1,6 +1,5 @@
 #include "h264_packetizer.h"
 #include <algorithm>
-#include <arpa/inet.h>
 
 namespace rtp {
 
@@ -8,6 +7,20 @@ H264Packetizer::H264Packetizer(uint16_t mtu) : H264Packet(), mtu_(mtu) {}
 
 H264Packetizer::H264Packetizer(uint16_t mtu, bool is_avc) : H264Packet(), mtu_(mtu) {
     is_avc_ = is_avc;
+    
+    // AVC input carries 4-byte NALU lengths instead of start codes
+    if (is_avc) {
+        nalu_length_size_ = 4;
+    }
+}
+
+bool H264Packetizer::SetNaluLengthSize(uint8_t length_size) {
+    if (length_size != 0 && !IsValidNaluLengthSize(length_size)) {
+        return false;
+    }
+    
+    nalu_length_size_ = length_size;
+    return true;
 }
 
 bool H264Packetizer::Packetize(const std::vector<uint8_t>& frame, std::vector<std::vector<uint8_t>>* packets) {
@@ -15,146 +28,203 @@ bool H264Packetizer::Packetize(const std::vector<uint8_t>& frame, std::vector<st
         return false;
     }
     
-    packets->clear();
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    if (!Packetize(frame.data(), frame.size(), &arena)) {
+        packets->clear();
+        return false;
+    }
+    
+    arena.CopyTo(packets);
+    return true;
+}
+
+bool H264Packetizer::Packetize(const uint8_t* frame, size_t size, PacketWriter* packets) {
+    if (!packets) {
+        return false;
+    }
     
-    if (frame.empty()) {
+    if (!frame || size == 0) {
         return true;
     }
     
-    // Find and process NALUs in the frame
-    std::vector<std::vector<uint8_t>> payloads;
+    // A truncated length-prefixed NALU means the frame is malformed; catch it
+    // before any packet or stored SPS/PPS changes
+    if (nalu_length_size_ && !IsWellFormedLengthPrefixed(frame, size, nalu_length_size_)) {
+        return false;
+    }
+    
+    stream_.BeginFrame();
+    
+    // NALUs are written one behind the scan, so the last NALU of the frame is
+    // known when its packets are built and can carry the marker bit
+    const uint8_t* pending_nalu = nullptr;
+    size_t pending_size = 0;
+    bool ok = true;
+    
+    size_t pos = 0;
+    NaluRange range;
+    auto next_nalu = [&]() {
+        return nalu_length_size_ ? NextLengthPrefixedNalu(frame, size, nalu_length_size_, &pos, &range)
+                                 : NextNalu(frame, size, &pos, &range);
+    };
     
-    H264Packet::EmitNalus(frame, [this, &payloads](const std::vector<uint8_t>& nalu) {
-        if (nalu.empty()) {
-            return;
+    while (ok && next_nalu()) {
+        if (range.size == 0) {
+            continue;
         }
         
-        std::vector<std::vector<uint8_t>> nalu_payloads = this->Payload(nalu);
-        payloads.insert(payloads.end(), nalu_payloads.begin(), nalu_payloads.end());
-    });
-    
-    // Create RTP packets for each payload
-    for (size_t i = 0; i < payloads.size(); i++) {
-        Packet rtp_packet;
+        const uint8_t* nalu = frame + range.offset;
+        uint8_t nalu_type = nalu[0] & kNaluTypeBitmask;
         
-        // Set marker bit for the last packet
-        rtp_packet.header.marker = (i == payloads.size() - 1);
-        rtp_packet.payload = payloads[i];
+        // Filter out specific NALU types
+        if (nalu_type == kAudNALUType || nalu_type == kFillerNALUType) {
+            continue;
+        }
         
-        std::vector<uint8_t> serialized = rtp_packet.Packetize();
-        packets->push_back(serialized);
-    }
-    
-    return true;
-}
-
-std::vector<std::vector<uint8_t>> H264Packetizer::Payload(const std::vector<uint8_t>& nalu) {
-    std::vector<std::vector<uint8_t>> payloads;
-    
-    if (nalu.empty()) {
-        return payloads;
+        // Hold SPS and PPS NALUs back for a STAP-A with the next NALU
+        if (!disable_stap_a_ && (nalu_type == kSpsNALUType || nalu_type == kPpsNALUType)) {
+            if (pending_nalu) {
+                ok = WriteNalu(pending_nalu, pending_size, false, packets);
+                pending_nalu = nullptr;
+            }
+            
+            std::vector<uint8_t>& stored = (nalu_type == kSpsNALUType) ? sps_nalu_ : pps_nalu_;
+            stored.assign(nalu, nalu + range.size);
+            continue;
+        }
+        
+        if (pending_nalu) {
+            ok = WriteNalu(pending_nalu, pending_size, false, packets);
+        }
+        
+        pending_nalu = nalu;
+        pending_size = range.size;
     }
     
-    uint8_t nalu_type = nalu[0] & kNaluTypeBitmask;
-    uint8_t nalu_ref_idc = nalu[0] & kNaluRefIdcBitmask;
-    
-    // Filter out specific NALU types
-    if (nalu_type == kAudNALUType || nalu_type == kFillerNALUType) {
-        return payloads;
+    if (ok && pending_nalu) {
+        ok = WriteNalu(pending_nalu, pending_size, true, packets);
     }
     
-    // Handle SPS and PPS NALUs for potential STAP-A
-    if (!disable_stap_a_) {
-        if (nalu_type == kSpsNALUType) {
-            sps_nalu_ = nalu;
-            return payloads;
-        } else if (nalu_type == kPpsNALUType) {
-            pps_nalu_ = nalu;
-            return payloads;
-        }
+    return ok;
+}
+
+bool H264Packetizer::WriteNalu(const uint8_t* nalu, size_t size, bool last, PacketWriter* packets) {
+    // If we have SPS and PPS NALUs, consider combining with the current NALU
+    if (!disable_stap_a_ && !sps_nalu_.empty() && !pps_nalu_.empty()) {
+        size_t stap_a_size = kStapaHeaderSize + 
+                             kStapaNALULengthSize + sps_nalu_.size() + 
+                             kStapaNALULengthSize + pps_nalu_.size() + 
+                             kStapaNALULengthSize + size;
         
-        // If we have SPS and PPS NALUs, consider combining with the current NALU
-        if (!sps_nalu_.empty() && !pps_nalu_.empty()) {
+        if (stap_a_size <= stream_.PayloadBudget(mtu_)) {
             // Pack current NALU with SPS and PPS as STAP-A
-            uint16_t sps_len = htons(static_cast<uint16_t>(sps_nalu_.size()));
-            uint16_t pps_len = htons(static_cast<uint16_t>(pps_nalu_.size()));
-            uint16_t nalu_len = htons(static_cast<uint16_t>(nalu.size()));
-            
-            std::vector<uint8_t> stap_a_nalu = {kOutputStapAHeader};
+            size_t header_size = stream_.HeaderSize();
+            uint8_t* out = packets->Begin(header_size + stap_a_size);
+            stream_.WriteHeader(out, static_cast<uint16_t>(stream_.ReserveSequenceNumbers(1)), last);
             
-            // Add SPS
-            stap_a_nalu.push_back(static_cast<uint8_t>(sps_len >> 8));
-            stap_a_nalu.push_back(static_cast<uint8_t>(sps_len & 0xFF));
-            stap_a_nalu.insert(stap_a_nalu.end(), sps_nalu_.begin(), sps_nalu_.end());
+            uint8_t* payload = out + header_size;
+            *payload++ = kOutputStapAHeader;
+            payload = WriteStapAUnit(sps_nalu_.data(), sps_nalu_.size(), payload);
+            payload = WriteStapAUnit(pps_nalu_.data(), pps_nalu_.size(), payload);
+            WriteStapAUnit(nalu, size, payload);
             
-            // Add PPS
-            stap_a_nalu.push_back(static_cast<uint8_t>(pps_len >> 8));
-            stap_a_nalu.push_back(static_cast<uint8_t>(pps_len & 0xFF));
-            stap_a_nalu.insert(stap_a_nalu.end(), pps_nalu_.begin(), pps_nalu_.end());
-            
-            // Add current NALU
-            stap_a_nalu.push_back(static_cast<uint8_t>(nalu_len >> 8));
-            stap_a_nalu.push_back(static_cast<uint8_t>(nalu_len & 0xFF));
-            stap_a_nalu.insert(stap_a_nalu.end(), nalu.begin(), nalu.end());
-            
-            if (stap_a_nalu.size() <= mtu_) {
-                payloads.push_back(stap_a_nalu);
-                
-                // Clear stored NALUs
-                sps_nalu_.clear();
-                pps_nalu_.clear();
-                
-                return payloads;
-            }
-            
-            // If STAP-A packet would be too large, clear stored NALUs
+            // Clear stored NALUs
             sps_nalu_.clear();
             pps_nalu_.clear();
+            
+            return packets->Commit(header_size + stap_a_size);
+        }
+        
+        // The STAP-A packet would be too large, send SPS and PPS on their own
+        bool ok = WriteSingleNalu(sps_nalu_.data(), sps_nalu_.size(), false, packets) &&
+                  WriteSingleNalu(pps_nalu_.data(), pps_nalu_.size(), false, packets);
+        sps_nalu_.clear();
+        pps_nalu_.clear();
+        
+        if (!ok) {
+            return false;
         }
     }
     
+    return WriteSingleNalu(nalu, size, last, packets);
+}
+
+bool H264Packetizer::WriteSingleNalu(const uint8_t* nalu, size_t size, bool last, PacketWriter* packets) {
+    size_t header_size = stream_.HeaderSize();
+    size_t mtu = stream_.PayloadBudget(mtu_);
+    
     // Single NALU
-    if (nalu.size() <= mtu_) {
-        std::vector<uint8_t> out = nalu;
-        payloads.push_back(out);
-        return payloads;
+    if (size <= mtu) {
+        uint8_t* out = packets->Begin(header_size + size);
+        stream_.WriteHeader(out, static_cast<uint16_t>(stream_.ReserveSequenceNumbers(1)), last);
+        std::copy(nalu, nalu + size, out + header_size);
+        return packets->Commit(header_size + size);
     }
     
     // FU-A fragmentation for large NALUs
-    size_t max_fragment_size = mtu_ - kFuaHeaderSize;
+    uint8_t nalu_type = nalu[0] & kNaluTypeBitmask;
+    uint8_t nalu_ref_idc = nalu[0] & kNaluRefIdcBitmask;
+    
+    if (mtu <= kFuaHeaderSize) {
+        return false;
+    }
+    
+    size_t max_fragment_size = mtu - kFuaHeaderSize;
     size_t nalu_index = 1; // Skip the first byte which contains the NALU header
-    size_t nalu_length = nalu.size() - nalu_index;
+    size_t nalu_length = size - nalu_index;
     size_t nalu_remaining = nalu_length;
     
+    // Claim the sequence numbers for all fragments at once
+    uint64_t sequence_number = stream_.ReserveSequenceNumbers(
+        (nalu_length + max_fragment_size - 1) / max_fragment_size);
+    
     while (nalu_remaining > 0) {
         size_t current_fragment_size = std::min(max_fragment_size, nalu_remaining);
-        std::vector<uint8_t> out(kFuaHeaderSize + current_fragment_size);
+        size_t packet_size = header_size + kFuaHeaderSize + current_fragment_size;
+        
+        uint8_t* out = packets->Begin(packet_size);
+        bool last_fragment = nalu_remaining <= current_fragment_size;
+        stream_.WriteHeader(out, static_cast<uint16_t>(sequence_number++), last && last_fragment);
+        
+        uint8_t* payload = out + header_size;
         
         // Set FU indicator
-        out[0] = kFuaNALUType | nalu_ref_idc;
+        payload[0] = kFuaNALUType | nalu_ref_idc;
         
         // Set FU header
-        out[1] = nalu_type;
+        payload[1] = nalu_type;
         if (nalu_remaining == nalu_length) {
             // Set start bit for first fragment
-            out[1] |= kFuStartBitmask;
-        } else if (nalu_remaining <= current_fragment_size) {
+            payload[1] |= kFuStartBitmask;
+        } else if (last_fragment) {
             // Set end bit for last fragment
-            out[1] |= kFuEndBitmask;
+            payload[1] |= kFuEndBitmask;
         }
         
         // Copy fragment data
-        std::copy(nalu.begin() + nalu_index, 
-                  nalu.begin() + nalu_index + current_fragment_size, 
-                  out.begin() + kFuaHeaderSize);
+        std::copy(nalu + nalu_index, 
+                  nalu + nalu_index + current_fragment_size, 
+                  payload + kFuaHeaderSize);
         
-        payloads.push_back(out);
+        if (!packets->Commit(packet_size)) {
+            return false;
+        }
         
         nalu_remaining -= current_fragment_size;
         nalu_index += current_fragment_size;
     }
     
-    return payloads;
+    return true;
+}
+
+uint8_t* H264Packetizer::WriteStapAUnit(const uint8_t* nalu, size_t size, uint8_t* out) {
+    // NALU size is in network byte order
+    out[0] = static_cast<uint8_t>(size >> 8);
+    out[1] = static_cast<uint8_t>(size & 0xFF);
+    std::copy(nalu, nalu + size, out + kStapaNALULengthSize);
+    return out + kStapaNALULengthSize + size;
 }
 
 } // namespace rtp
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <memory>
 #include "h264_packet.h"
 #include "rtp_packet.h"
+#include "rtp_stream.h"
 
 namespace rtp {
 
@@ -18,9 +19,22 @@ public:
     // Packetize fragments an H.264 frame into RTP packets
     bool Packetize(const std::vector<uint8_t>& frame, std::vector<std::vector<uint8_t>>* packets);
 
+    // Packetize a frame held in caller memory, appending each packet to the
+    // writer as soon as it is built
+    bool Packetize(const uint8_t* frame, size_t size, PacketWriter* packets);
+
     // EnableStapA allows combining SPS and PPS NALUs in a single packet
     void EnableStapA() { disable_stap_a_ = false; }
     void DisableStapA() { disable_stap_a_ = true; }
+    
+    // SetNaluLengthSize switches the input to length-prefixed (AVCC) NALUs
+    // with 1, 2 or 4 byte lengths; 0 selects Annex B start codes
+    bool SetNaluLengthSize(uint8_t length_size);
+    uint8_t NaluLengthSize() const { return nalu_length_size_; }
+    
+    // RTP header state (SSRC, payload type, timestamp, CSRCs, sequencer)
+    StreamState& Stream() { return stream_; }
+    const StreamState& Stream() const { return stream_; }
 
 private:
     // Maximum size for RTP packet payload
@@ -33,8 +47,20 @@ private:
     // Flag to disable STAP-A packet generation
     bool disable_stap_a_ = false;
     
-    // Payload fragments an H.264 NALU into one or more RTP packets
-    std::vector<std::vector<uint8_t>> Payload(const std::vector<uint8_t>& nalu);
+    // Size of the AVCC length field of input NALUs, 0 for Annex B input
+    uint8_t nalu_length_size_ = 0;
+    
+    // RTP header state shared by every packet
+    StreamState stream_;
+    
+    // WriteNalu writes the packets for one NALU, aggregating pending SPS and PPS
+    bool WriteNalu(const uint8_t* nalu, size_t size, bool last, PacketWriter* packets);
+    
+    // WriteSingleNalu writes one NALU as a single NALU packet or FU-A fragments
+    bool WriteSingleNalu(const uint8_t* nalu, size_t size, bool last, PacketWriter* packets);
+    
+    // WriteStapAUnit writes a length-prefixed STAP-A unit, returns its end
+    static uint8_t* WriteStapAUnit(const uint8_t* nalu, size_t size, uint8_t* out);
 };
 
 } // namespace rtp
@@ -1,4 +1,5 @@
 #include "h265_packetizer.h"
+#include "annexb_scanner.h"
 #include <algorithm>
 #include <cmath>
 #include <functional>
@@ -26,52 +27,107 @@ void H265Payloader::WithSkipAggregation(bool value) {
     skip_aggregation_ = value;
 }
 
+bool H265Payloader::WithNaluLengthSize(uint8_t length_size) {
+    if (length_size != 0 && !IsValidNaluLengthSize(length_size)) {
+        return false;
+    }
+    
+    nalu_length_size_ = length_size;
+    return true;
+}
+
 std::vector<std::vector<uint8_t>> H265Payloader::Payload(uint16_t mtu, const std::vector<uint8_t>& payload) {
+    return Payload(mtu, payload.data(), payload.size());
+}
+
+std::vector<std::vector<uint8_t>> H265Payloader::Payload(uint16_t mtu, const uint8_t* payload, size_t size) {
     std::vector<std::vector<uint8_t>> payloads;
-    if (payload.empty() || mtu == 0) {
-        return payloads;
+    
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    if (Payload(mtu, payload, size, nullptr, &arena)) {
+        arena.CopyTo(&payloads);
+    }
+    
+    return payloads;
+}
+
+bool H265Payloader::Payload(uint16_t mtu, const uint8_t* payload, size_t size, 
+                            StreamState* stream, PacketWriter* packets) {
+    if (!payload || size == 0 || mtu == 0 || !packets) {
+        return false;
     }
 
-    std::vector<std::vector<uint8_t>> bufferedNALUs;
+    // A truncated length-prefixed NALU means the frame is malformed; catch it
+    // before any packet is written
+    if (nalu_length_size_ && !IsWellFormedLengthPrefixed(payload, size, nalu_length_size_)) {
+        return false;
+    }
+
+    std::vector<std::pair<const uint8_t*, size_t>>& bufferedNALUs = buffered_nalus_;
+    bufferedNALUs.clear();
     int aggregationBufferSize = 0;
+    bool emitted = false;
+    
+    // Every packet is written in place: RTP header (if any) followed by the payload
+    const size_t headerSize = stream ? stream->HeaderSize() : 0;
+    uint8_t* packet = nullptr;
+    
+    auto beginPacket = [&](size_t payloadSize, bool marker) -> uint8_t* {
+        packet = packets->Begin(headerSize + payloadSize);
+        if (stream) {
+            stream->WriteHeader(packet, static_cast<uint16_t>(stream->ReserveSequenceNumbers(1)), marker);
+        }
+        return packet + headerSize;
+    };
+    
+    auto commitPacket = [&](size_t payloadSize) -> bool {
+        emitted = true;
+        return packets->Commit(headerSize + payloadSize);
+    };
 
-    auto flushBufferedNals = [&]() {
+    auto flushBufferedNals = [&](bool last) -> bool {
         if (bufferedNALUs.empty()) {
-            return;
+            return true;
         }
         
+        bool ok;
         if (bufferedNALUs.size() == 1) {
             // Emit this as a single NALU packet
-            std::vector<uint8_t> nalu = bufferedNALUs[0];
+            const uint8_t* nalu = bufferedNALUs[0].first;
+            size_t naluSize = bufferedNALUs[0].second;
 
             if (add_donl_) {
-                std::vector<uint8_t> buf(nalu.size() + 2);
+                uint8_t* buf = beginPacket(naluSize + 2, last);
 
                 // Copy the NALU header to the payload header
-                std::copy(nalu.begin(), nalu.begin() + kH265NaluHeaderSize, buf.begin());
+                std::copy(nalu, nalu + kH265NaluHeaderSize, buf);
 
                 // Copy the DONL into the header
                 buf[kH265NaluHeaderSize] = static_cast<uint8_t>(donl_ >> 8);
                 buf[kH265NaluHeaderSize + 1] = static_cast<uint8_t>(donl_ & 0xFF);
 
                 // Write the payload
-                std::copy(nalu.begin() + kH265NaluHeaderSize, nalu.end(), buf.begin() + kH265NaluHeaderSize + 2);
+                std::copy(nalu + kH265NaluHeaderSize, nalu + naluSize, buf + kH265NaluHeaderSize + 2);
 
                 donl_++;
-                payloads.push_back(buf);
+                ok = commitPacket(naluSize + 2);
             } else {
                 // Write the nalu directly to the payload
-                payloads.push_back(nalu);
+                uint8_t* buf = beginPacket(naluSize, last);
+                std::copy(nalu, nalu + naluSize, buf);
+                ok = commitPacket(naluSize);
             }
         } else {
             // Construct an aggregation packet
-            std::vector<uint8_t> buf(aggregationBufferSize);
+            uint8_t* buf = beginPacket(aggregationBufferSize, last);
 
             uint8_t layerID = 255;
             uint8_t tid = 255;
             
             for (const auto& nalu : bufferedNALUs) {
-                H265NALUHeader header(nalu[0], nalu[1]);
+                H265NALUHeader header(nalu.first[0], nalu.first[1]);
                 uint8_t headerLayerID = header.LayerID();
                 uint8_t headerTID = header.TID();
                 
@@ -94,7 +150,8 @@ std::vector<std::vector<uint8_t>> H265Payloader::Payload(uint16_t mtu, const std
 
             size_t index = 2;
             for (size_t i = 0; i < bufferedNALUs.size(); ++i) {
-                const auto& nalu = bufferedNALUs[i];
+                const uint8_t* nalu = bufferedNALUs[i].first;
+                size_t naluSize = bufferedNALUs[i].second;
                 
                 if (add_donl_) {
                     if (i == 0) {
@@ -106,28 +163,29 @@ std::vector<std::vector<uint8_t>> H265Payloader::Payload(uint16_t mtu, const std
                 }
 
                 // Write NALU size
-                uint16_t nalu_size = static_cast<uint16_t>(nalu.size());
+                uint16_t nalu_size = static_cast<uint16_t>(naluSize);
                 buf[index++] = static_cast<uint8_t>(nalu_size >> 8);
                 buf[index++] = static_cast<uint8_t>(nalu_size & 0xFF);
                 
                 // Copy NALU data
-                std::copy(nalu.begin(), nalu.end(), buf.begin() + index);
-                index += nalu.size();
+                std::copy(nalu, nalu + naluSize, buf + index);
+                index += naluSize;
             }
             
-            payloads.push_back(buf);
+            ok = commitPacket(aggregationBufferSize);
         }
         
         // Clear buffered NALUs
         bufferedNALUs.clear();
         aggregationBufferSize = 0;
+        return ok;
     };
 
-    auto calcMarginalAggregationSize = [&](const std::vector<uint8_t>& nalu) -> int {
-        int marginalAggregationSize = static_cast<int>(nalu.size()) + 2; // +2 is NALU size Field size
+    auto calcMarginalAggregationSize = [&](size_t naluSize) -> int {
+        int marginalAggregationSize = static_cast<int>(naluSize) + 2; // +2 is NALU size Field size
         
         if (bufferedNALUs.size() == 1) {
-            marginalAggregationSize = static_cast<int>(nalu.size()) + 4; // +4 are Aggregation header + NALU size Field size
+            marginalAggregationSize = static_cast<int>(naluSize) + 4; // +4 are Aggregation header + NALU size Field size
         }
         
         if (add_donl_) {
@@ -140,144 +198,144 @@ std::vector<std::vector<uint8_t>> H265Payloader::Payload(uint16_t mtu, const std
 
         return marginalAggregationSize;
     };
-
-    // Scan through payload to find NAL units
-    size_t offset = 0;
-    while (offset < payload.size()) {
-        // Find start code
-        size_t naluStart = offset;
-        size_t naluSize = 0;
-        
-        // Find the next start code or end of data
-        size_t nextStart = payload.size();
-        for (size_t i = offset + 3; i < payload.size() - 2; ++i) {
-            if (payload[i] == 0 && payload[i + 1] == 0 && 
-                (payload[i + 2] == 1 || (payload[i + 2] == 0 && payload[i + 3] == 1))) {
-                nextStart = i;
-                break;
-            }
+    
+    // last is set for the final NALU of the frame, whose last packet carries the marker
+    auto processNalu = [&](const uint8_t* nalu, size_t naluSize, bool last) -> bool {
+        int naluLen = static_cast<int>(naluSize) + kH265NaluHeaderSize;
+        if (add_donl_) {
+            naluLen += 2;
         }
         
-        // Calculate NALU size and skip start code
-        if (payload[naluStart] == 0 && payload[naluStart + 1] == 0) {
-            if (payload[naluStart + 2] == 1) {
-                // 3-byte start code
-                naluStart += 3;
-            } else if (naluStart + 3 < payload.size() && payload[naluStart + 2] == 0 && payload[naluStart + 3] == 1) {
-                // 4-byte start code
-                naluStart += 4;
+        if (naluLen <= mtu) {
+            // This NALU fits into a single packet, either it can be emitted as
+            // a single NALU or appended to the previous aggregation packet
+            int marginalAggregationSize = calcMarginalAggregationSize(naluSize);
+
+            if (aggregationBufferSize + marginalAggregationSize > mtu) {
+                if (!flushBufferedNals(false)) {
+                    return false;
+                }
+                marginalAggregationSize = calcMarginalAggregationSize(naluSize);
+            }
+            
+            bufferedNALUs.emplace_back(nalu, naluSize);
+            aggregationBufferSize += marginalAggregationSize;
+            
+            if (skip_aggregation_) {
+                // Emit this immediately
+                return flushBufferedNals(last);
             }
+            return true;
         }
         
-        naluSize = nextStart - naluStart;
+        // If this NALU doesn't fit in the current MTU, it needs to be fragmented
+        int fuPacketHeaderSize = kH265FragmentationUnitHeaderSize + kH265NaluHeaderSize;
+        if (add_donl_) {
+            fuPacketHeaderSize += 2;
+        }
+
+        // Then, fragment the NALU
+        int maxFUPayloadSize = mtu - fuPacketHeaderSize;
+
+        H265NALUHeader naluHeader(nalu[0], nalu[1]);
+
+        // The NALU header is omitted from the fragmentation packet payload
+        const uint8_t* naluData = nalu + kH265NaluHeaderSize;
+        size_t fullNALUSize = naluSize - kH265NaluHeaderSize;
+
+        if (maxFUPayloadSize <= 0 || fullNALUSize == 0) {
+            return true;
+        }
+
+        // Flush any buffered aggregation packets
+        if (!flushBufferedNals(false)) {
+            return false;
+        }
+
+        size_t offset = 0;
         
-        if (naluSize > 0) {
-            std::vector<uint8_t> nalu(payload.begin() + naluStart, payload.begin() + naluStart + naluSize);
+        while (offset < fullNALUSize) {
+            size_t currentFUPayloadSize = fullNALUSize - offset;
+            if (currentFUPayloadSize > static_cast<size_t>(maxFUPayloadSize)) {
+                currentFUPayloadSize = maxFUPayloadSize;
+            }
             
-            if (nalu.size() >= kH265NaluHeaderSize) {
-                int naluLen = static_cast<int>(nalu.size()) + kH265NaluHeaderSize;
-                if (add_donl_) {
-                    naluLen += 2;
-                }
-                
-                if (naluLen <= mtu) {
-                    // This NALU fits into a single packet, either it can be emitted as
-                    // a single NALU or appended to the previous aggregation packet
-                    int marginalAggregationSize = calcMarginalAggregationSize(nalu);
-
-                    if (aggregationBufferSize + marginalAggregationSize > mtu) {
-                        flushBufferedNals();
-                        marginalAggregationSize = calcMarginalAggregationSize(nalu);
-                    }
-                    
-                    bufferedNALUs.push_back(nalu);
-                    aggregationBufferSize += marginalAggregationSize;
-                    
-                    if (skip_aggregation_) {
-                        // Emit this immediately
-                        flushBufferedNals();
-                    }
-                } else {
-                    // If this NALU doesn't fit in the current MTU, it needs to be fragmented
-                    int fuPacketHeaderSize = kH265FragmentationUnitHeaderSize + kH265NaluHeaderSize;
-                    if (add_donl_) {
-                        fuPacketHeaderSize += 2;
-                    }
+            bool lastFragment = offset + currentFUPayloadSize == fullNALUSize;
+            uint8_t* out = beginPacket(fuPacketHeaderSize + currentFUPayloadSize, last && lastFragment);
+
+            // Write the payload header
+            uint16_t header_value = naluHeader.GetValue();
+            out[0] = (static_cast<uint8_t>(header_value >> 8) & 0b10000001) | 
+                     (kH265NaluFragmentationUnitType << 1);
+            out[1] = static_cast<uint8_t>(header_value & 0xFF);
+
+            // Write the fragment header
+            out[2] = naluHeader.Type();
+            if (offset == 0) {
+                // Set start bit
+                out[2] |= 1 << 7;
+            } else if (lastFragment) {
+                // Set end bit
+                out[2] |= 1 << 6;
+            }
+
+            if (add_donl_) {
+                // Write the DONL header
+                out[3] = static_cast<uint8_t>(donl_ >> 8);
+                out[4] = static_cast<uint8_t>(donl_ & 0xFF);
+                donl_++;
 
-                    // Then, fragment the NALU
-                    int maxFUPayloadSize = mtu - fuPacketHeaderSize;
+                // Copy the fragment payload
+                std::copy(naluData + offset, 
+                         naluData + offset + currentFUPayloadSize,
+                         out + 5);
+            } else {
+                // Copy the fragment payload
+                std::copy(naluData + offset,
+                         naluData + offset + currentFUPayloadSize,
+                         out + 3);
+            }
 
-                    H265NALUHeader naluHeader(nalu[0], nalu[1]);
+            // Hand the fragment to the writer
+            if (!commitPacket(fuPacketHeaderSize + currentFUPayloadSize)) {
+                return false;
+            }
 
-                    // The NALU header is omitted from the fragmentation packet payload
-                    std::vector<uint8_t> naluData(nalu.begin() + kH265NaluHeaderSize, nalu.end());
+            // Advance the NALU data pointer
+            offset += currentFUPayloadSize;
+        }
+        
+        return true;
+    };
 
-                    if (maxFUPayloadSize <= 0 || naluData.empty()) {
-                        continue;
-                    }
+    // NALUs are processed one behind the scan so the last one is known
+    const uint8_t* pendingNalu = nullptr;
+    size_t pendingSize = 0;
 
-                    // Flush any buffered aggregation packets
-                    flushBufferedNals();
-
-                    size_t fullNALUSize = naluData.size();
-                    size_t offset = 0;
-                    
-                    while (offset < naluData.size()) {
-                        size_t currentFUPayloadSize = naluData.size() - offset;
-                        if (currentFUPayloadSize > static_cast<size_t>(maxFUPayloadSize)) {
-                            currentFUPayloadSize = maxFUPayloadSize;
-                        }
-
-                        std::vector<uint8_t> out(fuPacketHeaderSize + currentFUPayloadSize);
-
-                        // Write the payload header
-                        uint16_t header_value = naluHeader.GetValue();
-                        out[0] = (static_cast<uint8_t>(header_value >> 8) & 0b10000001) | 
-                                 (kH265NaluFragmentationUnitType << 1);
-                        out[1] = static_cast<uint8_t>(header_value & 0xFF);
-
-                        // Write the fragment header
-                        out[2] = naluHeader.Type();
-                        if (offset == 0) {
-                            // Set start bit
-                            out[2] |= 1 << 7;
-                        } else if (offset + currentFUPayloadSize == fullNALUSize) {
-                            // Set end bit
-                            out[2] |= 1 << 6;
-                        }
-
-                        if (add_donl_) {
-                            // Write the DONL header
-                            out[3] = static_cast<uint8_t>(donl_ >> 8);
-                            out[4] = static_cast<uint8_t>(donl_ & 0xFF);
-                            donl_++;
-
-                            // Copy the fragment payload
-                            std::copy(naluData.begin() + offset, 
-                                     naluData.begin() + offset + currentFUPayloadSize,
-                                     out.begin() + 5);
-                        } else {
-                            // Copy the fragment payload
-                            std::copy(naluData.begin() + offset,
-                                     naluData.begin() + offset + currentFUPayloadSize,
-                                     out.begin() + 3);
-                        }
-
-                        // Append the fragment to the payload
-                        payloads.push_back(out);
-
-                        // Advance the NALU data pointer
-                        offset += currentFUPayloadSize;
-                    }
-                }
+    // Scan through payload to find NAL units
+    size_t pos = 0;
+    NaluRange range;
+    auto nextNalu = [&]() {
+        return nalu_length_size_ ? NextLengthPrefixedNalu(payload, size, nalu_length_size_, &pos, &range)
+                                 : NextNalu(payload, size, &pos, &range);
+    };
+    
+    while (nextNalu()) {
+        if (range.size >= kH265NaluHeaderSize) {
+            if (pendingNalu && !processNalu(pendingNalu, pendingSize, false)) {
+                return false;
             }
+            
+            pendingNalu = payload + range.offset;
+            pendingSize = range.size;
         }
-        
-        offset = nextStart;
     }
 
-    flushBufferedNals();
-    return payloads;
+    if (pendingNalu && !processNalu(pendingNalu, pendingSize, true)) {
+        return false;
+    }
+
+    return flushBufferedNals(true) && emitted;
 }
 
 //
@@ -285,8 +343,7 @@ std::vector<std::vector<uint8_t>> H265Payloader::Payload(uint16_t mtu, const std
 //
 
 H265Packetizer::H265Packetizer(uint16_t mtu) 
-    : mtu_(mtu),
-      sequencer_(std::make_shared<RandomSequencer>()) {
+    : mtu_(mtu) {
 }
 
 void H265Packetizer::WithDONL(bool value) {
@@ -297,22 +354,24 @@ void H265Packetizer::WithSkipAggregation(bool value) {
     payloader_.WithSkipAggregation(value);
 }
 
+bool H265Packetizer::WithNaluLengthSize(uint8_t length_size) {
+    return payloader_.WithNaluLengthSize(length_size);
+}
+
 void H265Packetizer::WithSequencer(std::shared_ptr<Sequencer> sequencer) {
-    if (sequencer) {
-        sequencer_ = sequencer;
-    }
+    stream_.SetSequencer(sequencer);
 }
 
 void H265Packetizer::WithTimestamp(uint32_t timestamp) {
-    timestamp_ = timestamp;
+    stream_.SetTimestamp(timestamp);
 }
 
 void H265Packetizer::WithSSRC(uint32_t ssrc) {
-    ssrc_ = ssrc;
+    stream_.SetSSRC(ssrc);
 }
 
 void H265Packetizer::WithPayloadType(uint8_t payload_type) {
-    payload_type_ = payload_type;
+    stream_.SetPayloadType(payload_type);
 }
 
 bool H265Packetizer::Packetize(const std::vector<uint8_t>& h265_frame, std::vector<std::vector<uint8_t>>* rtp_packets) {
@@ -320,36 +379,27 @@ bool H265Packetizer::Packetize(const std::vector<uint8_t>& h265_frame, std::vect
         return false;
     }
     
-    rtp_packets->clear();
-    
-    // Let the payloader process the frames into RTP sized chunks
-    std::vector<std::vector<uint8_t>> payloads = payloader_.Payload(mtu_, h265_frame);
-    
-    if (payloads.empty()) {
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    if (!Packetize(h265_frame.data(), h265_frame.size(), &arena)) {
+        rtp_packets->clear();
         return false;
     }
     
-    // For each payload, create an RTP packet
-    for (size_t i = 0; i < payloads.size(); ++i) {
-        const auto& payload = payloads[i];
-        
-        Packet packet;
-        packet.header.payload_type = payload_type_;
-        packet.header.sequence_number = sequencer_->NextSequenceNumber();
-        packet.header.timestamp = timestamp_;
-        packet.header.ssrc = ssrc_;
-        
-        // Set marker bit on the last packet
-        packet.header.marker = (i == payloads.size() - 1);
-        
-        packet.payload = payload;
-        
-        // Serialize the packet
-        std::vector<uint8_t> rtp_packet = packet.Packetize();
-        rtp_packets->push_back(rtp_packet);
+    arena.CopyTo(rtp_packets);
+    return true;
+}
+
+bool H265Packetizer::Packetize(const uint8_t* h265_frame, size_t size, PacketWriter* rtp_packets) {
+    if (!rtp_packets) {
+        return false;
     }
     
-    return true;
+    // Let the payloader write RTP sized packets straight to the writer
+    stream_.BeginFrame();
+    return payloader_.Payload(static_cast<uint16_t>(stream_.PayloadBudget(mtu_)), h265_frame, size,
+                              &stream_, rtp_packets);
 }
 
 } // namespace rtp
\ No newline at end of file
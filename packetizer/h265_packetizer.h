@@ -4,9 +4,11 @@
 #include "rtp_packet.h"
 #include <cstdint>
 #include <vector>
+#include <utility>
 #include <memory>
 #include <functional>
 #include "h265_packet.h"
+#include "rtp_stream.h"
 
 namespace rtp {
 
@@ -16,16 +18,30 @@ public:
     ~H265Payloader() = default;
     
     std::vector<std::vector<uint8_t>> Payload(uint16_t mtu, const std::vector<uint8_t>& payload);
+    std::vector<std::vector<uint8_t>> Payload(uint16_t mtu, const uint8_t* payload, size_t size);
+    
+    // Payload writes each packet to packets as soon as it is built. With a
+    // stream every packet starts with its RTP header, the last one marked;
+    // without one bare payloads are written
+    bool Payload(uint16_t mtu, const uint8_t* payload, size_t size, 
+                 StreamState* stream, PacketWriter* packets);
     
     // Configure options
     void WithDONL(bool value);
     void WithSkipAggregation(bool value);
     
+    // Length-prefixed (HVCC) input with 1, 2 or 4 byte lengths, 0 for Annex B
+    bool WithNaluLengthSize(uint8_t length_size);
+    
 private:
     bool add_donl_ = false;
     bool skip_aggregation_ = false;
+    uint8_t nalu_length_size_ = 0;
     uint16_t donl_ = 0;
     
+    // NALUs waiting to be aggregated, reused between frames
+    std::vector<std::pair<const uint8_t*, size_t>> buffered_nalus_;
+    
     void EmitNALU(const std::vector<uint8_t>& nalu, 
                  const std::function<void(const std::vector<uint8_t>&)>& emit_func);
 };
@@ -37,22 +53,28 @@ public:
     
     bool Packetize(const std::vector<uint8_t>& h265_frame, 
                   std::vector<std::vector<uint8_t>>* rtp_packets);
+
+    // Packetize a frame held in caller memory, appending each packet to the
+    // writer as soon as it is built
+    bool Packetize(const uint8_t* h265_frame, size_t size, PacketWriter* rtp_packets);
     
     // Configure options
     void WithDONL(bool value);
     void WithSkipAggregation(bool value);
+    bool WithNaluLengthSize(uint8_t length_size);
     void WithSequencer(std::shared_ptr<Sequencer> sequencer);
     void WithTimestamp(uint32_t timestamp);
     void WithSSRC(uint32_t ssrc);
     void WithPayloadType(uint8_t payload_type);
     
+    // RTP header state (SSRC, payload type, timestamp, CSRCs, sequencer)
+    StreamState& Stream() { return stream_; }
+    const StreamState& Stream() const { return stream_; }
+    
 private:
     H265Payloader payloader_;
     uint16_t mtu_;
-    std::shared_ptr<Sequencer> sequencer_;
-    uint32_t timestamp_ = 0;
-    uint32_t ssrc_ = 0;
-    uint8_t payload_type_ = 0;
+    StreamState stream_;
 };
 
 } // namespace rtp
@@ -1,65 +1,64 @@
 #include "opus_packetizer.h"
+#include <algorithm>
 
 namespace rtp {
 
 OPUSPacketizer::OPUSPacketizer(size_t mtu) 
-    : mtu_(mtu), sequencer_(std::make_shared<RandomSequencer>()) {
-    // Initialize default header
-    header_.version = 2;
-    header_.padding = false;
-    header_.extension = false;
-    header_.marker = false;
-    header_.payload_type = 0;  // Default, should be set by user
-    header_.sequence_number = 0;
-    header_.timestamp = 0;
-    header_.ssrc = 0;
+    : mtu_(mtu) {
+    // The default header has payload type 0, which should be set by the user
 }
 
 void OPUSPacketizer::SetRTPHeader(const Header& header) {
-    header_ = header;
+    stream_.SetHeader(header);
 }
 
 void OPUSPacketizer::SetSequencer(std::shared_ptr<Sequencer> sequencer) {
-    sequencer_ = sequencer;
+    stream_.SetSequencer(sequencer);
 }
 
 bool OPUSPacketizer::Packetize(const std::vector<uint8_t>& opus_frame,
                              std::vector<std::vector<uint8_t>>* rtp_packets) {
-    if (opus_frame.empty() || !rtp_packets) {
+    if (!rtp_packets) {
         return false;
     }
     
-    rtp_packets->clear();
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    if (!Packetize(opus_frame.data(), opus_frame.size(), &arena)) {
+        rtp_packets->clear();
+        return false;
+    }
+    
+    arena.CopyTo(rtp_packets);
+    return true;
+}
+
+bool OPUSPacketizer::Packetize(const uint8_t* opus_frame, size_t size, PacketWriter* rtp_packets) {
+    if (!opus_frame || size == 0 || !rtp_packets) {
+        return false;
+    }
     
     // For Opus, we simply copy the entire frame as the payload
     // This implementation follows the Go example where we don't fragment Opus packets
-    std::vector<uint8_t> payload = opus_frame;
+    uint16_t sequence_number = static_cast<uint16_t>(stream_.ReserveSequenceNumbers(1));
     
-    // Check if the payload fits in our MTU
-    Header packet_header = header_;
-    packet_header.sequence_number = sequencer_->NextSequenceNumber();
-    
-    Packet rtp_packet;
-    rtp_packet.header = packet_header;
-    rtp_packet.payload = payload;
-    
-    // Set marker bit for the last (and only) packet
-    rtp_packet.header.marker = true;
-    
-    // Serialize the packet
-    std::vector<uint8_t> serialized_packet = rtp_packet.Packetize();
-    
-    // Check if it exceeds MTU
-    if (serialized_packet.size() > mtu_) {
+    // Check if it exceeds MTU, including what SRTP appends later
+    size_t header_size = stream_.HeaderSize();
+    size_t packet_size = header_size + size;
+    if (packet_size + stream_.SrtpOverhead() > mtu_) {
         // In a real implementation, you might want to fragment the Opus frame
         // However, the Go example doesn't fragment, so we'll just report failure
         return false;
     }
     
-    // Add the packet to the output
-    rtp_packets->push_back(std::move(serialized_packet));
-    
-    return true;
+    // Serialize the packet straight into the arena
+    // Set marker bit for the last (and only) packet
+    uint8_t* out = rtp_packets->Begin(packet_size);
+    stream_.BeginFrame();
+    stream_.WriteHeader(out, sequence_number, true);
+    std::copy(opus_frame, opus_frame + size, out + header_size);
+    return rtp_packets->Commit(packet_size);
 }
 
 } // namespace rtp
\ No newline at end of file
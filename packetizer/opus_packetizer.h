@@ -3,6 +3,7 @@
 
 #include "opus_packet.h"
 #include "rtp_packet.h"
+#include "rtp_stream.h"
 #include <cstdint>
 #include <vector>
 #include <memory>
@@ -19,19 +20,25 @@ public:
     bool Packetize(const std::vector<uint8_t>& opus_frame, 
                   std::vector<std::vector<uint8_t>>* rtp_packets);
 
+    // Packetize an Opus frame held in caller memory, appending the packet to the writer
+    bool Packetize(const uint8_t* opus_frame, size_t size, PacketWriter* rtp_packets);
+
     // Configure the RTP header for the packetizer
     void SetRTPHeader(const Header& header);
     
     // Get the current RTP header
-    const Header& GetRTPHeader() const { return header_; }
+    const Header& GetRTPHeader() const { return stream_.header(); }
     
     // Set the sequencer used for generating sequence numbers
     void SetSequencer(std::shared_ptr<Sequencer> sequencer);
+    
+    // RTP header state (SSRC, payload type, timestamp, CSRCs, sequencer)
+    StreamState& Stream() { return stream_; }
+    const StreamState& Stream() const { return stream_; }
 
 private:
-    Header header_;                           // RTP header template
     size_t mtu_;                              // Maximum transmission unit (packet size)
-    std::shared_ptr<Sequencer> sequencer_;    // Sequence number generator
+    StreamState stream_;                      // RTP header state
 };
 
 } // namespace rtp
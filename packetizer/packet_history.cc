@@ -0,0 +1,209 @@
+#include "packet_history.h"
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    constexpr size_t kMaxCapacity = 1 << 15;
+
+    // RFC 4588 original sequence number field
+    constexpr size_t kRtxHeaderSize = 2;
+
+    constexpr size_t kTransportSequenceNumberSize = 2;
+
+    size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+PacketHistory::PacketHistory(size_t capacity, size_t max_bytes, int64_t max_age_ms)
+    : slots_(RoundUpToPowerOfTwo(capacity == 0 ? 1 : (capacity > kMaxCapacity ? kMaxCapacity : capacity))),
+      mask_(slots_.size() - 1),
+      data_(max_bytes),
+      max_age_ms_(max_age_ms),
+      rtx_sequencer_(std::make_shared<RandomSequencer>()) {
+}
+
+bool PacketHistory::PutPacket(const uint8_t* packet, size_t size, int64_t now_ms) {
+    PacketView view;
+    if (size > data_.size() || !view.Parse(packet, size)) {
+        return false;
+    }
+    
+    if (count_ == 0) {
+        // An empty history may switch streams
+        if (view.ssrc() != ssrc_) {
+            unwrapper_.Reset();
+        }
+        ssrc_ = view.ssrc();
+    } else if (view.ssrc() != ssrc_) {
+        return false;
+    }
+    
+    int64_t sequence_number = unwrapper_.Unwrap(view.sequence_number());
+    if (count_ > 0 && sequence_number <= newest_) {
+        return false;
+    }
+    
+    // Age and slot capacity limits
+    while (count_ > 0 && (now_ms - SlotFor(oldest_).sent_ms > max_age_ms_ ||
+                          sequence_number - oldest_ >= static_cast<int64_t>(slots_.size()))) {
+        EvictOldest();
+    }
+    
+    // Byte budget: packets are written in order around the byte ring. When
+    // the packet does not fit before the end, the rest of the previous lap
+    // is evicted and writing restarts at the front.
+    if (write_offset_ + size > data_.size()) {
+        while (count_ > 0 && SlotFor(oldest_).offset >= write_offset_) {
+            EvictOldest();
+        }
+        write_offset_ = 0;
+    }
+    while (count_ > 0 && SlotFor(oldest_).offset < write_offset_ + size &&
+           SlotFor(oldest_).offset + SlotFor(oldest_).size > write_offset_) {
+        EvictOldest();
+    }
+    
+    std::memcpy(data_.data() + write_offset_, packet, size);
+    
+    Slot& slot = SlotFor(sequence_number);
+    slot.sequence_number = sequence_number;
+    slot.sent_ms = now_ms;
+    slot.offset = write_offset_;
+    slot.size = size;
+    slot.used = true;
+    
+    if (count_ == 0) {
+        oldest_ = sequence_number;
+    }
+    newest_ = sequence_number;
+    count_++;
+    stored_bytes_ += size;
+    write_offset_ += size;
+    return true;
+}
+
+bool PacketHistory::GetPacket(uint16_t sequence_number, const uint8_t** packet, size_t* size) const {
+    const Slot* slot = FindSlot(sequence_number);
+    if (!slot || !packet || !size) {
+        return false;
+    }
+    
+    *packet = data_.data() + slot->offset;
+    *size = slot->size;
+    return true;
+}
+
+void PacketHistory::SetRtx(uint32_t rtx_ssrc, uint8_t rtx_payload_type,
+                           std::shared_ptr<Sequencer> rtx_sequencer) {
+    rtx_ssrc_ = rtx_ssrc;
+    rtx_payload_type_ = rtx_payload_type & kPayloadTypeMask;
+    if (rtx_sequencer) {
+        rtx_sequencer_ = std::move(rtx_sequencer);
+    }
+}
+
+void PacketHistory::SetTransportSequenceNumber(size_t offset, std::shared_ptr<Sequencer> sequencer) {
+    transport_sequencer_ = std::move(sequencer);
+    transport_sequence_number_offset_ = offset;
+}
+
+size_t PacketHistory::RtxPacketSize(uint16_t sequence_number) const {
+    const Slot* slot = FindSlot(sequence_number);
+    PacketView view;
+    if (!slot || !view.Parse(data_.data() + slot->offset, slot->size)) {
+        return 0;
+    }
+    return view.header_size() + kRtxHeaderSize + view.payload_size();
+}
+
+size_t PacketHistory::WriteRtxPacket(uint16_t sequence_number, uint8_t* buf, size_t buf_size) {
+    const Slot* slot = FindSlot(sequence_number);
+    PacketView view;
+    if (!slot || !buf || !view.Parse(data_.data() + slot->offset, slot->size)) {
+        return 0;
+    }
+    
+    size_t header_size = view.header_size();
+    size_t rtx_size = header_size + kRtxHeaderSize + view.payload_size();
+    if (buf_size < rtx_size) {
+        return 0;
+    }
+    
+    // Original header, CSRCs and extensions with the RTX stream fields
+    // patched in; padding is not retransmitted
+    std::memcpy(buf, view.data(), header_size);
+    buf[0] &= ~(kPaddingMask << kPaddingShift);
+    buf[1] = (buf[1] & (kMarkerMask << kMarkerShift)) | rtx_payload_type_;
+    
+    uint16_t rtx_sequence_number = rtx_sequencer_->NextSequenceNumber();
+    buf[kSeqNumOffset] = static_cast<uint8_t>(rtx_sequence_number >> 8);
+    buf[kSeqNumOffset + 1] = static_cast<uint8_t>(rtx_sequence_number);
+    
+    buf[kSsrcOffset] = static_cast<uint8_t>(rtx_ssrc_ >> 24);
+    buf[kSsrcOffset + 1] = static_cast<uint8_t>(rtx_ssrc_ >> 16);
+    buf[kSsrcOffset + 2] = static_cast<uint8_t>(rtx_ssrc_ >> 8);
+    buf[kSsrcOffset + 3] = static_cast<uint8_t>(rtx_ssrc_);
+    
+    // The retransmission is a new packet on the transport
+    size_t transport_offset = transport_sequence_number_offset_;
+    if (transport_sequencer_ && transport_offset >= static_cast<size_t>(kCsrcOffset) &&
+        transport_offset + kTransportSequenceNumberSize <= header_size) {
+        uint16_t transport_sequence_number = transport_sequencer_->NextSequenceNumber();
+        buf[transport_offset] = static_cast<uint8_t>(transport_sequence_number >> 8);
+        buf[transport_offset + 1] = static_cast<uint8_t>(transport_sequence_number);
+    }
+    
+    // Original sequence number, then the original payload
+    buf[header_size] = static_cast<uint8_t>(sequence_number >> 8);
+    buf[header_size + 1] = static_cast<uint8_t>(sequence_number);
+    std::memcpy(buf + header_size + kRtxHeaderSize, view.payload(), view.payload_size());
+    
+    return rtx_size;
+}
+
+void PacketHistory::Clear() {
+    for (Slot& slot : slots_) {
+        slot.used = false;
+    }
+    
+    count_ = 0;
+    write_offset_ = 0;
+    stored_bytes_ = 0;
+}
+
+const PacketHistory::Slot* PacketHistory::FindSlot(uint16_t sequence_number) const {
+    if (count_ == 0) {
+        return nullptr;
+    }
+    
+    const Slot& slot = slots_[sequence_number & mask_];
+    if (!slot.used || static_cast<uint16_t>(slot.sequence_number) != sequence_number) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+void PacketHistory::EvictOldest() {
+    Slot& slot = SlotFor(oldest_);
+    slot.used = false;
+    stored_bytes_ -= slot.size;
+    count_--;
+    
+    // Skip sequence numbers that were never stored
+    while (count_ > 0) {
+        oldest_++;
+        const Slot& next = SlotFor(oldest_);
+        if (next.used && next.sequence_number == oldest_) {
+            break;
+        }
+    }
+}
+
+} // namespace rtp
\ No newline at end of file
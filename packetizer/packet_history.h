@@ -0,0 +1,108 @@
+#ifndef PACKET_HISTORY_H_
+#define PACKET_HISTORY_H_
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "rtp_packet.h"
+#include "sequence_unwrapper.h"
+
+namespace rtp {
+
+// PacketHistory keeps the serialized packets recently sent on one SSRC so
+// NACKed packets can be retransmitted without packetizing the frame again.
+// Packet bytes are stored back to back in a fixed byte ring and located
+// through a power-of-two slot table indexed by sequence number, so both
+// PutPacket() and GetPacket() are O(1) and nothing is allocated after
+// construction. The oldest packets are evicted when the byte budget, the slot
+// capacity or the maximum age is exceeded.
+class PacketHistory {
+public:
+    // capacity is rounded up to a power of two and limited to 32768 packets
+    explicit PacketHistory(size_t capacity = 1024, size_t max_bytes = 1 << 20,
+                           int64_t max_age_ms = 1000);
+    ~PacketHistory() = default;
+
+    // Stores a copy of a packet sent at now_ms. Sequence numbers must
+    // increase and every packet must carry the SSRC of the first one.
+    bool PutPacket(const uint8_t* packet, size_t size, int64_t now_ms);
+    bool PutPacket(const std::vector<uint8_t>& packet, int64_t now_ms) {
+        return PutPacket(packet.data(), packet.size(), now_ms);
+    }
+
+    // Looks up a stored packet by sequence number; the data stays valid
+    // until the next PutPacket()
+    bool GetPacket(uint16_t sequence_number, const uint8_t** packet, size_t* size) const;
+
+    // Configures the RFC 4588 retransmission stream. A null sequencer keeps
+    // the current one, which starts at a random sequence number.
+    void SetRtx(uint32_t rtx_ssrc, uint8_t rtx_payload_type,
+                std::shared_ptr<Sequencer> rtx_sequencer = nullptr);
+
+    // Restamps the transport-wide sequence number (transport-cc) of every RTX
+    // packet with the next number of sequencer, the one shared with the
+    // transport's streams, so feedback tells the retransmission apart from
+    // the original. offset is the location of the extension value in the
+    // stored headers, from StreamState::GetExtensionOffset(). A null
+    // sequencer keeps the original value.
+    void SetTransportSequenceNumber(size_t offset, std::shared_ptr<Sequencer> sequencer);
+
+    // Writes the RTX packet retransmitting sequence_number into buf: the
+    // original header with the RTX SSRC, payload type and the next RTX
+    // sequence number, followed by the original sequence number and payload.
+    // Returns the packet size, or 0 if the packet is unknown or buf is too
+    // small.
+    size_t WriteRtxPacket(uint16_t sequence_number, uint8_t* buf, size_t buf_size);
+
+    // Size of the RTX packet for sequence_number, 0 if the packet is unknown
+    size_t RtxPacketSize(uint16_t sequence_number) const;
+
+    // Drops every stored packet
+    void Clear();
+
+    // Accessors
+    size_t Capacity() const { return slots_.size(); }
+    size_t Size() const { return count_; }
+    size_t StoredBytes() const { return stored_bytes_; }
+
+private:
+    struct Slot {
+        int64_t sequence_number = 0;
+        int64_t sent_ms = 0;
+        size_t offset = 0;
+        size_t size = 0;
+        bool used = false;
+    };
+
+    Slot& SlotFor(int64_t sequence_number) {
+        return slots_[static_cast<uint64_t>(sequence_number) & mask_];
+    }
+    const Slot* FindSlot(uint16_t sequence_number) const;
+
+    // Evicts the oldest stored packet
+    void EvictOldest();
+
+    std::vector<Slot> slots_;
+    uint64_t mask_;
+    std::vector<uint8_t> data_;
+    int64_t max_age_ms_;
+
+    SequenceNumberUnwrapper unwrapper_;
+    uint32_t ssrc_ = 0;
+    int64_t oldest_ = 0;       // Lowest sequence number that may be stored
+    int64_t newest_ = 0;       // Highest sequence number stored
+    size_t count_ = 0;
+    size_t write_offset_ = 0;
+    size_t stored_bytes_ = 0;
+
+    uint32_t rtx_ssrc_ = 0;
+    uint8_t rtx_payload_type_ = 0;
+    std::shared_ptr<Sequencer> rtx_sequencer_;
+
+    std::shared_ptr<Sequencer> transport_sequencer_;
+    size_t transport_sequence_number_offset_ = 0;
+};
+
+} // namespace rtp
+
+#endif // PACKET_HISTORY_H_
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "send_time_history.h"
+#include "rtp_packet.h"
+#include <algorithm>
+
+namespace rtp {
+
+namespace {
+    constexpr size_t kMaxCapacity = 1 << 15;
+}
+
+SendTimeHistory::SendTimeHistory(uint8_t extension_id, size_t capacity)
+    : extension_id_(extension_id) {
+    size_t size = 1;
+    while (size < std::min(std::max(capacity, size_t(1)), kMaxCapacity)) {
+        size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+bool SendTimeHistory::OnPacketSent(const uint8_t* rtp_packet, size_t size, int64_t send_time_us) {
+    PacketView packet;
+    if (!packet.Parse(rtp_packet, size)) {
+        return false;
+    }
+    
+    const uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+    if (!packet.GetExtension(extension_id_, &payload, &payload_size) || payload_size != 2) {
+        return false;
+    }
+    
+    OnPacketSent(static_cast<uint16_t>((payload[0] << 8) | payload[1]), size, send_time_us);
+    return true;
+}
+
+void SendTimeHistory::OnPacketSent(uint16_t transport_sequence_number, size_t size, int64_t send_time_us) {
+    Slot& slot = slots_[transport_sequence_number & mask_];
+    slot.valid = true;
+    slot.sequence_number = transport_sequence_number;
+    slot.size = size;
+    slot.send_time_us = send_time_us;
+}
+
+size_t SendTimeHistory::OnTransportFeedback(const FeedbackMessage& feedback, PacketFeedback* results,
+                                            size_t max_results) {
+    TransportFeedbackReader reader;
+    if (!results || !reader.Parse(feedback)) {
+        return 0;
+    }
+    
+    size_t count = 0;
+    PacketArrival arrival;
+    while (count < max_results && reader.Next(&arrival)) {
+        // Packets overwritten by newer ones are no longer known
+        const Slot& slot = slots_[arrival.sequence_number & mask_];
+        if (!slot.valid || slot.sequence_number != arrival.sequence_number) {
+            continue;
+        }
+        
+        PacketFeedback& result = results[count++];
+        result.sequence_number = arrival.sequence_number;
+        result.size = slot.size;
+        result.send_time_us = slot.send_time_us;
+        result.received = arrival.received;
+        result.arrival_time_us = arrival.arrival_time_us;
+    }
+    
+    return reader.error() ? 0 : count;
+}
+
+void SendTimeHistory::Clear() {
+    std::fill(slots_.begin(), slots_.end(), Slot());
+}
+
+} // namespace rtp
\ No newline at end of file
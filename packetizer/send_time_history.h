@@ -0,0 +1,63 @@
+#ifndef SEND_TIME_HISTORY_H_
+#define SEND_TIME_HISTORY_H_
+
+#include <cstdint>
+#include <vector>
+#include "rtcp_packet.h"
+#include "transport_feedback.h"
+
+namespace rtp {
+
+// Send and receive times of one packet reported by transport-wide feedback
+struct PacketFeedback {
+    uint16_t sequence_number = 0;
+    size_t size = 0;
+    int64_t send_time_us = 0;        // Sender clock
+    bool received = false;
+    int64_t arrival_time_us = 0;     // Receiver clock, only set if received
+};
+
+// SendTimeHistory remembers the send time and size of recently sent packets
+// by transport-wide sequence number, so transport-cc feedback can be turned
+// into (send time, arrival time) pairs for bandwidth estimation. The history
+// is a fixed power-of-two table indexed by sequence number.
+class SendTimeHistory {
+public:
+    // extension_id is the one-byte header extension id of transport-cc;
+    // capacity is rounded up to a power of two, at most 32768
+    explicit SendTimeHistory(uint8_t extension_id = 0, size_t capacity = 8192);
+    ~SendTimeHistory() = default;
+
+    void SetExtensionId(uint8_t extension_id) { extension_id_ = extension_id; }
+
+    // Records a sent RTP packet; returns false if it cannot be parsed or
+    // carries no transport-wide sequence number
+    bool OnPacketSent(const uint8_t* rtp_packet, size_t size, int64_t send_time_us);
+
+    // Records a sent transport-wide sequence number
+    void OnPacketSent(uint16_t transport_sequence_number, size_t size, int64_t send_time_us);
+
+    // Decodes an RTPFB FMT=15 message and writes one entry per reported
+    // packet that is still in the history, up to max_results. Returns the
+    // number of entries written; 0 with a malformed message.
+    size_t OnTransportFeedback(const FeedbackMessage& feedback, PacketFeedback* results, size_t max_results);
+
+    // Forgets every sent packet
+    void Clear();
+
+private:
+    struct Slot {
+        bool valid = false;
+        uint16_t sequence_number = 0;
+        size_t size = 0;
+        int64_t send_time_us = 0;
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    uint8_t extension_id_;
+};
+
+} // namespace rtp
+
+#endif // SEND_TIME_HISTORY_H_
\ No newline at end of file
@@ -1,18 +1,36 @@
 #include "vp8_packetizer.h"
+#include <algorithm>
 
 namespace rtp {
 
 VP8Packetizer::VP8Packetizer(uint16_t mtu) 
-    : mtu_(mtu), sequencer_(std::make_unique<RandomSequencer>()) {
+    : mtu_(mtu) {
+    // Default RTP payload type for VP8
+    stream_.SetPayloadType(96);
 }
 
 bool VP8Packetizer::Packetize(const std::vector<uint8_t>& vp8_frame,
                             std::vector<std::vector<uint8_t>>* rtp_packets) {
-    if (vp8_frame.empty() || rtp_packets == nullptr) {
+    if (rtp_packets == nullptr) {
         return false;
     }
     
-    rtp_packets->clear();
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    if (!Packetize(vp8_frame.data(), vp8_frame.size(), &arena)) {
+        rtp_packets->clear();
+        return false;
+    }
+    
+    arena.CopyTo(rtp_packets);
+    return true;
+}
+
+bool VP8Packetizer::Packetize(const uint8_t* vp8_frame, size_t size, PacketWriter* rtp_packets) {
+    if (vp8_frame == nullptr || size == 0 || rtp_packets == nullptr) {
+        return false;
+    }
     
     // Determine header size based on options
     uint8_t using_header_size = kVP8HeaderSize;
@@ -27,37 +45,39 @@ bool VP8Packetizer::Packetize(const std::vector<uint8_t>& vp8_frame,
     }
     
     // Calculate maximum fragment size
-    int max_fragment_size = static_cast<int>(mtu_) - using_header_size;
+    int max_fragment_size = static_cast<int>(stream_.PayloadBudget(mtu_)) - using_header_size;
     
     // Check if the payload size is valid
-    int payload_data_remaining = vp8_frame.size();
+    int payload_data_remaining = size;
     if (minValue(max_fragment_size, payload_data_remaining) <= 0) {
         return false;
     }
     
+    size_t rtp_header_size = stream_.HeaderSize();
+    
+    // Claim the sequence numbers for the whole frame at once
+    size_t packet_count = (payload_data_remaining + max_fragment_size - 1) / max_fragment_size;
+    uint64_t sequence_number = stream_.ReserveSequenceNumbers(packet_count);
+    
     // Fragment the VP8 frame into multiple packets
+    stream_.BeginFrame();
     bool first = true;
     size_t payload_data_index = 0;
     
     while (payload_data_remaining > 0) {
         int current_fragment_size = minValue(max_fragment_size, payload_data_remaining);
         
-        // Create a new RTP packet
-        Packet packet;
-        
-        // Set up the RTP header
-        packet.header.ssrc = ssrc_;
-        packet.header.payload_type = payload_type_;
-        packet.header.sequence_number = sequencer_->NextSequenceNumber();
-        packet.header.timestamp = timestamp_;
-        
         // Set marker bit on the last packet
-        if (payload_data_remaining <= max_fragment_size) {
-            packet.header.marker = true;
-        }
+        bool marker = (payload_data_remaining <= max_fragment_size);
+        
+        // Write the RTP header straight into the arena
+        size_t packet_size = rtp_header_size + using_header_size + current_fragment_size;
+        uint8_t* out = rtp_packets->Begin(packet_size);
+        stream_.WriteHeader(out, static_cast<uint16_t>(sequence_number++), marker);
         
         // Prepare the VP8 payload header
-        std::vector<uint8_t> payload(using_header_size + current_fragment_size);
+        uint8_t* payload = out + rtp_header_size;
+        std::fill(payload, payload + using_header_size, 0);
         
         // Set up VP8 payload header
         if (first) {
@@ -87,16 +107,13 @@ bool VP8Packetizer::Packetize(const std::vector<uint8_t>& vp8_frame,
         }
         
         // Copy VP8 frame data into the payload
-        std::copy(vp8_frame.begin() + payload_data_index, 
-                 vp8_frame.begin() + payload_data_index + current_fragment_size,
-                 payload.begin() + using_header_size);
+        std::copy(vp8_frame + payload_data_index, 
+                 vp8_frame + payload_data_index + current_fragment_size,
+                 payload + using_header_size);
         
-        // Set the payload in the RTP packet
-        packet.payload = std::move(payload);
-        
-        // Packetize the RTP packet
-        std::vector<uint8_t> rtp_packet = packet.Packetize();
-        rtp_packets->push_back(std::move(rtp_packet));
+        if (!rtp_packets->Commit(packet_size)) {
+            return false;
+        }
         
         // Update counters
         payload_data_remaining -= current_fragment_size;
@@ -6,6 +6,7 @@
 #include <memory>
 #include "rtp_packet.h"
 #include "vp8_packet.h"
+#include "rtp_stream.h"
 
 namespace rtp {
 
@@ -18,21 +19,29 @@ public:
     // Packetize a VP8 frame into multiple RTP packets
     bool Packetize(const std::vector<uint8_t>& vp8_frame, 
                    std::vector<std::vector<uint8_t>>* rtp_packets);
+
+    // Packetize a VP8 frame held in caller memory, appending each packet to
+    // the writer as soon as it is built
+    bool Packetize(const uint8_t* vp8_frame, size_t size, PacketWriter* rtp_packets);
     
     // Enable/disable picture ID
     void EnablePictureID(bool enable) { enable_picture_id_ = enable; }
     
     // Set the SSRC for all generated packets
-    void SetSSRC(uint32_t ssrc) { ssrc_ = ssrc; }
+    void SetSSRC(uint32_t ssrc) { stream_.SetSSRC(ssrc); }
     
     // Set the payload type for all generated packets
-    void SetPayloadType(uint8_t payload_type) { payload_type_ = payload_type; }
+    void SetPayloadType(uint8_t payload_type) { stream_.SetPayloadType(payload_type); }
     
     // Set the timestamp for the next frame
-    void SetTimestamp(uint32_t timestamp) { timestamp_ = timestamp; }
+    void SetTimestamp(uint32_t timestamp) { stream_.SetTimestamp(timestamp); }
     
     // Reset the picture ID counter
     void ResetPictureID() { picture_id_ = 0; }
+    
+    // RTP header state (SSRC, payload type, timestamp, CSRCs, sequencer)
+    StreamState& Stream() { return stream_; }
+    const StreamState& Stream() const { return stream_; }
 
 private:
     // Helper functions
@@ -42,10 +51,7 @@ private:
     uint16_t mtu_;                   // Maximum transfer unit
     bool enable_picture_id_ = false; // Enable picture ID
     uint16_t picture_id_ = 0;        // Current picture ID (0-0x7FFF)
-    uint32_t ssrc_ = 0;              // Synchronization source
-    uint8_t payload_type_ = 96;      // Default RTP payload type for VP8
-    uint32_t timestamp_ = 0;         // Current timestamp
-    std::unique_ptr<Sequencer> sequencer_; // Sequence number generator
+    StreamState stream_;             // RTP header state
 };
 
 } // namespace rtp
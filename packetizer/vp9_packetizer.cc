@@ -1,4 +1,5 @@
 #include "vp9_packetizer.h"
+#include <algorithm>
 #include <chrono>
 
 namespace rtp {
@@ -19,7 +20,24 @@ uint16_t VP9Packetizer::generateRandomPictureID() {
 }
 
 bool VP9Packetizer::Packetize(const std::vector<uint8_t>& vp9Frame, std::vector<std::vector<uint8_t>>* rtpPackets) {
-    if (vp9Frame.empty() || !rtpPackets) {
+    if (!rtpPackets) {
+        return false;
+    }
+    
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    PacketArena arena(&data, &offsets);
+    if (!Packetize(vp9Frame.data(), vp9Frame.size(), &arena)) {
+        rtpPackets->clear();
+        return false;
+    }
+    
+    arena.CopyTo(rtpPackets);
+    return true;
+}
+
+bool VP9Packetizer::Packetize(const uint8_t* vp9Frame, size_t size, PacketWriter* rtpPackets) {
+    if (!vp9Frame || size == 0 || !rtpPackets) {
         return false;
     }
     
@@ -30,11 +48,12 @@ bool VP9Packetizer::Packetize(const std::vector<uint8_t>& vp9Frame, std::vector<
     }
     
     // Generate payloads
-    std::vector<std::vector<uint8_t>> payloads;
+    stream_.BeginFrame();
+    bool ok;
     if (flexibleMode_) {
-        payloads = payloadFlexible(vp9Frame);
+        ok = payloadFlexible(vp9Frame, size, rtpPackets);
     } else {
-        payloads = payloadNonFlexible(vp9Frame);
+        ok = payloadNonFlexible(vp9Frame, size, rtpPackets);
     }
     
     // Increment picture ID for next frame
@@ -43,12 +62,10 @@ bool VP9Packetizer::Packetize(const std::vector<uint8_t>& vp9Frame, std::vector<
         pictureID_ = 0;
     }
     
-    // Return generated packets
-    rtpPackets->swap(payloads);
-    return !rtpPackets->empty();
+    return ok;
 }
 
-std::vector<std::vector<uint8_t>> VP9Packetizer::payloadFlexible(const std::vector<uint8_t>& payload) {
+bool VP9Packetizer::payloadFlexible(const uint8_t* payload, size_t size, PacketWriter* packets) {
     /*
      * Flexible mode (F=1)
      *        0 1 2 3 4 5 6 7
@@ -62,18 +79,26 @@ std::vector<std::vector<uint8_t>> VP9Packetizer::payloadFlexible(const std::vect
      */
     
     const int headerSize = 3; // 1 byte VP9 descriptor + 2 bytes for picture ID
-    const int maxFragmentSize = mtu_ - headerSize;
-    int payloadDataRemaining = payload.size();
+    const int maxFragmentSize = static_cast<int>(stream_.PayloadBudget(mtu_)) - headerSize;
+    int payloadDataRemaining = size;
     int payloadDataIndex = 0;
-    std::vector<std::vector<uint8_t>> payloads;
     
     if (minInt(maxFragmentSize, payloadDataRemaining) <= 0) {
-        return payloads; // Return empty vector
+        return false; // No packets
     }
     
+    // Claim the sequence numbers for the whole frame at once
+    const size_t rtpHeaderSize = stream_.HeaderSize();
+    uint64_t sequenceNumber = stream_.ReserveSequenceNumbers((size + maxFragmentSize - 1) / maxFragmentSize);
+    
     while (payloadDataRemaining > 0) {
         int currentFragmentSize = minInt(maxFragmentSize, payloadDataRemaining);
-        std::vector<uint8_t> out(headerSize + currentFragmentSize);
+        uint8_t* packet = packets->Begin(rtpHeaderSize + headerSize + currentFragmentSize);
+        
+        // Write the RTP header, marking the last packet of the frame
+        bool marker = payloadDataRemaining == currentFragmentSize;
+        stream_.WriteHeader(packet, static_cast<uint16_t>(sequenceNumber++), marker);
+        uint8_t* out = packet + rtpHeaderSize;
         
         // Set VP9 descriptor
         out[0] = 0x90; // F=1, I=1
@@ -90,20 +115,22 @@ std::vector<std::vector<uint8_t>> VP9Packetizer::payloadFlexible(const std::vect
         
         // Copy payload fragment
         std::copy(
-            payload.begin() + payloadDataIndex, 
-            payload.begin() + payloadDataIndex + currentFragmentSize, 
-            out.begin() + headerSize
+            payload + payloadDataIndex, 
+            payload + payloadDataIndex + currentFragmentSize, 
+            out + headerSize
         );
         
-        payloads.push_back(out);
+        if (!packets->Commit(rtpHeaderSize + headerSize + currentFragmentSize)) {
+            return false;
+        }
         payloadDataRemaining -= currentFragmentSize;
         payloadDataIndex += currentFragmentSize;
     }
     
-    return payloads;
+    return true;
 }
 
-std::vector<std::vector<uint8_t>> VP9Packetizer::payloadNonFlexible(const std::vector<uint8_t>& payload) {
+bool VP9Packetizer::payloadNonFlexible(const uint8_t* payload, size_t size, PacketWriter* packets) {
     /*
      * Non-flexible mode (F=0)
      *        0 1 2 3 4 5 6 7
@@ -122,7 +149,7 @@ std::vector<std::vector<uint8_t>> VP9Packetizer::payloadNonFlexible(const std::v
     
     // Try to extract VP9 frame header information
     bool isKeyFrame = false;
-    if (payload.size() >= 1 && vp9Header_->Unmarshal(payload)) {
+    if (size >= 1 && vp9Header_->Unmarshal(payload, size)) {
         isKeyFrame = !vp9Header_->NonKeyFrame;
     }
     
@@ -131,15 +158,18 @@ std::vector<std::vector<uint8_t>> VP9Packetizer::payloadNonFlexible(const std::v
     headerSize += 2;    // Picture ID (16-bit)
     headerSize += 2;    // Layer indices and TL0PICIDX
     
-    const int maxFragmentSize = mtu_ - headerSize;
-    int payloadDataRemaining = payload.size();
+    const int maxFragmentSize = static_cast<int>(stream_.PayloadBudget(mtu_)) - headerSize;
+    int payloadDataRemaining = size;
     int payloadDataIndex = 0;
-    std::vector<std::vector<uint8_t>> payloads;
     
     if (minInt(maxFragmentSize, payloadDataRemaining) <= 0) {
-        return payloads; // Return empty vector
+        return false; // No packets
     }
     
+    // Claim the sequence numbers for the whole frame at once
+    const size_t rtpHeaderSize = stream_.HeaderSize();
+    uint64_t sequenceNumber = stream_.ReserveSequenceNumbers((size + maxFragmentSize - 1) / maxFragmentSize);
+    
     // Static temporal layer with no spatial scalability
     const uint8_t temporalID = 0;
     const uint8_t spatialID = 0;
@@ -147,7 +177,12 @@ std::vector<std::vector<uint8_t>> VP9Packetizer::payloadNonFlexible(const std::v
     
     while (payloadDataRemaining > 0) {
         int currentFragmentSize = minInt(maxFragmentSize, payloadDataRemaining);
-        std::vector<uint8_t> out(headerSize + currentFragmentSize);
+        uint8_t* packet = packets->Begin(rtpHeaderSize + headerSize + currentFragmentSize);
+        
+        // Write the RTP header, marking the last packet of the frame
+        bool marker = payloadDataRemaining == currentFragmentSize;
+        stream_.WriteHeader(packet, static_cast<uint16_t>(sequenceNumber++), marker);
+        uint8_t* out = packet + rtpHeaderSize;
         
         // Set VP9 descriptor
         uint8_t descriptor = 0x00;
@@ -188,17 +223,19 @@ std::vector<std::vector<uint8_t>> VP9Packetizer::payloadNonFlexible(const std::v
         
         // Copy payload fragment
         std::copy(
-            payload.begin() + payloadDataIndex, 
-            payload.begin() + payloadDataIndex + currentFragmentSize, 
-            out.begin() + headerSize
+            payload + payloadDataIndex, 
+            payload + payloadDataIndex + currentFragmentSize, 
+            out + headerSize
         );
         
-        payloads.push_back(out);
+        if (!packets->Commit(rtpHeaderSize + headerSize + currentFragmentSize)) {
+            return false;
+        }
         payloadDataRemaining -= currentFragmentSize;
         payloadDataIndex += currentFragmentSize;
     }
     
-    return payloads;
+    return true;
 }
 
 } // namespace rtp
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <random>
 #include "rtp_packet.h"
 #include "vp9_packet.h"
+#include "rtp_stream.h"
 
 namespace rtp {
 
@@ -18,16 +19,24 @@ public:
     
     // Payload fragments a VP9 frame across one or more RTP packets
     bool Packetize(const std::vector<uint8_t>& vp9Frame, std::vector<std::vector<uint8_t>>* rtpPackets);
+
+    // Packetize a VP9 frame held in caller memory, appending each packet to
+    // the writer as soon as it is built
+    bool Packetize(const uint8_t* vp9Frame, size_t size, PacketWriter* rtpPackets);
     
     // Configuration
     void SetFlexibleMode(bool flexible) { flexibleMode_ = flexible; }
     void SetInitialPictureID(uint16_t id) { pictureID_ = id & 0x7FFF; }
     
+    // RTP header state (SSRC, payload type, timestamp, CSRCs, sequencer)
+    StreamState& Stream() { return stream_; }
+    const StreamState& Stream() const { return stream_; }
+    
 private:
-    std::vector<std::vector<uint8_t>> payloadFlexible(const std::vector<uint8_t>& payload);
-    std::vector<std::vector<uint8_t>> payloadNonFlexible(const std::vector<uint8_t>& payload);
+    bool payloadFlexible(const uint8_t* payload, size_t size, PacketWriter* packets);
+    bool payloadNonFlexible(const uint8_t* payload, size_t size, PacketWriter* packets);
     
-    uint16_t minInt(uint16_t a, uint16_t b) { return (a < b) ? a : b; }
+    int minInt(int a, int b) { return (a < b) ? a : b; }
     uint16_t generateRandomPictureID();
     
     uint16_t mtu_;
@@ -36,6 +45,7 @@ private:
     bool initialized_ = false;
     
     std::unique_ptr<VP9Header> vp9Header_;
+    StreamState stream_;
     std::mt19937 randomGenerator_;
 };
 
@@ -0,0 +1,284 @@
+#include "aes.h"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RTP_AES_NI 1
+#include <immintrin.h>
+#endif
+
+namespace rtp {
+
+namespace {
+
+    inline uint32_t LoadBE32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    inline void StoreBE32(uint8_t* p, uint32_t v) {
+        p[0] = static_cast<uint8_t>(v >> 24);
+        p[1] = static_cast<uint8_t>(v >> 16);
+        p[2] = static_cast<uint8_t>(v >> 8);
+        p[3] = static_cast<uint8_t>(v);
+    }
+
+    inline uint32_t RotateRight(uint32_t v, int bits) {
+        return (v >> bits) | (v << (32 - bits));
+    }
+
+    inline uint8_t XTime(uint8_t x) {
+        return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00));
+    }
+
+    inline uint8_t RotateLeft8(uint8_t x, int bits) {
+        return static_cast<uint8_t>((x << bits) | (x >> (8 - bits)));
+    }
+
+    // S-box and the four round tables of the portable cipher, built once
+    struct AesTables {
+        uint8_t sbox[256];
+        uint32_t te[4][256];
+
+        AesTables() {
+            // Walk the multiplicative group with generator 3 and its inverse
+            // to get every inverse, then apply the affine transform
+            uint8_t p = 1;
+            uint8_t q = 1;
+            do {
+                p = static_cast<uint8_t>(p ^ XTime(p));
+                q ^= static_cast<uint8_t>(q << 1);
+                q ^= static_cast<uint8_t>(q << 2);
+                q ^= static_cast<uint8_t>(q << 4);
+                if (q & 0x80) {
+                    q ^= 0x09;
+                }
+                uint8_t x = q ^ RotateLeft8(q, 1) ^ RotateLeft8(q, 2) ^
+                            RotateLeft8(q, 3) ^ RotateLeft8(q, 4);
+                sbox[p] = x ^ 0x63;
+            } while (p != 1);
+            sbox[0] = 0x63;
+
+            for (int i = 0; i < 256; i++) {
+                uint8_t s = sbox[i];
+                uint8_t s2 = XTime(s);
+                uint8_t s3 = s2 ^ s;
+                uint32_t word = (uint32_t(s2) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | s3;
+                te[0][i] = word;
+                te[1][i] = RotateRight(word, 8);
+                te[2][i] = RotateRight(word, 16);
+                te[3][i] = RotateRight(word, 24);
+            }
+        }
+    };
+
+    const AesTables& Tables() {
+        static const AesTables tables;
+        return tables;
+    }
+
+    void EncryptBlockPortable(const uint8_t* round_keys, int rounds,
+                              const uint8_t* in, uint8_t* out) {
+        const AesTables& t = Tables();
+        const uint8_t* rk = round_keys;
+
+        uint32_t s0 = LoadBE32(in) ^ LoadBE32(rk);
+        uint32_t s1 = LoadBE32(in + 4) ^ LoadBE32(rk + 4);
+        uint32_t s2 = LoadBE32(in + 8) ^ LoadBE32(rk + 8);
+        uint32_t s3 = LoadBE32(in + 12) ^ LoadBE32(rk + 12);
+
+        for (int round = 1; round < rounds; round++) {
+            rk += kAesBlockSize;
+            uint32_t t0 = t.te[0][s0 >> 24] ^ t.te[1][(s1 >> 16) & 0xFF] ^
+                          t.te[2][(s2 >> 8) & 0xFF] ^ t.te[3][s3 & 0xFF] ^ LoadBE32(rk);
+            uint32_t t1 = t.te[0][s1 >> 24] ^ t.te[1][(s2 >> 16) & 0xFF] ^
+                          t.te[2][(s3 >> 8) & 0xFF] ^ t.te[3][s0 & 0xFF] ^ LoadBE32(rk + 4);
+            uint32_t t2 = t.te[0][s2 >> 24] ^ t.te[1][(s3 >> 16) & 0xFF] ^
+                          t.te[2][(s0 >> 8) & 0xFF] ^ t.te[3][s1 & 0xFF] ^ LoadBE32(rk + 8);
+            uint32_t t3 = t.te[0][s3 >> 24] ^ t.te[1][(s0 >> 16) & 0xFF] ^
+                          t.te[2][(s1 >> 8) & 0xFF] ^ t.te[3][s2 & 0xFF] ^ LoadBE32(rk + 12);
+            s0 = t0;
+            s1 = t1;
+            s2 = t2;
+            s3 = t3;
+        }
+
+        // Last round without MixColumns
+        rk += kAesBlockSize;
+        const uint8_t* sbox = t.sbox;
+        uint32_t t0 = (uint32_t(sbox[s0 >> 24]) << 24) | (uint32_t(sbox[(s1 >> 16) & 0xFF]) << 16) |
+                      (uint32_t(sbox[(s2 >> 8) & 0xFF]) << 8) | sbox[s3 & 0xFF];
+        uint32_t t1 = (uint32_t(sbox[s1 >> 24]) << 24) | (uint32_t(sbox[(s2 >> 16) & 0xFF]) << 16) |
+                      (uint32_t(sbox[(s3 >> 8) & 0xFF]) << 8) | sbox[s0 & 0xFF];
+        uint32_t t2 = (uint32_t(sbox[s2 >> 24]) << 24) | (uint32_t(sbox[(s3 >> 16) & 0xFF]) << 16) |
+                      (uint32_t(sbox[(s0 >> 8) & 0xFF]) << 8) | sbox[s1 & 0xFF];
+        uint32_t t3 = (uint32_t(sbox[s3 >> 24]) << 24) | (uint32_t(sbox[(s0 >> 16) & 0xFF]) << 16) |
+                      (uint32_t(sbox[(s1 >> 8) & 0xFF]) << 8) | sbox[s2 & 0xFF];
+        StoreBE32(out, t0 ^ LoadBE32(rk));
+        StoreBE32(out + 4, t1 ^ LoadBE32(rk + 4));
+        StoreBE32(out + 8, t2 ^ LoadBE32(rk + 8));
+        StoreBE32(out + 12, t3 ^ LoadBE32(rk + 12));
+    }
+
+    // Writes the counter block for block index i after counter
+    inline void CounterBlock(const uint8_t* counter, uint32_t i, uint8_t* out) {
+        std::memcpy(out, counter, 12);
+        StoreBE32(out + 12, LoadBE32(counter + 12) + i);
+    }
+
+    void CtrPortable(const uint8_t* round_keys, int rounds, const uint8_t* counter,
+                     uint8_t* data, size_t size) {
+        uint8_t block[kAesBlockSize];
+        uint8_t keystream[kAesBlockSize];
+        for (uint32_t i = 0; size > 0; i++) {
+            CounterBlock(counter, i, block);
+            EncryptBlockPortable(round_keys, rounds, block, keystream);
+            size_t n = size < kAesBlockSize ? size : kAesBlockSize;
+            for (size_t k = 0; k < n; k++) {
+                data[k] ^= keystream[k];
+            }
+            data += n;
+            size -= n;
+        }
+    }
+
+#if RTP_AES_NI
+    __attribute__((target("aes,sse2")))
+    inline __m128i EncryptAesni(const __m128i* rk, int rounds, __m128i block) {
+        block = _mm_xor_si128(block, _mm_loadu_si128(rk));
+        for (int round = 1; round < rounds; round++) {
+            block = _mm_aesenc_si128(block, _mm_loadu_si128(rk + round));
+        }
+        return _mm_aesenclast_si128(block, _mm_loadu_si128(rk + rounds));
+    }
+
+    __attribute__((target("aes,sse2")))
+    void EncryptBlockAesni(const uint8_t* round_keys, int rounds, const uint8_t* in, uint8_t* out) {
+        const __m128i* rk = reinterpret_cast<const __m128i*>(round_keys);
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), EncryptAesni(rk, rounds, block));
+    }
+
+    // Encrypts four counter blocks per step so the AES units stay busy
+    __attribute__((target("aes,sse2")))
+    void CtrAesni(const uint8_t* round_keys, int rounds, const uint8_t* counter,
+                  uint8_t* data, size_t size) {
+        const __m128i* rk = reinterpret_cast<const __m128i*>(round_keys);
+        alignas(16) uint8_t blocks[4][kAesBlockSize];
+        uint32_t i = 0;
+
+        while (size >= 4 * kAesBlockSize) {
+            __m128i b[4];
+            for (int k = 0; k < 4; k++) {
+                CounterBlock(counter, i + k, blocks[k]);
+                b[k] = _mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(blocks[k])),
+                                     _mm_loadu_si128(rk));
+            }
+            for (int round = 1; round < rounds; round++) {
+                __m128i key = _mm_loadu_si128(rk + round);
+                for (int k = 0; k < 4; k++) {
+                    b[k] = _mm_aesenc_si128(b[k], key);
+                }
+            }
+            __m128i last = _mm_loadu_si128(rk + rounds);
+            for (int k = 0; k < 4; k++) {
+                __m128i* p = reinterpret_cast<__m128i*>(data + k * kAesBlockSize);
+                b[k] = _mm_aesenclast_si128(b[k], last);
+                _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), b[k]));
+            }
+            data += 4 * kAesBlockSize;
+            size -= 4 * kAesBlockSize;
+            i += 4;
+        }
+
+        while (size > 0) {
+            CounterBlock(counter, i++, blocks[0]);
+            __m128i keystream = EncryptAesni(rk, rounds,
+                _mm_load_si128(reinterpret_cast<const __m128i*>(blocks[0])));
+            if (size >= kAesBlockSize) {
+                __m128i* p = reinterpret_cast<__m128i*>(data);
+                _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), keystream));
+                data += kAesBlockSize;
+                size -= kAesBlockSize;
+            } else {
+                _mm_store_si128(reinterpret_cast<__m128i*>(blocks[0]), keystream);
+                for (size_t k = 0; k < size; k++) {
+                    data[k] ^= blocks[0][k];
+                }
+                size = 0;
+            }
+        }
+    }
+#endif
+
+    bool DetectAesni() {
+#if RTP_AES_NI
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2");
+#else
+        return false;
+#endif
+    }
+}
+
+bool Aes::HasHardwareSupport() {
+    static const bool supported = DetectAesni();
+    return supported;
+}
+
+bool Aes::SetKey(const uint8_t* key, size_t key_size) {
+    if (!key || (key_size != 16 && key_size != 32)) {
+        return false;
+    }
+
+    const uint8_t* sbox = Tables().sbox;
+    int nk = static_cast<int>(key_size / 4);
+    rounds_ = nk + 6;
+    int words = 4 * (rounds_ + 1);
+
+    uint32_t w[60];
+    for (int i = 0; i < nk; i++) {
+        w[i] = LoadBE32(key + 4 * i);
+    }
+
+    uint8_t rcon = 0x01;
+    for (int i = nk; i < words; i++) {
+        uint32_t temp = w[i - 1];
+        if (i % nk == 0) {
+            temp = (temp << 8) | (temp >> 24);
+            temp = (uint32_t(sbox[temp >> 24]) << 24) | (uint32_t(sbox[(temp >> 16) & 0xFF]) << 16) |
+                   (uint32_t(sbox[(temp >> 8) & 0xFF]) << 8) | sbox[temp & 0xFF];
+            temp ^= uint32_t(rcon) << 24;
+            rcon = XTime(rcon);
+        } else if (nk > 6 && i % nk == 4) {
+            temp = (uint32_t(sbox[temp >> 24]) << 24) | (uint32_t(sbox[(temp >> 16) & 0xFF]) << 16) |
+                   (uint32_t(sbox[(temp >> 8) & 0xFF]) << 8) | sbox[temp & 0xFF];
+        }
+        w[i] = w[i - nk] ^ temp;
+    }
+
+    for (int i = 0; i < words; i++) {
+        StoreBE32(round_keys_ + 4 * i, w[i]);
+    }
+    return true;
+}
+
+void Aes::EncryptBlock(const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]) const {
+#if RTP_AES_NI
+    if (HasHardwareSupport()) {
+        EncryptBlockAesni(round_keys_, rounds_, in, out);
+        return;
+    }
+#endif
+    EncryptBlockPortable(round_keys_, rounds_, in, out);
+}
+
+void Aes::Ctr(const uint8_t counter[kAesBlockSize], uint8_t* data, size_t size) const {
+#if RTP_AES_NI
+    if (HasHardwareSupport()) {
+        CtrAesni(round_keys_, rounds_, counter, data, size);
+        return;
+    }
+#endif
+    CtrPortable(round_keys_, rounds_, counter, data, size);
+}
+
+} // namespace rtp
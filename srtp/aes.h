@@ -0,0 +1,39 @@
+#ifndef AES_H_
+#define AES_H_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace rtp {
+
+constexpr size_t kAesBlockSize = 16;
+
+// Aes encrypts with AES-128 or AES-256. Only the forward cipher is provided,
+// which is all counter mode and GCM need. Blocks are processed with AES-NI
+// when the CPU has it and with a table-based portable implementation
+// otherwise; both share one key schedule.
+class Aes {
+public:
+    Aes() = default;
+
+    // key_size is 16 or 32 bytes
+    bool SetKey(const uint8_t* key, size_t key_size);
+
+    void EncryptBlock(const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]) const;
+
+    // XORs data in place with the counter mode keystream starting at counter.
+    // The last 32 bits of the counter block are incremented big-endian per
+    // block, as in SRTP AES-CM and GCM.
+    void Ctr(const uint8_t counter[kAesBlockSize], uint8_t* data, size_t size) const;
+
+    // Whether blocks are encrypted with AES-NI
+    static bool HasHardwareSupport();
+
+private:
+    uint8_t round_keys_[15 * kAesBlockSize] = {};
+    int rounds_ = 0;
+};
+
+} // namespace rtp
+
+#endif // AES_H_
@@ -0,0 +1,255 @@
+#include "aes_gcm.h"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RTP_GCM_PCLMUL 1
+#include <immintrin.h>
+#endif
+
+namespace rtp {
+
+namespace {
+
+    inline uint64_t LoadBE64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+
+    inline void StoreBE64(uint8_t* p, uint64_t v) {
+        for (int i = 7; i >= 0; i--) {
+            p[i] = static_cast<uint8_t>(v);
+            v >>= 8;
+        }
+    }
+
+    // Reduction constants for shifting four bits out of the product
+    const uint64_t kLast4[16] = {
+        0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+        0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+    };
+
+    // x = x * H with the 4-bit tables
+    void MultiplyTable(const uint64_t* hl, const uint64_t* hh, uint8_t x[kAesBlockSize]) {
+        uint8_t lo = x[15] & 0x0F;
+        uint64_t zh = hh[lo];
+        uint64_t zl = hl[lo];
+
+        for (int i = 15; i >= 0; i--) {
+            lo = x[i] & 0x0F;
+            uint8_t hi = (x[i] >> 4) & 0x0F;
+
+            if (i != 15) {
+                uint8_t rem = static_cast<uint8_t>(zl & 0x0F);
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ (kLast4[rem] << 48);
+                zh ^= hh[lo];
+                zl ^= hl[lo];
+            }
+
+            uint8_t rem = static_cast<uint8_t>(zl & 0x0F);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (kLast4[rem] << 48);
+            zh ^= hh[hi];
+            zl ^= hl[hi];
+        }
+
+        StoreBE64(x, zh);
+        StoreBE64(x + 8, zl);
+    }
+
+    void GhashTable(const uint64_t* hl, const uint64_t* hh, uint8_t* y,
+                    const uint8_t* data, size_t size) {
+        while (size > 0) {
+            size_t n = size < kAesBlockSize ? size : kAesBlockSize;
+            for (size_t k = 0; k < n; k++) {
+                y[k] ^= data[k];
+            }
+            MultiplyTable(hl, hh, y);
+            data += n;
+            size -= n;
+        }
+    }
+
+#if RTP_GCM_PCLMUL
+    // Multiplies two byte-reflected field elements (Intel carry-less
+    // multiplication white paper, algorithm 5)
+    __attribute__((target("pclmul,sse2")))
+    inline __m128i MultiplyClmul(__m128i a, __m128i b) {
+        __m128i t3 = _mm_clmulepi64_si128(a, b, 0x00);
+        __m128i t4 = _mm_clmulepi64_si128(a, b, 0x10);
+        __m128i t5 = _mm_clmulepi64_si128(a, b, 0x01);
+        __m128i t6 = _mm_clmulepi64_si128(a, b, 0x11);
+
+        t4 = _mm_xor_si128(t4, t5);
+        t5 = _mm_slli_si128(t4, 8);
+        t4 = _mm_srli_si128(t4, 8);
+        t3 = _mm_xor_si128(t3, t5);
+        t6 = _mm_xor_si128(t6, t4);
+
+        // Shift the 256-bit product left by one for the reflected order
+        __m128i t7 = _mm_srli_epi32(t3, 31);
+        __m128i t8 = _mm_srli_epi32(t6, 31);
+        t3 = _mm_slli_epi32(t3, 1);
+        t6 = _mm_slli_epi32(t6, 1);
+        __m128i t9 = _mm_srli_si128(t7, 12);
+        t8 = _mm_slli_si128(t8, 4);
+        t7 = _mm_slli_si128(t7, 4);
+        t3 = _mm_or_si128(t3, t7);
+        t6 = _mm_or_si128(t6, t8);
+        t6 = _mm_or_si128(t6, t9);
+
+        // Reduce modulo x^128 + x^7 + x^2 + x + 1
+        t7 = _mm_slli_epi32(t3, 31);
+        t8 = _mm_slli_epi32(t3, 30);
+        t9 = _mm_slli_epi32(t3, 25);
+        t7 = _mm_xor_si128(t7, t8);
+        t7 = _mm_xor_si128(t7, t9);
+        t8 = _mm_srli_si128(t7, 4);
+        t7 = _mm_slli_si128(t7, 12);
+        t3 = _mm_xor_si128(t3, t7);
+
+        __m128i t2 = _mm_srli_epi32(t3, 1);
+        t4 = _mm_srli_epi32(t3, 2);
+        t5 = _mm_srli_epi32(t3, 7);
+        t2 = _mm_xor_si128(t2, t4);
+        t2 = _mm_xor_si128(t2, t5);
+        t2 = _mm_xor_si128(t2, t8);
+        t3 = _mm_xor_si128(t3, t2);
+        return _mm_xor_si128(t6, t3);
+    }
+
+    __attribute__((target("pclmul,ssse3")))
+    void GhashClmul(const uint8_t* h, uint8_t* y, const uint8_t* data, size_t size) {
+        const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        __m128i hv = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), swap);
+        __m128i yv = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y)), swap);
+
+        while (size >= kAesBlockSize) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            yv = MultiplyClmul(_mm_xor_si128(yv, _mm_shuffle_epi8(block, swap)), hv);
+            data += kAesBlockSize;
+            size -= kAesBlockSize;
+        }
+        if (size > 0) {
+            alignas(16) uint8_t last[kAesBlockSize] = {};
+            std::memcpy(last, data, size);
+            __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(last));
+            yv = MultiplyClmul(_mm_xor_si128(yv, _mm_shuffle_epi8(block, swap)), hv);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_shuffle_epi8(yv, swap));
+    }
+#endif
+
+    bool DetectPclmul() {
+#if RTP_GCM_PCLMUL
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#else
+        return false;
+#endif
+    }
+}
+
+bool AesGcm::HasHardwareSupport() {
+    static const bool supported = DetectPclmul();
+    return supported;
+}
+
+bool AesGcm::SetKey(const uint8_t* key, size_t key_size) {
+    if (!aes_.SetKey(key, key_size)) {
+        return false;
+    }
+
+    uint8_t zero[kAesBlockSize] = {};
+    aes_.EncryptBlock(zero, h_);
+
+    // hl_/hh_[i] hold H times the 4-bit value i in GHASH bit order
+    uint64_t vh = LoadBE64(h_);
+    uint64_t vl = LoadBE64(h_ + 8);
+    hl_[8] = vl;
+    hh_[8] = vh;
+    hl_[0] = 0;
+    hh_[0] = 0;
+    for (int i = 4; i > 0; i >>= 1) {
+        uint64_t t = (vl & 1) * 0xE1000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (t << 32);
+        hl_[i] = vl;
+        hh_[i] = vh;
+    }
+    for (int i = 2; i <= 8; i *= 2) {
+        for (int j = 1; j < i; j++) {
+            hh_[i + j] = hh_[i] ^ hh_[j];
+            hl_[i + j] = hl_[i] ^ hl_[j];
+        }
+    }
+    return true;
+}
+
+void AesGcm::Ghash(uint8_t y[kAesBlockSize], const uint8_t* data, size_t size) const {
+#if RTP_GCM_PCLMUL
+    if (HasHardwareSupport()) {
+        GhashClmul(h_, y, data, size);
+        return;
+    }
+#endif
+    GhashTable(hl_, hh_, y, data, size);
+}
+
+void AesGcm::ComputeTag(const uint8_t iv[kGcmIvSize], const uint8_t* aad, size_t aad_size,
+                        const uint8_t* data, size_t size, uint8_t tag[kGcmTagSize]) const {
+    uint8_t y[kAesBlockSize] = {};
+    Ghash(y, aad, aad_size);
+    Ghash(y, data, size);
+
+    uint8_t lengths[kAesBlockSize];
+    StoreBE64(lengths, static_cast<uint64_t>(aad_size) * 8);
+    StoreBE64(lengths + 8, static_cast<uint64_t>(size) * 8);
+    Ghash(y, lengths, kAesBlockSize);
+
+    // Tag = E(K, J0) ^ S with J0 = IV || 1
+    uint8_t j0[kAesBlockSize] = {};
+    std::memcpy(j0, iv, kGcmIvSize);
+    j0[15] = 1;
+    uint8_t mask[kAesBlockSize];
+    aes_.EncryptBlock(j0, mask);
+    for (size_t i = 0; i < kGcmTagSize; i++) {
+        tag[i] = y[i] ^ mask[i];
+    }
+}
+
+void AesGcm::Seal(const uint8_t iv[kGcmIvSize], const uint8_t* aad, size_t aad_size,
+                  uint8_t* data, size_t size, uint8_t tag[kGcmTagSize]) const {
+    uint8_t counter[kAesBlockSize] = {};
+    std::memcpy(counter, iv, kGcmIvSize);
+    counter[15] = 2;
+    aes_.Ctr(counter, data, size);
+    ComputeTag(iv, aad, aad_size, data, size, tag);
+}
+
+bool AesGcm::Open(const uint8_t iv[kGcmIvSize], const uint8_t* aad, size_t aad_size,
+                  uint8_t* data, size_t size, const uint8_t tag[kGcmTagSize]) const {
+    uint8_t expected[kGcmTagSize];
+    ComputeTag(iv, aad, aad_size, data, size, expected);
+
+    // Constant-time comparison
+    uint8_t diff = 0;
+    for (size_t i = 0; i < kGcmTagSize; i++) {
+        diff |= expected[i] ^ tag[i];
+    }
+    if (diff != 0) {
+        return false;
+    }
+
+    uint8_t counter[kAesBlockSize] = {};
+    std::memcpy(counter, iv, kGcmIvSize);
+    counter[15] = 2;
+    aes_.Ctr(counter, data, size);
+    return true;
+}
+
+} // namespace rtp
@@ -0,0 +1,53 @@
+#ifndef AES_GCM_H_
+#define AES_GCM_H_
+
+#include <cstdint>
+#include <cstddef>
+#include "aes.h"
+
+namespace rtp {
+
+constexpr size_t kGcmIvSize = 12;
+constexpr size_t kGcmTagSize = 16;
+
+// AesGcm is AES-GCM authenticated encryption with a 96-bit IV and a 128-bit
+// tag, working in place. GHASH uses carry-less multiplication (PCLMULQDQ)
+// when the CPU has it and 4-bit multiplication tables otherwise.
+class AesGcm {
+public:
+    AesGcm() = default;
+
+    // key_size is 16 or 32 bytes
+    bool SetKey(const uint8_t* key, size_t key_size);
+
+    // Encrypts data in place and writes the tag over aad and the ciphertext
+    void Seal(const uint8_t iv[kGcmIvSize], const uint8_t* aad, size_t aad_size,
+              uint8_t* data, size_t size, uint8_t tag[kGcmTagSize]) const;
+
+    // Checks the tag and decrypts data in place; on a mismatch data is left
+    // untouched and false is returned
+    bool Open(const uint8_t iv[kGcmIvSize], const uint8_t* aad, size_t aad_size,
+              uint8_t* data, size_t size, const uint8_t tag[kGcmTagSize]) const;
+
+    // Whether GHASH runs on PCLMULQDQ
+    static bool HasHardwareSupport();
+
+private:
+    // Folds data, zero padded to whole blocks, into the GHASH state y
+    void Ghash(uint8_t y[kAesBlockSize], const uint8_t* data, size_t size) const;
+
+    // Tag over aad and ciphertext for the IV
+    void ComputeTag(const uint8_t iv[kGcmIvSize], const uint8_t* aad, size_t aad_size,
+                    const uint8_t* data, size_t size, uint8_t tag[kGcmTagSize]) const;
+
+    Aes aes_;
+    uint8_t h_[kAesBlockSize] = {};
+
+    // Multiples of H for the table-driven GHASH
+    uint64_t hl_[16] = {};
+    uint64_t hh_[16] = {};
+};
+
+} // namespace rtp
+
+#endif // AES_GCM_H_
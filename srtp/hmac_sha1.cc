@@ -0,0 +1,162 @@
+#include "hmac_sha1.h"
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    inline uint32_t RotateLeft(uint32_t v, int bits) {
+        return (v << bits) | (v >> (32 - bits));
+    }
+}
+
+void Sha1::Reset() {
+    state_[0] = 0x67452301;
+    state_[1] = 0xEFCDAB89;
+    state_[2] = 0x98BADCFE;
+    state_[3] = 0x10325476;
+    state_[4] = 0xC3D2E1F0;
+    length_ = 0;
+    buffered_ = 0;
+}
+
+void Sha1::Compress(const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+               (uint32_t(block[4 * i + 2]) << 8) | block[4 * i + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state_[0];
+    uint32_t b = state_[1];
+    uint32_t c = state_[2];
+    uint32_t d = state_[3];
+    uint32_t e = state_[4];
+
+    for (int i = 0; i < 80; i++) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = RotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+}
+
+void Sha1::Update(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    length_ += size;
+
+    if (buffered_ > 0) {
+        size_t n = kSha1BlockSize - buffered_;
+        if (n > size) {
+            n = size;
+        }
+        std::memcpy(buffer_ + buffered_, data, n);
+        buffered_ += n;
+        data += n;
+        size -= n;
+        if (buffered_ < kSha1BlockSize) {
+            return;
+        }
+        Compress(buffer_);
+        buffered_ = 0;
+    }
+
+    while (size >= kSha1BlockSize) {
+        Compress(data);
+        data += kSha1BlockSize;
+        size -= kSha1BlockSize;
+    }
+
+    std::memcpy(buffer_, data, size);
+    buffered_ = size;
+}
+
+void Sha1::Final(uint8_t digest[kSha1DigestSize]) {
+    uint64_t bits = length_ * 8;
+
+    buffer_[buffered_++] = 0x80;
+    if (buffered_ > kSha1BlockSize - 8) {
+        std::memset(buffer_ + buffered_, 0, kSha1BlockSize - buffered_);
+        Compress(buffer_);
+        buffered_ = 0;
+    }
+    std::memset(buffer_ + buffered_, 0, kSha1BlockSize - 8 - buffered_);
+    for (int i = 0; i < 8; i++) {
+        buffer_[kSha1BlockSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    Compress(buffer_);
+
+    for (int i = 0; i < 5; i++) {
+        digest[4 * i] = static_cast<uint8_t>(state_[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(state_[i]);
+    }
+}
+
+void HmacSha1::SetKey(const uint8_t* key, size_t key_size) {
+    uint8_t block[kSha1BlockSize] = {};
+    if (key_size > kSha1BlockSize) {
+        Sha1 hash;
+        hash.Update(key, key_size);
+        hash.Final(block);
+    } else if (key_size > 0) {
+        std::memcpy(block, key, key_size);
+    }
+
+    uint8_t pad[kSha1BlockSize];
+    for (size_t i = 0; i < kSha1BlockSize; i++) {
+        pad[i] = block[i] ^ 0x36;
+    }
+    inner_key_.Reset();
+    inner_key_.Update(pad, kSha1BlockSize);
+
+    for (size_t i = 0; i < kSha1BlockSize; i++) {
+        pad[i] = block[i] ^ 0x5C;
+    }
+    outer_key_.Reset();
+    outer_key_.Update(pad, kSha1BlockSize);
+}
+
+void HmacSha1::Begin() {
+    inner_ = inner_key_;
+}
+
+void HmacSha1::Final(uint8_t mac[kSha1DigestSize]) {
+    uint8_t inner_digest[kSha1DigestSize];
+    inner_.Final(inner_digest);
+
+    Sha1 outer = outer_key_;
+    outer.Update(inner_digest, kSha1DigestSize);
+    outer.Final(mac);
+}
+
+} // namespace rtp
@@ -0,0 +1,52 @@
+#ifndef HMAC_SHA1_H_
+#define HMAC_SHA1_H_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace rtp {
+
+constexpr size_t kSha1DigestSize = 20;
+constexpr size_t kSha1BlockSize = 64;
+
+// Sha1 is an incremental SHA-1 hash
+class Sha1 {
+public:
+    Sha1() { Reset(); }
+
+    void Reset();
+    void Update(const uint8_t* data, size_t size);
+    void Final(uint8_t digest[kSha1DigestSize]);
+
+private:
+    void Compress(const uint8_t* block);
+
+    uint32_t state_[5];
+    uint64_t length_ = 0;
+    uint8_t buffer_[kSha1BlockSize];
+    size_t buffered_ = 0;
+};
+
+// HmacSha1 computes HMAC-SHA1 (RFC 2104) with a fixed key. The hash states
+// after the inner and outer padded keys are kept, so each message costs only
+// its own blocks plus one block for the outer hash.
+class HmacSha1 {
+public:
+    HmacSha1() = default;
+
+    void SetKey(const uint8_t* key, size_t key_size);
+
+    // Starts a message, then feed it in any number of pieces
+    void Begin();
+    void Update(const uint8_t* data, size_t size) { inner_.Update(data, size); }
+    void Final(uint8_t mac[kSha1DigestSize]);
+
+private:
+    Sha1 inner_key_;
+    Sha1 outer_key_;
+    Sha1 inner_;
+};
+
+} // namespace rtp
+
+#endif // HMAC_SHA1_H_
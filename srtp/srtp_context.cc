@@ -0,0 +1,638 @@
+#include "srtp_context.h"
+#include <algorithm>
+#include <cstring>
+
+namespace rtp {
+
+namespace {
+
+    // Key derivation labels (RFC 3711 section 4.3.1); RTCP adds 3
+    constexpr uint8_t kLabelEncryption = 0;
+    constexpr uint8_t kLabelAuthentication = 1;
+    constexpr uint8_t kLabelSalt = 2;
+    constexpr uint8_t kRtcpLabelBase = 3;
+
+    constexpr size_t kAuthKeySize = 20;
+    constexpr size_t kCounterSaltSize = 14;
+    constexpr size_t kGcmSaltSize = 12;
+    constexpr size_t kRtcpTagSize = 10;
+    constexpr size_t kSrtcpTrailerSize = 4;
+    constexpr size_t kRtpFixedHeaderSize = 12;
+    constexpr size_t kRtcpEncryptOffset = 8;
+    constexpr uint32_t kSrtcpEncryptedFlag = 0x80000000;
+    constexpr uint32_t kSrtcpIndexMask = 0x7FFFFFFF;
+
+    inline uint32_t LoadBE32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    inline void StoreBE32(uint8_t* p, uint32_t v) {
+        p[0] = static_cast<uint8_t>(v >> 24);
+        p[1] = static_cast<uint8_t>(v >> 16);
+        p[2] = static_cast<uint8_t>(v >> 8);
+        p[3] = static_cast<uint8_t>(v);
+    }
+
+    // Size of the RTP header including CSRCs and the extension block, or 0
+    // if the packet is shorter than its header. Padding is not looked at,
+    // since it is encrypted.
+    size_t RtpHeaderSize(const uint8_t* packet, size_t size) {
+        if (size < kRtpFixedHeaderSize || (packet[0] >> kVersionShift) != 2) {
+            return 0;
+        }
+        size_t header_size = kRtpFixedHeaderSize + (packet[0] & kCCMask) * kCsrcLength;
+        if ((packet[0] >> kExtensionShift) & kExtensionMask) {
+            if (size < header_size + 4) {
+                return 0;
+            }
+            size_t words = (size_t(packet[header_size + 2]) << 8) | packet[header_size + 3];
+            header_size += 4 + words * 4;
+        }
+        return header_size <= size ? header_size : 0;
+    }
+
+    bool IsRtcp(const uint8_t* packet, size_t size) {
+        return size >= kRtcpEncryptOffset && (packet[0] >> kVersionShift) == 2 &&
+               packet[1] >= 192 && packet[1] <= 223;
+    }
+
+    bool TagsEqual(const uint8_t* a, const uint8_t* b, size_t size) {
+        uint8_t diff = 0;
+        for (size_t i = 0; i < size; i++) {
+            diff |= a[i] ^ b[i];
+        }
+        return diff == 0;
+    }
+}
+
+const char* GetSrtpErrorMessage(SrtpErrorCode code) {
+    switch (code) {
+        case kSrtpOk:
+            return "OK";
+        case kSrtpNoKey:
+            return "No SRTP key set";
+        case kSrtpBadPacket:
+            return "Malformed packet";
+        case kSrtpNoRoom:
+            return "Not enough tailroom for SRTP overhead";
+        case kSrtpAuthFailed:
+            return "Authentication failed";
+        case kSrtpReplayed:
+            return "Replayed packet";
+        case kSrtpTooOld:
+            return "Packet behind replay window";
+        default:
+            return "Unknown SRTP error";
+    }
+}
+
+size_t SrtpMasterKeySize(SrtpProfile profile) {
+    return profile == SrtpProfile::kAeadAes256Gcm ? 32 : 16;
+}
+
+size_t SrtpMasterSaltSize(SrtpProfile profile) {
+    switch (profile) {
+        case SrtpProfile::kAeadAes128Gcm:
+        case SrtpProfile::kAeadAes256Gcm:
+            return kGcmSaltSize;
+        default:
+            return kCounterSaltSize;
+    }
+}
+
+size_t SrtpRtpOverhead(SrtpProfile profile) {
+    switch (profile) {
+        case SrtpProfile::kAes128CmHmacSha1_80:
+            return 10;
+        case SrtpProfile::kAes128CmHmacSha1_32:
+            return 4;
+        default:
+            return kGcmTagSize;
+    }
+}
+
+size_t SrtpRtcpOverhead(SrtpProfile profile) {
+    switch (profile) {
+        case SrtpProfile::kAeadAes128Gcm:
+        case SrtpProfile::kAeadAes256Gcm:
+            return kGcmTagSize + kSrtcpTrailerSize;
+        default:
+            // SRTCP keeps the 80-bit tag with either AES-CM profile
+            return kRtcpTagSize + kSrtcpTrailerSize;
+    }
+}
+
+// ReplayWindow implementation
+void SrtpContext::ReplayWindow::Resize(size_t window) {
+    // One spare word keeps the word of the newest index apart from the
+    // oldest one still tracked
+    size_t words = 1;
+    while (words < window / 64 + 1) {
+        words <<= 1;
+    }
+    bits_.assign(words, 0);
+    word_mask_ = words - 1;
+    started_ = false;
+}
+
+SrtpErrorCode SrtpContext::ReplayWindow::Check(uint64_t index) const {
+    if (!started_ || index > highest_) {
+        return kSrtpOk;
+    }
+    if (highest_ - index >= word_mask_ * 64) {
+        return kSrtpTooOld;
+    }
+    return IsSet(index) ? kSrtpReplayed : kSrtpOk;
+}
+
+void SrtpContext::ReplayWindow::Update(uint64_t index) {
+    if (!started_) {
+        std::fill(bits_.begin(), bits_.end(), 0);
+        started_ = true;
+        highest_ = index;
+    } else if (index > highest_) {
+        // Clear the words entered since the previous newest index
+        uint64_t from = (highest_ >> 6) + 1;
+        uint64_t to = index >> 6;
+        if (to >= from && to - from + 1 >= bits_.size()) {
+            std::fill(bits_.begin(), bits_.end(), 0);
+        } else {
+            for (uint64_t word = from; word <= to; word++) {
+                bits_[word & word_mask_] = 0;
+            }
+        }
+        highest_ = index;
+    }
+    bits_[(index >> 6) & word_mask_] |= uint64_t(1) << (index & 63);
+}
+
+// SrtpContext implementation
+SrtpContext::SrtpContext() = default;
+
+bool SrtpContext::DeriveKeys(const uint8_t* master_key, size_t key_size, const uint8_t* master_salt,
+                             size_t salt_size, uint8_t label_base, SessionKeys* keys) {
+    // The PRF is AES-CM keyed with the master key, over an IV of the master
+    // salt with the label XORed in at byte 7 (key derivation rate 0)
+    Aes prf;
+    if (!prf.SetKey(master_key, key_size)) {
+        return false;
+    }
+
+    auto derive = [&](uint8_t label, uint8_t* out, size_t size) {
+        uint8_t iv[kAesBlockSize] = {};
+        std::memcpy(iv, master_salt, salt_size);
+        iv[7] ^= label;
+        std::memset(out, 0, size);
+        prf.Ctr(iv, out, size);
+    };
+
+    uint8_t key[32];
+    derive(label_base + kLabelEncryption, key, key_size);
+    std::memset(keys->salt, 0, sizeof(keys->salt));
+    derive(label_base + kLabelSalt, keys->salt, salt_size);
+
+    bool ok;
+    if (aead_) {
+        ok = keys->gcm.SetKey(key, key_size);
+    } else {
+        uint8_t auth_key[kAuthKeySize];
+        derive(label_base + kLabelAuthentication, auth_key, kAuthKeySize);
+        keys->hmac.SetKey(auth_key, kAuthKeySize);
+        std::memset(auth_key, 0, sizeof(auth_key));
+        ok = keys->aes.SetKey(key, key_size);
+    }
+    std::memset(key, 0, sizeof(key));
+    return ok;
+}
+
+bool SrtpContext::SetKey(SrtpProfile profile, const uint8_t* master_key, size_t key_size,
+                         const uint8_t* master_salt, size_t salt_size) {
+    keyed_ = false;
+    if (!master_key || !master_salt || key_size != SrtpMasterKeySize(profile) ||
+        salt_size != SrtpMasterSaltSize(profile)) {
+        return false;
+    }
+
+    profile_ = profile;
+    aead_ = profile == SrtpProfile::kAeadAes128Gcm || profile == SrtpProfile::kAeadAes256Gcm;
+    tag_size_ = SrtpRtpOverhead(profile);
+    rtcp_tag_size_ = SrtpRtcpOverhead(profile) - kSrtcpTrailerSize;
+
+    if (!DeriveKeys(master_key, key_size, master_salt, salt_size, 0, &rtp_keys_) ||
+        !DeriveKeys(master_key, key_size, master_salt, salt_size, kRtcpLabelBase, &rtcp_keys_)) {
+        return false;
+    }
+
+    streams_.clear();
+    last_stream_ = 0;
+    keyed_ = true;
+    return true;
+}
+
+void SrtpContext::SetReplayWindow(size_t window) {
+    replay_window_ = window < 64 ? 64 : window;
+    for (Stream& stream : streams_) {
+        stream.rtp_window.Resize(replay_window_);
+        stream.rtcp_window.Resize(replay_window_);
+    }
+}
+
+SrtpContext::Stream* SrtpContext::FindStream(uint32_t ssrc) {
+    if (last_stream_ < streams_.size() && streams_[last_stream_].ssrc == ssrc) {
+        return &streams_[last_stream_];
+    }
+    for (size_t i = 0; i < streams_.size(); i++) {
+        if (streams_[i].ssrc == ssrc) {
+            last_stream_ = i;
+            return &streams_[i];
+        }
+    }
+    return nullptr;
+}
+
+SrtpContext::Stream& SrtpContext::GetOrCreateStream(uint32_t ssrc) {
+    if (Stream* stream = FindStream(ssrc)) {
+        return *stream;
+    }
+    streams_.emplace_back();
+    Stream& stream = streams_.back();
+    stream.ssrc = ssrc;
+    stream.rtp_window.Resize(replay_window_);
+    stream.rtcp_window.Resize(replay_window_);
+    last_stream_ = streams_.size() - 1;
+    return stream;
+}
+
+void SrtpContext::AttachSequencer(uint32_t ssrc, std::shared_ptr<Sequencer> sequencer) {
+    GetOrCreateStream(ssrc).sequencer = std::move(sequencer);
+}
+
+void SrtpContext::SetRolloverCounter(uint32_t ssrc, uint32_t roc) {
+    Stream& stream = GetOrCreateStream(ssrc);
+    stream.roc = roc;
+    stream.rtp_window.Resize(replay_window_);
+    if (stream.has_send_index) {
+        stream.send_index = (uint64_t(roc) << 16) | (stream.send_index & 0xFFFF);
+    }
+}
+
+uint32_t SrtpContext::RolloverCounter(uint32_t ssrc) const {
+    for (const Stream& stream : streams_) {
+        if (stream.ssrc != ssrc) {
+            continue;
+        }
+        if (stream.sequencer) {
+            return static_cast<uint32_t>(stream.sequencer->RollOverCount());
+        }
+        if (stream.has_send_index) {
+            return static_cast<uint32_t>(stream.send_index >> 16);
+        }
+        if (stream.rtp_window.started()) {
+            return static_cast<uint32_t>(stream.rtp_window.highest() >> 16);
+        }
+        return stream.roc;
+    }
+    return 0;
+}
+
+uint64_t SrtpContext::SendIndex(Stream& stream, uint16_t sequence_number) {
+    if (stream.sequencer) {
+        // The packet was numbered at or before the sequencer's last number
+        uint64_t last = stream.sequencer->ExtendedSequenceNumber();
+        uint16_t behind = static_cast<uint16_t>(static_cast<uint16_t>(last) - sequence_number);
+        if (behind > last) {
+            return sequence_number;
+        }
+        return last - behind;
+    }
+
+    uint64_t index;
+    if (!stream.has_send_index) {
+        index = (uint64_t(stream.roc) << 16) | sequence_number;
+    } else {
+        int16_t delta = static_cast<int16_t>(sequence_number - static_cast<uint16_t>(stream.send_index));
+        index = (stream.send_index + delta) & kExtendedSequenceNumberMask;
+    }
+    if (!stream.has_send_index || index > stream.send_index) {
+        stream.send_index = index;
+        stream.has_send_index = true;
+    }
+    return index;
+}
+
+uint64_t SrtpContext::ReceiveIndex(const Stream& stream, uint16_t sequence_number) {
+    // RFC 3711 section 3.3.1: the index closest to the newest one received
+    if (!stream.rtp_window.started()) {
+        return (uint64_t(stream.roc) << 16) | sequence_number;
+    }
+    uint64_t highest = stream.rtp_window.highest();
+    int16_t delta = static_cast<int16_t>(sequence_number - static_cast<uint16_t>(highest));
+    if (delta < 0 && static_cast<uint64_t>(-delta) > highest) {
+        return sequence_number;
+    }
+    return highest + delta;
+}
+
+void SrtpContext::CounterIv(const uint8_t* salt, uint32_t ssrc, uint64_t index,
+                            uint8_t iv[kAesBlockSize]) {
+    // IV = (salt * 2^16) XOR (SSRC * 2^64) XOR (index * 2^16)
+    std::memcpy(iv, salt, kCounterSaltSize);
+    iv[14] = 0;
+    iv[15] = 0;
+    iv[4] ^= static_cast<uint8_t>(ssrc >> 24);
+    iv[5] ^= static_cast<uint8_t>(ssrc >> 16);
+    iv[6] ^= static_cast<uint8_t>(ssrc >> 8);
+    iv[7] ^= static_cast<uint8_t>(ssrc);
+    for (int i = 0; i < 6; i++) {
+        iv[13 - i] ^= static_cast<uint8_t>(index >> (8 * i));
+    }
+}
+
+void SrtpContext::GcmIv(const uint8_t* salt, uint32_t ssrc, uint64_t index,
+                        uint8_t iv[kGcmIvSize]) {
+    // IV = (00 00 || SSRC || index as 48 bits) XOR salt (RFC 7714 section 8.1)
+    iv[0] = salt[0];
+    iv[1] = salt[1];
+    iv[2] = salt[2] ^ static_cast<uint8_t>(ssrc >> 24);
+    iv[3] = salt[3] ^ static_cast<uint8_t>(ssrc >> 16);
+    iv[4] = salt[4] ^ static_cast<uint8_t>(ssrc >> 8);
+    iv[5] = salt[5] ^ static_cast<uint8_t>(ssrc);
+    for (int i = 0; i < 6; i++) {
+        iv[11 - i] = salt[11 - i] ^ static_cast<uint8_t>(index >> (8 * i));
+    }
+}
+
+void SrtpContext::AuthTag(SessionKeys& keys, const uint8_t* data, size_t size, const uint8_t* suffix,
+                          size_t suffix_size, uint8_t* tag, size_t tag_size) {
+    uint8_t mac[kSha1DigestSize];
+    keys.hmac.Begin();
+    keys.hmac.Update(data, size);
+    keys.hmac.Update(suffix, suffix_size);
+    keys.hmac.Final(mac);
+    std::memcpy(tag, mac, tag_size);
+}
+
+SrtpErrorCode SrtpContext::Record(SrtpErrorCode code) {
+    stats_.packets++;
+    if (code != kSrtpOk) {
+        stats_.errors[code]++;
+    }
+    return code;
+}
+
+SrtpErrorCode SrtpContext::ProtectRtp(Stream& stream, uint8_t* packet, size_t* size, size_t capacity) {
+    size_t header_size = RtpHeaderSize(packet, *size);
+    if (header_size == 0) {
+        return kSrtpBadPacket;
+    }
+    if (capacity < *size || capacity - *size < tag_size_) {
+        return kSrtpNoRoom;
+    }
+
+    uint16_t sequence_number = static_cast<uint16_t>((packet[kSeqNumOffset] << 8) | packet[kSeqNumOffset + 1]);
+    uint64_t index = SendIndex(stream, sequence_number);
+    uint8_t* payload = packet + header_size;
+    size_t payload_size = *size - header_size;
+
+    if (aead_) {
+        uint8_t iv[kGcmIvSize];
+        GcmIv(rtp_keys_.salt, stream.ssrc, index, iv);
+        rtp_keys_.gcm.Seal(iv, packet, header_size, payload, payload_size, packet + *size);
+    } else {
+        uint8_t iv[kAesBlockSize];
+        CounterIv(rtp_keys_.salt, stream.ssrc, index, iv);
+        rtp_keys_.aes.Ctr(iv, payload, payload_size);
+
+        uint8_t roc[4];
+        StoreBE32(roc, static_cast<uint32_t>(index >> 16));
+        AuthTag(rtp_keys_, packet, *size, roc, sizeof(roc), packet + *size, tag_size_);
+    }
+
+    *size += tag_size_;
+    return kSrtpOk;
+}
+
+SrtpErrorCode SrtpContext::UnprotectRtp(Stream* stream, uint8_t* packet, size_t* size) {
+    size_t header_size = RtpHeaderSize(packet, *size);
+    if (header_size == 0 || *size < header_size + tag_size_) {
+        return kSrtpBadPacket;
+    }
+
+    // Unknown SSRCs are checked against fresh state, kept only if the packet
+    // authenticates
+    uint32_t ssrc = LoadBE32(packet + kSsrcOffset);
+    Stream fresh;
+    const Stream& state = stream ? *stream : fresh;
+
+    uint16_t sequence_number = static_cast<uint16_t>((packet[kSeqNumOffset] << 8) | packet[kSeqNumOffset + 1]);
+    uint64_t index = ReceiveIndex(state, sequence_number);
+    if (stream) {
+        SrtpErrorCode replay = stream->rtp_window.Check(index);
+        if (replay != kSrtpOk) {
+            return replay;
+        }
+    }
+
+    size_t protected_size = *size - tag_size_;
+    uint8_t* payload = packet + header_size;
+    size_t payload_size = protected_size - header_size;
+
+    if (aead_) {
+        uint8_t iv[kGcmIvSize];
+        GcmIv(rtp_keys_.salt, ssrc, index, iv);
+        if (!rtp_keys_.gcm.Open(iv, packet, header_size, payload, payload_size, packet + protected_size)) {
+            return kSrtpAuthFailed;
+        }
+    } else {
+        uint8_t roc[4];
+        StoreBE32(roc, static_cast<uint32_t>(index >> 16));
+        uint8_t tag[kSha1DigestSize];
+        AuthTag(rtp_keys_, packet, protected_size, roc, sizeof(roc), tag, tag_size_);
+        if (!TagsEqual(tag, packet + protected_size, tag_size_)) {
+            return kSrtpAuthFailed;
+        }
+
+        uint8_t iv[kAesBlockSize];
+        CounterIv(rtp_keys_.salt, ssrc, index, iv);
+        rtp_keys_.aes.Ctr(iv, payload, payload_size);
+    }
+
+    if (!stream) {
+        stream = &GetOrCreateStream(ssrc);
+    }
+    stream->rtp_window.Update(index);
+    *size = protected_size;
+    return kSrtpOk;
+}
+
+SrtpErrorCode SrtpContext::ProtectRtp(uint8_t* packet, size_t* size, size_t capacity) {
+    if (!keyed_) {
+        return Record(kSrtpNoKey);
+    }
+    if (!packet || !size || *size < kRtpFixedHeaderSize) {
+        return Record(kSrtpBadPacket);
+    }
+    Stream& stream = GetOrCreateStream(LoadBE32(packet + kSsrcOffset));
+    return Record(ProtectRtp(stream, packet, size, capacity));
+}
+
+SrtpErrorCode SrtpContext::UnprotectRtp(uint8_t* packet, size_t* size) {
+    if (!keyed_) {
+        return Record(kSrtpNoKey);
+    }
+    if (!packet || !size || *size < kRtpFixedHeaderSize) {
+        return Record(kSrtpBadPacket);
+    }
+    return Record(UnprotectRtp(FindStream(LoadBE32(packet + kSsrcOffset)), packet, size));
+}
+
+size_t SrtpContext::ProtectRtp(SrtpPacket* packets, size_t count) {
+    size_t protected_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        SrtpPacket& packet = packets[i];
+        packet.status = ProtectRtp(packet.data, &packet.size, packet.capacity);
+        if (packet.status == kSrtpOk) {
+            protected_count++;
+        }
+    }
+    return protected_count;
+}
+
+size_t SrtpContext::UnprotectRtp(SrtpPacket* packets, size_t count) {
+    size_t unprotected_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        SrtpPacket& packet = packets[i];
+        packet.status = UnprotectRtp(packet.data, &packet.size);
+        if (packet.status == kSrtpOk) {
+            unprotected_count++;
+        }
+    }
+    return unprotected_count;
+}
+
+size_t SrtpContext::ProtectRtp(PacketBuffer* packets, size_t count) {
+    size_t protected_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        PacketBuffer& packet = packets[i];
+        size_t size = packet.size();
+        if (ProtectRtp(packet.data(), &size, packet.size() + packet.tailroom()) == kSrtpOk) {
+            packet.Append(size - packet.size());
+            protected_count++;
+        }
+    }
+    return protected_count;
+}
+
+SrtpErrorCode SrtpContext::ProtectRtcp(uint8_t* packet, size_t* size, size_t capacity) {
+    if (!keyed_) {
+        return Record(kSrtpNoKey);
+    }
+    if (!packet || !size || !IsRtcp(packet, *size)) {
+        return Record(kSrtpBadPacket);
+    }
+    size_t overhead = rtcp_tag_size_ + kSrtcpTrailerSize;
+    if (capacity < *size || capacity - *size < overhead) {
+        return Record(kSrtpNoRoom);
+    }
+
+    uint32_t ssrc = LoadBE32(packet + 4);
+    Stream& stream = GetOrCreateStream(ssrc);
+    uint32_t index = stream.rtcp_send_index;
+    stream.rtcp_send_index = (index + 1) & kSrtcpIndexMask;
+    uint32_t trailer = kSrtcpEncryptedFlag | index;
+
+    uint8_t* body = packet + kRtcpEncryptOffset;
+    size_t body_size = *size - kRtcpEncryptOffset;
+
+    if (aead_) {
+        // AAD is the first 8 bytes followed by the trailer; the trailer goes
+        // after the tag on the wire
+        uint8_t aad[kRtcpEncryptOffset + kSrtcpTrailerSize];
+        std::memcpy(aad, packet, kRtcpEncryptOffset);
+        StoreBE32(aad + kRtcpEncryptOffset, trailer);
+        uint8_t iv[kGcmIvSize];
+        GcmIv(rtcp_keys_.salt, ssrc, index, iv);
+        rtcp_keys_.gcm.Seal(iv, aad, sizeof(aad), body, body_size, packet + *size);
+        StoreBE32(packet + *size + kGcmTagSize, trailer);
+    } else {
+        uint8_t iv[kAesBlockSize];
+        CounterIv(rtcp_keys_.salt, ssrc, index, iv);
+        rtcp_keys_.aes.Ctr(iv, body, body_size);
+        StoreBE32(packet + *size, trailer);
+        AuthTag(rtcp_keys_, packet, *size + kSrtcpTrailerSize, nullptr, 0,
+                packet + *size + kSrtcpTrailerSize, rtcp_tag_size_);
+    }
+
+    *size += overhead;
+    return Record(kSrtpOk);
+}
+
+SrtpErrorCode SrtpContext::UnprotectRtcp(uint8_t* packet, size_t* size) {
+    if (!keyed_) {
+        return Record(kSrtpNoKey);
+    }
+    size_t overhead = rtcp_tag_size_ + kSrtcpTrailerSize;
+    if (!packet || !size || *size < kRtcpEncryptOffset + overhead || !IsRtcp(packet, *size)) {
+        return Record(kSrtpBadPacket);
+    }
+
+    size_t protected_size = *size - overhead;
+    const uint8_t* trailer_bytes = aead_ ? packet + protected_size + kGcmTagSize
+                                         : packet + protected_size;
+    const uint8_t* tag = aead_ ? packet + protected_size
+                               : packet + protected_size + kSrtcpTrailerSize;
+    uint32_t trailer = LoadBE32(trailer_bytes);
+    uint32_t index = trailer & kSrtcpIndexMask;
+    bool encrypted = (trailer & kSrtcpEncryptedFlag) != 0;
+
+    uint32_t ssrc = LoadBE32(packet + 4);
+    Stream* stream = FindStream(ssrc);
+    if (stream) {
+        SrtpErrorCode replay = stream->rtcp_window.Check(index);
+        if (replay != kSrtpOk) {
+            return Record(replay);
+        }
+    }
+
+    uint8_t* body = packet + kRtcpEncryptOffset;
+    size_t body_size = protected_size - kRtcpEncryptOffset;
+
+    if (aead_) {
+        uint8_t aad[kRtcpEncryptOffset + kSrtcpTrailerSize];
+        std::memcpy(aad, packet, kRtcpEncryptOffset);
+        std::memcpy(aad + kRtcpEncryptOffset, trailer_bytes, kSrtcpTrailerSize);
+        uint8_t iv[kGcmIvSize];
+        GcmIv(rtcp_keys_.salt, ssrc, index, iv);
+        if (encrypted) {
+            if (!rtcp_keys_.gcm.Open(iv, aad, sizeof(aad), body, body_size, tag)) {
+                return Record(kSrtpAuthFailed);
+            }
+        } else {
+            // Unencrypted SRTCP authenticates the whole packet as AAD
+            // (RFC 7714 section 9.3), which is not contiguous with the
+            // trailer here; it is not supported
+            return Record(kSrtpBadPacket);
+        }
+    } else {
+        uint8_t expected[kSha1DigestSize];
+        AuthTag(rtcp_keys_, packet, protected_size + kSrtcpTrailerSize, nullptr, 0,
+                expected, rtcp_tag_size_);
+        if (!TagsEqual(expected, tag, rtcp_tag_size_)) {
+            return Record(kSrtpAuthFailed);
+        }
+        if (encrypted) {
+            uint8_t iv[kAesBlockSize];
+            CounterIv(rtcp_keys_.salt, ssrc, index, iv);
+            rtcp_keys_.aes.Ctr(iv, body, body_size);
+        }
+    }
+
+    if (!stream) {
+        stream = &GetOrCreateStream(ssrc);
+    }
+    stream->rtcp_window.Update(index);
+    *size = protected_size;
+    return Record(kSrtpOk);
+}
+
+} // namespace rtp
@@ -0,0 +1,210 @@
+#ifndef SRTP_CONTEXT_H_
+#define SRTP_CONTEXT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "aes.h"
+#include "aes_gcm.h"
+#include "hmac_sha1.h"
+#include "rtp_packet.h"
+#include "buffer_pool.h"
+
+namespace rtp {
+
+// Protection profiles (RFC 5764, RFC 7714)
+enum class SrtpProfile {
+    kAes128CmHmacSha1_80,
+    kAes128CmHmacSha1_32,
+    kAeadAes128Gcm,
+    kAeadAes256Gcm
+};
+
+// Master key and salt sizes of a profile
+size_t SrtpMasterKeySize(SrtpProfile profile);
+size_t SrtpMasterSaltSize(SrtpProfile profile);
+
+// Bytes protection appends to an RTP or RTCP packet
+size_t SrtpRtpOverhead(SrtpProfile profile);
+size_t SrtpRtcpOverhead(SrtpProfile profile);
+
+// Error codes and messages
+enum SrtpErrorCode {
+    kSrtpOk,
+    kSrtpNoKey,             // SetKey() has not succeeded
+    kSrtpBadPacket,         // Too short or not an RTP/RTCP packet
+    kSrtpNoRoom,            // Not enough tailroom for the tag and trailer
+    kSrtpAuthFailed,        // Authentication tag mismatch
+    kSrtpReplayed,          // Index already received
+    kSrtpTooOld,            // Index behind the replay window
+    kSrtpErrorCodeCount
+};
+
+// Returns a static description of code, never allocates
+const char* GetSrtpErrorMessage(SrtpErrorCode code);
+
+// SrtpStats counts the packets one context processed and the ones it
+// rejected, per error code
+struct SrtpStats {
+    uint64_t packets = 0;
+    uint64_t errors[kSrtpErrorCodeCount] = {};
+};
+
+// One packet of a batch call. capacity is the number of bytes writable from
+// data on, so capacity - size is the tailroom protection may append to.
+// status receives the outcome and size the new packet size.
+struct SrtpPacket {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+    SrtpErrorCode status = kSrtpOk;
+};
+
+// SrtpContext protects or unprotects the RTP and RTCP packets of one
+// direction of a session (RFC 3711, RFC 7714) in place, so packetizer output
+// with enough tailroom is encrypted without a copy. Session keys are derived
+// once in SetKey() with a key derivation rate of zero. Per-SSRC state holds
+// the rollover counter (ROC), the SRTCP index and the replay windows;
+// receive state for a new SSRC is only kept once a packet authenticates.
+// Use separate contexts for sending and receiving.
+class SrtpContext {
+public:
+    SrtpContext();
+    ~SrtpContext() = default;
+
+    // Derives the RTP and RTCP session keys; drops all per-SSRC state
+    bool SetKey(SrtpProfile profile, const uint8_t* master_key, size_t key_size,
+                const uint8_t* master_salt, size_t salt_size);
+
+    // Received packets up to window indices behind the newest one are
+    // accepted once; rounded up to a multiple of 64, at least 64
+    void SetReplayWindow(size_t window);
+
+    // Takes the ROC of outgoing packets of ssrc from the extended sequence
+    // numbers of the sequencer that numbered them, such as the one of the
+    // packetizer's StreamState. Without a sequencer the ROC is advanced when
+    // the sequence number wraps.
+    void AttachSequencer(uint32_t ssrc, std::shared_ptr<Sequencer> sequencer);
+
+    // ROC of ssrc, e.g. signaled when joining a stream late
+    void SetRolloverCounter(uint32_t ssrc, uint32_t roc);
+    uint32_t RolloverCounter(uint32_t ssrc) const;
+
+    // RTP. Protection grows *size by RtpOverhead() bytes, which must fit in
+    // capacity; unprotection shrinks it again.
+    SrtpErrorCode ProtectRtp(uint8_t* packet, size_t* size, size_t capacity);
+    SrtpErrorCode UnprotectRtp(uint8_t* packet, size_t* size);
+
+    // RTCP, growing packets by RtcpOverhead() bytes
+    SrtpErrorCode ProtectRtcp(uint8_t* packet, size_t* size, size_t capacity);
+    SrtpErrorCode UnprotectRtcp(uint8_t* packet, size_t* size);
+
+    // Batch variants; the per-SSRC state found for one packet is reused for
+    // the following packets of the same SSRC. Return the number of packets
+    // that succeeded.
+    size_t ProtectRtp(SrtpPacket* packets, size_t count);
+    size_t UnprotectRtp(SrtpPacket* packets, size_t count);
+
+    // Protects pooled packets in place, appending the tag to each data range
+    size_t ProtectRtp(PacketBuffer* packets, size_t count);
+
+    // Accessors
+    SrtpProfile profile() const { return profile_; }
+    size_t RtpOverhead() const { return SrtpRtpOverhead(profile_); }
+    size_t RtcpOverhead() const { return SrtpRtcpOverhead(profile_); }
+    const SrtpStats& Stats() const { return stats_; }
+
+private:
+    // Sliding window of received indices; a bit per index, kept circularly
+    class ReplayWindow {
+    public:
+        SrtpErrorCode Check(uint64_t index) const;
+        void Update(uint64_t index);
+        void Resize(size_t window);
+
+        bool started() const { return started_; }
+        uint64_t highest() const { return highest_; }
+
+    private:
+        bool IsSet(uint64_t index) const {
+            return (bits_[(index >> 6) & word_mask_] >> (index & 63)) & 1;
+        }
+
+        std::vector<uint64_t> bits_;
+        uint64_t word_mask_ = 0;
+        uint64_t highest_ = 0;
+        bool started_ = false;
+    };
+
+    struct Stream {
+        uint32_t ssrc = 0;
+
+        // Sending
+        std::shared_ptr<Sequencer> sequencer;
+        uint64_t send_index = 0;        // Highest RTP index sent
+        bool has_send_index = false;
+        uint32_t rtcp_send_index = 0;   // Next SRTCP index
+
+        // Receiving
+        uint32_t roc = 0;               // ROC before the first packet
+        ReplayWindow rtp_window;
+        ReplayWindow rtcp_window;
+    };
+
+    struct SessionKeys {
+        Aes aes;
+        AesGcm gcm;
+        HmacSha1 hmac;
+        uint8_t salt[14] = {};
+    };
+
+    bool DeriveKeys(const uint8_t* master_key, size_t key_size, const uint8_t* master_salt,
+                    size_t salt_size, uint8_t label_base, SessionKeys* keys);
+
+    // Finds the state of ssrc, or null
+    Stream* FindStream(uint32_t ssrc);
+    Stream& GetOrCreateStream(uint32_t ssrc);
+
+    // 48-bit RTP index of an outgoing or incoming sequence number
+    uint64_t SendIndex(Stream& stream, uint16_t sequence_number);
+    static uint64_t ReceiveIndex(const Stream& stream, uint16_t sequence_number);
+
+    // Writes the AES-CM IV for ssrc and index
+    static void CounterIv(const uint8_t* salt, uint32_t ssrc, uint64_t index,
+                          uint8_t iv[kAesBlockSize]);
+
+    // Writes the GCM IV; index is ROC || SEQ for RTP and the SRTCP index
+    static void GcmIv(const uint8_t* salt, uint32_t ssrc, uint64_t index,
+                      uint8_t iv[kGcmIvSize]);
+
+    // Authentication tag of data followed by the 32-bit suffix (the ROC for
+    // RTP), truncated to tag_size
+    void AuthTag(SessionKeys& keys, const uint8_t* data, size_t size, const uint8_t* suffix,
+                 size_t suffix_size, uint8_t* tag, size_t tag_size);
+
+    SrtpErrorCode ProtectRtp(Stream& stream, uint8_t* packet, size_t* size, size_t capacity);
+    SrtpErrorCode UnprotectRtp(Stream* stream, uint8_t* packet, size_t* size);
+
+    // Counts the outcome of one packet
+    SrtpErrorCode Record(SrtpErrorCode code);
+
+    bool keyed_ = false;
+    SrtpProfile profile_ = SrtpProfile::kAes128CmHmacSha1_80;
+    bool aead_ = false;
+    size_t tag_size_ = 0;           // RTP authentication tag
+    size_t rtcp_tag_size_ = 0;
+
+    SessionKeys rtp_keys_;
+    SessionKeys rtcp_keys_;
+
+    size_t replay_window_ = 128;
+    std::vector<Stream> streams_;
+    size_t last_stream_ = 0;
+
+    SrtpStats stats_;
+};
+
+} // namespace rtp
+
+#endif // SRTP_CONTEXT_H_
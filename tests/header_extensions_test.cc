@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <vector>
+#include "rtp_header_extensions.h"
+#include "test_util.h"
+
+namespace {
+
+    // RTP packet with the X bit set and the given extension elements, padded
+    // to whole words, in front of a four byte payload
+    std::vector<uint8_t> BuildExtensionPacket(uint16_t profile, std::vector<uint8_t> elements) {
+        std::vector<uint8_t> packet = test::BuildRtpPacket(1, 0);
+        packet[0] |= 0x10;
+        while (elements.size() % 4 != 0) {
+            elements.push_back(0);
+        }
+        size_t words = elements.size() / 4;
+        packet.push_back(static_cast<uint8_t>(profile >> 8));
+        packet.push_back(static_cast<uint8_t>(profile));
+        packet.push_back(static_cast<uint8_t>(words >> 8));
+        packet.push_back(static_cast<uint8_t>(words));
+        packet.insert(packet.end(), elements.begin(), elements.end());
+        packet.insert(packet.end(), {1, 2, 3, 4});
+        return packet;
+    }
+
+    bool FindSize(const rtp::ExtensionReader& reader, uint8_t id, size_t* size) {
+        const uint8_t* data = nullptr;
+        return reader.Find(id, &data, size);
+    }
+
+    void TestOneByte() {
+        std::vector<uint8_t> packet = BuildExtensionPacket(rtp::kExtensionProfileOneByte, {
+            0x12, 0xAA, 0xBB, 0xCC,     // ID 1, abs-send-time
+            0x00,                       // Padding between elements
+            0x31, 0x12, 0x34,           // ID 3, transport-cc
+            0x10, 0xFF,                 // ID 1 again, ignored
+            0xF0,                       // ID 15 ends the block
+            0x40, 0x01,                 // ID 4, never reached
+        });
+        rtp::PacketView view;
+        EXPECT(view.Parse(packet));
+        EXPECT(view.payload_size() == 4);
+
+        rtp::ExtensionMap map;
+        EXPECT(map.Register(rtp::ExtensionType::kAbsSendTime, 1));
+        EXPECT(map.Register(rtp::ExtensionType::kTransportSequenceNumber, 3));
+        EXPECT(map.Register(rtp::ExtensionType::kAudioLevel, 4));
+        EXPECT(!map.Register(rtp::ExtensionType::kMid, 3));
+        EXPECT(!map.Register(rtp::ExtensionType::kMid, 0));
+
+        rtp::ExtensionReader reader(view, &map);
+        size_t size = 0;
+        EXPECT(FindSize(reader, 1, &size) && size == 3);
+        EXPECT(FindSize(reader, 3, &size) && size == 2);
+        EXPECT(!FindSize(reader, 4, &size));
+        EXPECT(!FindSize(reader, 0, &size));
+        EXPECT(!FindSize(reader, 2, &size));
+
+        uint32_t abs_send_time = 0;
+        uint16_t sequence_number = 0;
+        EXPECT(reader.Get<rtp::AbsSendTimeExtension>(&abs_send_time) && abs_send_time == 0xAABBCC);
+        EXPECT(reader.Get<rtp::TransportSequenceNumberExtension>(&sequence_number) &&
+               sequence_number == 0x1234);
+        EXPECT(!reader.Has(rtp::ExtensionType::kAudioLevel));
+        EXPECT(!reader.Has(rtp::ExtensionType::kMid));
+
+        // Patched in place, then read back through a new reader
+        EXPECT(rtp::UpdateExtension<rtp::AbsSendTimeExtension>(packet.data(), packet.size(), 1, 0x010203));
+        EXPECT(!rtp::UpdateExtension<rtp::TransportSequenceNumberExtension>(packet.data(), packet.size(), 1, 7));
+        EXPECT(view.Parse(packet));
+        rtp::ExtensionReader updated(view, &map);
+        EXPECT(updated.Get<rtp::AbsSendTimeExtension>(&abs_send_time) && abs_send_time == 0x010203);
+    }
+
+    void TestTwoByte() {
+        std::vector<uint8_t> packet = BuildExtensionPacket(rtp::kExtensionProfileTwoByte, {
+            200, 2, 0x12, 0x34,     // ID 200
+            0x00,                   // Padding
+            5, 0,                   // ID 5, empty
+            7, 20, 0x01,            // ID 7, longer than the block
+        });
+        rtp::PacketView view;
+        EXPECT(view.Parse(packet));
+
+        rtp::ExtensionReader reader(view);
+        size_t size = 0;
+        EXPECT(FindSize(reader, 200, &size) && size == 2);
+        EXPECT(FindSize(reader, 5, &size) && size == 0);
+        EXPECT(!FindSize(reader, 7, &size));
+
+        // Without a map there is no typed access
+        uint16_t sequence_number = 0;
+        EXPECT(!reader.Get<rtp::TransportSequenceNumberExtension>(&sequence_number));
+    }
+
+    // No block, or a profile that is neither RFC 8285 layout
+    void TestNoElements() {
+        rtp::PacketView view;
+        std::vector<uint8_t> plain = test::BuildRtpPacket(1, 4);
+        EXPECT(view.Parse(plain));
+        size_t size = 0;
+        EXPECT(!FindSize(rtp::ExtensionReader(view), 1, &size));
+
+        std::vector<uint8_t> generic = BuildExtensionPacket(0x1234, {0x12, 0xAA, 0xBB, 0xCC});
+        EXPECT(view.Parse(generic));
+        EXPECT(!FindSize(rtp::ExtensionReader(view), 1, &size));
+    }
+}
+
+int main() {
+    TestOneByte();
+    TestTwoByte();
+    TestNoElements();
+
+    std::printf("header_extensions_test passed\n");
+    return 0;
+}
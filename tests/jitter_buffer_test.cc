@@ -0,0 +1,150 @@
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+#include "jitter_buffer.h"
+#include "test_util.h"
+
+namespace {
+
+    std::vector<uint8_t> BuildPacket(uint16_t sequence_number) {
+        return test::BuildRtpPacket(sequence_number, 8);
+    }
+
+    uint16_t SequenceNumber(const rtp::JitterBufferPacket& packet) {
+        return test::SequenceNumber(packet.data);
+    }
+
+    // A gap holds back later packets until the first of them has waited
+    // the maximum latency, also while it is polled
+    void TestGap() {
+        rtp::JitterBuffer buffer(64, 100);
+        rtp::JitterBufferPacket packet;
+
+        EXPECT(buffer.Insert(BuildPacket(10), 0));
+        EXPECT(buffer.Pop(0, &packet) && SequenceNumber(packet) == 10);
+
+        EXPECT(buffer.Insert(BuildPacket(13), 5));
+        EXPECT(buffer.Insert(BuildPacket(12), 10));
+        for (int64_t now = 10; now < 105; now += 5) {
+            EXPECT(!buffer.Pop(now, &packet));
+        }
+
+        // 12 arrived later than 13 but is first in line
+        EXPECT(!buffer.Pop(105, &packet));
+        EXPECT(buffer.Pop(110, &packet) && SequenceNumber(packet) == 12 && packet.after_gap);
+        EXPECT(buffer.Pop(110, &packet) && SequenceNumber(packet) == 13 && !packet.after_gap);
+        EXPECT(buffer.Stats().lost == 1);
+
+        // A packet filling the gap is released right away
+        EXPECT(buffer.Insert(BuildPacket(16), 200));
+        EXPECT(!buffer.Pop(200, &packet));
+        EXPECT(buffer.Insert(BuildPacket(14), 210));
+        EXPECT(buffer.Pop(210, &packet) && SequenceNumber(packet) == 14);
+        EXPECT(!buffer.Pop(210, &packet));
+        EXPECT(buffer.Insert(BuildPacket(15), 220));
+        EXPECT(buffer.Pop(220, &packet) && SequenceNumber(packet) == 15);
+        EXPECT(buffer.Pop(220, &packet) && SequenceNumber(packet) == 16);
+        EXPECT(buffer.Size() == 0);
+    }
+
+    // Packets far behind the release point are late until enough of them in
+    // a row agree on a new position; a new SSRC restarts right away
+    void TestRestart() {
+        rtp::JitterBuffer buffer(64, 100);
+        rtp::JitterBufferPacket packet;
+
+        EXPECT(buffer.Insert(BuildPacket(1000), 0));
+        EXPECT(buffer.Pop(0, &packet) && SequenceNumber(packet) == 1000);
+
+        // A single stray packet does not throw away the stream
+        EXPECT(!buffer.Insert(BuildPacket(100), 10));
+        EXPECT(buffer.Stats().late == 1);
+        EXPECT(buffer.Insert(BuildPacket(1001), 10));
+        EXPECT(buffer.Pop(10, &packet) && SequenceNumber(packet) == 1001);
+
+        // An in-window packet breaks a run of far-behind packets
+        EXPECT(!buffer.Insert(BuildPacket(200), 20));
+        EXPECT(!buffer.Insert(BuildPacket(201), 20));
+        EXPECT(buffer.Insert(BuildPacket(1002), 20));
+        EXPECT(buffer.Pop(20, &packet) && SequenceNumber(packet) == 1002);
+        EXPECT(!buffer.Insert(BuildPacket(202), 30));
+        EXPECT(buffer.Stats().late == 4);
+
+        // Four consecutive packets restart the buffer at the last of them
+        EXPECT(!buffer.Insert(BuildPacket(300), 40));
+        EXPECT(!buffer.Insert(BuildPacket(301), 40));
+        EXPECT(!buffer.Insert(BuildPacket(302), 40));
+        EXPECT(buffer.Insert(BuildPacket(303), 40));
+        EXPECT(buffer.Stats().late == 7);
+        EXPECT(buffer.Pop(40, &packet) && SequenceNumber(packet) == 303);
+        EXPECT(buffer.Insert(BuildPacket(304), 50));
+        EXPECT(buffer.Pop(50, &packet) && SequenceNumber(packet) == 304);
+
+        // A new SSRC starts over with its first packet
+        EXPECT(buffer.Insert(test::BuildRtpPacket(5, 8, 0x1234), 60));
+        EXPECT(buffer.Pop(60, &packet) && SequenceNumber(packet) == 5);
+        EXPECT(buffer.Stats().late == 7);
+    }
+
+    // Random reordering and loss against a model of the release rules
+    void TestRandom() {
+        const int64_t kLatency = 30;
+        rtp::JitterBuffer buffer(256, kLatency);
+        std::map<int, int64_t> model;      // Buffered sequence number to arrival
+        int next = 1000;
+        uint64_t lost = 0;
+
+        std::mt19937 random(7);
+        int send = 1000;
+        int64_t now = 0;
+        std::vector<int> in_flight;
+        while (send < 20000) {
+            now++;
+            for (int i = 0; i < 2; i++) {
+                if (random() % 10 != 0) {
+                    in_flight.push_back(send);
+                }
+                send++;
+            }
+            while (!in_flight.empty() && random() % 3 != 0) {
+                size_t pick = random() % std::min<size_t>(in_flight.size(), 8);
+                int seq = in_flight[pick];
+                in_flight.erase(in_flight.begin() + pick);
+
+                bool inserted = buffer.Insert(BuildPacket(static_cast<uint16_t>(seq)), now);
+                EXPECT(inserted == (seq >= next));
+                if (inserted) {
+                    model[seq] = now;
+                }
+            }
+
+            rtp::JitterBufferPacket packet;
+            for (;;) {
+                bool ready = !model.empty() &&
+                             (model.begin()->first == next || now - model.begin()->second >= kLatency);
+                EXPECT(buffer.Pop(now, &packet) == ready);
+                if (!ready) {
+                    break;
+                }
+                int seq = model.begin()->first;
+                EXPECT(SequenceNumber(packet) == static_cast<uint16_t>(seq));
+                EXPECT(packet.after_gap == (seq != next));
+                lost += static_cast<uint64_t>(seq - next);
+                next = seq + 1;
+                model.erase(model.begin());
+            }
+        }
+        EXPECT(buffer.Stats().lost == lost);
+        EXPECT(buffer.Size() == model.size());
+    }
+}
+
+int main() {
+    TestGap();
+    TestRestart();
+    TestRandom();
+
+    std::printf("jitter_buffer_test passed\n");
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <vector>
+#include "nack_generator.h"
+#include "test_util.h"
+
+namespace {
+
+    // Sequence numbers requested by a Generic NACK packet, once per request
+    std::vector<int> RequestCounts(const uint8_t* buf, size_t size) {
+        std::vector<int> counts(65536, 0);
+        for (size_t fci = 12; fci + 4 <= size; fci += 4) {
+            uint16_t pid = static_cast<uint16_t>((buf[fci] << 8) | buf[fci + 1]);
+            uint16_t blp = static_cast<uint16_t>((buf[fci + 2] << 8) | buf[fci + 3]);
+            counts[pid]++;
+            for (int bit = 0; bit < 16; bit++) {
+                if ((blp >> bit) & 1) {
+                    counts[static_cast<uint16_t>(pid + bit + 1)]++;
+                }
+            }
+        }
+        return counts;
+    }
+
+    // A packet with more items than one internal batch requests every
+    // missing packet exactly once, also without an RTT between requests
+    void TestLargePacket(int loss_interval, int64_t rtt_ms) {
+        rtp::NackGenerator generator(4096);
+        generator.SetRtt(rtt_ms);
+
+        const int kPackets = 3000;
+        size_t lost = 0;
+        for (int seq = 0; seq < kPackets; seq++) {
+            if (seq % loss_interval == 1) {
+                lost++;
+                continue;
+            }
+            generator.OnPacket(static_cast<uint16_t>(seq));
+        }
+        EXPECT(generator.MissingCount() == lost);
+
+        std::vector<uint8_t> buf(12 + 4 * 1000);
+        size_t size = generator.BuildNackPacket(1000, 1, buf.data(), buf.size());
+        EXPECT(size > 12 + 4 * 64);
+
+        std::vector<int> counts = RequestCounts(buf.data(), size);
+        for (int seq = 0; seq < kPackets; seq++) {
+            EXPECT(counts[seq] == (seq % loss_interval == 1 ? 1 : 0));
+        }
+        EXPECT(generator.Stats().requests == lost);
+    }
+
+    // A buffer too small for every item is filled with the oldest ones
+    void TestPartialPacket() {
+        rtp::NackGenerator generator(4096);
+        generator.SetRtt(0);
+        for (int seq = 0; seq < 4000; seq++) {
+            if (seq % 20 != 1) {
+                generator.OnPacket(static_cast<uint16_t>(seq));
+            }
+        }
+
+        std::vector<uint8_t> buf(12 + 4 * 100);
+        size_t size = generator.BuildNackPacket(1000, 1, buf.data(), buf.size());
+        EXPECT(size == buf.size());
+        for (size_t i = 0; i < 100; i++) {
+            const uint8_t* fci = buf.data() + 12 + 4 * i;
+            EXPECT(((fci[0] << 8) | fci[1]) == static_cast<int>(20 * i + 1));
+        }
+    }
+}
+
+int main() {
+    TestLargePacket(20, 0);
+    TestLargePacket(20, 100);
+    TestLargePacket(3, 0);
+    TestPartialPacket();
+
+    std::printf("nack_generator_test passed\n");
+    return 0;
+}
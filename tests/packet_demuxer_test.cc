@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "packet_demuxer.h"
+#include "test_util.h"
+
+namespace {
+
+    // RTCP receiver report header with the sender SSRC
+    std::vector<uint8_t> BuildRtcpPacket(uint32_t ssrc) {
+        return {0x80, 201, 0x00, 0x01,
+                static_cast<uint8_t>(ssrc >> 24), static_cast<uint8_t>(ssrc >> 16),
+                static_cast<uint8_t>(ssrc >> 8), static_cast<uint8_t>(ssrc)};
+    }
+
+    void TestClassify() {
+        std::vector<uint8_t> stun(20, 0);
+        std::vector<uint8_t> dtls(13, 22);
+        std::vector<uint8_t> turn(4, 64);
+        std::vector<uint8_t> garbage(20, 100);
+        std::vector<uint8_t> rtp = test::BuildRtpPacket(1, 0);
+        std::vector<uint8_t> rtcp = BuildRtcpPacket(1);
+
+        EXPECT(rtp::ClassifyPacket(stun.data(), stun.size()) == rtp::PacketClass::kStun);
+        EXPECT(rtp::ClassifyPacket(dtls.data(), dtls.size()) == rtp::PacketClass::kDtls);
+        EXPECT(rtp::ClassifyPacket(turn.data(), turn.size()) == rtp::PacketClass::kTurnChannel);
+        EXPECT(rtp::ClassifyPacket(garbage.data(), garbage.size()) == rtp::PacketClass::kGarbage);
+        EXPECT(rtp::ClassifyPacket(rtp.data(), rtp.size()) == rtp::PacketClass::kRtp);
+        EXPECT(rtp::ClassifyPacket(rtcp.data(), rtcp.size()) == rtp::PacketClass::kRtcp);
+
+        // Too short for the fixed header of their class
+        EXPECT(rtp::ClassifyPacket(stun.data(), 19) == rtp::PacketClass::kGarbage);
+        EXPECT(rtp::ClassifyPacket(rtp.data(), 11) == rtp::PacketClass::kGarbage);
+        EXPECT(rtp::ClassifyPacket(rtcp.data(), 7) == rtp::PacketClass::kGarbage);
+        EXPECT(rtp::ClassifyPacket(rtp.data(), 1) == rtp::PacketClass::kGarbage);
+    }
+
+    // RTP and RTCP find the stream of their SSRC, one by one and in batches
+    // longer than a prefetch slice
+    void TestDemux() {
+        rtp::PacketDemuxer demuxer;
+        EXPECT(demuxer.AddStream(0x1111, 1));
+        EXPECT(demuxer.AddStream(0x2222, 2));
+        EXPECT(!demuxer.AddStream(0x3333, rtp::SsrcMap::kNoStream));
+        EXPECT(demuxer.StreamCount() == 2);
+
+        std::vector<uint8_t> rtp = test::BuildRtpPacket(1, 4, 0x1111);
+        std::vector<uint8_t> rtcp = BuildRtcpPacket(0x2222);
+        std::vector<uint8_t> unknown = test::BuildRtpPacket(1, 4, 0x3333);
+        std::vector<uint8_t> stun(20, 0);
+
+        rtp::DemuxedPacket packet = demuxer.Demux(rtp.data(), rtp.size());
+        EXPECT(packet.type == rtp::PacketClass::kRtp && packet.stream == 1);
+        packet = demuxer.Demux(rtcp.data(), rtcp.size());
+        EXPECT(packet.type == rtp::PacketClass::kRtcp && packet.stream == 2);
+        packet = demuxer.Demux(unknown.data(), unknown.size());
+        EXPECT(packet.type == rtp::PacketClass::kRtp && packet.stream == rtp::SsrcMap::kNoStream);
+        packet = demuxer.Demux(stun.data(), stun.size());
+        EXPECT(packet.type == rtp::PacketClass::kStun && packet.stream == rtp::SsrcMap::kNoStream);
+
+        const std::vector<uint8_t>* sources[] = {&rtp, &rtcp, &unknown, &stun};
+        std::vector<rtp::DemuxedPacket> batch(100);
+        for (size_t i = 0; i < batch.size(); i++) {
+            batch[i].data = sources[i % 4]->data();
+            batch[i].size = sources[i % 4]->size();
+        }
+        EXPECT(demuxer.Demux(batch.data(), batch.size()) == 50);
+        for (size_t i = 0; i < batch.size(); i++) {
+            uint32_t expected[] = {1, 2, rtp::SsrcMap::kNoStream, rtp::SsrcMap::kNoStream};
+            EXPECT(batch[i].stream == expected[i % 4]);
+        }
+
+        EXPECT(demuxer.RemoveStream(0x1111));
+        EXPECT(!demuxer.RemoveStream(0x1111));
+        EXPECT(demuxer.FindStream(0x1111) == rtp::SsrcMap::kNoStream);
+        EXPECT(demuxer.FindStream(0x2222) == 2);
+    }
+
+    // Random inserts and erases against a model. A small SSRC pool keeps the
+    // table near its load limit, so buckets spill and every erase has to
+    // shift spilled SSRCs back towards their home bucket.
+    void TestSsrcMapRandom() {
+        rtp::SsrcMap map(8);
+        std::unordered_map<uint32_t, uint32_t> model;
+        std::mt19937 random(11);
+
+        for (int step = 0; step < 200000; step++) {
+            uint32_t ssrc = random() % 600;
+            if (random() % 2 == 0) {
+                uint32_t stream = random() % 1000;
+                EXPECT(map.Insert(ssrc, stream));
+                model[ssrc] = stream;
+            } else {
+                EXPECT(map.Erase(ssrc) == (model.erase(ssrc) == 1));
+            }
+            EXPECT(map.Size() == model.size());
+
+            if (step % 997 == 0) {
+                for (uint32_t s = 0; s < 600; s++) {
+                    auto it = model.find(s);
+                    EXPECT(map.Find(s) == (it == model.end() ? rtp::SsrcMap::kNoStream : it->second));
+                }
+            }
+        }
+
+        map.Clear();
+        EXPECT(map.Size() == 0);
+        EXPECT(map.Find(model.begin()->first) == rtp::SsrcMap::kNoStream);
+    }
+}
+
+int main() {
+    TestClassify();
+    TestDemux();
+    TestSsrcMapRandom();
+
+    std::printf("packet_demuxer_test passed\n");
+    return 0;
+}
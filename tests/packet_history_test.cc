@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "media_rtp.h"
+#include "packet_history.h"
+#include "test_util.h"
+
+namespace {
+
+    const uint8_t kTransportExtensionId = 5;
+
+    uint16_t TransportSequenceNumber(const uint8_t* packet, size_t size) {
+        rtp::PacketView view;
+        const uint8_t* value = nullptr;
+        size_t value_size = 0;
+        EXPECT(view.Parse(packet, size));
+        EXPECT(view.GetExtension(kTransportExtensionId, &value, &value_size));
+        EXPECT(value_size == 2);
+        return static_cast<uint16_t>((value[0] << 8) | value[1]);
+    }
+
+    // An RTX packet takes the next transport-wide sequence number instead of
+    // repeating the one of the original packet
+    void TestRtxTransportSequenceNumber() {
+        auto transport_sequencer = std::make_shared<rtp::FixedSequencer>(100);
+
+        media::RTPPacketizer packetizer(media::Codec::OPUS);
+        packetizer.SetSSRC(0x1234);
+        EXPECT(packetizer.SetTransportSequenceNumber(kTransportExtensionId, transport_sequencer));
+
+        rtp::PacketHistory history;
+        history.SetRtx(0x5678, 97);
+        size_t offset = 0;
+        size_t size = 0;
+        EXPECT(packetizer.GetHeaderExtensionOffset(kTransportExtensionId, &offset, &size));
+        EXPECT(size == 2);
+        history.SetTransportSequenceNumber(offset, transport_sequencer);
+
+        std::vector<std::vector<uint8_t>> packets;
+        std::vector<std::vector<uint8_t>> frame_packets;
+        for (int i = 0; i < 3; i++) {
+            EXPECT(packetizer.Packetize(std::vector<uint8_t>(50, static_cast<uint8_t>(i)), &frame_packets));
+            packets.insert(packets.end(), frame_packets.begin(), frame_packets.end());
+        }
+        EXPECT(packets.size() == 3);
+        for (size_t i = 0; i < packets.size(); i++) {
+            EXPECT(TransportSequenceNumber(packets[i].data(), packets[i].size()) == 100 + i);
+            EXPECT(history.PutPacket(packets[i], 0));
+        }
+
+        rtp::PacketView original;
+        EXPECT(original.Parse(packets[1]));
+        std::vector<uint8_t> rtx(1500);
+        size_t rtx_size = history.WriteRtxPacket(original.sequence_number(), rtx.data(), rtx.size());
+        EXPECT(rtx_size == packets[1].size() + 2);
+        EXPECT(TransportSequenceNumber(rtx.data(), rtx_size) == 103);
+
+        // The stream goes on after the retransmission
+        EXPECT(packetizer.Packetize(std::vector<uint8_t>(50, 0), &frame_packets));
+        EXPECT(frame_packets.size() == 1);
+        EXPECT(TransportSequenceNumber(frame_packets[0].data(), frame_packets[0].size()) == 104);
+    }
+}
+
+int main() {
+    TestRtxTransportSequenceNumber();
+
+    std::printf("packet_history_test passed\n");
+    return 0;
+}
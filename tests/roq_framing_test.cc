@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+#include "roq_framing.h"
+#include "test_util.h"
+
+namespace {
+
+    // In-memory QUIC connection that records what the sender wrote
+    class MemorySink : public rtp::QuicSink {
+    public:
+        struct Stream {
+            std::vector<uint8_t> data;
+            bool fin = false;
+        };
+
+        bool SendDatagram(const uint8_t* data, size_t size) override {
+            datagrams.emplace_back(data, data + size);
+            return true;
+        }
+        size_t MaxDatagramSize() const override { return max_datagram_size; }
+        int64_t OpenStream() override {
+            int64_t id = next_stream;
+            next_stream += 4;
+            streams[id];
+            return id;
+        }
+        bool WriteStream(int64_t stream, const uint8_t* data, size_t size, bool fin) override {
+            Stream& state = streams[stream];
+            EXPECT(!state.fin);
+            state.data.insert(state.data.end(), data, data + size);
+            state.fin = fin;
+            return true;
+        }
+
+        size_t max_datagram_size = 1200;
+        int64_t next_stream = 2;
+        std::vector<std::vector<uint8_t>> datagrams;
+        std::map<int64_t, Stream> streams;
+    };
+
+    class PacketCollector : public rtp::RoqPacketHandler {
+    public:
+        void OnRoqPacket(uint64_t flow_id, const uint8_t* packet, size_t size) override {
+            flow_ids.push_back(flow_id);
+            packets.emplace_back(packet, packet + size);
+        }
+
+        std::vector<uint64_t> flow_ids;
+        std::vector<std::vector<uint8_t>> packets;
+    };
+
+    // Every size boundary, and the RFC 9000 A.1 sample encodings
+    void TestVarint() {
+        const uint64_t kValues[] = {0, 63, 64, 16383, 16384, 1073741823, 1073741824, rtp::kMaxQuicVarint};
+        const size_t kSizes[] = {1, 1, 2, 2, 4, 4, 8, 8};
+        for (size_t i = 0; i < sizeof(kValues) / sizeof(kValues[0]); i++) {
+            uint8_t encoded[rtp::kMaxQuicVarintSize];
+            EXPECT(rtp::QuicVarintSize(kValues[i]) == kSizes[i]);
+            EXPECT(rtp::WriteQuicVarint(kValues[i], encoded) == kSizes[i]);
+            uint64_t value = 0;
+            EXPECT(rtp::ReadQuicVarint(encoded, kSizes[i], &value) == kSizes[i] && value == kValues[i]);
+            EXPECT(rtp::ReadQuicVarint(encoded, kSizes[i] - 1, &value) == 0);
+        }
+
+        struct Sample {
+            std::vector<uint8_t> bytes;
+            uint64_t value;
+        };
+        const Sample kSamples[] = {
+            {{0xc2, 0x19, 0x7c, 0x5e, 0xff, 0x14, 0xe8, 0x8c}, 151288809941952652ull},
+            {{0x9d, 0x7f, 0x3e, 0x7d}, 494878333},
+            {{0x7b, 0xbd}, 15293},
+            {{0x25}, 37},
+            {{0x40, 0x25}, 37},   // Not the shortest encoding, but valid
+        };
+        for (const Sample& sample : kSamples) {
+            uint64_t value = 0;
+            EXPECT(rtp::ReadQuicVarint(sample.bytes.data(), sample.bytes.size(), &value) == sample.bytes.size());
+            EXPECT(value == sample.value);
+        }
+    }
+
+    void TestDatagrams() {
+        MemorySink sink;
+        rtp::RoqSender sender(&sink, 70);
+        PacketCollector collector;
+        rtp::RoqReceiver receiver(&collector);
+
+        std::vector<uint8_t> packet = test::BuildRtpPacket(1, 100);
+        EXPECT(sender.SendPacket(packet.data(), packet.size()));
+
+        // Written by a packetizer through the PacketWriter interface
+        uint8_t* out = sender.Begin(packet.size());
+        std::memcpy(out, packet.data(), packet.size());
+        EXPECT(sender.Commit(packet.size()));
+
+        // In place, behind just enough headroom for the two-byte flow id
+        std::vector<uint8_t> framed(2 + packet.size());
+        std::memcpy(framed.data() + 2, packet.data(), packet.size());
+        EXPECT(!sender.SendPacketInPlace(framed.data() + 2, packet.size(), 1));
+        EXPECT(sender.SendPacketInPlace(framed.data() + 2, packet.size(), 2));
+
+        // Too large for a datagram
+        std::vector<uint8_t> large = test::BuildRtpPacket(2, sink.max_datagram_size);
+        EXPECT(!sender.SendPacket(large.data(), large.size()));
+        EXPECT(sender.Stats().oversized == 1);
+        EXPECT(sender.Stats().datagrams == 3);
+
+        EXPECT(sink.datagrams.size() == 3);
+        for (const std::vector<uint8_t>& datagram : sink.datagrams) {
+            EXPECT(datagram.size() == 2 + packet.size());
+            EXPECT(receiver.OnDatagram(datagram.data(), datagram.size()));
+        }
+        EXPECT(collector.packets.size() == 3);
+        for (size_t i = 0; i < collector.packets.size(); i++) {
+            EXPECT(collector.flow_ids[i] == 70 && collector.packets[i] == packet);
+        }
+
+        // A datagram needs a whole flow id and a packet behind it
+        const uint8_t kTruncated[] = {0x40};
+        const uint8_t kEmpty[] = {0x05};
+        EXPECT(!receiver.OnDatagram(kTruncated, sizeof(kTruncated)));
+        EXPECT(!receiver.OnDatagram(kEmpty, sizeof(kEmpty)));
+        EXPECT(receiver.Stats().malformed == 2);
+    }
+
+    // Feeds a stream to the receiver in chunks of at most max_chunk bytes
+    void FeedStream(rtp::RoqReceiver* receiver, int64_t id, const std::vector<uint8_t>& stream,
+                    size_t max_chunk, std::mt19937* random) {
+        size_t offset = 0;
+        while (offset < stream.size()) {
+            size_t chunk = std::min<size_t>(stream.size() - offset, 1 + (*random)() % max_chunk);
+            bool fin = offset + chunk == stream.size();
+            EXPECT(receiver->OnStreamData(id, stream.data() + offset, chunk, fin));
+            offset += chunk;
+        }
+    }
+
+    // Packets with one, two and four byte length varints behind a two-byte
+    // flow id come back whole however the stream data is split
+    void TestStream() {
+        MemorySink sink;
+        rtp::RoqSender sender(&sink, 300);
+        std::vector<std::vector<uint8_t>> packets;
+        for (size_t payload_size : {20, 500, 20000}) {
+            packets.push_back(test::BuildRtpPacket(static_cast<uint16_t>(packets.size()), payload_size));
+        }
+
+        EXPECT(sender.BeginStream());
+        EXPECT(!sender.BeginStream());
+        for (const std::vector<uint8_t>& packet : packets) {
+            EXPECT(sender.SendPacket(packet.data(), packet.size()));
+        }
+        EXPECT(sender.EndStream());
+        EXPECT(sender.Stats().stream_packets == packets.size());
+        EXPECT(sink.streams.size() == 1);
+        int64_t id = sink.streams.begin()->first;
+        const MemorySink::Stream& stream = sink.streams.begin()->second;
+        EXPECT(stream.fin);
+
+        std::mt19937 random(3);
+        for (size_t max_chunk : {1, 3, 100, 70000}) {
+            PacketCollector collector;
+            rtp::RoqReceiver receiver(&collector);
+            FeedStream(&receiver, id, stream.data, max_chunk, &random);
+            EXPECT(collector.packets == packets);
+            for (uint64_t flow_id : collector.flow_ids) {
+                EXPECT(flow_id == 300);
+            }
+            EXPECT(receiver.Stats().stream_packets == packets.size());
+            EXPECT(receiver.Stats().malformed == 0);
+        }
+
+        // A stream that ends inside a packet is malformed
+        PacketCollector collector;
+        rtp::RoqReceiver receiver(&collector);
+        EXPECT(!receiver.OnStreamData(id, stream.data.data(), stream.data.size() - 1, true));
+        EXPECT(receiver.Stats().malformed == 1);
+
+        // So is a packet larger than the receiver takes; the rest of the
+        // stream is ignored
+        rtp::RoqReceiver small(&collector, 1000);
+        EXPECT(!small.OnStreamData(id, stream.data.data(), stream.data.size() - 10, false));
+        EXPECT(!small.OnStreamData(id, stream.data.data() + stream.data.size() - 10, 10, true));
+        EXPECT(small.Stats().malformed == 1);
+    }
+}
+
+int main() {
+    TestVarint();
+    TestDatagrams();
+    TestStream();
+
+    std::printf("roq_framing_test passed\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "rtcp_packet.h"
+#include "rtp_packet.h"
+#include "rtp_stream.h"
+#include "test_util.h"
+
+namespace {
+
+    // Fixed header with P=1, followed by payload_size bytes and the padding
+    // count in the last byte
+    std::vector<uint8_t> BuildPaddedPacket(size_t payload_size, uint8_t padding_size) {
+        std::vector<uint8_t> packet = test::BuildRtpPacket(0, payload_size);
+        packet[0] |= 0x20;
+        packet.back() = padding_size;
+        return packet;
+    }
+
+    void TestPadding() {
+        rtp::PacketView view;
+        rtp::Packet packet;
+
+        // Two payload bytes and two padding bytes
+        std::vector<uint8_t> valid = BuildPaddedPacket(4, 2);
+        EXPECT(view.Parse(valid));
+        EXPECT(view.padding_size() == 2);
+        EXPECT(view.payload_size() == 2);
+        EXPECT(packet.Depacketize(valid));
+        EXPECT(packet.payload.size() == 2);
+
+        // All of the payload is padding
+        std::vector<uint8_t> all_padding = BuildPaddedPacket(4, 4);
+        EXPECT(view.Parse(all_padding));
+        EXPECT(view.payload_size() == 0);
+
+        // Padding count larger than the bytes behind the header
+        std::vector<uint8_t> overlong = BuildPaddedPacket(1, 0xFF);
+        EXPECT(!view.Parse(overlong));
+        EXPECT(!packet.Depacketize(overlong));
+
+        std::vector<uint8_t> one_over = BuildPaddedPacket(4, 5);
+        EXPECT(!view.Parse(one_over));
+        EXPECT(!packet.Depacketize(one_over));
+
+        // The padding count includes itself, so 0 is invalid
+        std::vector<uint8_t> zero = BuildPaddedPacket(4, 0);
+        EXPECT(!view.Parse(zero));
+        EXPECT(!packet.Depacketize(zero));
+    }
+
+    void TestExtensionIds() {
+        // Id 0 is padding and never starts an extension block
+        rtp::Header header;
+        EXPECT(!header.SetExtension(0, {1}));
+        EXPECT(!header.extension);
+        EXPECT(header.SetExtension(15, {1}));
+        EXPECT(header.extension_profile == rtp::kExtensionProfileTwoByte);
+
+        rtp::StreamState stream;
+        auto sequencer = std::make_shared<rtp::FixedSequencer>(0);
+        EXPECT(stream.SetTransportSequenceNumber(3, sequencer));
+        size_t header_size = stream.HeaderSize();
+        size_t offset = 0;
+        size_t size = 0;
+        EXPECT(stream.GetExtensionOffset(3, &offset, &size));
+
+        // Rejected ids leave the header and the transport extension alone
+        uint8_t value[4] = {1, 2, 3, 4};
+        EXPECT(!stream.AddExtension(0, value, sizeof(value)));
+        EXPECT(!stream.AddExtension(15, value, sizeof(value)));
+        EXPECT(!stream.SetTransportSequenceNumber(0, sequencer));
+        EXPECT(!stream.SetTransportSequenceNumber(15, sequencer));
+        EXPECT(stream.HeaderSize() == header_size);
+        EXPECT(stream.header().extensions.size() == 1);
+        size_t unchanged_offset = 0;
+        EXPECT(stream.GetExtensionOffset(3, &unchanged_offset, &size));
+        EXPECT(unchanged_offset == offset);
+
+        // One-byte elements hold at most 16 bytes
+        uint8_t large[17] = {};
+        EXPECT(!stream.AddExtension(4, large, sizeof(large)));
+        EXPECT(stream.HeaderSize() == header_size);
+        EXPECT(stream.AddExtension(14, value, sizeof(value)));
+        EXPECT(stream.HeaderSize() > header_size);
+    }
+
+    // The RTCP length field counts 32-bit words minus one in 16 bits, which
+    // bounds a packet at 256 KiB
+    void TestRtcpLength() {
+        std::vector<uint8_t> buf(2 * rtp::kRtcpMaxPacketSize);
+
+        // Largest NACK: 12 header bytes and 65533 items make 65536 words
+        std::vector<rtp::NackItem> items(65534);
+        rtp::RtcpWriter nack(buf.data(), buf.size());
+        EXPECT(!nack.AddNack(1, 2, items.data(), items.size()));
+        EXPECT(nack.AddNack(1, 2, items.data(), items.size() - 1));
+        EXPECT(buf[2] == 0xFF && buf[3] == 0xFF);
+
+        // One chunk of 255 byte items: SSRC, items and the null item
+        std::vector<uint8_t> text(255, 'a');
+        std::vector<rtp::SdesItem> sdes(1021);
+        for (rtp::SdesItem& item : sdes) {
+            item.ssrc = 1;
+            item.text = text.data();
+            item.size = static_cast<uint8_t>(text.size());
+        }
+        rtp::RtcpWriter writer(buf.data(), buf.size());
+        EXPECT(!writer.AddSdes(sdes.data(), sdes.size()));
+        EXPECT(writer.AddSdes(sdes.data(), 1019));
+    }
+}
+
+int main() {
+    TestPadding();
+    TestExtensionIds();
+    TestRtcpLength();
+
+    std::printf("rtp_packet_test passed\n");
+    return 0;
+}
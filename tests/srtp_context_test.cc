@@ -0,0 +1,223 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "aes.h"
+#include "aes_gcm.h"
+#include "hmac_sha1.h"
+#include "srtp_context.h"
+#include "test_util.h"
+
+namespace {
+
+    const uint8_t kMasterKey[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    const uint8_t kMasterSalt[14] = {21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34};
+    const uint32_t kSsrc = 0x11223344;
+
+    std::vector<uint8_t> FromHex(const char* hex) {
+        std::vector<uint8_t> bytes;
+        for (; hex[0] && hex[1]; hex += 2) {
+            bytes.push_back(static_cast<uint8_t>(std::stoi(std::string(hex, 2), nullptr, 16)));
+        }
+        return bytes;
+    }
+
+    // RFC 3711 B.2: AES-CM keystream, including blocks where the 16-bit
+    // block counter carries into the salt bytes
+    void TestAesCmKeystream() {
+        const std::vector<uint8_t> kKey = FromHex("2b7e151628aed2a6abf7158809cf4f3c");
+        const std::vector<uint8_t> kCounter = FromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfd0000");
+        struct Block {
+            size_t index;
+            const char* keystream;
+        };
+        const Block kBlocks[] = {
+            {0x0000, "e03ead0935c95e80e166b16dd92b4eb4"},
+            {0x0001, "d23513162b02d0f72a43a2fe4a5f97ab"},
+            {0x0002, "41e95b3bb0a2e8dd477901e4fca894c0"},
+            {0xfeff, "ec8cdf7398607cb0f2d21675ea9ea1e4"},
+            {0xff00, "362b7c3c6773516318a077d7fc5073ae"},
+            {0xff01, "6a2cc3787889374fbeb4c81b17ba6c44"},
+        };
+
+        rtp::Aes aes;
+        EXPECT(aes.SetKey(kKey.data(), kKey.size()));
+        std::vector<uint8_t> keystream(0xff02 * rtp::kAesBlockSize, 0);
+        aes.Ctr(kCounter.data(), keystream.data(), keystream.size());
+        for (const Block& block : kBlocks) {
+            std::vector<uint8_t> expected = FromHex(block.keystream);
+            EXPECT(std::memcmp(keystream.data() + block.index * rtp::kAesBlockSize,
+                               expected.data(), expected.size()) == 0);
+        }
+    }
+
+    // RFC 3711 B.3: the session keys derived from the master key and salt.
+    // The context keeps them private, so a packet protected by it is
+    // compared with one built from the published session keys.
+    void TestKeyDerivation() {
+        const std::vector<uint8_t> kMasterKey = FromHex("e1f97a0d3e018be0d64fa32c06de4139");
+        const std::vector<uint8_t> kMasterSalt = FromHex("0ec675ad498afeebb6960b3aabe6");
+        const std::vector<uint8_t> kCipherKey = FromHex("c61e7a93744f39ee10734afe3ff7a087");
+        const std::vector<uint8_t> kCipherSalt = FromHex("30cbbc08863d8c85d49db34a9ae1");
+        const std::vector<uint8_t> kAuthKey = FromHex("cebe321f6ff7716b6fd4ab49af256a156d38baa4");
+        const rtp::SrtpProfile kProfile = rtp::SrtpProfile::kAes128CmHmacSha1_80;
+        const uint32_t kRoc = 2;
+        const uint16_t kSequenceNumber = 0x1234;
+
+        rtp::SrtpContext sender;
+        EXPECT(sender.SetKey(kProfile, kMasterKey.data(), kMasterKey.size(),
+                             kMasterSalt.data(), kMasterSalt.size()));
+        sender.SetRolloverCounter(kSsrc, kRoc);
+        std::vector<uint8_t> packet = test::BuildRtpPacket(kSequenceNumber, 40, kSsrc);
+        size_t size = packet.size();
+        size_t header_size = 12;
+        std::vector<uint8_t> expected = packet;
+        packet.resize(size + rtp::SrtpRtpOverhead(kProfile));
+        EXPECT(sender.ProtectRtp(packet.data(), &size, packet.size()) == rtp::kSrtpOk);
+        EXPECT(size == packet.size());
+
+        // IV = (salt << 16) ^ (SSRC << 64) ^ (index << 16)
+        uint64_t index = (uint64_t(kRoc) << 16) | kSequenceNumber;
+        uint8_t iv[rtp::kAesBlockSize] = {};
+        std::memcpy(iv, kCipherSalt.data(), kCipherSalt.size());
+        for (int i = 0; i < 4; i++) {
+            iv[4 + i] ^= static_cast<uint8_t>(kSsrc >> (24 - 8 * i));
+        }
+        for (int i = 0; i < 6; i++) {
+            iv[8 + i] ^= static_cast<uint8_t>(index >> (40 - 8 * i));
+        }
+        rtp::Aes aes;
+        EXPECT(aes.SetKey(kCipherKey.data(), kCipherKey.size()));
+        aes.Ctr(iv, expected.data() + header_size, expected.size() - header_size);
+
+        // The tag is HMAC-SHA1 over the packet and the ROC, cut to 80 bits
+        const uint8_t roc[4] = {0, 0, 0, kRoc};
+        uint8_t mac[rtp::kSha1DigestSize];
+        rtp::HmacSha1 hmac;
+        hmac.SetKey(kAuthKey.data(), kAuthKey.size());
+        hmac.Begin();
+        hmac.Update(expected.data(), expected.size());
+        hmac.Update(roc, sizeof(roc));
+        hmac.Final(mac);
+        expected.insert(expected.end(), mac, mac + 10);
+
+        EXPECT(packet == expected);
+    }
+
+    // RFC 7714 16.1.1: AEAD_AES_128_GCM with the header as associated data
+    void TestAesGcm() {
+        const std::vector<uint8_t> kKey = FromHex("000102030405060708090a0b0c0d0e0f");
+        const std::vector<uint8_t> kIv = FromHex("51753c6580c2726f20718414");
+        const std::vector<uint8_t> kPlain = FromHex(
+            "8040f17b8041f8d35501a0b247616c6c696120657374206f6d6e697320646976"
+            "69736120696e207061727465732074726573");
+        const std::vector<uint8_t> kSealed = FromHex(
+            "8040f17b8041f8d35501a0b2f24de3a3fb34de6cacba861c9d7e4bcabe633bd5"
+            "0d294e6f42a5f47a51c7d19b36de3adf8833899d7f27beb16a9152cf765ee439"
+            "0cce");
+        const size_t kHeaderSize = 12;
+
+        rtp::AesGcm gcm;
+        EXPECT(gcm.SetKey(kKey.data(), kKey.size()));
+        std::vector<uint8_t> packet = kPlain;
+        packet.resize(kPlain.size() + rtp::kGcmTagSize);
+        gcm.Seal(kIv.data(), packet.data(), kHeaderSize, packet.data() + kHeaderSize,
+                 kPlain.size() - kHeaderSize, packet.data() + kPlain.size());
+        EXPECT(packet == kSealed);
+
+        EXPECT(gcm.Open(kIv.data(), packet.data(), kHeaderSize, packet.data() + kHeaderSize,
+                        kPlain.size() - kHeaderSize, packet.data() + kPlain.size()));
+        EXPECT(std::memcmp(packet.data(), kPlain.data(), kPlain.size()) == 0);
+
+        // A flipped tag bit leaves the ciphertext alone
+        std::vector<uint8_t> tampered = kSealed;
+        tampered.back() ^= 1;
+        EXPECT(!gcm.Open(kIv.data(), tampered.data(), kHeaderSize, tampered.data() + kHeaderSize,
+                         kPlain.size() - kHeaderSize, tampered.data() + kPlain.size()));
+        EXPECT(std::memcmp(tampered.data(), kSealed.data(), kPlain.size()) == 0);
+    }
+
+    // RFC 2202 section 3, with every message fed in two pieces
+    void TestHmacSha1() {
+        struct Case {
+            std::vector<uint8_t> key;
+            std::string data;
+            const char* digest;
+        };
+        const Case kCases[] = {
+            {std::vector<uint8_t>(20, 0x0b), "Hi There",
+             "b617318655057264e28bc0b6fb378c8ef146be00"},
+            {{'J', 'e', 'f', 'e'}, "what do ya want for nothing?",
+             "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79"},
+            {std::vector<uint8_t>(20, 0xaa), std::string(50, '\xdd'),
+             "125d7342b9ac11cd91a39af48aa17b4f63f175d3"},
+            {FromHex("0102030405060708090a0b0c0d0e0f10111213141516171819"), std::string(50, '\xcd'),
+             "4c9007f4026250c6bc8414f9bf50c86c2d7235da"},
+            {std::vector<uint8_t>(20, 0x0c), "Test With Truncation",
+             "4c1a03424b55e07fe7f27be1d58bb9324a9a5a04"},
+            {std::vector<uint8_t>(80, 0xaa), "Test Using Larger Than Block-Size Key - Hash Key First",
+             "aa4ae5e15272d00e95705637ce8a3b55ed402112"},
+            {std::vector<uint8_t>(80, 0xaa),
+             "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data",
+             "e8e99d0f45237d786d6bbaa7965c7808bbff1a91"},
+        };
+
+        for (const Case& test_case : kCases) {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(test_case.data.data());
+            size_t half = test_case.data.size() / 2;
+            uint8_t mac[rtp::kSha1DigestSize];
+            rtp::HmacSha1 hmac;
+            hmac.SetKey(test_case.key.data(), test_case.key.size());
+            hmac.Begin();
+            hmac.Update(data, half);
+            hmac.Update(data + half, test_case.data.size() - half);
+            hmac.Final(mac);
+            EXPECT(std::vector<uint8_t>(mac, mac + sizeof(mac)) == FromHex(test_case.digest));
+        }
+    }
+
+    // Protects count packets numbered by sequencer and unprotects them with
+    // a fresh receiver
+    void RoundTrip(rtp::SrtpProfile profile, std::shared_ptr<rtp::Sequencer> sequencer, int count) {
+        rtp::SrtpContext sender;
+        rtp::SrtpContext receiver;
+        EXPECT(sender.SetKey(profile, kMasterKey, rtp::SrtpMasterKeySize(profile),
+                             kMasterSalt, rtp::SrtpMasterSaltSize(profile)));
+        EXPECT(receiver.SetKey(profile, kMasterKey, rtp::SrtpMasterKeySize(profile),
+                               kMasterSalt, rtp::SrtpMasterSaltSize(profile)));
+        sender.AttachSequencer(kSsrc, sequencer);
+
+        for (int i = 0; i < count; i++) {
+            std::vector<uint8_t> packet = test::BuildRtpPacket(sequencer->NextSequenceNumber(), 100, kSsrc);
+            std::vector<uint8_t> original = packet;
+            size_t size = packet.size();
+            packet.resize(size + rtp::SrtpRtpOverhead(profile));
+
+            EXPECT(sender.ProtectRtp(packet.data(), &size, packet.size()) == rtp::kSrtpOk);
+            EXPECT(receiver.UnprotectRtp(packet.data(), &size) == rtp::kSrtpOk);
+            EXPECT(size == original.size());
+            EXPECT(std::memcmp(packet.data(), original.data(), size) == 0);
+        }
+        EXPECT(sender.RolloverCounter(kSsrc) == receiver.RolloverCounter(kSsrc));
+    }
+}
+
+int main() {
+    TestAesCmKeystream();
+    TestKeyDerivation();
+    TestAesGcm();
+    TestHmacSha1();
+
+    // The first packet of an attached sequencer has ROC 0, whatever its
+    // sequence number
+    RoundTrip(rtp::SrtpProfile::kAes128CmHmacSha1_80, std::make_shared<rtp::FixedSequencer>(0), 10);
+    RoundTrip(rtp::SrtpProfile::kAeadAes128Gcm, std::make_shared<rtp::FixedSequencer>(0), 10);
+    RoundTrip(rtp::SrtpProfile::kAes128CmHmacSha1_80, std::make_shared<rtp::RandomSequencer>(), 10);
+
+    // And the ROC advances as the sequence number wraps
+    RoundTrip(rtp::SrtpProfile::kAes128CmHmacSha1_80, std::make_shared<rtp::FixedSequencer>(65530), 20);
+
+    std::printf("srtp_context_test passed\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "stream_framing.h"
+#include "test_util.h"
+
+namespace {
+
+    // Appends packet to stream with the framing header in front of it
+    void AppendFramed(rtp::StreamFraming framing, uint8_t channel,
+                      const std::vector<uint8_t>& packet, std::vector<uint8_t>* stream) {
+        size_t header_size = rtp::FrameHeaderSize(framing);
+        size_t offset = stream->size();
+        stream->resize(offset + header_size);
+        stream->insert(stream->end(), packet.begin(), packet.end());
+        EXPECT(rtp::WriteFrameHeader(framing, channel, stream->data() + offset + header_size, packet.size()));
+    }
+
+    void AppendText(const std::string& text, std::vector<uint8_t>* stream) {
+        stream->insert(stream->end(), text.begin(), text.end());
+    }
+
+    std::vector<uint8_t> ToBytes(const rtp::FramedPacket& packet) {
+        return std::vector<uint8_t>(packet.data, packet.data + packet.size);
+    }
+
+    // Packets written in random chunks come back whole and in order, also
+    // those that wrap around the end of the ring
+    void TestRfc4571() {
+        const rtp::StreamFraming kFraming = rtp::StreamFraming::kRfc4571;
+        rtp::StreamDeframer deframer(kFraming, 0);
+        std::mt19937 random(5);
+
+        std::vector<std::vector<uint8_t>> packets;
+        std::vector<uint8_t> stream;
+        size_t total = 0;
+        while (total < 3 * deframer.Capacity()) {
+            std::vector<uint8_t> packet = test::BuildRtpPacket(static_cast<uint16_t>(packets.size()),
+                                                               random() % 1400);
+            AppendFramed(kFraming, 0, packet, &stream);
+            total += packet.size();
+            packets.push_back(std::move(packet));
+        }
+        // Empty frames carry nothing and are skipped
+        stream.push_back(0);
+        stream.push_back(0);
+
+        size_t written = 0;
+        size_t next = 0;
+        rtp::FramedPacket packet;
+        while (written < stream.size()) {
+            size_t chunk = std::min<size_t>(stream.size() - written, 1 + random() % 3000);
+            written += deframer.Write(stream.data() + written, chunk);
+            while (deframer.Next(&packet)) {
+                EXPECT(next < packets.size());
+                EXPECT(packet.channel == 0);
+                EXPECT(ToBytes(packet) == packets[next]);
+                next++;
+            }
+        }
+        EXPECT(next == packets.size());
+        EXPECT(!deframer.Failed());
+        EXPECT(deframer.Buffered() == 0);
+        EXPECT(deframer.Stats().packets == packets.size());
+        EXPECT(deframer.Stats().wrapped_packets > 0);
+    }
+
+    // RTSP messages between interleaved packets are returned whole, with a
+    // body that may hold the interleaved magic byte, even byte by byte
+    void TestInterleaved() {
+        const rtp::StreamFraming kFraming = rtp::StreamFraming::kRtspInterleaved;
+        rtp::StreamDeframer deframer(kFraming);
+
+        const std::string kResponse = "RTSP/1.0 200 OK\r\nCSeq: 2\r\n\r\n";
+        const std::string kAnnounce = "ANNOUNCE rtsp://host/a RTSP/1.0\r\nCSeq: 3\r\n"
+                                      "content-length: 6\r\n\r\n$$\r\n\r\n";
+        std::vector<uint8_t> rtp = test::BuildRtpPacket(7, 100);
+        std::vector<uint8_t> rtcp = test::BuildRtpPacket(8, 20);
+
+        std::vector<uint8_t> stream;
+        AppendText(kResponse, &stream);
+        AppendFramed(kFraming, 0, rtp, &stream);
+        AppendText(kAnnounce, &stream);
+        AppendFramed(kFraming, 1, rtcp, &stream);
+
+        std::vector<rtp::FramedPacket> found;
+        std::vector<std::vector<uint8_t>> bytes;
+        rtp::FramedPacket packet;
+        for (uint8_t byte : stream) {
+            EXPECT(deframer.Write(&byte, 1) == 1);
+            while (deframer.Next(&packet)) {
+                found.push_back(packet);
+                bytes.push_back(ToBytes(packet));
+            }
+        }
+
+        EXPECT(found.size() == 4);
+        EXPECT(found[0].channel == rtp::kRtspMessageChannel);
+        EXPECT(bytes[0] == std::vector<uint8_t>(kResponse.begin(), kResponse.end()));
+        EXPECT(found[1].channel == 0 && bytes[1] == rtp);
+        EXPECT(found[2].channel == rtp::kRtspMessageChannel);
+        EXPECT(bytes[2] == std::vector<uint8_t>(kAnnounce.begin(), kAnnounce.end()));
+        EXPECT(found[3].channel == 1 && bytes[3] == rtcp);
+        EXPECT(deframer.Stats().rtsp_messages == 2);
+        EXPECT(deframer.Stats().packets == 2);
+
+        // A header that never ends breaks the framing until Reset()
+        std::vector<uint8_t> endless(9000, 'a');
+        deframer.Write(endless.data(), endless.size());
+        EXPECT(!deframer.Next(&packet));
+        EXPECT(deframer.Failed());
+        deframer.Reset();
+        EXPECT(!deframer.Failed() && deframer.Buffered() == 0);
+    }
+
+    // Packets with exactly the header size as headroom frame into one span
+    void TestFrameArena() {
+        const rtp::StreamFraming kFraming = rtp::StreamFraming::kRtspInterleaved;
+        const size_t kHeadroom = rtp::kInterleavedHeaderSize;
+        std::vector<uint8_t> data;
+        std::vector<size_t> offsets = {0};
+        for (int i = 0; i < 3; i++) {
+            data.resize(data.size() + kHeadroom);
+            std::vector<uint8_t> packet = test::BuildRtpPacket(static_cast<uint16_t>(i), 50 + i);
+            data.insert(data.end(), packet.begin(), packet.end());
+            offsets.push_back(data.size());
+        }
+
+        std::vector<rtp::StreamSpan> spans;
+        EXPECT(rtp::FrameArena(kFraming, 2, &data, offsets, kHeadroom, 0, &spans));
+        EXPECT(spans.size() == 1);
+        EXPECT(spans[0].data == data.data() && spans[0].size == data.size());
+
+        rtp::StreamDeframer deframer(kFraming);
+        EXPECT(deframer.Write(spans[0].data, spans[0].size) == spans[0].size);
+        rtp::FramedPacket packet;
+        for (int i = 0; i < 3; i++) {
+            EXPECT(deframer.Next(&packet));
+            EXPECT(packet.channel == 2 && packet.size == 12 + 50 + static_cast<size_t>(i));
+            EXPECT(test::SequenceNumber(packet.data) == i);
+        }
+        EXPECT(!deframer.Next(&packet));
+
+        // Too little headroom for the header
+        EXPECT(!rtp::FrameArena(kFraming, 2, &data, offsets, kHeadroom - 1, 0, &spans));
+    }
+}
+
+int main() {
+    TestRfc4571();
+    TestInterleaved();
+    TestFrameArena();
+
+    std::printf("stream_framing_test passed\n");
+    return 0;
+}
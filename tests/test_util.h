@@ -0,0 +1,48 @@
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Exit code of a test that cannot run here, e.g. without io_uring
+#define TEST_SKIPPED 77
+
+// Fails the test binary with the location of the first broken expectation
+#define EXPECT(condition)                                                       \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                       \
+        }                                                                       \
+    } while (0)
+
+namespace test {
+
+    // RTP packet with a fixed 12-byte header and payload_size bytes counting
+    // up from 0
+    inline std::vector<uint8_t> BuildRtpPacket(uint16_t sequence_number, size_t payload_size,
+                                               uint32_t ssrc = 0, uint8_t payload_type = 96) {
+        std::vector<uint8_t> packet(12 + payload_size, 0);
+        packet[0] = 0x80;
+        packet[1] = payload_type;
+        packet[2] = static_cast<uint8_t>(sequence_number >> 8);
+        packet[3] = static_cast<uint8_t>(sequence_number);
+        packet[8] = static_cast<uint8_t>(ssrc >> 24);
+        packet[9] = static_cast<uint8_t>(ssrc >> 16);
+        packet[10] = static_cast<uint8_t>(ssrc >> 8);
+        packet[11] = static_cast<uint8_t>(ssrc);
+        for (size_t i = 0; i < payload_size; i++) {
+            packet[12 + i] = static_cast<uint8_t>(i);
+        }
+        return packet;
+    }
+
+    // Sequence number of an RTP packet
+    inline uint16_t SequenceNumber(const uint8_t* packet) {
+        return static_cast<uint16_t>((packet[2] << 8) | packet[3]);
+    }
+}
+
+#endif // TEST_UTIL_H_
@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "udp_transport.h"
+#include "test_util.h"
+
+namespace {
+
+    sockaddr_in Loopback() {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    // Receives until count datagrams carrying a running packet number have
+    // arrived; returns how many of them were out of order
+    uint32_t ReceiveNumbered(rtp::UdpTransport* receiver, uint32_t count, uint32_t* received) {
+        uint32_t out_of_order = 0;
+        for (int i = 0; i < 1000 && *received < count; i++) {
+            int n = receiver->Receive(true);
+            EXPECT(n >= 0);
+            for (const rtp::UdpDatagram& datagram : receiver->Datagrams()) {
+                uint32_t number = 0;
+                EXPECT(datagram.size >= sizeof(number));
+                std::memcpy(&number, datagram.data, sizeof(number));
+                out_of_order += number != *received;
+                (*received)++;
+            }
+        }
+        return out_of_order;
+    }
+
+    // A frame of equally sized packets and a shorter last one, as packetizers
+    // produce, arrives whole and in order with or without GSO and GRO
+    bool TestFrames(bool offload) {
+        const int kFrames = 10;
+        const int kPacketsPerFrame = 50;
+
+        rtp::UdpTransportConfig config;
+        config.enable_gro = offload;
+        config.enable_gso = offload;
+        rtp::UdpTransport sender(config);
+        rtp::UdpTransport receiver(config);
+        sockaddr_in local = Loopback();
+        if (!sender.Open(reinterpret_cast<sockaddr*>(&local), sizeof(local)) ||
+            !receiver.Open(reinterpret_cast<sockaddr*>(&local), sizeof(local))) {
+            return false;
+        }
+        sockaddr_storage peer;
+        socklen_t peer_size = 0;
+        EXPECT(receiver.LocalAddress(&peer, &peer_size));
+        sender.SetPeer(reinterpret_cast<sockaddr*>(&peer), peer_size);
+
+        std::vector<std::vector<uint8_t>> packets(kPacketsPerFrame);
+        std::vector<iovec> iov(kPacketsPerFrame);
+        uint32_t sent = 0;
+        uint32_t received = 0;
+        uint32_t out_of_order = 0;
+        for (int frame = 0; frame < kFrames; frame++) {
+            for (int i = 0; i < kPacketsPerFrame; i++) {
+                packets[i].assign(i + 1 < kPacketsPerFrame ? 1200 : 300, static_cast<uint8_t>(i));
+                std::memcpy(packets[i].data(), &sent, sizeof(sent));
+                iov[i].iov_base = packets[i].data();
+                iov[i].iov_len = packets[i].size();
+                sent++;
+            }
+            EXPECT(sender.Send(iov.data(), iov.size()) == kPacketsPerFrame);
+            out_of_order += ReceiveNumbered(&receiver, sent, &received);
+        }
+
+        EXPECT(received == sent);
+        EXPECT(out_of_order == 0);
+        EXPECT(receiver.Stats().packets_received == sent);
+        EXPECT(receiver.Stats().receive_truncated == 0);
+        return true;
+    }
+
+    // A datagram larger than a receive slot is dropped and counted, and the
+    // datagrams after it still arrive
+    void TestTruncated() {
+        rtp::UdpTransportConfig config;
+        config.enable_gro = false;
+        rtp::UdpTransport receiver(config);
+        sockaddr_in local = Loopback();
+        EXPECT(receiver.Open(reinterpret_cast<sockaddr*>(&local), sizeof(local)));
+        sockaddr_storage address;
+        socklen_t address_size = 0;
+        EXPECT(receiver.LocalAddress(&address, &address_size));
+
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        EXPECT(fd >= 0);
+        static const uint8_t kLarge[4000] = {};
+        uint32_t number = 0;
+        EXPECT(sendto(fd, kLarge, sizeof(kLarge), 0, reinterpret_cast<sockaddr*>(&address),
+                      address_size) == static_cast<ssize_t>(sizeof(kLarge)));
+        EXPECT(sendto(fd, &number, sizeof(number), 0, reinterpret_cast<sockaddr*>(&address),
+                      address_size) == static_cast<ssize_t>(sizeof(number)));
+        close(fd);
+
+        uint32_t received = 0;
+        EXPECT(ReceiveNumbered(&receiver, 1, &received) == 0);
+        EXPECT(received == 1);
+        EXPECT(receiver.Stats().receive_truncated == 1);
+        EXPECT(receiver.Stats().packets_received == 1);
+    }
+}
+
+int main() {
+    if (!TestFrames(false)) {
+        std::printf("udp_transport_test skipped: UDP sockets are not available\n");
+        return TEST_SKIPPED;
+    }
+    EXPECT(TestFrames(true));
+    TestTruncated();
+
+    std::printf("udp_transport_test passed\n");
+    return 0;
+}
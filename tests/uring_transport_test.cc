@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "uring_transport.h"
+#include "test_util.h"
+
+namespace {
+
+    // Records the datagrams received, which carry a running packet number
+    class CountingHandler : public rtp::DatagramHandler {
+    public:
+        void OnDatagram(const uint8_t* data, size_t size,
+                        const sockaddr* /*source*/, socklen_t /*source_size*/) override {
+            uint32_t number = 0;
+            if (size >= sizeof(number)) {
+                std::memcpy(&number, data, sizeof(number));
+            }
+            out_of_order += number != received;
+            received++;
+        }
+
+        uint32_t received = 0;
+        uint32_t out_of_order = 0;
+    };
+
+    sockaddr_in Loopback() {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    // A frame of packets costs one system call, and arrives whole and in order
+    bool TestFrames() {
+        const int kFrames = 20;
+        const int kPacketsPerFrame = 100;
+
+        rtp::UringTransport sender;
+        rtp::UringTransport receiver;
+        sockaddr_in local = Loopback();
+        if (!sender.Open(reinterpret_cast<sockaddr*>(&local), sizeof(local)) ||
+            !receiver.Open(reinterpret_cast<sockaddr*>(&local), sizeof(local))) {
+            return false;
+        }
+        sockaddr_storage peer;
+        socklen_t peer_size = 0;
+        EXPECT(receiver.LocalAddress(&peer, &peer_size));
+        EXPECT(sender.Connect(reinterpret_cast<sockaddr*>(&peer), peer_size));
+
+        CountingHandler handler;
+        uint32_t sent = 0;
+        uint64_t enters = sender.Stats().ring_enters;
+        for (int frame = 0; frame < kFrames; frame++) {
+            for (int i = 0; i < kPacketsPerFrame; i++) {
+                uint8_t* packet = sender.Begin(200);
+                std::memcpy(packet, &sent, sizeof(sent));
+                EXPECT(sender.Commit(200));
+                sent++;
+            }
+            EXPECT(sender.Flush());
+            while (receiver.Poll(&handler, false) > 0) {
+            }
+        }
+        EXPECT(sender.Stats().ring_enters - enters <= kFrames + 2);
+
+        for (int i = 0; i < 100 && handler.received < sent; i++) {
+            EXPECT(receiver.Poll(&handler, false) >= 0);
+        }
+        EXPECT(handler.received == sent);
+        EXPECT(handler.out_of_order == 0);
+
+        EXPECT(sender.Poll(&handler, false) >= 0);
+        EXPECT(sender.Stats().packets_sent == sent);
+        EXPECT(sender.Stats().send_errors == 0);
+        return true;
+    }
+
+    // A datagram larger than a receive buffer is dropped and counted, and
+    // the buffer goes back to the kernel
+    void TestTruncated() {
+        rtp::UringTransport receiver;
+        sockaddr_in local = Loopback();
+        EXPECT(receiver.Open(reinterpret_cast<sockaddr*>(&local), sizeof(local)));
+        sockaddr_storage address;
+        socklen_t address_size = 0;
+        EXPECT(receiver.LocalAddress(&address, &address_size));
+
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        EXPECT(fd >= 0);
+        static const uint8_t kLarge[4000] = {};
+        uint32_t number = 0;
+        EXPECT(sendto(fd, kLarge, sizeof(kLarge), 0, reinterpret_cast<sockaddr*>(&address),
+                      address_size) == static_cast<ssize_t>(sizeof(kLarge)));
+        EXPECT(sendto(fd, &number, sizeof(number), 0, reinterpret_cast<sockaddr*>(&address),
+                      address_size) == static_cast<ssize_t>(sizeof(number)));
+        close(fd);
+
+        CountingHandler handler;
+        for (int i = 0; i < 100 && handler.received == 0; i++) {
+            EXPECT(receiver.Poll(&handler, false) >= 0);
+        }
+        EXPECT(handler.received == 1);
+        EXPECT(handler.out_of_order == 0);
+        EXPECT(receiver.Stats().receive_truncated == 1);
+        EXPECT(receiver.Stats().packets_received == 1);
+    }
+}
+
+int main() {
+    if (!TestFrames()) {
+        std::printf("uring_transport_test skipped: io_uring is not available\n");
+        return TEST_SKIPPED;
+    }
+    TestTruncated();
+
+    std::printf("uring_transport_test passed\n");
+    return 0;
+}
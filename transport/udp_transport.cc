@@ -0,0 +1,317 @@
+#include "udp_transport.h"
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <unistd.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+namespace rtp {
+
+namespace {
+
+    // Kernel limits of one GSO message
+    constexpr size_t kMaxGsoSegments = 64;
+    constexpr size_t kMaxGsoBytes = 65000;
+
+    // Receive slot size with GRO, the largest coalesced datagram
+    constexpr size_t kGroSlotSize = 65536;
+
+    constexpr size_t kSegmentControlSize = CMSG_SPACE(sizeof(uint16_t));
+    constexpr size_t kGroControlSize = CMSG_SPACE(sizeof(int));
+}
+
+UdpTransport::UdpTransport(const UdpTransportConfig& config) : config_(config) {
+    if (config_.batch_size == 0) {
+        config_.batch_size = 1;
+    }
+}
+
+UdpTransport::~UdpTransport() {
+    Close();
+}
+
+bool UdpTransport::Open(const sockaddr* local, socklen_t local_size) {
+    Close();
+    if (!local) {
+        return false;
+    }
+
+    fd_ = socket(local->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (bind(fd_, local, local_size) != 0) {
+        int error = errno;
+        Close();
+        errno = error;
+        return false;
+    }
+
+    int on = 1;
+    gro_enabled_ = config_.enable_gro &&
+                   setsockopt(fd_, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == 0;
+
+    // Kernels without UDP_SEGMENT reject the option query
+    int segment = 0;
+    socklen_t segment_size = sizeof(segment);
+    gso_enabled_ = config_.enable_gso &&
+                   getsockopt(fd_, IPPROTO_UDP, UDP_SEGMENT, &segment, &segment_size) == 0;
+
+    // Receive batch, one slot per datagram or GRO super-datagram
+    size_t batch = config_.batch_size;
+    slot_size_ = gro_enabled_ ? kGroSlotSize : config_.max_datagram_size;
+    receive_buffer_.assign(batch * slot_size_, 0);
+    receive_messages_.assign(batch, mmsghdr());
+    receive_iov_.assign(batch, iovec());
+    sources_.assign(batch, sockaddr_storage());
+    receive_control_.assign(batch * kGroControlSize, 0);
+    datagrams_.clear();
+    datagrams_.reserve(gro_enabled_ ? batch * kMaxGsoSegments : batch);
+
+    // Send batch
+    iov_.assign(batch, iovec());
+    send_messages_.assign(batch, mmsghdr());
+    message_packets_.assign(batch, 0);
+    send_control_.assign(batch * kSegmentControlSize, 0);
+    return true;
+}
+
+void UdpTransport::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    gro_enabled_ = false;
+    gso_enabled_ = false;
+}
+
+void UdpTransport::SetPeer(const sockaddr* peer, socklen_t peer_size) {
+    if (!peer || peer_size > sizeof(peer_)) {
+        peer_size_ = 0;
+        return;
+    }
+    std::memcpy(&peer_, peer, peer_size);
+    peer_size_ = peer_size;
+}
+
+bool UdpTransport::LocalAddress(sockaddr_storage* address, socklen_t* size) const {
+    if (fd_ < 0 || !address || !size) {
+        return false;
+    }
+    *size = sizeof(*address);
+    return getsockname(fd_, reinterpret_cast<sockaddr*>(address), size) == 0;
+}
+
+int UdpTransport::Receive(bool wait) {
+    datagrams_.clear();
+    if (fd_ < 0) {
+        errno = EBADF;
+        return -1;
+    }
+
+    size_t batch = receive_messages_.size();
+    for (size_t i = 0; i < batch; i++) {
+        receive_iov_[i].iov_base = receive_buffer_.data() + i * slot_size_;
+        receive_iov_[i].iov_len = slot_size_;
+
+        msghdr& header = receive_messages_[i].msg_hdr;
+        header.msg_name = &sources_[i];
+        header.msg_namelen = sizeof(sources_[i]);
+        header.msg_iov = &receive_iov_[i];
+        header.msg_iovlen = 1;
+        header.msg_control = receive_control_.data() + i * kGroControlSize;
+        header.msg_controllen = gro_enabled_ ? kGroControlSize : 0;
+        header.msg_flags = 0;
+        receive_messages_[i].msg_len = 0;
+    }
+
+    int received = recvmmsg(fd_, receive_messages_.data(), static_cast<unsigned int>(batch),
+                            wait ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < received; i++) {
+        msghdr& header = receive_messages_[i].msg_hdr;
+        uint8_t* data = static_cast<uint8_t*>(receive_iov_[i].iov_base);
+        size_t size = receive_messages_[i].msg_len;
+
+        // Only the start of a datagram larger than the slot was received
+        if (header.msg_flags & MSG_TRUNC) {
+            stats_.receive_truncated++;
+            continue;
+        }
+
+        // A GRO super-datagram carries equally sized segments, the last one
+        // possibly shorter
+        size_t segment_size = size;
+        if (gro_enabled_) {
+            for (cmsghdr* control = CMSG_FIRSTHDR(&header); control;
+                 control = CMSG_NXTHDR(&header, control)) {
+                if (control->cmsg_level == IPPROTO_UDP && control->cmsg_type == UDP_GRO) {
+                    int gso_size = 0;
+                    std::memcpy(&gso_size, CMSG_DATA(control), sizeof(gso_size));
+                    if (gso_size > 0) {
+                        segment_size = static_cast<size_t>(gso_size);
+                    }
+                }
+            }
+        }
+
+        for (size_t offset = 0; offset < size; offset += segment_size) {
+            UdpDatagram datagram;
+            datagram.data = data + offset;
+            datagram.size = size - offset < segment_size ? size - offset : segment_size;
+            datagram.source = &sources_[i];
+            datagrams_.push_back(datagram);
+        }
+        if (size == 0) {
+            UdpDatagram datagram;
+            datagram.data = data;
+            datagram.source = &sources_[i];
+            datagrams_.push_back(datagram);
+        }
+    }
+
+    stats_.packets_received += datagrams_.size();
+    return static_cast<int>(datagrams_.size());
+}
+
+int UdpTransport::SendBatch(size_t count) {
+    size_t sent = 0;
+
+    while (sent < count) {
+        // Group the remaining packets into messages: a run of equally sized
+        // packets, optionally ending in a shorter one, is one GSO message
+        size_t messages = 0;
+        size_t packet = sent;
+        while (packet < count) {
+            size_t segment_size = iov_[packet].iov_len;
+            size_t run = 1;
+            size_t bytes = segment_size;
+            if (gso_enabled_ && segment_size > 0) {
+                while (packet + run < count && run < kMaxGsoSegments) {
+                    size_t next = iov_[packet + run].iov_len;
+                    if (next == 0 || next > segment_size || bytes + next > kMaxGsoBytes) {
+                        break;
+                    }
+                    bytes += next;
+                    run++;
+                    if (next < segment_size) {
+                        break;
+                    }
+                }
+            }
+
+            msghdr& header = send_messages_[messages].msg_hdr;
+            header.msg_name = peer_size_ ? &peer_ : nullptr;
+            header.msg_namelen = peer_size_;
+            header.msg_iov = &iov_[packet];
+            header.msg_iovlen = run;
+            header.msg_control = nullptr;
+            header.msg_controllen = 0;
+            header.msg_flags = 0;
+
+            if (run > 1) {
+                uint8_t* control_buffer = send_control_.data() + messages * kSegmentControlSize;
+                std::memset(control_buffer, 0, kSegmentControlSize);
+                header.msg_control = control_buffer;
+                header.msg_controllen = kSegmentControlSize;
+                cmsghdr* control = CMSG_FIRSTHDR(&header);
+                control->cmsg_level = IPPROTO_UDP;
+                control->cmsg_type = UDP_SEGMENT;
+                control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t gso_size = static_cast<uint16_t>(segment_size);
+                std::memcpy(CMSG_DATA(control), &gso_size, sizeof(gso_size));
+            }
+
+            message_packets_[messages] = run;
+            messages++;
+            packet += run;
+        }
+
+        int result = sendmmsg(fd_, send_messages_.data(), static_cast<unsigned int>(messages), 0);
+        if (result < 0) {
+            if ((errno == EIO || errno == EINVAL) && gso_enabled_) {
+                // The device cannot segment, fall back to one datagram each
+                gso_enabled_ = false;
+                continue;
+            }
+            if (sent > 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            return sent > 0 ? static_cast<int>(sent) : -1;
+        }
+
+        for (int i = 0; i < result; i++) {
+            sent += message_packets_[i];
+        }
+        if (static_cast<size_t>(result) < messages) {
+            // Socket buffer full; leave the rest to the caller
+            break;
+        }
+    }
+
+    return static_cast<int>(sent);
+}
+
+template <typename Fill>
+int UdpTransport::SendPackets(size_t count, const Fill& fill) {
+    if (fd_ < 0) {
+        errno = EBADF;
+        return -1;
+    }
+
+    size_t batch = iov_.size();
+    size_t sent = 0;
+    while (sent < count) {
+        size_t chunk = count - sent < batch ? count - sent : batch;
+        for (size_t i = 0; i < chunk; i++) {
+            fill(sent + i, &iov_[i]);
+        }
+        int result = SendBatch(chunk);
+        if (result < 0) {
+            return sent > 0 ? static_cast<int>(sent) : -1;
+        }
+        sent += static_cast<size_t>(result);
+        if (static_cast<size_t>(result) < chunk) {
+            break;
+        }
+    }
+    return static_cast<int>(sent);
+}
+
+int UdpTransport::Send(const iovec* packets, size_t count) {
+    return SendPackets(count, [packets](size_t index, iovec* iov) {
+        *iov = packets[index];
+    });
+}
+
+int UdpTransport::Send(const PacketBuffer* packets, size_t count) {
+    return SendPackets(count, [packets](size_t index, iovec* iov) {
+        iov->iov_base = const_cast<uint8_t*>(packets[index].data());
+        iov->iov_len = packets[index].size();
+    });
+}
+
+int UdpTransport::Send(const std::vector<uint8_t>& packet_data, const std::vector<size_t>& packet_offsets,
+                       size_t headroom, size_t tailroom) {
+    if (packet_offsets.size() < 2) {
+        return 0;
+    }
+    return SendPackets(packet_offsets.size() - 1, [&](size_t index, iovec* iov) {
+        size_t begin = packet_offsets[index] + headroom;
+        size_t end = packet_offsets[index + 1] - tailroom;
+        iov->iov_base = const_cast<uint8_t*>(packet_data.data() + begin);
+        iov->iov_len = end - begin;
+    });
+}
+
+} // namespace rtp
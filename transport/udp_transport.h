@@ -0,0 +1,120 @@
+#ifndef UDP_TRANSPORT_H_
+#define UDP_TRANSPORT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "buffer_pool.h"
+
+namespace rtp {
+
+// UdpTransportConfig sizes the preallocated batches of a UdpTransport
+struct UdpTransportConfig {
+    size_t batch_size = 32;             // Datagrams per recvmmsg/sendmmsg call
+    size_t max_datagram_size = 1500;    // Receive buffer per datagram without GRO
+    bool enable_gro = true;             // Coalesce received datagrams (UDP_GRO)
+    bool enable_gso = true;             // Segment sent packets in the kernel (UDP_SEGMENT)
+};
+
+// Counters of one UdpTransport
+struct UdpTransportStats {
+    uint64_t packets_received = 0;
+    uint64_t receive_truncated = 0;     // Datagrams larger than a receive slot, dropped
+};
+
+// One received datagram; data points into the transport's receive buffers
+// and stays valid until the next Receive()
+struct UdpDatagram {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    const sockaddr_storage* source = nullptr;
+};
+
+// UdpTransport moves RTP/RTCP packets over a Linux UDP socket in batches.
+// Receive() fills preallocated buffers with one recvmmsg call and splits GRO
+// coalesced datagrams back into packets. Send() hands a whole frame's packets
+// to the kernel with one sendmmsg call; runs of equally sized packets, as
+// packetizers produce for fragmented frames, go out as one UDP_SEGMENT
+// (GSO) message each. GRO and GSO are only used when the kernel supports
+// them. Nothing is allocated after Open().
+class UdpTransport {
+public:
+    explicit UdpTransport(const UdpTransportConfig& config = UdpTransportConfig());
+    ~UdpTransport();
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // Creates the socket bound to local; port 0 picks a free port
+    bool Open(const sockaddr* local, socklen_t local_size);
+    void Close();
+
+    // Default destination of Send()
+    void SetPeer(const sockaddr* peer, socklen_t peer_size);
+
+    // Receives every datagram that is ready, at most batch_size before GRO
+    // splitting. With wait the call blocks until at least one arrives.
+    // Datagrams that did not fit a receive slot are dropped and counted.
+    // Returns the number of datagrams, or -1 with errno set.
+    int Receive(bool wait);
+    const std::vector<UdpDatagram>& Datagrams() const { return datagrams_; }
+
+    // Sends count packets to the peer in order. Returns the number of
+    // packets sent, which is less than count if the socket would block, or
+    // -1 with errno set if nothing could be sent.
+    int Send(const iovec* packets, size_t count);
+    int Send(const PacketBuffer* packets, size_t count);
+
+    // Sends the packets of an RTPPacketizer arena (packet_data and
+    // packet_offsets) with the given headroom and tailroom around each
+    int Send(const std::vector<uint8_t>& packet_data, const std::vector<size_t>& packet_offsets,
+             size_t headroom = 0, size_t tailroom = 0);
+
+    // Accessors
+    int fd() const { return fd_; }
+    bool gro_enabled() const { return gro_enabled_; }
+    bool gso_enabled() const { return gso_enabled_; }
+    const UdpTransportStats& Stats() const { return stats_; }
+
+    // Local address after Open(), e.g. to learn the chosen port
+    bool LocalAddress(sockaddr_storage* address, socklen_t* size) const;
+
+private:
+    // Sends count packets in batches; fill(index, iov) describes a packet
+    template <typename Fill>
+    int SendPackets(size_t count, const Fill& fill);
+
+    // Sends packets [0, count) of iov_ grouped into GSO messages
+    int SendBatch(size_t count);
+
+    UdpTransportConfig config_;
+    int fd_ = -1;
+    bool gro_enabled_ = false;
+    bool gso_enabled_ = false;
+
+    sockaddr_storage peer_ = {};
+    socklen_t peer_size_ = 0;
+
+    // Receive batch
+    size_t slot_size_ = 0;
+    std::vector<uint8_t> receive_buffer_;
+    std::vector<mmsghdr> receive_messages_;
+    std::vector<iovec> receive_iov_;
+    std::vector<sockaddr_storage> sources_;
+    std::vector<uint8_t> receive_control_;
+    std::vector<UdpDatagram> datagrams_;
+
+    // Send batch
+    std::vector<iovec> iov_;
+    std::vector<mmsghdr> send_messages_;
+    std::vector<size_t> message_packets_;
+    std::vector<uint8_t> send_control_;
+
+    UdpTransportStats stats_;
+};
+
+} // namespace rtp
+
+#endif // UDP_TRANSPORT_H_
@@ -0,0 +1,534 @@
+#include "uring_transport.h"
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace rtp {
+
+namespace {
+
+    // user_data of the receive and of each send, which carries its buffer
+    constexpr uint64_t kReceiveTag = uint64_t(1) << 63;
+    constexpr uint64_t kSendTag = uint64_t(1) << 62;
+
+    // Provided buffer group of the receive buffers
+    constexpr uint16_t kBufferGroup = 0;
+
+    int SetupSyscall(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int EnterSyscall(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                                        flags, nullptr, 0));
+    }
+
+    int RegisterSyscall(int fd, unsigned opcode, const void* arg, unsigned count) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    void* MapAnonymous(size_t size) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    size_t RoundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+UringTransport::UringTransport(const UringTransportConfig& config) : config_(config) {
+    config_.receive_buffers = RoundUpPowerOfTwo(config_.receive_buffers == 0 ? 1 : config_.receive_buffers);
+    // Buffer ids are 16 bits
+    if (config_.receive_buffers > 32768) {
+        config_.receive_buffers = 32768;
+    }
+    if (config_.send_buffers == 0) {
+        config_.send_buffers = 1;
+    }
+}
+
+UringTransport::~UringTransport() {
+    Close();
+}
+
+bool UringTransport::Open(const sockaddr* local, socklen_t local_size) {
+    Close();
+    if (!local) {
+        return false;
+    }
+
+    socket_fd_ = socket(local->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (socket_fd_ < 0) {
+        return false;
+    }
+    if (bind(socket_fd_, local, local_size) != 0 || !SetupRing() || !SetupBuffers() ||
+        !ArmReceive() || Submit(0, false) < 0) {
+        int error = errno;
+        Close();
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+void UringTransport::Close() {
+    TeardownRing();
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+        socket_fd_ = -1;
+    }
+    connected_ = false;
+}
+
+bool UringTransport::Connect(const sockaddr* peer, socklen_t peer_size) {
+    if (socket_fd_ < 0 || !peer) {
+        return false;
+    }
+    connected_ = connect(socket_fd_, peer, peer_size) == 0;
+    return connected_;
+}
+
+bool UringTransport::LocalAddress(sockaddr_storage* address, socklen_t* size) const {
+    if (socket_fd_ < 0 || !address || !size) {
+        return false;
+    }
+    *size = sizeof(*address);
+    return getsockname(socket_fd_, reinterpret_cast<sockaddr*>(address), size) == 0;
+}
+
+bool UringTransport::SetupRing() {
+    // Completions are only processed when this thread enters the kernel,
+    // which Poll() always does; older kernels get a plain ring
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    ring_fd_ = SetupSyscall(config_.ring_entries, &params);
+    defer_taskrun_ = ring_fd_ >= 0;
+    if (ring_fd_ < 0) {
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = SetupSyscall(config_.ring_entries, &params);
+        if (ring_fd_ < 0) {
+            return false;
+        }
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+        sq_ring_size_ = cq_ring_size_ = sq_ring_size_ > cq_ring_size_ ? sq_ring_size_ : cq_ring_size_;
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        return false;
+    }
+    if (single_map) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+    sq_submitted_ = sq_local_tail_;
+
+    uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    return true;
+}
+
+bool UringTransport::SetupBuffers() {
+    // Receive buffers, handed to the kernel through a provided buffer ring
+    receive_count_ = config_.receive_buffers;
+    receive_memory_size_ = receive_count_ * config_.receive_buffer_size;
+    receive_memory_ = static_cast<uint8_t*>(MapAnonymous(receive_memory_size_));
+    buffer_ring_size_ = receive_count_ * sizeof(io_uring_buf);
+    buffer_ring_ = static_cast<io_uring_buf_ring*>(MapAnonymous(buffer_ring_size_));
+    if (!receive_memory_ || !buffer_ring_) {
+        return false;
+    }
+
+    io_uring_buf_reg registration;
+    std::memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = reinterpret_cast<uint64_t>(buffer_ring_);
+    registration.ring_entries = static_cast<uint32_t>(receive_count_);
+    registration.bgid = kBufferGroup;
+    if (RegisterSyscall(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) != 0) {
+        return false;
+    }
+
+    buffer_ring_tail_ = 0;
+    for (size_t i = 0; i < receive_count_; i++) {
+        RecycleBuffer(static_cast<uint16_t>(i));
+    }
+    deferred_.clear();
+    deferred_.reserve(receive_count_);
+
+    // Every receive buffer starts with the recvmsg header and the source
+    // address, followed by the datagram
+    std::memset(&receive_header_, 0, sizeof(receive_header_));
+    receive_header_.msg_namelen = sizeof(sockaddr_storage);
+
+    // Send buffers, registered once as fixed buffer 0
+    send_memory_size_ = config_.send_buffers * config_.send_buffer_size;
+    send_memory_ = static_cast<uint8_t*>(MapAnonymous(send_memory_size_));
+    if (!send_memory_) {
+        return false;
+    }
+    iovec region;
+    region.iov_base = send_memory_;
+    region.iov_len = send_memory_size_;
+    if (RegisterSyscall(ring_fd_, IORING_REGISTER_BUFFERS, &region, 1) != 0) {
+        return false;
+    }
+
+    free_send_buffers_.clear();
+    free_send_buffers_.reserve(config_.send_buffers);
+    for (size_t i = config_.send_buffers; i > 0; i--) {
+        free_send_buffers_.push_back(static_cast<uint32_t>(i - 1));
+    }
+    pending_buffer_ = -1;
+    return true;
+}
+
+void UringTransport::TeardownRing() {
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (buffer_ring_) {
+        munmap(buffer_ring_, buffer_ring_size_);
+        buffer_ring_ = nullptr;
+    }
+    if (receive_memory_) {
+        munmap(receive_memory_, receive_memory_size_);
+        receive_memory_ = nullptr;
+    }
+    if (send_memory_) {
+        munmap(send_memory_, send_memory_size_);
+        send_memory_ = nullptr;
+    }
+    receive_armed_ = false;
+    pending_buffer_ = -1;
+    sends_queued_ = 0;
+    sends_in_flight_ = 0;
+}
+
+io_uring_sqe* UringTransport::GetSqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sq_local_tail_ - head >= sq_entries_) {
+        if (Submit(0, false) < 0) {
+            return nullptr;
+        }
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_local_tail_ - head >= sq_entries_) {
+            return nullptr;
+        }
+    }
+
+    unsigned index = sq_local_tail_ & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    sq_local_tail_++;
+    return sqe;
+}
+
+int UringTransport::Enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    int result;
+    do {
+        stats_.ring_enters++;
+        result = EnterSyscall(ring_fd_, to_submit, min_complete, flags);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0 && (errno == EAGAIN || errno == EBUSY)) {
+        // Completion queue full or out of memory, nothing was consumed; the
+        // caller reaps and retries
+        return 0;
+    }
+    return result;
+}
+
+int UringTransport::EnterPublished(unsigned min_complete, unsigned flags) {
+    // Only the entries the kernel consumed count as submitted; the rest stay
+    // in the queue for the next call
+    unsigned to_submit = *sq_tail_ - sq_submitted_;
+    int result = Enter(to_submit, min_complete, flags);
+    if (result > 0) {
+        unsigned consumed = static_cast<unsigned>(result);
+        sq_submitted_ += consumed < to_submit ? consumed : to_submit;
+    }
+    return result;
+}
+
+int UringTransport::Submit(unsigned min_complete, bool wait) {
+    // The sends of one submission are issued in order. A send that found
+    // the socket buffer full is retried later, and new sends would overtake
+    // it, so the previous frame completes first. Sends that went out inline
+    // already have their completions posted, so this rarely enters the
+    // kernel.
+    if (sends_queued_ > 0 && sends_in_flight_ > 0) {
+        Reap(nullptr);
+        while (sends_in_flight_ > 0) {
+            if (EnterPublished(1, IORING_ENTER_GETEVENTS) < 0) {
+                return -1;
+            }
+            Reap(nullptr);
+        }
+    }
+
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+    sends_in_flight_ += sends_queued_;
+    sends_queued_ = 0;
+
+    // Deferred task work only runs when completions are asked for
+    unsigned flags = (wait || defer_taskrun_) ? IORING_ENTER_GETEVENTS : 0;
+    if (sq_submitted_ == sq_local_tail_ && flags == 0) {
+        return 0;
+    }
+    int result = EnterPublished(wait ? min_complete : 0, flags);
+    if (result >= 0 && sq_submitted_ != sq_local_tail_) {
+        // A short submit: make room in the completion queue and retry the
+        // rest once; what is still left goes with the next Submit()
+        Reap(nullptr);
+        result = EnterPublished(0, defer_taskrun_ ? IORING_ENTER_GETEVENTS : 0);
+    }
+    return result;
+}
+
+bool UringTransport::ArmReceive() {
+    io_uring_sqe* sqe = GetSqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = socket_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&receive_header_);
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = kReceiveTag;
+    receive_armed_ = true;
+    return true;
+}
+
+void UringTransport::RecycleBuffer(uint16_t buffer_id) {
+    unsigned mask = static_cast<unsigned>(receive_count_ - 1);
+    // Index the entries directly: in C++ the header's flexible array member
+    // does not start at offset 0 of the ring
+    io_uring_buf* buffer = reinterpret_cast<io_uring_buf*>(buffer_ring_) + (buffer_ring_tail_ & mask);
+    buffer->addr = reinterpret_cast<uint64_t>(receive_memory_ + size_t(buffer_id) * config_.receive_buffer_size);
+    buffer->len = static_cast<uint32_t>(config_.receive_buffer_size);
+    buffer->bid = buffer_id;
+    buffer_ring_tail_++;
+    __atomic_store_n(&buffer_ring_->tail, static_cast<uint16_t>(buffer_ring_tail_), __ATOMIC_RELEASE);
+}
+
+bool UringTransport::HandleReceive(uint16_t buffer_id, uint32_t length, DatagramHandler* handler) {
+    uint8_t* buffer = receive_memory_ + size_t(buffer_id) * config_.receive_buffer_size;
+    const io_uring_recvmsg_out* out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+    size_t payload_offset = sizeof(*out) + receive_header_.msg_namelen + receive_header_.msg_controllen;
+
+    bool delivered = false;
+    if (out->flags & MSG_TRUNC) {
+        // Only the start of a datagram larger than the buffer was received
+        stats_.receive_truncated++;
+    } else if (length >= payload_offset) {
+        size_t payload_size = out->payloadlen;
+        socklen_t source_size = out->namelen < receive_header_.msg_namelen
+                                    ? out->namelen : receive_header_.msg_namelen;
+        stats_.packets_received++;
+        handler->OnDatagram(buffer + payload_offset, payload_size,
+                            reinterpret_cast<const sockaddr*>(buffer + sizeof(*out)), source_size);
+        delivered = true;
+    }
+    RecycleBuffer(buffer_id);
+    return delivered;
+}
+
+int UringTransport::Reap(DatagramHandler* handler) {
+    int received = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        head++;
+
+        if (cqe.user_data & kSendTag) {
+            uint32_t buffer = static_cast<uint32_t>(cqe.user_data & ~kSendTag);
+            free_send_buffers_.push_back(buffer);
+            sends_in_flight_--;
+            if (cqe.res < 0) {
+                stats_.send_errors++;
+            } else {
+                stats_.packets_sent++;
+            }
+            continue;
+        }
+
+        if (cqe.user_data != kReceiveTag) {
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            // The multishot receive ended, e.g. when it ran out of buffers
+            receive_armed_ = false;
+        }
+        if (cqe.res >= 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+            uint16_t buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (handler) {
+                received += HandleReceive(buffer_id, static_cast<uint32_t>(cqe.res), handler);
+            } else {
+                DeferredReceive deferred;
+                deferred.buffer_id = buffer_id;
+                deferred.length = static_cast<uint32_t>(cqe.res);
+                deferred_.push_back(deferred);
+            }
+        }
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return received;
+}
+
+int UringTransport::Poll(DatagramHandler* handler, bool wait) {
+    if (ring_fd_ < 0 || !handler) {
+        errno = EBADF;
+        return -1;
+    }
+
+    // Datagrams that arrived while Begin() or Submit() waited for sends
+    int received = HandleDeferred(handler);
+
+    // Restart the receive once buffers are back in the ring
+    if (!receive_armed_) {
+        stats_.receive_rearms++;
+        if (!ArmReceive()) {
+            return -1;
+        }
+    }
+
+    bool block = wait && received == 0 && *cq_head_ == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (Submit(1, block) < 0) {
+        return -1;
+    }
+    received += HandleDeferred(handler);
+    received += Reap(handler);
+    return received;
+}
+
+int UringTransport::HandleDeferred(DatagramHandler* handler) {
+    int received = 0;
+    for (const DeferredReceive& deferred : deferred_) {
+        received += HandleReceive(deferred.buffer_id, deferred.length, handler);
+    }
+    deferred_.clear();
+    return received;
+}
+
+uint8_t* UringTransport::Begin(size_t max_size) {
+    if (pending_buffer_ < 0 && ring_fd_ >= 0 && max_size <= config_.send_buffer_size) {
+        // Out of send buffers: submit what is queued and wait for sends to
+        // complete; received datagrams are kept for the next Poll()
+        while (free_send_buffers_.empty()) {
+            stats_.send_buffer_waits++;
+            if (Submit(1, true) < 0) {
+                break;
+            }
+            Reap(nullptr);
+        }
+        if (!free_send_buffers_.empty()) {
+            pending_buffer_ = static_cast<int>(free_send_buffers_.back());
+            free_send_buffers_.pop_back();
+        }
+    }
+
+    if (pending_buffer_ >= 0 && max_size <= config_.send_buffer_size) {
+        return send_memory_ + size_t(pending_buffer_) * config_.send_buffer_size;
+    }
+
+    // Packetizers always write to the returned buffer, so oversized packets
+    // get a scratch buffer and fail in Commit()
+    if (overflow_.size() < max_size) {
+        overflow_.resize(max_size);
+    }
+    return overflow_.data();
+}
+
+bool UringTransport::Commit(size_t size) {
+    if (pending_buffer_ < 0 || !connected_ || size > config_.send_buffer_size) {
+        return false;
+    }
+
+    io_uring_sqe* sqe = GetSqe();
+    if (!sqe) {
+        return false;
+    }
+
+    uint32_t buffer = static_cast<uint32_t>(pending_buffer_);
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = socket_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(send_memory_ + size_t(buffer) * config_.send_buffer_size);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->off = 0;
+    sqe->buf_index = 0;
+    sqe->user_data = kSendTag | buffer;
+    pending_buffer_ = -1;
+    sends_queued_++;
+    return true;
+}
+
+bool UringTransport::Flush() {
+    if (ring_fd_ < 0) {
+        return false;
+    }
+    return Submit(0, false) >= 0;
+}
+
+} // namespace rtp
@@ -0,0 +1,177 @@
+#ifndef URING_TRANSPORT_H_
+#define URING_TRANSPORT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/socket.h>
+#include "rtp_packet.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace rtp {
+
+// UringTransportConfig sizes the ring and the buffers a UringTransport owns
+struct UringTransportConfig {
+    unsigned ring_entries = 256;        // Submission queue size
+    size_t receive_buffers = 512;       // Rounded up to a power of two
+    size_t receive_buffer_size = 2048;
+    size_t send_buffers = 256;          // Packets in flight
+    size_t send_buffer_size = 2048;
+};
+
+// Counters of one io_uring transport
+struct UringTransportStats {
+    uint64_t packets_received = 0;
+    uint64_t packets_sent = 0;
+    uint64_t receive_truncated = 0;     // Datagrams larger than a receive buffer, dropped
+    uint64_t receive_rearms = 0;        // Multishot receives restarted
+    uint64_t send_errors = 0;           // Failed or canceled sends
+    uint64_t send_buffer_waits = 0;     // Begin() waited for a free send buffer
+    uint64_t ring_enters = 0;           // io_uring_enter system calls
+};
+
+// DatagramHandler receives each datagram from UringTransport::Poll() on the
+// polling thread; data is only valid for the duration of the call
+class DatagramHandler {
+public:
+    virtual ~DatagramHandler() = default;
+    virtual void OnDatagram(const uint8_t* data, size_t size,
+                            const sockaddr* source, socklen_t source_size) = 0;
+};
+
+// UringTransport is a completion-driven UDP transport on io_uring, set up
+// through the raw kernel interface. Receiving runs one multishot recvmsg
+// over a ring of provided buffers the transport owns; Poll() hands every
+// completed datagram to the handler in place and returns its buffer to the
+// kernel, so packets reach the per-SSRC depacketizer state on the polling
+// thread without a copy or thread hop. Sending, the transport is a
+// PacketWriter: packetizers build packets straight into registered fixed
+// send buffers, each packet of a frame is queued as a WRITE_FIXED, and
+// Flush() submits the frame with one system call. The sends of a frame are
+// issued in order, and a frame is only submitted once the previous one
+// completed, so packets leave in order. Sends go to the connected peer.
+// The transport is not thread-safe; one thread should own it.
+class UringTransport : public PacketWriter {
+public:
+    explicit UringTransport(const UringTransportConfig& config = UringTransportConfig());
+    ~UringTransport() override;
+
+    UringTransport(const UringTransport&) = delete;
+    UringTransport& operator=(const UringTransport&) = delete;
+
+    // Creates the socket bound to local, the ring and its buffers, and
+    // starts receiving. Needs Linux 6.0 or later.
+    bool Open(const sockaddr* local, socklen_t local_size);
+    void Close();
+
+    // Destination of every packet sent
+    bool Connect(const sockaddr* peer, socklen_t peer_size);
+
+    // PacketWriter: packets go into send buffers owned by the transport.
+    // A packet larger than a send buffer fails Commit().
+    uint8_t* Begin(size_t max_size) override;
+    bool Commit(size_t size) override;
+
+    // Submits the packets committed since the last call
+    bool Flush();
+
+    // Processes the completions that are ready, or waits for at least one.
+    // Received datagrams go to handler; returns their number, or -1 if the
+    // ring failed.
+    int Poll(DatagramHandler* handler, bool wait);
+
+    // Accessors
+    int fd() const { return socket_fd_; }
+    const UringTransportStats& Stats() const { return stats_; }
+    bool LocalAddress(sockaddr_storage* address, socklen_t* size) const;
+
+private:
+    // Completion of a datagram whose handler could not be called yet
+    struct DeferredReceive {
+        uint16_t buffer_id = 0;
+        uint32_t length = 0;
+    };
+
+    bool SetupRing();
+    bool SetupBuffers();
+    void TeardownRing();
+
+    // Next free submission entry, submitting pending ones if the queue is full
+    io_uring_sqe* GetSqe();
+    int Submit(unsigned min_complete, bool wait);
+    int Enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+
+    // Submits the published entries the kernel has not consumed yet,
+    // counting only the ones it takes
+    int EnterPublished(unsigned min_complete, unsigned flags);
+
+    // Arms the multishot receive
+    bool ArmReceive();
+
+    // Processes every ready completion; without a handler received
+    // datagrams are deferred to the next Poll()
+    int Reap(DatagramHandler* handler);
+    int HandleDeferred(DatagramHandler* handler);
+
+    // Passes one datagram to handler and recycles its buffer; false if it
+    // was dropped
+    bool HandleReceive(uint16_t buffer_id, uint32_t length, DatagramHandler* handler);
+    void RecycleBuffer(uint16_t buffer_id);
+
+    UringTransportConfig config_;
+    int socket_fd_ = -1;
+    int ring_fd_ = -1;
+    bool connected_ = false;
+
+    // Ring mappings
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sq_local_tail_ = 0;
+    unsigned sq_submitted_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    bool defer_taskrun_ = false;
+
+    // Provided receive buffers and their ring
+    io_uring_buf_ring* buffer_ring_ = nullptr;
+    size_t buffer_ring_size_ = 0;
+    uint8_t* receive_memory_ = nullptr;
+    size_t receive_memory_size_ = 0;
+    size_t receive_count_ = 0;
+    unsigned buffer_ring_tail_ = 0;
+    msghdr receive_header_ = {};
+    bool receive_armed_ = false;
+    std::vector<DeferredReceive> deferred_;
+
+    // Registered send buffers
+    uint8_t* send_memory_ = nullptr;
+    size_t send_memory_size_ = 0;
+    std::vector<uint32_t> free_send_buffers_;
+    int pending_buffer_ = -1;           // Taken by Begin(), not committed
+    unsigned sends_queued_ = 0;         // Committed sends not yet submitted
+    unsigned sends_in_flight_ = 0;      // Submitted sends not yet completed
+    std::vector<uint8_t> overflow_;     // Begin() target for oversized packets
+
+    UringTransportStats stats_;
+};
+
+} // namespace rtp
+
+#endif // URING_TRANSPORT_H_